@@ -0,0 +1,479 @@
+// headless scene benchmark: steps every scenario at each thread count and
+// reports step rate, phase times and allocations, optionally as JSON
+#include "scenes.hpp"
+#include "toy_physics/log.hpp"
+#include "toy_physics/simd.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace toy_physics;
+
+constexpr float DeltaTime = 1.0f / 60.0f;
+constexpr uint32_t JsonSchemaVersion = 1;
+
+struct Phase {
+    const char* m_name;
+    double StepTimings::*m_seconds;
+};
+
+constexpr Phase Phases[] = {
+    {"broadphase", &StepTimings::m_broadphase},
+    {"narrowphase", &StepTimings::m_narrowphase},
+    {"integrate_velocities", &StepTimings::m_integrate_velocities},
+    {"solve", &StepTimings::m_solve},
+    {"ccd", &StepTimings::m_ccd},
+    {"integrate_positions", &StepTimings::m_integrate_positions},
+    {"sleep", &StepTimings::m_sleep},
+    {"publish", &StepTimings::m_publish},
+    {"total", &StepTimings::m_total},
+};
+
+struct Options {
+    std::vector<const Scenario*> m_scenarios;
+    std::vector<uint32_t> m_threads;
+    uint32_t m_steps = 300;
+    uint32_t m_warmup = 60;
+    Broadphase::Type m_broadphase = Broadphase::Type::Tree;
+    // empty prints only the table, "-" writes JSON to stdout
+    std::string m_json_path;
+    // Chrome trace of the measured steps, needs TOY_PHYSICS_PROFILE
+    std::string m_trace_path;
+};
+
+struct RunResult {
+    const Scenario* m_scenario = nullptr;
+    uint32_t m_threads = 0;
+    size_t m_body_count = 0;
+    size_t m_awake_count = 0;
+    size_t m_manifold_count = 0;
+    double m_build_seconds = 0;
+    // wall time of every measured step, sorted
+    std::vector<double> m_step_seconds;
+    // summed over the measured steps
+    StepTimings m_phases;
+    uint64_t m_allocations = 0;
+    uint64_t m_max_step_allocations = 0;
+
+    double GetTotalSeconds() const {
+        double total = 0;
+        for (double seconds : m_step_seconds) {
+            total += seconds;
+        }
+        return total;
+    }
+
+    double GetMeanStep() const {
+        return m_step_seconds.empty()
+                   ? 0
+                   : GetTotalSeconds() / m_step_seconds.size();
+    }
+
+    double GetStepsPerSecond() const {
+        double total = GetTotalSeconds();
+        return total > 0 ? m_step_seconds.size() / total : 0;
+    }
+
+    double GetPercentile(double fraction) const {
+        if (m_step_seconds.empty()) {
+            return 0;
+        }
+        size_t index = static_cast<size_t>(fraction *
+                                           (m_step_seconds.size() - 1));
+        return m_step_seconds[index];
+    }
+
+    double GetMeanPhase(double StepTimings::*phase) const {
+        return m_step_seconds.empty()
+                   ? 0
+                   : m_phases.*phase / m_step_seconds.size();
+    }
+};
+
+static double GetSeconds() {
+    return std::chrono::duration<double>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static const char* GetBroadphaseName(Broadphase::Type type) {
+    switch (type) {
+        case Broadphase::Type::Tree:
+            return "tree";
+        case Broadphase::Type::SweepAndPrune:
+            return "sap";
+        case Broadphase::Type::HashGrid:
+            return "grid";
+    }
+    return "unknown";
+}
+
+static std::string GetCompilerName() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_VER);
+#else
+    return "unknown";
+#endif
+}
+
+static uint32_t GetHardwareThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// 1, 2, 4, ... up to every hardware thread
+static std::vector<uint32_t> GetDefaultThreads() {
+    uint32_t count = GetHardwareThreads();
+    std::vector<uint32_t> threads;
+    for (uint32_t n = 1; n < count; n *= 2) {
+        threads.push_back(n);
+    }
+    threads.push_back(count);
+    return threads;
+}
+
+static bool ParseUint(const char* text, uint32_t& value) {
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+// comma separated list of names or numbers
+static std::vector<std::string> SplitList(const std::string& text) {
+    std::vector<std::string> items;
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = text.find(',', begin);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        if (end > begin) {
+            items.push_back(text.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+    return items;
+}
+
+static void PrintUsage() {
+    std::printf(
+        "usage: toy_physics_bench [options]\n"
+        "  --scenario a,b    scenarios to run, default all\n"
+        "  --threads 1,2,8   worker counts, default 1, 2, 4, ... up to %u\n"
+        "  --steps n         measured steps per run, default 300\n"
+        "  --warmup n        steps before measuring, default 60\n"
+        "  --broadphase x    tree, sap or grid, default tree\n"
+        "  --json path       write results as JSON, - for stdout\n"
+        "  --trace path      write a Chrome trace of the measured steps\n"
+        "  --list            list the scenarios\n",
+        GetHardwareThreads());
+}
+
+enum class ParseResult {
+    Run,
+    // help or the scenario list was printed
+    Done,
+    Error,
+};
+
+static ParseResult ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            return ParseResult::Done;
+        }
+        if (arg == "--list") {
+            for (const Scenario& scenario : GetScenarios()) {
+                std::printf("%-12s %s\n", scenario.m_name.data(),
+                            scenario.m_description.data());
+            }
+            return ParseResult::Done;
+        }
+        if (i + 1 >= argc) {
+            LOGE("unknown option or missing value: {}", arg);
+            return ParseResult::Error;
+        }
+        std::string value = argv[++i];
+        if (arg == "--scenario") {
+            for (const std::string& name : SplitList(value)) {
+                const Scenario* scenario = FindScenario(name);
+                if (!scenario) {
+                    LOGE("unknown scenario {}", name);
+                    return ParseResult::Error;
+                }
+                options.m_scenarios.push_back(scenario);
+            }
+        } else if (arg == "--threads") {
+            for (const std::string& item : SplitList(value)) {
+                uint32_t threads = 0;
+                if (!ParseUint(item.c_str(), threads) || threads == 0) {
+                    LOGE("invalid thread count {}", item);
+                    return ParseResult::Error;
+                }
+                options.m_threads.push_back(threads);
+            }
+        } else if (arg == "--steps") {
+            if (!ParseUint(value.c_str(), options.m_steps) ||
+                options.m_steps == 0) {
+                LOGE("invalid step count {}", value);
+                return ParseResult::Error;
+            }
+        } else if (arg == "--warmup") {
+            if (!ParseUint(value.c_str(), options.m_warmup)) {
+                LOGE("invalid warmup step count {}", value);
+                return ParseResult::Error;
+            }
+        } else if (arg == "--broadphase") {
+            if (value == "tree") {
+                options.m_broadphase = Broadphase::Type::Tree;
+            } else if (value == "sap") {
+                options.m_broadphase = Broadphase::Type::SweepAndPrune;
+            } else if (value == "grid") {
+                options.m_broadphase = Broadphase::Type::HashGrid;
+            } else {
+                LOGE("unknown broadphase {}", value);
+                return ParseResult::Error;
+            }
+        } else if (arg == "--json") {
+            options.m_json_path = value;
+        } else if (arg == "--trace") {
+            options.m_trace_path = value;
+        } else {
+            LOGE("unknown option {}", arg);
+            return ParseResult::Error;
+        }
+    }
+
+    if (options.m_scenarios.empty()) {
+        for (const Scenario& scenario : GetScenarios()) {
+            options.m_scenarios.push_back(&scenario);
+        }
+    }
+    if (options.m_threads.empty()) {
+        options.m_threads = GetDefaultThreads();
+    }
+    return ParseResult::Run;
+}
+
+static RunResult Run(const Scenario& scenario, uint32_t threads,
+                     const Options& options) {
+    RunResult result;
+    result.m_scenario = &scenario;
+    result.m_threads = threads;
+
+    double build_start = GetSeconds();
+    auto world = std::make_unique<World>(options.m_broadphase, threads);
+    SceneDriver driver;
+    scenario.m_build(*world, driver);
+    result.m_build_seconds = GetSeconds() - build_start;
+
+    result.m_step_seconds.reserve(options.m_steps);
+    uint32_t step_count = options.m_warmup + options.m_steps;
+    for (uint32_t step = 0; step < step_count; step++) {
+        driver.Update(*world, step);
+
+        if (step == options.m_warmup && !options.m_trace_path.empty()) {
+            Profiler::SetRecording(true);
+        }
+        double start = GetSeconds();
+        world->Step(DeltaTime);
+        double seconds = GetSeconds() - start;
+        if (step < options.m_warmup) {
+            continue;
+        }
+
+        result.m_step_seconds.push_back(seconds);
+        const StepTimings& timings = world->GetStepTimings();
+        for (const Phase& phase : Phases) {
+            result.m_phases.*phase.m_seconds += timings.*phase.m_seconds;
+        }
+        uint64_t allocations = world->GetStepAllocationCount();
+        result.m_allocations += allocations;
+        result.m_max_step_allocations =
+            std::max(result.m_max_step_allocations, allocations);
+    }
+    Profiler::SetRecording(false);
+    std::sort(result.m_step_seconds.begin(), result.m_step_seconds.end());
+
+    result.m_body_count = world->GetBodyCount();
+    result.m_awake_count = world->GetAwakeBodyCount();
+    result.m_manifold_count = world->GetManifolds().size();
+    return result;
+}
+
+// step rate relative to the single threaded run of the same scenario
+static double GetSpeedup(const std::vector<RunResult>& results,
+                         const RunResult& result) {
+    for (const RunResult& other : results) {
+        if (other.m_scenario == result.m_scenario && other.m_threads == 1) {
+            double base = other.GetStepsPerSecond();
+            return base > 0 ? result.GetStepsPerSecond() / base : 0;
+        }
+    }
+    return 0;
+}
+
+static void PrintHeader(FILE* out) {
+    std::fprintf(out,
+                 "%-12s %7s %7s %9s %8s %8s %7s %7s %7s %7s %7s %7s %8s\n",
+                 "scenario", "threads", "bodies", "steps/s", "mean ms",
+                 "p95 ms", "speedup", "broad", "narrow", "solve", "ccd",
+                 "sleep", "allocs");
+}
+
+static void PrintResult(FILE* out, const std::vector<RunResult>& results,
+                        const RunResult& result) {
+    auto phase_ms = [&](double StepTimings::*phase) {
+        return result.GetMeanPhase(phase) * 1000;
+    };
+    std::string allocations =
+        IsAllocationTrackingCompiled() ? std::to_string(result.m_allocations) : "-";
+    std::fprintf(out,
+                 "%-12s %7u %7zu %9.1f %8.3f %8.3f %7.2f %7.3f %7.3f %7.3f "
+                 "%7.3f %7.3f %8s\n",
+                 result.m_scenario->m_name.data(), result.m_threads,
+                 result.m_body_count, result.GetStepsPerSecond(),
+                 result.GetMeanStep() * 1000,
+                 result.GetPercentile(0.95) * 1000,
+                 GetSpeedup(results, result),
+                 phase_ms(&StepTimings::m_broadphase),
+                 phase_ms(&StepTimings::m_narrowphase),
+                 phase_ms(&StepTimings::m_solve),
+                 phase_ms(&StepTimings::m_ccd), phase_ms(&StepTimings::m_sleep),
+                 allocations.c_str());
+}
+
+static void WriteJson(FILE* out, const Options& options,
+                      const std::vector<RunResult>& results) {
+    std::fprintf(out, "{\n");
+    std::fprintf(out, "  \"schema\": %u,\n", JsonSchemaVersion);
+    std::fprintf(out, "  \"build\": {\n");
+    std::fprintf(out, "    \"compiler\": \"%s\",\n",
+                 GetCompilerName().c_str());
+#ifdef NDEBUG
+    std::fprintf(out, "    \"optimized\": true,\n");
+#else
+    std::fprintf(out, "    \"optimized\": false,\n");
+#endif
+    std::fprintf(out, "    \"simd\": \"%s\",\n",
+                 GetSimdLevelName(GetSimdLevel()));
+    std::fprintf(out, "    \"allocation_tracking\": %s\n",
+                 IsAllocationTrackingCompiled() ? "true" : "false");
+    std::fprintf(out, "  },\n");
+    std::fprintf(out, "  \"hardware_threads\": %u,\n", GetHardwareThreads());
+    std::fprintf(out,
+                 "  \"config\": {\"broadphase\": \"%s\", \"delta_time\": %.9g, "
+                 "\"warmup\": %u, \"steps\": %u},\n",
+                 GetBroadphaseName(options.m_broadphase), DeltaTime,
+                 options.m_warmup, options.m_steps);
+    std::fprintf(out, "  \"results\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        const RunResult& result = results[i];
+        std::fprintf(out, "%s\n    {\n", i == 0 ? "" : ",");
+        std::fprintf(out, "      \"scenario\": \"%s\",\n",
+                     result.m_scenario->m_name.data());
+        std::fprintf(out, "      \"threads\": %u,\n", result.m_threads);
+        std::fprintf(out, "      \"bodies\": %zu,\n", result.m_body_count);
+        std::fprintf(out, "      \"awake_bodies\": %zu,\n",
+                     result.m_awake_count);
+        std::fprintf(out, "      \"manifolds\": %zu,\n",
+                     result.m_manifold_count);
+        std::fprintf(out, "      \"build_ms\": %.3f,\n",
+                     result.m_build_seconds * 1000);
+        std::fprintf(out, "      \"steps_per_sec\": %.3f,\n",
+                     result.GetStepsPerSecond());
+        std::fprintf(out, "      \"speedup\": %.3f,\n",
+                     GetSpeedup(results, result));
+        std::fprintf(out,
+                     "      \"step_ms\": {\"mean\": %.4f, \"median\": %.4f, "
+                     "\"p95\": %.4f, \"max\": %.4f},\n",
+                     result.GetMeanStep() * 1000,
+                     result.GetPercentile(0.5) * 1000,
+                     result.GetPercentile(0.95) * 1000,
+                     result.GetPercentile(1.0) * 1000);
+        std::fprintf(out, "      \"phase_ms\": {");
+        for (size_t p = 0; p < std::size(Phases); p++) {
+            std::fprintf(out, "%s\"%s\": %.4f", p == 0 ? "" : ", ",
+                         Phases[p].m_name,
+                         result.GetMeanPhase(Phases[p].m_seconds) * 1000);
+        }
+        std::fprintf(out, "},\n");
+        // null rather than a misleading zero when nothing was counted
+        if (IsAllocationTrackingCompiled()) {
+            std::fprintf(out,
+                         "      \"allocations\": {\"total\": %llu, "
+                         "\"max_per_step\": %llu}\n",
+                         static_cast<unsigned long long>(result.m_allocations),
+                         static_cast<unsigned long long>(
+                             result.m_max_step_allocations));
+        } else {
+            std::fprintf(out, "      \"allocations\": null\n");
+        }
+        std::fprintf(out, "    }");
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    ParseResult parsed = ParseOptions(argc, argv, options);
+    if (parsed != ParseResult::Run) {
+        return parsed == ParseResult::Done ? 0 : 1;
+    }
+
+    // the table moves to stderr when stdout carries the JSON
+    bool json_to_stdout = options.m_json_path == "-";
+    FILE* table = json_to_stdout ? stderr : stdout;
+    if (!IsAllocationTrackingCompiled()) {
+        std::fprintf(table, "allocations are only counted in builds with "
+                            "TOY_PHYSICS_TRACK_ALLOCATIONS\n");
+    }
+#ifndef TOY_PHYSICS_PROFILE
+    if (!options.m_trace_path.empty()) {
+        std::fprintf(table, "the trace only has events in builds with "
+                            "TOY_PHYSICS_PROFILE\n");
+    }
+#endif
+
+    std::vector<RunResult> results;
+    PrintHeader(table);
+    for (const Scenario* scenario : options.m_scenarios) {
+        for (uint32_t threads : options.m_threads) {
+            results.push_back(Run(*scenario, threads, options));
+            PrintResult(table, results, results.back());
+            std::fflush(table);
+        }
+    }
+
+    if (!options.m_trace_path.empty() &&
+        !Profiler::WriteChromeTrace(options.m_trace_path)) {
+        return 1;
+    }
+    if (options.m_json_path.empty()) {
+        return 0;
+    }
+    FILE* out = json_to_stdout ? stdout
+                               : std::fopen(options.m_json_path.c_str(), "w");
+    if (!out) {
+        LOGE("can't write {}", options.m_json_path);
+        return 1;
+    }
+    WriteJson(out, options, results);
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include "scenes.hpp"
+
+#include <random>
+
+using namespace toy_physics;
+
+void SceneDriver::Update(World& world, uint32_t step) const {
+    if (m_kick_interval == 0 || step % m_kick_interval != 0) {
+        return;
+    }
+    for (BodyHandle handle : m_movers) {
+        world.WakeUp(handle);
+        world.SetVelocity(handle, m_kick_velocity);
+    }
+}
+
+static BodyHandle AddStatic(World& world, GeometryHandle geom,
+                            const Eigen::Vector3f& position) {
+    Body body;
+    body.m_pose.m_position = position;
+    body.m_geometry.m_geom = geom;
+    return world.CreateBody(body);
+}
+
+static BodyHandle AddDynamic(World& world, GeometryHandle geom,
+                             const Pose& pose) {
+    Body body;
+    body.m_pose = pose;
+    body.m_inv_mass = 1;
+    body.m_geometry.m_geom = geom;
+    return world.CreateBody(body);
+}
+
+static Pose MakePose(const Eigen::Vector3f& position,
+                     const Eigen::Quaternionf& rotation =
+                         Eigen::Quaternionf::Identity()) {
+    Pose pose;
+    pose.m_position = position;
+    pose.m_rotation = rotation;
+    return pose;
+}
+
+// uniformly distributed rotation, seeded so every run builds the same scene
+static Eigen::Quaternionf RandomRotation(std::mt19937& random) {
+    std::uniform_real_distribution<float> dist{-1, 1};
+    Eigen::Quaternionf rotation{dist(random), dist(random), dist(random),
+                                dist(random)};
+    if (rotation.squaredNorm() < 1e-4f) {
+        return Eigen::Quaternionf::Identity();
+    }
+    return rotation.normalized();
+}
+
+// top face of the ground is at y = 0
+static void AddGround(World& world, float half_extent) {
+    AddStatic(world,
+              world.GetGeometryPool().Add(
+                  BoxGeometry{Eigen::Vector3f{half_extent, 1, half_extent}}),
+              {0, -1, 0});
+}
+
+// 10 walls of stacked boxes, 210 boxes each
+static void BuildPyramids(World& world, SceneDriver&) {
+    constexpr int PyramidCount = 10;
+    constexpr int BaseCount = 20;
+
+    AddGround(world, 100);
+    GeometryPool& pool = world.GetGeometryPool();
+    GeometryHandle box = pool.Add(BoxGeometry{Eigen::Vector3f{.5f, .5f, .5f}});
+    for (int p = 0; p < PyramidCount; p++) {
+        float z = (p - PyramidCount / 2) * 4.0f;
+        for (int row = 0; row < BaseCount; row++) {
+            int count = BaseCount - row;
+            for (int i = 0; i < count; i++) {
+                float x = (i - (count - 1) * 0.5f) * 1.01f;
+                AddDynamic(world, box, MakePose({x, 0.5f + row * 1.0f, z}));
+            }
+        }
+    }
+}
+
+// 10k spheres dropped from a jittered 25 x 25 x 16 grid
+static void BuildSpheres(World& world, SceneDriver&) {
+    AddGround(world, 100);
+    GeometryHandle sphere = world.GetGeometryPool().Add(SphereGeometry{0.5f});
+    std::mt19937 random{1};
+    std::uniform_real_distribution<float> jitter{-0.1f, 0.1f};
+    for (int y = 0; y < 16; y++) {
+        for (int z = 0; z < 25; z++) {
+            for (int x = 0; x < 25; x++) {
+                Eigen::Vector3f position{(x - 12) * 1.3f + jitter(random),
+                                         1.0f + y * 1.3f,
+                                         (z - 12) * 1.3f + jitter(random)};
+                AddDynamic(world, sphere, MakePose(position));
+            }
+        }
+    }
+}
+
+// 4000 randomly rotated capsules dropped into a walled pit
+static void BuildCapsulePile(World& world, SceneDriver&) {
+    AddGround(world, 50);
+    GeometryPool& pool = world.GetGeometryPool();
+    GeometryHandle wall_x =
+        pool.Add(BoxGeometry{Eigen::Vector3f{0.5f, 8, 12.5f}});
+    GeometryHandle wall_z =
+        pool.Add(BoxGeometry{Eigen::Vector3f{12.5f, 8, 0.5f}});
+    AddStatic(world, wall_x, {-12, 8, 0});
+    AddStatic(world, wall_x, {12, 8, 0});
+    AddStatic(world, wall_z, {0, 8, -12});
+    AddStatic(world, wall_z, {0, 8, 12});
+
+    GeometryHandle capsule = pool.Add(CapsuleGeometry{0.2f, 0.8f});
+    std::mt19937 random{2};
+    for (int y = 0; y < 10; y++) {
+        for (int z = 0; z < 20; z++) {
+            for (int x = 0; x < 20; x++) {
+                Eigen::Vector3f position{(x - 9.5f) * 1.1f, 1.0f + y * 1.3f,
+                                         (z - 9.5f) * 1.1f};
+                AddDynamic(world, capsule,
+                           MakePose(position, RandomRotation(random)));
+            }
+        }
+    }
+}
+
+// 64 platforms kilometers apart, far from the world origin, each with a
+// heap of 125 boxes, spheres and capsules
+static void BuildLargeWorld(World& world, SceneDriver&) {
+    const Eigen::Vector3d center{1.0e6, 0, -2.0e6};
+    world.SetOrigin(center);
+
+    GeometryPool& pool = world.GetGeometryPool();
+    GeometryHandle platform =
+        pool.Add(BoxGeometry{Eigen::Vector3f{6, 0.5f, 6}});
+    GeometryHandle shapes[] = {
+        pool.Add(BoxGeometry{Eigen::Vector3f{.4f, .4f, .4f}}),
+        pool.Add(SphereGeometry{0.4f}),
+        pool.Add(CapsuleGeometry{0.25f, 0.5f}),
+    };
+    std::mt19937 random{3};
+    int index = 0;
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) {
+            Eigen::Vector3d anchor =
+                center + Eigen::Vector3d{(i - 3.5) * 500, 0, (j - 3.5) * 500};
+            AddStatic(world, platform, world.ToLocal(anchor));
+            for (int y = 0; y < 5; y++) {
+                for (int z = 0; z < 5; z++) {
+                    for (int x = 0; x < 5; x++) {
+                        Eigen::Vector3d offset{(x - 2) * 1.5, 1.5 + y * 1.2,
+                                               (z - 2) * 1.5};
+                        AddDynamic(world, shapes[index++ % 3],
+                                   MakePose(world.ToLocal(anchor + offset),
+                                            RandomRotation(random)));
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 20k boxes resting on the ground fall asleep during the warmup, 256
+// spheres next to them are kicked up every second and stay awake
+static void BuildMostlyAsleep(World& world, SceneDriver& driver) {
+    AddGround(world, 120);
+    GeometryPool& pool = world.GetGeometryPool();
+    GeometryHandle box = pool.Add(BoxGeometry{Eigen::Vector3f{.4f, .4f, .4f}});
+    for (int z = 0; z < 125; z++) {
+        for (int x = 0; x < 160; x++) {
+            AddDynamic(world, box,
+                       MakePose({(x - 79.5f) * 1.2f, 0.4f, (z - 62) * 1.2f}));
+        }
+    }
+
+    GeometryHandle sphere = pool.Add(SphereGeometry{0.4f});
+    for (int z = 0; z < 16; z++) {
+        for (int x = 0; x < 16; x++) {
+            driver.m_movers.push_back(AddDynamic(
+                world, sphere,
+                MakePose({(x - 7.5f) * 1.2f, 0.4f, 90 + z * 1.2f})));
+        }
+    }
+    driver.m_kick_interval = 60;
+    driver.m_kick_velocity = {0, 5, 0};
+}
+
+const std::vector<Scenario>& GetScenarios() {
+    static const std::vector<Scenario> scenarios = {
+        {"pyramid", "10 box pyramids, 2100 stacked boxes", BuildPyramids},
+        {"spheres", "10k spheres falling onto the ground", BuildSpheres},
+        {"capsules", "4000 capsules piling up in a pit", BuildCapsulePile},
+        {"large_world", "8000 mixed bodies on 64 islands far from the origin",
+         BuildLargeWorld},
+        {"asleep", "20k sleeping boxes and 256 bouncing spheres",
+         BuildMostlyAsleep},
+    };
+    return scenarios;
+}
+
+const Scenario* FindScenario(std::string_view name) {
+    for (const Scenario& scenario : GetScenarios()) {
+        if (scenario.m_name == name) {
+            return &scenario;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "toy_physics/world.hpp"
+
+#include <string_view>
+#include <vector>
+
+// bodies kicked upwards every few steps to keep part of a scene awake
+struct SceneDriver {
+    std::vector<toy_physics::BodyHandle> m_movers;
+    uint32_t m_kick_interval = 0;
+    Eigen::Vector3f m_kick_velocity = Eigen::Vector3f::Zero();
+
+    void Update(toy_physics::World& world, uint32_t step) const;
+};
+
+struct Scenario {
+    std::string_view m_name;
+    std::string_view m_description;
+    void (*m_build)(toy_physics::World& world, SceneDriver& driver);
+};
+
+// the standard scenarios, in the order they run by default
+const std::vector<Scenario>& GetScenarios();
+const Scenario* FindScenario(std::string_view name);
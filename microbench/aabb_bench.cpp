@@ -0,0 +1,50 @@
+// world space bounds of every geometry type. ComputeAABB has no batched
+// form, so only the scalar path is measured
+#include "bench_data.hpp"
+#include "toy_physics/aabb.hpp"
+#include "toy_physics/geometry.hpp"
+
+using namespace toy_physics;
+
+template <typename G>
+static void RunComputeAABB(benchmark::State& state, const G& geom) {
+    auto poses = MakeRandomPoses(InputCount, 100, 1);
+    size_t i = 0;
+    for (auto _ : state) {
+        AABB aabb = ComputeAABB(geom, poses[i++ % InputCount]);
+        benchmark::DoNotOptimize(aabb);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ComputeAABBBox(benchmark::State& state) {
+    RunComputeAABB(state, BoxGeometry{Eigen::Vector3f{0.5f, 1.0f, 1.5f}});
+}
+BENCHMARK(BM_ComputeAABBBox);
+
+static void BM_ComputeAABBSphere(benchmark::State& state) {
+    RunComputeAABB(state, SphereGeometry{0.5f});
+}
+BENCHMARK(BM_ComputeAABBSphere);
+
+static void BM_ComputeAABBCapsule(benchmark::State& state) {
+    RunComputeAABB(state, CapsuleGeometry{0.3f, 1.0f});
+}
+BENCHMARK(BM_ComputeAABBCapsule);
+
+// through the Geometry::Type switch the world uses
+static void BM_ComputeAABBDispatch(benchmark::State& state) {
+    BoxGeometry box{Eigen::Vector3f{0.5f, 1.0f, 1.5f}};
+    SphereGeometry sphere{0.5f};
+    CapsuleGeometry capsule{0.3f, 1.0f};
+    const Geometry* geoms[] = {&box, &sphere, &capsule};
+    auto poses = MakeRandomPoses(InputCount, 100, 1);
+    size_t i = 0;
+    for (auto _ : state) {
+        AABB aabb = ComputeAABB(*geoms[i % 3], poses[i % InputCount]);
+        benchmark::DoNotOptimize(aabb);
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ComputeAABBDispatch);
@@ -0,0 +1,67 @@
+#include "bench_data.hpp"
+
+#include <algorithm>
+#include <random>
+
+using namespace toy_physics;
+
+static Eigen::Quaternionf RandomRotation(std::mt19937& random) {
+    std::uniform_real_distribution<float> dist{-1, 1};
+    Eigen::Quaternionf rotation{dist(random), dist(random), dist(random),
+                                dist(random)};
+    if (rotation.squaredNorm() < 1e-4f) {
+        return Eigen::Quaternionf::Identity();
+    }
+    return rotation.normalized();
+}
+
+static Eigen::Vector3f RandomDirection(std::mt19937& random) {
+    std::normal_distribution<float> dist;
+    Eigen::Vector3f dir{dist(random), dist(random), dist(random)};
+    float length = dir.norm();
+    return length > 1e-4f ? Eigen::Vector3f{dir / length}
+                          : Eigen::Vector3f::UnitY();
+}
+
+std::vector<Pose> MakeRandomPoses(size_t count, float extent,
+                                  uint32_t seed) {
+    std::mt19937 random{seed};
+    std::uniform_real_distribution<float> dist{-extent, extent};
+    std::vector<Pose> poses(count);
+    for (Pose& pose : poses) {
+        pose.m_position = {dist(random), dist(random), dist(random)};
+        pose.m_rotation = RandomRotation(random);
+    }
+    return poses;
+}
+
+std::vector<PosePair> MakePosePairs(size_t count, float distance,
+                                    uint32_t seed) {
+    std::mt19937 random{seed};
+    std::vector<PosePair> pairs(count);
+    for (PosePair& pair : pairs) {
+        pair.m_a.m_rotation = RandomRotation(random);
+        pair.m_b.m_position = RandomDirection(random) * distance;
+        pair.m_b.m_rotation = RandomRotation(random);
+    }
+    return pairs;
+}
+
+void SimdLevelArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgName("simd");
+    bench->Arg(static_cast<int>(SimdLevel::Scalar));
+#ifdef TOY_PHYSICS_SSE2
+    bench->Arg(static_cast<int>(SimdLevel::SSE2));
+#endif
+#ifdef TOY_PHYSICS_X86
+    bench->Arg(static_cast<int>(SimdLevel::AVX2));
+#endif
+}
+
+SimdLevel GetSimdArg(benchmark::State& state) {
+    // levels the cpu can't run fall back to the detected one
+    auto level = static_cast<SimdLevel>(state.range(0));
+    level = std::min(level, GetSimdLevel());
+    state.SetLabel(GetSimdLevelName(level));
+    return level;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "toy_physics/pose.hpp"
+#include "toy_physics/simd.hpp"
+
+#include "benchmark/benchmark.h"
+
+#include <cstdint>
+#include <vector>
+
+// kernels cycle through this many inputs so they don't run on one hot value
+constexpr size_t InputCount = 1024;
+
+// seeded, so every run measures the same inputs
+std::vector<toy_physics::Pose> MakeRandomPoses(size_t count, float extent,
+                                               uint32_t seed);
+
+// a pair of shapes whose centers are distance apart in a random direction,
+// both randomly rotated
+struct PosePair {
+    toy_physics::Pose m_a;
+    toy_physics::Pose m_b;
+};
+
+std::vector<PosePair> MakePosePairs(size_t count, float distance,
+                                    uint32_t seed);
+
+// one run per simd level built into the library, passed as range(0)
+void SimdLevelArgs(benchmark::internal::Benchmark* bench);
+
+// the level of a run, labelled with the level the kernels actually use
+toy_physics::SimdLevel GetSimdArg(benchmark::State& state);
@@ -0,0 +1,121 @@
+// every narrowphase pair kernel on touching, randomly rotated pairs. The
+// sphere and capsule pairs also have the wide kernels the narrowphase
+// batches them through
+#include "bench_data.hpp"
+#include "toy_physics/collision.hpp"
+#include "toy_physics/contact_batch.hpp"
+
+#include <algorithm>
+
+using namespace toy_physics;
+
+constexpr float Margin = 0.02f;
+
+// centers are placed closer than the shapes' extents so most pairs overlap
+template <typename A, typename B, typename F>
+static void RunCollide(benchmark::State& state, const A& a, const B& b,
+                       float distance, const F& collide) {
+    auto pairs = MakePosePairs(InputCount, distance, 1);
+    ContactManifold manifold;
+    size_t i = 0;
+    int64_t contacts = 0;
+    for (auto _ : state) {
+        const PosePair& pair = pairs[i++ % InputCount];
+        contacts += collide(a, pair.m_a, b, pair.m_b, Margin, manifold);
+        benchmark::DoNotOptimize(manifold);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hit_rate"] = static_cast<double>(contacts) /
+                                 std::max<int64_t>(state.iterations(), 1);
+}
+
+static void BM_CollideSphereSphere(benchmark::State& state) {
+    SphereGeometry sphere{0.5f};
+    RunCollide(state, sphere, sphere, 0.9f, CollideSphereSphere);
+}
+BENCHMARK(BM_CollideSphereSphere);
+
+static void BM_CollideBoxSphere(benchmark::State& state) {
+    RunCollide(state, BoxGeometry{Eigen::Vector3f{.5f, .5f, .5f}},
+               SphereGeometry{0.5f}, 0.9f, CollideBoxSphere);
+}
+BENCHMARK(BM_CollideBoxSphere);
+
+static void BM_CollideBoxCapsule(benchmark::State& state) {
+    RunCollide(state, BoxGeometry{Eigen::Vector3f{.5f, .5f, .5f}},
+               CapsuleGeometry{0.3f, 1.0f}, 0.9f,
+               [](const BoxGeometry& a, const Pose& pose_a,
+                  const CapsuleGeometry& b, const Pose& pose_b, float margin,
+                  ContactManifold& manifold) {
+                   return CollideBoxCapsule(a, pose_a, b, pose_b, margin,
+                                            manifold);
+               });
+}
+BENCHMARK(BM_CollideBoxCapsule);
+
+static void BM_CollideSphereCapsule(benchmark::State& state) {
+    RunCollide(state, SphereGeometry{0.5f}, CapsuleGeometry{0.3f, 1.0f},
+               0.9f, CollideSphereCapsule);
+}
+BENCHMARK(BM_CollideSphereCapsule);
+
+static void BM_CollideCapsuleCapsule(benchmark::State& state) {
+    CapsuleGeometry capsule{0.3f, 1.0f};
+    RunCollide(state, capsule, capsule, 0.9f, CollideCapsuleCapsule);
+}
+BENCHMARK(BM_CollideCapsuleCapsule);
+
+static void BM_CollideBoxBox(benchmark::State& state) {
+    BoxGeometry box{Eigen::Vector3f{.5f, .5f, .5f}};
+    RunCollide(state, box, box, 0.9f, CollideBoxBox);
+}
+BENCHMARK(BM_CollideBoxBox);
+
+// the GJK/EPA fallback for convex pairs without a dedicated kernel
+static void BM_CollideConvexShapes(benchmark::State& state) {
+    BoxGeometry box{Eigen::Vector3f{.5f, .5f, .5f}};
+    RunCollide(state, box, box, 0.9f,
+               [](const Geometry& a, const Pose& pose_a, const Geometry& b,
+                  const Pose& pose_b, float margin,
+                  ContactManifold& manifold) {
+                   return CollideConvexShapes(a, pose_a, b, pose_b, margin,
+                                              manifold);
+               });
+}
+BENCHMARK(BM_CollideConvexShapes);
+
+static void BM_CollideSphereBatch(benchmark::State& state) {
+    SimdLevel level = GetSimdArg(state);
+    SpherePairBatch batch;
+    for (const PosePair& pair : MakePosePairs(InputCount, 0.9f, 1)) {
+        batch.Push(pair.m_a.m_position, 0.5f, pair.m_b.m_position, 0.5f);
+    }
+    ContactBatch contacts;
+    for (auto _ : state) {
+        CollideSphereBatch(batch, contacts, level);
+        benchmark::DoNotOptimize(contacts.m_depth.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_CollideSphereBatch)->Apply(SimdLevelArgs);
+
+static void BM_CollideCapsuleBatch(benchmark::State& state) {
+    SimdLevel level = GetSimdArg(state);
+    CapsuleGeometry capsule{0.3f, 1.0f};
+    CapsulePairBatch batch;
+    for (const PosePair& pair : MakePosePairs(InputCount, 0.9f, 1)) {
+        Eigen::Vector3f p1, q1, p2, q2;
+        GetCapsuleSegment(capsule, pair.m_a, p1, q1);
+        GetCapsuleSegment(capsule, pair.m_b, p2, q2);
+        batch.Push(p1, q1, capsule.m_radius, p2, q2, capsule.m_radius);
+    }
+    ContactBatch contacts;
+    for (auto _ : state) {
+        CollideCapsuleBatch(batch, contacts, level);
+        benchmark::DoNotOptimize(contacts.m_depth.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_CollideCapsuleBatch)->Apply(SimdLevelArgs);
@@ -0,0 +1,15 @@
+// kernel microbenchmarks, every Google Benchmark flag works, e.g.
+// --benchmark_filter=Pose --benchmark_format=json
+#include "bench_data.hpp"
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::AddCustomContext(
+        "simd", toy_physics::GetSimdLevelName(toy_physics::GetSimdLevel()));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
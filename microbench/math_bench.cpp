@@ -0,0 +1,50 @@
+// math.hpp helpers are Eigen expressions, vectorized at compile time, so
+// they only have the one variant
+#include "bench_data.hpp"
+#include "toy_physics/math.hpp"
+
+static void BM_CreatePersp(benchmark::State& state) {
+    float aspect = 16.0f / 9.0f;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(aspect);
+        Eigen::Matrix4f m = CreatePersp(Radians{1.0f}, aspect, 0.1f, 1000.0f);
+        benchmark::DoNotOptimize(m);
+    }
+}
+BENCHMARK(BM_CreatePersp);
+
+static void BM_LookAt(benchmark::State& state) {
+    auto poses = MakeRandomPoses(InputCount, 100, 1);
+    size_t i = 0;
+    for (auto _ : state) {
+        const Eigen::Vector3f& position = poses[i++ % InputCount].m_position;
+        Eigen::Matrix4f m =
+            LookAt(Eigen::Vector3f::Zero().eval(), position,
+                   Eigen::Vector3f::UnitY().eval());
+        benchmark::DoNotOptimize(m);
+    }
+}
+BENCHMARK(BM_LookAt);
+
+static void BM_CreateXYZRotation(benchmark::State& state) {
+    auto poses = MakeRandomPoses(InputCount, 3, 2);
+    size_t i = 0;
+    for (auto _ : state) {
+        const Eigen::Vector3f& angles = poses[i++ % InputCount].m_position;
+        Eigen::Vector3<Radians> r{Radians{angles.x()}, Radians{angles.y()},
+                                  Radians{angles.z()}};
+        Eigen::Matrix4f m = CreateXYZRotation(r);
+        benchmark::DoNotOptimize(m);
+    }
+}
+BENCHMARK(BM_CreateXYZRotation);
+
+static void BM_CreateScale(benchmark::State& state) {
+    auto poses = MakeRandomPoses(InputCount, 10, 3);
+    size_t i = 0;
+    for (auto _ : state) {
+        Eigen::Matrix4f m = CreateScale(poses[i++ % InputCount].m_position);
+        benchmark::DoNotOptimize(m);
+    }
+}
+BENCHMARK(BM_CreateScale);
@@ -0,0 +1,166 @@
+// scalar Pose methods one pose at a time against the batched kernels of
+// pose_batch.hpp at each simd level
+#include "bench_data.hpp"
+#include "toy_physics/pose_batch.hpp"
+
+using namespace toy_physics;
+
+static PoseBatch MakeBatch(const std::vector<Pose>& poses) {
+    PoseBatch batch;
+    for (const Pose& pose : poses) {
+        batch.Push(pose);
+    }
+    return batch;
+}
+
+static void BM_PoseTransformBy(benchmark::State& state) {
+    auto parents = MakeRandomPoses(InputCount, 100, 1);
+    auto children = MakeRandomPoses(InputCount, 1, 2);
+    std::vector<Pose> out(InputCount);
+    for (auto _ : state) {
+        for (size_t i = 0; i < InputCount; i++) {
+            out[i] = parents[i].TransformBy(children[i]);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_PoseTransformBy);
+
+static void BM_ComposePoses(benchmark::State& state) {
+    SimdLevel level = GetSimdArg(state);
+    PoseBatch parents = MakeBatch(MakeRandomPoses(InputCount, 100, 1));
+    PoseBatch children = MakeBatch(MakeRandomPoses(InputCount, 1, 2));
+    PoseBatch out;
+    out.Resize(InputCount);
+    for (auto _ : state) {
+        ComposePoses(parents, children, out, level);
+        benchmark::DoNotOptimize(out.m_position.m_x.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_ComposePoses)->Apply(SimdLevelArgs);
+
+static void BM_PoseRelativeBy(benchmark::State& state) {
+    auto poses = MakeRandomPoses(InputCount, 100, 1);
+    auto children = MakeRandomPoses(InputCount, 1, 2);
+    std::vector<Pose> out(InputCount);
+    for (auto _ : state) {
+        for (size_t i = 0; i < InputCount; i++) {
+            out[i] = poses[i].RelativeBy(children[i]);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_PoseRelativeBy);
+
+static void BM_RelativePoses(benchmark::State& state) {
+    SimdLevel level = GetSimdArg(state);
+    PoseBatch poses = MakeBatch(MakeRandomPoses(InputCount, 100, 1));
+    PoseBatch children = MakeBatch(MakeRandomPoses(InputCount, 1, 2));
+    PoseBatch out;
+    out.Resize(InputCount);
+    for (auto _ : state) {
+        RelativePoses(poses, children, out, level);
+        benchmark::DoNotOptimize(out.m_position.m_x.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_RelativePoses)->Apply(SimdLevelArgs);
+
+static void BM_PoseInverse(benchmark::State& state) {
+    auto poses = MakeRandomPoses(InputCount, 100, 1);
+    std::vector<Pose> out(InputCount);
+    for (auto _ : state) {
+        for (size_t i = 0; i < InputCount; i++) {
+            out[i] = poses[i].Inverse();
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_PoseInverse);
+
+static void BM_InvertPoses(benchmark::State& state) {
+    SimdLevel level = GetSimdArg(state);
+    PoseBatch poses = MakeBatch(MakeRandomPoses(InputCount, 100, 1));
+    PoseBatch out;
+    out.Resize(InputCount);
+    for (auto _ : state) {
+        InvertPoses(poses, out, level);
+        benchmark::DoNotOptimize(out.m_position.m_x.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_InvertPoses)->Apply(SimdLevelArgs);
+
+static void BM_PoseTransformPoint(benchmark::State& state) {
+    auto poses = MakeRandomPoses(InputCount, 100, 1);
+    auto points = MakeRandomPoses(InputCount, 1, 2);
+    std::vector<Eigen::Vector3f> out(InputCount);
+    for (auto _ : state) {
+        for (size_t i = 0; i < InputCount; i++) {
+            out[i] = poses[i].m_position +
+                     poses[i].m_rotation * points[i].m_position;
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_PoseTransformPoint);
+
+static void BM_TransformPoints(benchmark::State& state) {
+    SimdLevel level = GetSimdArg(state);
+    PoseBatch poses = MakeBatch(MakeRandomPoses(InputCount, 100, 1));
+    Vec3Column points;
+    for (const Pose& pose : MakeRandomPoses(InputCount, 1, 2)) {
+        points.Push(pose.m_position);
+    }
+    Vec3Column out;
+    out.Resize(InputCount);
+    for (auto _ : state) {
+        TransformPoints(poses, points, out, level);
+        benchmark::DoNotOptimize(out.m_x.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_TransformPoints)->Apply(SimdLevelArgs);
+
+static void BM_PoseLerp(benchmark::State& state) {
+    auto from = MakeRandomPoses(InputCount, 100, 1);
+    auto to = MakeRandomPoses(InputCount, 100, 2);
+    std::vector<Pose> out(InputCount);
+    for (auto _ : state) {
+        for (size_t i = 0; i < InputCount; i++) {
+            out[i] = from[i].Lerp(to[i], 0.3f);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_PoseLerp);
+
+static void BM_LerpPoses(benchmark::State& state) {
+    SimdLevel level = GetSimdArg(state);
+    PoseBatch from = MakeBatch(MakeRandomPoses(InputCount, 100, 1));
+    PoseBatch to = MakeBatch(MakeRandomPoses(InputCount, 100, 2));
+    PoseBatch out;
+    out.Resize(InputCount);
+    for (auto _ : state) {
+        LerpPoses(from, to, 0.3f, out, level);
+        benchmark::DoNotOptimize(out.m_position.m_x.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * InputCount);
+}
+BENCHMARK(BM_LerpPoses)->Apply(SimdLevelArgs);
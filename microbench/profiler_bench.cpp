@@ -0,0 +1,40 @@
+// cost of one profiling scope, compiled in with TOY_PHYSICS_PROFILE.
+// Without it the scope benchmarks measure an empty loop. A recorded scope
+// reads the clock twice, a nested one only once with
+// TOY_PHYSICS_PROFILE_ONE_READ. BM_ProfileTicks is the cost of one read
+#include "bench_data.hpp"
+#include "toy_physics/log.hpp"
+
+using namespace toy_physics;
+
+static void BM_ProfileScope(benchmark::State& state) {
+    bool recording = state.range(0) != 0;
+    bool nested = state.range(1) != 0;
+    auto run = [&state] {
+        for (auto _ : state) {
+            PROFILE_SCOPE("BM_ProfileScope");
+            benchmark::ClobberMemory();
+        }
+    };
+    Profiler::SetRecording(recording);
+    if (nested) {
+        PROFILE_SCOPE("BM_ProfileScope parent");
+        run();
+    } else {
+        run();
+    }
+    Profiler::SetRecording(false);
+    Profiler::Clear();
+}
+BENCHMARK(BM_ProfileScope)
+    ->ArgNames({"recording", "nested"})
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({1, 0});
+
+static void BM_ProfileTicks(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ReadProfileTicks());
+    }
+}
+BENCHMARK(BM_ProfileTicks);
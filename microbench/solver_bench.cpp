@@ -0,0 +1,92 @@
+// the contact solver on the manifolds of a settled box pyramid. The variants
+// are iteration counts, the large island mode and the simd level of the
+// colored island kernels, mass splitting is scalar only
+#include "bench_data.hpp"
+#include "toy_physics/world.hpp"
+
+#include <algorithm>
+
+using namespace toy_physics;
+
+// one pyramid of 210 boxes is a single island of about 600 manifolds,
+// large enough to be split
+struct SolverScene {
+    BodyColumns m_bodies;
+    std::vector<ContactManifold> m_manifolds;
+
+    SolverScene() {
+        World world{Broadphase::Type::Tree, 1};
+        Body ground;
+        ground.m_pose.m_position = {0, -1, 0};
+        ground.m_geometry.m_geom = world.GetGeometryPool().Add(
+            BoxGeometry{Eigen::Vector3f{50, 1, 50}});
+        world.CreateBody(ground);
+
+        GeometryHandle box = world.GetGeometryPool().Add(
+            BoxGeometry{Eigen::Vector3f{.5f, .5f, .5f}});
+        for (int row = 0; row < 20; row++) {
+            for (int i = 0; i < 20 - row; i++) {
+                Body body;
+                body.m_inv_mass = 1;
+                body.m_pose.m_position = {(i - (19 - row) * 0.5f) * 1.01f,
+                                          0.5f + row * 1.0f, 0};
+                body.m_geometry.m_geom = box;
+                world.CreateBody(body);
+            }
+        }
+        world.m_allow_sleeping = false;
+        for (int i = 0; i < 30; i++) {
+            world.Step(1.0f / 60.0f);
+        }
+        m_bodies = world.GetBodies();
+        m_manifolds = world.GetManifolds();
+    }
+};
+
+static void BM_SolveContacts(benchmark::State& state) {
+    static const SolverScene scene;
+    ContactSolver solver;
+    solver.m_settings.m_velocity_iterations =
+        static_cast<uint32_t>(state.range(0));
+    solver.m_settings.m_large_island_mode =
+        state.range(1) ? LargeIslandMode::MassSplitting
+                       : LargeIslandMode::Coloring;
+    solver.m_settings.m_simd_level = static_cast<SimdLevel>(state.range(2));
+    JobSystem jobs{1};
+
+    std::vector<Eigen::Vector3f> velocities = scene.m_bodies.m_velocities;
+    std::vector<Eigen::Vector3f> angular_velocities =
+        scene.m_bodies.m_angular_velocities;
+    std::vector<ContactManifold> manifolds = scene.m_manifolds;
+    SolverBodies bodies;
+    bodies.m_positions = scene.m_bodies.m_positions.data();
+    bodies.m_rotations = scene.m_bodies.m_rotations.data();
+    bodies.m_velocities = velocities.data();
+    bodies.m_angular_velocities = angular_velocities.data();
+    bodies.m_inv_masses = scene.m_bodies.m_inv_masses.data();
+    bodies.m_inv_inertias = scene.m_bodies.m_inv_inertias.data();
+    bodies.m_count = static_cast<uint32_t>(scene.m_bodies.m_awake_count);
+
+    for (auto _ : state) {
+        // every run starts from the same warm start impulses, copies into
+        // the existing buffers don't allocate
+        std::copy(scene.m_manifolds.begin(), scene.m_manifolds.end(),
+                  manifolds.begin());
+        std::copy(scene.m_bodies.m_velocities.begin(),
+                  scene.m_bodies.m_velocities.end(), velocities.begin());
+        std::copy(scene.m_bodies.m_angular_velocities.begin(),
+                  scene.m_bodies.m_angular_velocities.end(),
+                  angular_velocities.begin());
+        solver.Solve(bodies, manifolds, 1.0f / 60.0f, jobs);
+        benchmark::DoNotOptimize(velocities.data());
+        benchmark::ClobberMemory();
+    }
+    // constraint updates, one per manifold per iteration
+    state.SetItemsProcessed(state.iterations() * manifolds.size() *
+                            state.range(0));
+    state.counters["manifolds"] = static_cast<double>(manifolds.size());
+}
+BENCHMARK(BM_SolveContacts)
+    ->ArgsProduct({{1, 8}, {0, 1}, {0, 1, 2}})
+    ->ArgNames({"iterations", "mass_splitting", "simd"})
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,61 @@
+#include "toy_physics/aabb.hpp"
+
+#include <cmath>
+
+namespace toy_physics {
+
+AABBCast AABBCast::Make(const Eigen::Vector3f& origin,
+                        const Eigen::Vector3f& delta,
+                        const Eigen::Vector3f& extent) {
+    AABBCast cast;
+    cast.m_origin = origin;
+    cast.m_delta = delta;
+    // a huge finite inverse instead of inf keeps 0 * inv out of NaN when
+    // the origin lies on a slab plane the segment runs parallel to
+    cast.m_inv_delta = delta.unaryExpr([](float d) {
+        return 1.0f / (std::abs(d) < 1e-30f ? 1e-30f : d);
+    });
+    cast.m_extent = extent;
+    return cast;
+}
+
+AABB AABBCast::GetBounds() const {
+    Eigen::Vector3f end = m_origin + m_delta * std::max(m_max_fraction, 0.0f);
+    return {m_origin.cwiseMin(end) - m_extent,
+            m_origin.cwiseMax(end) + m_extent};
+}
+
+AABB ComputeAABB(const BoxGeometry& box, const Pose& pose) {
+    Eigen::Matrix3f abs_rot = pose.m_rotation.toRotationMatrix().cwiseAbs();
+    Eigen::Vector3f extent = abs_rot * box.m_half_size;
+    return {pose.m_position - extent, pose.m_position + extent};
+}
+
+AABB ComputeAABB(const SphereGeometry& sphere, const Pose& pose) {
+    Eigen::Vector3f extent = Eigen::Vector3f::Constant(sphere.m_radius);
+    return {pose.m_position - extent, pose.m_position + extent};
+}
+
+AABB ComputeAABB(const CapsuleGeometry& capsule, const Pose& pose) {
+    // capsule axis is local Y, m_height is the length of the inner segment
+    Eigen::Vector3f axis =
+        pose.m_rotation * Eigen::Vector3f{0, capsule.m_height * 0.5f, 0};
+    Eigen::Vector3f extent =
+        axis.cwiseAbs() + Eigen::Vector3f::Constant(capsule.m_radius);
+    return {pose.m_position - extent, pose.m_position + extent};
+}
+
+AABB ComputeAABB(const Geometry& geom, const Pose& pose) {
+    switch (geom.GetType()) {
+        case Geometry::Type::Box:
+            return ComputeAABB(static_cast<const BoxGeometry&>(geom), pose);
+        case Geometry::Type::Sphere:
+            return ComputeAABB(static_cast<const SphereGeometry&>(geom), pose);
+        case Geometry::Type::Capsule:
+            return ComputeAABB(static_cast<const CapsuleGeometry&>(geom),
+                               pose);
+    }
+    return {pose.m_position, pose.m_position};
+}
+
+}
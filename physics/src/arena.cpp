@@ -0,0 +1,141 @@
+#include "toy_physics/arena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace toy_physics {
+
+FrameArena::FrameArena(size_t block_size) : m_block_size{block_size} {}
+
+FrameArena::~FrameArena() {
+    for (Block& block : m_blocks) {
+        ::operator delete(block.m_data,
+                          std::align_val_t{alignof(std::max_align_t)});
+    }
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+    while (m_current < m_blocks.size()) {
+        Block& block = m_blocks[m_current];
+        size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= block.m_size) {
+            m_offset = offset + size;
+            return block.m_data + offset;
+        }
+        // the tail of this block is wasted
+        m_used += m_offset;
+        m_current++;
+        m_offset = 0;
+    }
+    addBlock(size + alignment);
+    return Allocate(size, alignment);
+}
+
+void FrameArena::Reset() {
+    if (m_blocks.size() > 1) {
+        size_t capacity = GetCapacity();
+        for (Block& block : m_blocks) {
+            ::operator delete(block.m_data,
+                              std::align_val_t{alignof(std::max_align_t)});
+        }
+        m_blocks.clear();
+        addBlock(capacity);
+    }
+    m_current = 0;
+    m_offset = 0;
+    m_used = 0;
+}
+
+size_t FrameArena::GetCapacity() const {
+    size_t capacity = 0;
+    for (const Block& block : m_blocks) {
+        capacity += block.m_size;
+    }
+    return capacity;
+}
+
+void FrameArena::addBlock(size_t min_size) {
+    size_t size = std::max(m_block_size, min_size);
+    auto data = static_cast<std::byte*>(::operator new(
+        size, std::align_val_t{alignof(std::max_align_t)}));
+    m_blocks.push_back({data, size});
+}
+
+static std::atomic<uint64_t> g_tracked_allocations{0};
+static thread_local uint32_t t_allocation_scope_depth = 0;
+
+uint64_t GetTrackedAllocationCount() {
+    return g_tracked_allocations.load(std::memory_order_relaxed);
+}
+
+bool IsAllocationTrackingCompiled() {
+#ifdef TOY_PHYSICS_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool IsInAllocationScope() {
+    return t_allocation_scope_depth != 0;
+}
+
+AllocationScope::AllocationScope() {
+    t_allocation_scope_depth++;
+}
+
+AllocationScope::~AllocationScope() {
+    t_allocation_scope_depth--;
+}
+
+#ifdef TOY_PHYSICS_TRACK_ALLOCATIONS
+static void CountAllocation() {
+    if (t_allocation_scope_depth != 0) {
+        g_tracked_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+#endif
+
+}
+
+// replaces the global allocation functions so allocations inside a scope
+// are counted. Defined here because this unit is always linked in
+#ifdef TOY_PHYSICS_TRACK_ALLOCATIONS
+void* operator new(size_t size) {
+    toy_physics::CountAllocation();
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    toy_physics::CountAllocation();
+    size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+    void* p = _aligned_malloc(size ? size : 1, align);
+#else
+    // aligned_alloc wants the size to be a multiple of the alignment
+    size = (std::max<size_t>(size, 1) + align - 1) & ~(align - 1);
+    void* p = std::aligned_alloc(align, size);
+#endif
+    if (!p) {
+        throw std::bad_alloc{};
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+#endif
@@ -0,0 +1,48 @@
+#include "toy_physics/broadphase.hpp"
+#include "toy_physics/spatial_hash_grid.hpp"
+#include "toy_physics/sweep_and_prune.hpp"
+#include "toy_physics/tree_broadphase.hpp"
+
+namespace toy_physics {
+
+void Broadphase::CastQuery(
+    AABBCast* casts, uint32_t count,
+    const std::function<void(uint32_t, uint32_t)>& callback) const {
+    for (uint32_t i = 0; i < count; i++) {
+        if (casts[i].m_max_fraction < 0) {
+            continue;
+        }
+        // the backend only reports ids, so every proxy in the bounds is
+        // handed on and the caller's exact test does the rest. A single
+        // captured reference keeps std::function off the heap
+        auto visit = [&](uint32_t id) {
+            callback(i, id);
+            return casts[i].m_max_fraction >= 0;
+        };
+        Query(casts[i].GetBounds(),
+              [&visit](uint32_t id) { return visit(id); });
+    }
+}
+
+bool Broadphase::SaveState(std::vector<std::byte>&) const {
+    return false;
+}
+
+bool Broadphase::LoadState(std::span<const std::byte>) {
+    return false;
+}
+
+std::unique_ptr<Broadphase> CreateBroadphase(Broadphase::Type type,
+                                             JobSystem* job_system) {
+    switch (type) {
+        case Broadphase::Type::Tree:
+            return std::make_unique<TreeBroadphase>();
+        case Broadphase::Type::SweepAndPrune:
+            return std::make_unique<SweepAndPrune>();
+        case Broadphase::Type::HashGrid:
+            return std::make_unique<SpatialHashGrid>(job_system);
+    }
+    return nullptr;
+}
+
+}
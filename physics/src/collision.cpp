@@ -0,0 +1,606 @@
+#include "toy_physics/collision.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace toy_physics {
+
+constexpr float Epsilon = 1e-6f;
+
+static Eigen::Vector3f AnyPerpendicular(const Eigen::Vector3f& v) {
+    Eigen::Vector3f axis = std::abs(v.x()) < 0.57735f
+                               ? Eigen::Vector3f::UnitX()
+                               : Eigen::Vector3f::UnitY();
+    Eigen::Vector3f perp = v.cross(axis);
+    float len = perp.norm();
+    return len > Epsilon ? Eigen::Vector3f(perp / len)
+                         : Eigen::Vector3f::UnitZ();
+}
+
+void GetCapsuleSegment(const CapsuleGeometry& capsule, const Pose& pose,
+                       Eigen::Vector3f& p, Eigen::Vector3f& q) {
+    Eigen::Vector3f axis =
+        pose.m_rotation * Eigen::Vector3f{0, capsule.m_height * 0.5f, 0};
+    p = pose.m_position - axis;
+    q = pose.m_position + axis;
+}
+
+// Ericson, Real-Time Collision Detection 5.1.9
+void ClosestPointsSegmentSegment(const Eigen::Vector3f& p1,
+                                 const Eigen::Vector3f& q1,
+                                 const Eigen::Vector3f& p2,
+                                 const Eigen::Vector3f& q2, float& s,
+                                 float& t) {
+    Eigen::Vector3f d1 = q1 - p1;
+    Eigen::Vector3f d2 = q2 - p2;
+    Eigen::Vector3f r = p1 - p2;
+    float a = d1.dot(d1);
+    float e = d2.dot(d2);
+    float f = d2.dot(r);
+
+    if (a <= Epsilon && e <= Epsilon) {
+        s = t = 0;
+        return;
+    }
+    if (a <= Epsilon) {
+        s = 0;
+        t = std::clamp(f / e, 0.0f, 1.0f);
+        return;
+    }
+
+    float c = d1.dot(r);
+    if (e <= Epsilon) {
+        t = 0;
+        s = std::clamp(-c / a, 0.0f, 1.0f);
+        return;
+    }
+
+    float b = d1.dot(d2);
+    float denom = a * e - b * b;
+    s = denom > Epsilon * a * e ? std::clamp((b * f - c * e) / denom, 0.0f, 1.0f)
+                                : 0.0f;
+    t = (b * s + f) / e;
+    if (t < 0) {
+        t = 0;
+        s = std::clamp(-c / a, 0.0f, 1.0f);
+    } else if (t > 1) {
+        t = 1;
+        s = std::clamp((b - c) / a, 0.0f, 1.0f);
+    }
+}
+
+// contact between two spheres given by center and radius, normal from a to b
+static bool CollidePoints(const Eigen::Vector3f& ca, float ra,
+                          const Eigen::Vector3f& cb, float rb, float margin,
+                          const Eigen::Vector3f& fallback_normal,
+                          ContactManifold& manifold) {
+    Eigen::Vector3f d = cb - ca;
+    float dist2 = d.squaredNorm();
+    float radius = ra + rb;
+    if (dist2 > (radius + margin) * (radius + margin)) {
+        return false;
+    }
+
+    float dist = std::sqrt(dist2);
+    Eigen::Vector3f normal =
+        dist > Epsilon ? Eigen::Vector3f(d / dist) : fallback_normal;
+    float depth = radius - dist;
+    manifold.m_normal = normal;
+    manifold.AddPoint(ca + normal * (ra - depth * 0.5f), depth, 0);
+    return true;
+}
+
+bool CollideSphereSphere(const SphereGeometry& a, const Pose& pose_a,
+                         const SphereGeometry& b, const Pose& pose_b,
+                         float margin, ContactManifold& manifold) {
+    return CollidePoints(pose_a.m_position, a.m_radius, pose_b.m_position,
+                         b.m_radius, margin, Eigen::Vector3f::UnitY(),
+                         manifold);
+}
+
+// sphere of given radius at point against the box, outputs normal from box
+// to the point
+static bool BoxPointContact(const BoxGeometry& box, const Pose& pose,
+                            const Eigen::Matrix3f& rot,
+                            const Eigen::Vector3f& point, float radius,
+                            float margin, Eigen::Vector3f& normal,
+                            Eigen::Vector3f& position, float& depth) {
+    const Eigen::Vector3f& h = box.m_half_size;
+    Eigen::Vector3f c = rot.transpose() * (point - pose.m_position);
+    Eigen::Vector3f clamped = c.cwiseMax(-h).cwiseMin(h);
+    Eigen::Vector3f d = c - clamped;
+    float dist2 = d.squaredNorm();
+
+    Eigen::Vector3f n_local;
+    Eigen::Vector3f surface_local;
+    if (dist2 > Epsilon * Epsilon) {
+        float dist = std::sqrt(dist2);
+        if (dist > radius + margin) {
+            return false;
+        }
+        n_local = d / dist;
+        surface_local = clamped;
+        depth = radius - dist;
+    } else {
+        // center inside the box, push out through the closest face
+        Eigen::Vector3f face_dist = h - c.cwiseAbs();
+        int axis;
+        face_dist.minCoeff(&axis);
+        n_local.setZero();
+        n_local[axis] = c[axis] >= 0 ? 1.0f : -1.0f;
+        surface_local = c;
+        surface_local[axis] = n_local[axis] * h[axis];
+        depth = radius + face_dist[axis];
+    }
+
+    normal = rot * n_local;
+    Eigen::Vector3f surface_box = pose.m_position + rot * surface_local;
+    Eigen::Vector3f surface_point = point - normal * radius;
+    position = (surface_box + surface_point) * 0.5f;
+    return true;
+}
+
+bool CollideBoxSphere(const BoxGeometry& a, const Pose& pose_a,
+                      const SphereGeometry& b, const Pose& pose_b,
+                      float margin, ContactManifold& manifold) {
+    Eigen::Matrix3f rot = pose_a.m_rotation.toRotationMatrix();
+    Eigen::Vector3f normal, position;
+    float depth;
+    if (!BoxPointContact(a, pose_a, rot, pose_b.m_position, b.m_radius,
+                         margin, normal, position, depth)) {
+        return false;
+    }
+    manifold.m_normal = normal;
+    manifold.AddPoint(position, depth, 0);
+    return true;
+}
+
+// clip segment pq (world space) to the side planes of the box face along
+// `axis`, and add the parts closer than margin to the face as contacts.
+// normal is the face normal pointing out of the box
+static uint32_t ClipSegmentToBoxFace(const BoxGeometry& box, const Pose& pose,
+                                     const Eigen::Matrix3f& rot, int axis,
+                                     const Eigen::Vector3f& normal,
+                                     const Eigen::Vector3f& p,
+                                     const Eigen::Vector3f& q, float radius,
+                                     float margin, ContactManifold& manifold) {
+    const Eigen::Vector3f& h = box.m_half_size;
+    Eigen::Vector3f pl = rot.transpose() * (p - pose.m_position);
+    Eigen::Vector3f ql = rot.transpose() * (q - pose.m_position);
+    Eigen::Vector3f dl = ql - pl;
+
+    float t0 = 0, t1 = 1;
+    for (int k = 0; k < 3; k++) {
+        if (k == axis) {
+            continue;
+        }
+        if (std::abs(dl[k]) < Epsilon) {
+            if (std::abs(pl[k]) > h[k]) {
+                return 0;
+            }
+            continue;
+        }
+        float ta = (-h[k] - pl[k]) / dl[k];
+        float tb = (h[k] - pl[k]) / dl[k];
+        if (ta > tb) {
+            std::swap(ta, tb);
+        }
+        t0 = std::max(t0, ta);
+        t1 = std::min(t1, tb);
+        if (t0 > t1) {
+            return 0;
+        }
+    }
+
+    float face_offset = normal.dot(pose.m_position) + h[axis];
+    uint32_t count = 0;
+    float params[2] = {t0, t1};
+    for (int i = 0; i < 2; i++) {
+        Eigen::Vector3f e = p + (q - p) * params[i];
+        float separation = normal.dot(e) - face_offset - radius;
+        if (separation <= margin) {
+            manifold.AddPoint(e - normal * (radius + separation * 0.5f),
+                              -separation, axis * 2 + i);
+            count++;
+        }
+    }
+    return count;
+}
+
+bool CollideBoxCapsule(const BoxGeometry& a, const Pose& pose_a,
+                       const CapsuleGeometry& b, const Pose& pose_b,
+                       float margin, ContactManifold& manifold,
+                       SimplexCache* cache) {
+    ConvexContact contact;
+    if (!CollideConvex(MakeConvexProxy(a, pose_a), MakeConvexProxy(b, pose_b),
+                       margin, cache, contact)) {
+        return false;
+    }
+
+    // a capsule resting on a face gets two points from the clipped segment
+    Eigen::Matrix3f rot = pose_a.m_rotation.toRotationMatrix();
+    Eigen::Vector3f n_local = rot.transpose() * contact.m_normal;
+    int axis;
+    n_local.cwiseAbs().maxCoeff(&axis);
+    if (std::abs(n_local[axis]) > 0.99f) {
+        Eigen::Vector3f face_normal =
+            rot.col(axis) * (n_local[axis] > 0 ? 1.0f : -1.0f);
+        Eigen::Vector3f p, q;
+        GetCapsuleSegment(b, pose_b, p, q);
+        Eigen::Vector3f d = (q - p).normalized();
+        if (std::abs(d.dot(face_normal)) < 0.1f) {
+            manifold.m_normal = face_normal;
+            if (ClipSegmentToBoxFace(a, pose_a, rot, axis, face_normal, p, q,
+                                     b.m_radius, margin, manifold) > 0) {
+                return true;
+            }
+        }
+    }
+
+    manifold.m_normal = contact.m_normal;
+    manifold.AddPoint((contact.m_point_a + contact.m_point_b) * 0.5f,
+                      contact.m_depth, 0);
+    return true;
+}
+
+bool CollideSphereCapsule(const SphereGeometry& a, const Pose& pose_a,
+                          const CapsuleGeometry& b, const Pose& pose_b,
+                          float margin, ContactManifold& manifold) {
+    Eigen::Vector3f p, q;
+    GetCapsuleSegment(b, pose_b, p, q);
+    Eigen::Vector3f d = q - p;
+    float len2 = d.squaredNorm();
+    float t = len2 > Epsilon
+                  ? std::clamp((pose_a.m_position - p).dot(d) / len2, 0.0f,
+                               1.0f)
+                  : 0.0f;
+    return CollidePoints(pose_a.m_position, a.m_radius, p + d * t, b.m_radius,
+                         margin, AnyPerpendicular(d), manifold);
+}
+
+bool CollideCapsuleCapsule(const CapsuleGeometry& a, const Pose& pose_a,
+                           const CapsuleGeometry& b, const Pose& pose_b,
+                           float margin, ContactManifold& manifold) {
+    Eigen::Vector3f p1, q1, p2, q2;
+    GetCapsuleSegment(a, pose_a, p1, q1);
+    GetCapsuleSegment(b, pose_b, p2, q2);
+
+    float s, t;
+    ClosestPointsSegmentSegment(p1, q1, p2, q2, s, t);
+    Eigen::Vector3f d1 = q1 - p1;
+    Eigen::Vector3f d2 = q2 - p2;
+    Eigen::Vector3f c1 = p1 + d1 * s;
+    Eigen::Vector3f c2 = p2 + d2 * t;
+    if (!CollidePoints(c1, a.m_radius, c2, b.m_radius, margin,
+                       AnyPerpendicular(d1), manifold)) {
+        return false;
+    }
+
+    // nearly parallel capsules lying on each other get a point at both ends
+    // of the overlapping span
+    float len1 = d1.squaredNorm();
+    float len2 = d2.squaredNorm();
+    if (len1 < Epsilon || len2 < Epsilon ||
+        d1.cross(d2).squaredNorm() > 0.0025f * len1 * len2) {
+        return true;
+    }
+
+    float sp = std::clamp((p2 - p1).dot(d1) / len1, 0.0f, 1.0f);
+    float sq = std::clamp((q2 - p1).dot(d1) / len1, 0.0f, 1.0f);
+    if (std::abs(sp - sq) * std::sqrt(len1) < 0.01f) {
+        return true;
+    }
+
+    Eigen::Vector3f normal = manifold.m_normal;
+    float radius = a.m_radius + b.m_radius;
+    manifold.m_point_count = 0;
+    float params[2] = {sp, sq};
+    for (int i = 0; i < 2; i++) {
+        Eigen::Vector3f x1 = p1 + d1 * params[i];
+        float tt = std::clamp((x1 - p2).dot(d2) / len2, 0.0f, 1.0f);
+        Eigen::Vector3f x2 = p2 + d2 * tt;
+        float depth = radius - normal.dot(x2 - x1);
+        if (depth > -margin) {
+            manifold.AddPoint(x1 + normal * (a.m_radius - depth * 0.5f), depth,
+                              i + 1);
+        }
+    }
+    if (manifold.m_point_count == 0) {
+        return false;
+    }
+    return true;
+}
+
+// projection radius of a box onto a unit axis
+static float ProjectBox(const Eigen::Matrix3f& rot, const Eigen::Vector3f& h,
+                        const Eigen::Vector3f& axis) {
+    return h.x() * std::abs(rot.col(0).dot(axis)) +
+           h.y() * std::abs(rot.col(1).dot(axis)) +
+           h.z() * std::abs(rot.col(2).dot(axis));
+}
+
+struct ClipVertex {
+    Eigen::Vector3f m_position;
+    uint32_t m_id;
+};
+
+// Sutherland-Hodgman against plane n.x <= offset
+static int ClipPolygon(const ClipVertex* in, int count,
+                       const Eigen::Vector3f& n, float offset,
+                       uint32_t plane_id, ClipVertex* out) {
+    int out_count = 0;
+    for (int i = 0; i < count; i++) {
+        const ClipVertex& v1 = in[i];
+        const ClipVertex& v2 = in[(i + 1) % count];
+        float d1 = n.dot(v1.m_position) - offset;
+        float d2 = n.dot(v2.m_position) - offset;
+        if (d1 <= 0) {
+            out[out_count++] = v1;
+        }
+        if ((d1 <= 0) != (d2 <= 0)) {
+            float t = d1 / (d1 - d2);
+            out[out_count++] = {
+                v1.m_position + (v2.m_position - v1.m_position) * t,
+                0x80u | (plane_id << 2) | (v1.m_id & 0x3u)};
+        }
+    }
+    return out_count;
+}
+
+// keep the deepest point plus the three points spanning the largest area
+static void ReduceContacts(const Eigen::Vector3f& normal,
+                           const ContactPoint* points, int count,
+                           ContactManifold& manifold) {
+    if (count <= static_cast<int>(ContactManifold::MaxPoints)) {
+        for (int i = 0; i < count; i++) {
+            manifold.AddPoint(points[i].m_position, points[i].m_depth,
+                              points[i].m_feature);
+        }
+        return;
+    }
+
+    int i0 = 0;
+    for (int i = 1; i < count; i++) {
+        if (points[i].m_depth > points[i0].m_depth) {
+            i0 = i;
+        }
+    }
+    const Eigen::Vector3f& p0 = points[i0].m_position;
+
+    int i1 = -1;
+    float best = -1;
+    for (int i = 0; i < count; i++) {
+        float dist = (points[i].m_position - p0).squaredNorm();
+        if (i != i0 && dist > best) {
+            best = dist;
+            i1 = i;
+        }
+    }
+    const Eigen::Vector3f& p1 = points[i1].m_position;
+
+    int i2 = -1, i3 = -1;
+    float max_area = 0, min_area = 0;
+    for (int i = 0; i < count; i++) {
+        if (i == i0 || i == i1) {
+            continue;
+        }
+        float area = normal.dot((p1 - p0).cross(points[i].m_position - p0));
+        if (area > max_area) {
+            max_area = area;
+            i2 = i;
+        }
+        if (area < min_area) {
+            min_area = area;
+            i3 = i;
+        }
+    }
+
+    for (int i : {i0, i1, i2, i3}) {
+        if (i >= 0) {
+            manifold.AddPoint(points[i].m_position, points[i].m_depth,
+                              points[i].m_feature);
+        }
+    }
+}
+
+// reference face of box 1 against incident face of box 2. flip is true when
+// box 1 is B of the pair
+static bool BoxFaceContact(const Eigen::Vector3f& pos1,
+                           const Eigen::Matrix3f& rot1,
+                           const Eigen::Vector3f& h1,
+                           const Eigen::Vector3f& pos2,
+                           const Eigen::Matrix3f& rot2,
+                           const Eigen::Vector3f& h2, int axis, bool flip,
+                           float margin, ContactManifold& manifold) {
+    Eigen::Vector3f n = rot1.col(axis);
+    if (n.dot(pos2 - pos1) < 0) {
+        n = -n;
+    }
+
+    // incident face is the face of box 2 most anti-parallel to n
+    Eigen::Vector3f n_inc = rot2.transpose() * n;
+    int inc_axis;
+    n_inc.cwiseAbs().maxCoeff(&inc_axis);
+    float inc_sign = n_inc[inc_axis] > 0 ? -1.0f : 1.0f;
+    Eigen::Vector3f center =
+        pos2 + rot2.col(inc_axis) * (inc_sign * h2[inc_axis]);
+    int u = (inc_axis + 1) % 3;
+    int v = (inc_axis + 2) % 3;
+    Eigen::Vector3f eu = rot2.col(u) * h2[u];
+    Eigen::Vector3f ev = rot2.col(v) * h2[v];
+
+    ClipVertex buffer1[8] = {
+        {center + eu + ev, 0},
+        {center - eu + ev, 1},
+        {center - eu - ev, 2},
+        {center + eu - ev, 3},
+    };
+    ClipVertex buffer2[8];
+    ClipVertex* in = buffer1;
+    ClipVertex* out = buffer2;
+    int count = 4;
+
+    int ru = (axis + 1) % 3;
+    int rv = (axis + 2) % 3;
+    uint32_t plane_id = 0;
+    for (int side : {ru, rv}) {
+        Eigen::Vector3f side_n = rot1.col(side);
+        float offset = side_n.dot(pos1);
+        count = ClipPolygon(in, count, side_n, offset + h1[side], plane_id++,
+                            out);
+        std::swap(in, out);
+        count = ClipPolygon(in, count, -side_n, -offset + h1[side],
+                            plane_id++, out);
+        std::swap(in, out);
+        if (count == 0) {
+            return false;
+        }
+    }
+
+    uint32_t feature_base = (flip ? 1u << 15 : 0u) | (uint32_t(axis) << 12) |
+                            (uint32_t(inc_axis) << 10) |
+                            (inc_sign > 0 ? 1u << 9 : 0u);
+    float face_offset = n.dot(pos1) + h1[axis];
+    ContactPoint points[8];
+    int point_count = 0;
+    for (int i = 0; i < count; i++) {
+        float separation = n.dot(in[i].m_position) - face_offset;
+        if (separation <= margin) {
+            points[point_count++] = {
+                in[i].m_position - n * (separation * 0.5f), -separation,
+                feature_base | in[i].m_id};
+        }
+    }
+    if (point_count == 0) {
+        return false;
+    }
+
+    manifold.m_normal = flip ? Eigen::Vector3f(-n) : n;
+    ReduceContacts(n, points, point_count, manifold);
+    return true;
+}
+
+bool CollideBoxBox(const BoxGeometry& a, const Pose& pose_a,
+                   const BoxGeometry& b, const Pose& pose_b, float margin,
+                   ContactManifold& manifold) {
+    Eigen::Matrix3f rot_a = pose_a.m_rotation.toRotationMatrix();
+    Eigen::Matrix3f rot_b = pose_b.m_rotation.toRotationMatrix();
+    const Eigen::Vector3f& ha = a.m_half_size;
+    const Eigen::Vector3f& hb = b.m_half_size;
+    Eigen::Vector3f d = pose_b.m_position - pose_a.m_position;
+
+    float face_a_sep = -std::numeric_limits<float>::max();
+    int face_a = 0;
+    for (int i = 0; i < 3; i++) {
+        Eigen::Vector3f axis = rot_a.col(i);
+        float separation =
+            std::abs(d.dot(axis)) - ha[i] - ProjectBox(rot_b, hb, axis);
+        if (separation > margin) {
+            return false;
+        }
+        if (separation > face_a_sep) {
+            face_a_sep = separation;
+            face_a = i;
+        }
+    }
+
+    float face_b_sep = -std::numeric_limits<float>::max();
+    int face_b = 0;
+    for (int i = 0; i < 3; i++) {
+        Eigen::Vector3f axis = rot_b.col(i);
+        float separation =
+            std::abs(d.dot(axis)) - hb[i] - ProjectBox(rot_a, ha, axis);
+        if (separation > margin) {
+            return false;
+        }
+        if (separation > face_b_sep) {
+            face_b_sep = separation;
+            face_b = i;
+        }
+    }
+
+    float edge_sep = -std::numeric_limits<float>::max();
+    int edge_a = 0, edge_b = 0;
+    Eigen::Vector3f edge_axis = Eigen::Vector3f::UnitX();
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            Eigen::Vector3f axis = rot_a.col(i).cross(rot_b.col(j));
+            float len = axis.norm();
+            if (len < 1e-4f) {
+                continue;
+            }
+            axis /= len;
+            float separation = std::abs(d.dot(axis)) -
+                               ProjectBox(rot_a, ha, axis) -
+                               ProjectBox(rot_b, hb, axis);
+            if (separation > margin) {
+                return false;
+            }
+            if (separation > edge_sep) {
+                edge_sep = separation;
+                edge_a = i;
+                edge_b = j;
+                edge_axis = axis;
+            }
+        }
+    }
+
+    // prefer face contacts, they give stable multi point manifolds
+    constexpr float RelativeTolerance = 0.98f;
+    constexpr float AbsoluteTolerance = 0.001f;
+    bool use_b = face_b_sep > RelativeTolerance * face_a_sep + AbsoluteTolerance;
+    float face_sep = use_b ? face_b_sep : face_a_sep;
+
+    if (edge_sep > RelativeTolerance * face_sep + AbsoluteTolerance * 5) {
+        Eigen::Vector3f n = edge_axis.dot(d) < 0 ? Eigen::Vector3f(-edge_axis)
+                                                 : edge_axis;
+        Eigen::Vector3f center_a = pose_a.m_position;
+        Eigen::Vector3f center_b = pose_b.m_position;
+        for (int k = 0; k < 3; k++) {
+            if (k != edge_a) {
+                center_a += rot_a.col(k) *
+                            (rot_a.col(k).dot(n) > 0 ? ha[k] : -ha[k]);
+            }
+            if (k != edge_b) {
+                center_b += rot_b.col(k) *
+                            (rot_b.col(k).dot(n) > 0 ? -hb[k] : hb[k]);
+            }
+        }
+        Eigen::Vector3f dir_a = rot_a.col(edge_a) * ha[edge_a];
+        Eigen::Vector3f dir_b = rot_b.col(edge_b) * hb[edge_b];
+        float s, t;
+        ClosestPointsSegmentSegment(center_a - dir_a, center_a + dir_a,
+                                    center_b - dir_b, center_b + dir_b, s, t);
+        Eigen::Vector3f pa = center_a - dir_a + dir_a * (2.0f * s);
+        Eigen::Vector3f pb = center_b - dir_b + dir_b * (2.0f * t);
+        manifold.m_normal = n;
+        manifold.AddPoint((pa + pb) * 0.5f, -edge_sep,
+                          0x10000u | uint32_t(edge_a * 3 + edge_b));
+        return true;
+    }
+
+    if (use_b) {
+        return BoxFaceContact(pose_b.m_position, rot_b, hb, pose_a.m_position,
+                              rot_a, ha, face_b, true, margin, manifold);
+    }
+    return BoxFaceContact(pose_a.m_position, rot_a, ha, pose_b.m_position,
+                          rot_b, hb, face_a, false, margin, manifold);
+}
+
+
+bool CollideConvexShapes(const Geometry& a, const Pose& pose_a,
+                         const Geometry& b, const Pose& pose_b, float margin,
+                         ContactManifold& manifold, SimplexCache* cache) {
+    ConvexContact contact;
+    if (!CollideConvex(MakeConvexProxy(a, pose_a), MakeConvexProxy(b, pose_b),
+                       margin, cache, contact)) {
+        return false;
+    }
+    manifold.m_normal = contact.m_normal;
+    manifold.AddPoint((contact.m_point_a + contact.m_point_b) * 0.5f,
+                      contact.m_depth, 0);
+    return true;
+}
+
+}
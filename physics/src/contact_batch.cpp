@@ -0,0 +1,89 @@
+#include "toy_physics/contact_batch.hpp"
+#include "contact_batch_kernel.hpp"
+
+#include <algorithm>
+
+namespace toy_physics {
+
+void SpherePairBatch::Clear() {
+    m_center_a.Clear();
+    m_center_b.Clear();
+    m_radius_a.clear();
+    m_radius_b.clear();
+}
+
+void SpherePairBatch::Push(const Eigen::Vector3f& center_a, float radius_a,
+                           const Eigen::Vector3f& center_b, float radius_b) {
+    m_center_a.Push(center_a);
+    m_center_b.Push(center_b);
+    m_radius_a.push_back(radius_a);
+    m_radius_b.push_back(radius_b);
+}
+
+void CapsulePairBatch::Clear() {
+    m_p1.Clear();
+    m_q1.Clear();
+    m_p2.Clear();
+    m_q2.Clear();
+    m_radius_a.clear();
+    m_radius_b.clear();
+}
+
+void CapsulePairBatch::Push(const Eigen::Vector3f& p1,
+                            const Eigen::Vector3f& q1, float radius_a,
+                            const Eigen::Vector3f& p2,
+                            const Eigen::Vector3f& q2, float radius_b) {
+    m_p1.Push(p1);
+    m_q1.Push(q1);
+    m_p2.Push(p2);
+    m_q2.Push(q2);
+    m_radius_a.push_back(radius_a);
+    m_radius_b.push_back(radius_b);
+}
+
+void ContactBatch::Resize(size_t count) {
+    m_normal.Resize(count);
+    m_position.Resize(count);
+    m_depth.resize(count);
+}
+
+void CollideSphereBatch(const SpherePairBatch& batch, ContactBatch& contacts,
+                        SimdLevel level) {
+    level = std::min(level, GetSimdLevel());
+    contacts.Resize(batch.Size());
+
+    // wide paths leave the tail to the narrower ones
+    size_t i = 0;
+#ifdef TOY_PHYSICS_X86
+    if (level == SimdLevel::AVX2) {
+        i = CollideSphereBatchAVX2(batch, contacts);
+    }
+#endif
+#ifdef TOY_PHYSICS_SSE2
+    if (level >= SimdLevel::SSE2) {
+        i = CollideSphereLanes<Float4>(batch, contacts, i);
+    }
+#endif
+    CollideSphereLanes<Float1>(batch, contacts, i);
+}
+
+void CollideCapsuleBatch(const CapsulePairBatch& batch,
+                         ContactBatch& contacts, SimdLevel level) {
+    level = std::min(level, GetSimdLevel());
+    contacts.Resize(batch.Size());
+
+    size_t i = 0;
+#ifdef TOY_PHYSICS_X86
+    if (level == SimdLevel::AVX2) {
+        i = CollideCapsuleBatchAVX2(batch, contacts);
+    }
+#endif
+#ifdef TOY_PHYSICS_SSE2
+    if (level >= SimdLevel::SSE2) {
+        i = CollideCapsuleLanes<Float4>(batch, contacts, i);
+    }
+#endif
+    CollideCapsuleLanes<Float1>(batch, contacts, i);
+}
+
+}
@@ -0,0 +1,26 @@
+// built with AVX2 enabled, only called after the runtime cpu check
+#include "toy_physics/simd.hpp"
+
+#ifdef TOY_PHYSICS_X86
+
+#ifndef __AVX2__
+#error "contact_batch_avx2.cpp must be compiled with AVX2 enabled"
+#endif
+
+#include "contact_batch_kernel.hpp"
+
+namespace toy_physics {
+
+size_t CollideSphereBatchAVX2(const SpherePairBatch& batch,
+                              ContactBatch& contacts) {
+    return CollideSphereLanes<Float8>(batch, contacts, 0);
+}
+
+size_t CollideCapsuleBatchAVX2(const CapsulePairBatch& batch,
+                               ContactBatch& contacts) {
+    return CollideCapsuleLanes<Float8>(batch, contacts, 0);
+}
+
+}
+
+#endif
@@ -0,0 +1,110 @@
+#pragma once
+#include "toy_physics/contact_batch.hpp"
+#include "simd_lanes.hpp"
+
+// lane generic contact kernels shared by the scalar, SSE2 and AVX2
+// translation units, see simd_lanes.hpp
+
+namespace toy_physics {
+
+#ifdef TOY_PHYSICS_X86
+size_t CollideSphereBatchAVX2(const SpherePairBatch& batch,
+                              ContactBatch& contacts);
+size_t CollideCapsuleBatchAVX2(const CapsulePairBatch& batch,
+                               ContactBatch& contacts);
+#endif
+
+namespace {
+
+constexpr float BatchEpsilon = 1e-6f;
+
+// contact between spheres (ca, ra) and (cb, rb)
+template <typename F>
+void StoreSphereContact(const Vec3Lanes<F>& ca, F ra, const Vec3Lanes<F>& cb,
+                        F rb, ContactBatch& contacts, size_t i) {
+    Vec3Lanes<F> d = cb - ca;
+    F dist = Sqrt(d.Dot(d));
+    F depth = (ra + rb) - dist;
+    auto valid = dist > F(BatchEpsilon);
+    F inv_dist = F(1.0f) / Select(valid, dist, F(1.0f));
+    Vec3Lanes<F> normal{Select(valid, d.m_x * inv_dist, F(0.0f)),
+                        Select(valid, d.m_y * inv_dist, F(1.0f)),
+                        Select(valid, d.m_z * inv_dist, F(0.0f))};
+    Vec3Lanes<F> position = ca + normal * (ra - depth * F(0.5f));
+
+    normal.Store(contacts.m_normal, i);
+    position.Store(contacts.m_position, i);
+    depth.Store(&contacts.m_depth[i]);
+}
+
+template <typename F>
+size_t CollideSphereLanes(const SpherePairBatch& batch,
+                          ContactBatch& contacts, size_t begin) {
+    size_t count = batch.Size();
+    size_t i = begin;
+    for (; i + F::Width <= count; i += F::Width) {
+        StoreSphereContact(Vec3Lanes<F>::Load(batch.m_center_a, i),
+                           F::Load(&batch.m_radius_a[i]),
+                           Vec3Lanes<F>::Load(batch.m_center_b, i),
+                           F::Load(&batch.m_radius_b[i]), contacts, i);
+    }
+    return i;
+}
+
+// Ericson's segment closest points with every branch turned into a select
+template <typename F>
+void ClosestPointsSegmentLanes(const Vec3Lanes<F>& p1,
+                               const Vec3Lanes<F>& d1,
+                               const Vec3Lanes<F>& p2,
+                               const Vec3Lanes<F>& d2, F& s, F& t) {
+    Vec3Lanes<F> r = p1 - p2;
+    F a = d1.Dot(d1);
+    F e = d2.Dot(d2);
+    F f = d2.Dot(r);
+    F c = d1.Dot(r);
+    F b = d1.Dot(d2);
+    F denom = a * e - b * b;
+
+    F epsilon(BatchEpsilon);
+    auto a_degenerate = a <= epsilon;
+    auto e_degenerate = e <= epsilon;
+    auto not_parallel = denom > epsilon * a * e;
+    F a_safe = Select(a_degenerate, F(1.0f), a);
+    F e_safe = Select(e_degenerate, F(1.0f), e);
+    F denom_safe = Select(not_parallel, denom, F(1.0f));
+
+    s = Select(not_parallel, Clamp01((b * f - c * e) / denom_safe), F(0.0f));
+    F t_unclamped = (b * s + f) / e_safe;
+    t = Clamp01(t_unclamped);
+    s = Select(Or(t_unclamped < F(0.0f), t_unclamped > F(1.0f)),
+               Clamp01((b * t - c) / a_safe), s);
+
+    s = Select(e_degenerate, Clamp01((F(0.0f) - c) / a_safe), s);
+    t = Select(e_degenerate, F(0.0f), t);
+    t = Select(a_degenerate, Clamp01(f / e_safe), t);
+    s = Select(a_degenerate, F(0.0f), s);
+    t = Select(And(a_degenerate, e_degenerate), F(0.0f), t);
+}
+
+template <typename F>
+size_t CollideCapsuleLanes(const CapsulePairBatch& batch,
+                           ContactBatch& contacts, size_t begin) {
+    size_t count = batch.Size();
+    size_t i = begin;
+    for (; i + F::Width <= count; i += F::Width) {
+        Vec3Lanes<F> p1 = Vec3Lanes<F>::Load(batch.m_p1, i);
+        Vec3Lanes<F> d1 = Vec3Lanes<F>::Load(batch.m_q1, i) - p1;
+        Vec3Lanes<F> p2 = Vec3Lanes<F>::Load(batch.m_p2, i);
+        Vec3Lanes<F> d2 = Vec3Lanes<F>::Load(batch.m_q2, i) - p2;
+        F s(0.0f), t(0.0f);
+        ClosestPointsSegmentLanes(p1, d1, p2, d2, s, t);
+        StoreSphereContact(p1 + d1 * s, F::Load(&batch.m_radius_a[i]),
+                           p2 + d2 * t, F::Load(&batch.m_radius_b[i]),
+                           contacts, i);
+    }
+    return i;
+}
+
+}
+
+}
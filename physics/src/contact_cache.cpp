@@ -0,0 +1,173 @@
+#include "toy_physics/contact_cache.hpp"
+
+#include <algorithm>
+
+namespace toy_physics {
+
+ContactCacheEntry& ContactCache::Touch(uint32_t id_a, uint32_t id_b) {
+    ContactCacheEntry& entry =
+        m_entries.Insert(PairMap<ContactCacheEntry>::MakeKey(id_a, id_b));
+    entry.m_touched_step = m_step;
+    return entry;
+}
+
+ContactCacheEntry* ContactCache::Find(uint32_t id_a, uint32_t id_b) {
+    return m_entries.Find(PairMap<ContactCacheEntry>::MakeKey(id_a, id_b));
+}
+
+void ContactCache::WarmStart(uint32_t id_a, uint32_t id_b,
+                             ContactManifold& manifold) {
+    ContactCacheEntry& entry = Touch(id_a, id_b);
+    if (entry.m_manifold_step + 1 == m_step) {
+        const ContactManifold& old = entry.m_manifold;
+        uint32_t used = 0;
+        float max_dist2 = m_match_distance * m_match_distance;
+        for (uint32_t i = 0; i < manifold.m_point_count; i++) {
+            ContactPoint& point = manifold.m_points[i];
+            int match = -1;
+            for (uint32_t j = 0; j < old.m_point_count; j++) {
+                if (!(used & (1u << j)) &&
+                    old.m_points[j].m_feature == point.m_feature) {
+                    match = static_cast<int>(j);
+                    break;
+                }
+            }
+            if (match < 0) {
+                float best = max_dist2;
+                for (uint32_t j = 0; j < old.m_point_count; j++) {
+                    float dist2 = (old.m_points[j].m_position -
+                                   point.m_position)
+                                      .squaredNorm();
+                    if (!(used & (1u << j)) && dist2 <= best) {
+                        best = dist2;
+                        match = static_cast<int>(j);
+                    }
+                }
+            }
+            if (match >= 0) {
+                used |= 1u << match;
+                point.m_normal_impulse = old.m_points[match].m_normal_impulse;
+                point.m_tangent_impulse =
+                    old.m_points[match].m_tangent_impulse;
+            }
+        }
+    }
+
+    entry.m_manifold = manifold;
+    entry.m_manifold_step = m_step;
+}
+
+void ContactCache::StoreImpulses(uint32_t id_a, uint32_t id_b,
+                                 const ContactManifold& manifold) {
+    ContactCacheEntry* entry =
+        m_entries.Find(PairMap<ContactCacheEntry>::MakeKey(id_a, id_b));
+    if (!entry || entry->m_manifold_step != m_step) {
+        return;
+    }
+    for (uint32_t i = 0; i < manifold.m_point_count; i++) {
+        entry->m_manifold.m_points[i].m_normal_impulse =
+            manifold.m_points[i].m_normal_impulse;
+        entry->m_manifold.m_points[i].m_tangent_impulse =
+            manifold.m_points[i].m_tangent_impulse;
+    }
+}
+
+void ContactCache::ShiftOrigin(const Eigen::Vector3f& offset) {
+    m_entries.ForEach([&offset](uint64_t, ContactCacheEntry& entry) {
+        ContactManifold& manifold = entry.m_manifold;
+        for (uint32_t i = 0; i < manifold.m_point_count; i++) {
+            manifold.m_points[i].m_position += offset;
+        }
+    });
+}
+
+void ContactCache::Save(std::vector<ContactCacheRecord>& records) const {
+    records.clear();
+    records.reserve(m_entries.Size());
+    m_entries.ForEach([&](uint64_t key, const ContactCacheEntry& entry) {
+        if (!isRemoved(key)) {
+            records.push_back({key, entry});
+        }
+    });
+}
+
+void ContactCache::Load(const ContactCacheRecord* records, size_t count,
+                        uint32_t step) {
+    m_entries.Clear();
+    std::fill(m_removed.begin(), m_removed.end(), 0);
+    m_removed_count = 0;
+    std::fill(m_resting.begin(), m_resting.end(), 0);
+    m_entries.Reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        m_entries.Insert(records[i].m_key) = records[i].m_entry;
+    }
+    m_step = step;
+}
+
+void ContactCache::RemoveId(uint32_t id) {
+    if (id >= m_removed.size()) {
+        m_removed.resize(id + 1);
+    }
+    m_removed_count += m_removed[id] == 0;
+    m_removed[id] = 1;
+    if (id < m_resting.size()) {
+        m_resting[id] = 0;
+    }
+}
+
+void ContactCache::SetResting(uint32_t id, bool resting) {
+    if (id >= m_resting.size()) {
+        if (!resting) {
+            return;
+        }
+        m_resting.resize(id + 1);
+    }
+    m_resting[id] = resting;
+}
+
+bool ContactCache::isRemoved(uint64_t key) const {
+    if (m_removed_count == 0) {
+        return false;
+    }
+    uint64_t a = key >> 32;
+    uint64_t b = key & UINT32_MAX;
+    return (a < m_removed.size() && m_removed[a]) ||
+           (b < m_removed.size() && m_removed[b]);
+}
+
+bool ContactCache::isResting(uint64_t key) const {
+    uint64_t a = key >> 32;
+    uint64_t b = key & UINT32_MAX;
+    return a < m_resting.size() && m_resting[a] && b < m_resting.size() &&
+           m_resting[b];
+}
+
+void ContactCache::BeginStep() {
+    uint32_t step = m_step;
+    m_entries.EraseIf([this, step](uint64_t key, ContactCacheEntry& entry) {
+        if (isRemoved(key)) {
+            return true;
+        }
+        if (entry.m_touched_step == step) {
+            return false;
+        }
+        if (!isResting(key)) {
+            return true;
+        }
+        // neither shape moved, the pair counts as touched in the coming
+        // step, and a manifold it had as solved in it. Either survives the
+        // step the pair wakes in
+        if (entry.m_manifold_step == entry.m_touched_step) {
+            entry.m_manifold_step = step + 1;
+        }
+        entry.m_touched_step = step + 1;
+        return false;
+    });
+    if (m_removed_count != 0) {
+        std::fill(m_removed.begin(), m_removed.end(), 0);
+        m_removed_count = 0;
+    }
+    m_step++;
+}
+
+}
@@ -0,0 +1,349 @@
+#include "toy_physics/dynamic_aabb_tree.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace toy_physics {
+
+uint32_t DynamicAABBTree::CreateProxy(const AABB& aabb, uint32_t user_data) {
+    uint32_t proxy = allocateNode();
+    Node& node = m_nodes[proxy];
+    node.m_aabb = makeFatAABB(aabb, Eigen::Vector3f::Zero());
+    node.m_user_data = user_data;
+    node.m_height = 0;
+    insertLeaf(proxy);
+    m_proxy_count++;
+    return proxy;
+}
+
+void DynamicAABBTree::DestroyProxy(uint32_t proxy) {
+    removeLeaf(proxy);
+    freeNode(proxy);
+    m_proxy_count--;
+}
+
+bool DynamicAABBTree::MoveProxy(uint32_t proxy, const AABB& aabb,
+                                const Eigen::Vector3f& displacement) {
+    const AABB& fat = m_nodes[proxy].m_aabb;
+    if (fat.Contains(aabb)) {
+        // a fat AABB much larger than the body would keep producing
+        // useless pairs, so shrink it once the body slowed down
+        AABB huge = makeFatAABB(aabb, displacement).Expand(m_margin * 4.0f);
+        if (huge.Contains(fat)) {
+            return false;
+        }
+    }
+
+    removeLeaf(proxy);
+    m_nodes[proxy].m_aabb = makeFatAABB(aabb, displacement);
+    insertLeaf(proxy);
+    return true;
+}
+
+void DynamicAABBTree::ShiftOrigin(const Eigen::Vector3f& offset) {
+    for (Node& node : m_nodes) {
+        node.m_aabb = node.m_aabb.Translate(offset);
+    }
+}
+
+bool DynamicAABBTree::Restore(std::vector<Node> nodes, uint32_t root,
+                              uint32_t free_list, size_t proxy_count) {
+    // every node is reached exactly once, from the root through matching
+    // parent links or through the free list
+    size_t count = nodes.size();
+    std::vector<uint8_t> seen(count, 0);
+    std::vector<uint32_t> order;
+    size_t leaf_count = 0;
+    if (root != NullNode) {
+        if (root >= count || nodes[root].m_parent != NullNode) {
+            return false;
+        }
+        seen[root] = 1;
+        order.push_back(root);
+        for (size_t i = 0; i < order.size(); i++) {
+            uint32_t index = order[i];
+            const Node& node = nodes[index];
+            if (node.IsLeaf()) {
+                if (node.m_child2 != NullNode || node.m_height != 0) {
+                    return false;
+                }
+                leaf_count++;
+                continue;
+            }
+            for (uint32_t child : {node.m_child1, node.m_child2}) {
+                if (child >= count || seen[child] ||
+                    nodes[child].m_parent != index) {
+                    return false;
+                }
+                seen[child] = 1;
+                order.push_back(child);
+            }
+        }
+    }
+    for (uint32_t index = free_list; index != NullNode;
+         index = nodes[index].m_parent) {
+        if (index >= count || seen[index] || nodes[index].m_height != -1) {
+            return false;
+        }
+        seen[index] = 1;
+    }
+    if (leaf_count != proxy_count ||
+        std::find(seen.begin(), seen.end(), 0) != seen.end()) {
+        return false;
+    }
+    // balancing trusts the heights, children come after their parent
+    for (size_t i = order.size(); i-- > 0;) {
+        const Node& node = nodes[order[i]];
+        if (!node.IsLeaf() &&
+            node.m_height != 1 + std::max(nodes[node.m_child1].m_height,
+                                          nodes[node.m_child2].m_height)) {
+            return false;
+        }
+    }
+
+    m_nodes = std::move(nodes);
+    m_root = root;
+    m_free_list = free_list;
+    m_proxy_count = proxy_count;
+    return true;
+}
+
+int32_t DynamicAABBTree::GetHeight() const {
+    return m_root == NullNode ? 0 : m_nodes[m_root].m_height;
+}
+
+AABB DynamicAABBTree::makeFatAABB(const AABB& aabb,
+                                  const Eigen::Vector3f& displacement) const {
+    AABB fat = aabb.Expand(m_margin);
+    Eigen::Vector3f d = displacement * m_displacement_multiplier;
+    fat.m_min += d.cwiseMin(0.0f);
+    fat.m_max += d.cwiseMax(0.0f);
+    return fat;
+}
+
+uint32_t DynamicAABBTree::allocateNode() {
+    if (m_free_list == NullNode) {
+        m_nodes.emplace_back();
+        return static_cast<uint32_t>(m_nodes.size() - 1);
+    }
+
+    uint32_t index = m_free_list;
+    m_free_list = m_nodes[index].m_parent;
+    m_nodes[index] = Node{};
+    return index;
+}
+
+void DynamicAABBTree::freeNode(uint32_t node) {
+    m_nodes[node].m_parent = m_free_list;
+    m_nodes[node].m_height = -1;
+    m_free_list = node;
+}
+
+void DynamicAABBTree::insertLeaf(uint32_t leaf) {
+    if (m_root == NullNode) {
+        m_root = leaf;
+        m_nodes[leaf].m_parent = NullNode;
+        return;
+    }
+
+    // descend by the surface area heuristic to find the best sibling
+    AABB leaf_aabb = m_nodes[leaf].m_aabb;
+    uint32_t index = m_root;
+    while (!m_nodes[index].IsLeaf()) {
+        const Node& node = m_nodes[index];
+        float area = node.m_aabb.SurfaceArea();
+        float combined_area = node.m_aabb.Union(leaf_aabb).SurfaceArea();
+
+        // cost of creating a new parent for this node and the new leaf
+        float cost = 2.0f * combined_area;
+        // minimum cost of pushing the leaf further down the tree
+        float inheritance_cost = 2.0f * (combined_area - area);
+
+        auto descend_cost = [&](uint32_t child) {
+            const Node& c = m_nodes[child];
+            float new_area = leaf_aabb.Union(c.m_aabb).SurfaceArea();
+            if (c.IsLeaf()) {
+                return new_area + inheritance_cost;
+            }
+            return new_area - c.m_aabb.SurfaceArea() + inheritance_cost;
+        };
+
+        float cost1 = descend_cost(node.m_child1);
+        float cost2 = descend_cost(node.m_child2);
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+        index = cost1 < cost2 ? node.m_child1 : node.m_child2;
+    }
+
+    uint32_t sibling = index;
+    uint32_t old_parent = m_nodes[sibling].m_parent;
+    uint32_t new_parent = allocateNode();
+    m_nodes[new_parent].m_parent = old_parent;
+    m_nodes[new_parent].m_aabb = leaf_aabb.Union(m_nodes[sibling].m_aabb);
+    m_nodes[new_parent].m_height = m_nodes[sibling].m_height + 1;
+    m_nodes[new_parent].m_child1 = sibling;
+    m_nodes[new_parent].m_child2 = leaf;
+    m_nodes[sibling].m_parent = new_parent;
+    m_nodes[leaf].m_parent = new_parent;
+
+    if (old_parent != NullNode) {
+        Node& parent = m_nodes[old_parent];
+        if (parent.m_child1 == sibling) {
+            parent.m_child1 = new_parent;
+        } else {
+            parent.m_child2 = new_parent;
+        }
+    } else {
+        m_root = new_parent;
+    }
+
+    // walk back up fixing heights and AABBs
+    index = m_nodes[leaf].m_parent;
+    while (index != NullNode) {
+        index = balance(index);
+        Node& node = m_nodes[index];
+        const Node& child1 = m_nodes[node.m_child1];
+        const Node& child2 = m_nodes[node.m_child2];
+        node.m_height = 1 + std::max(child1.m_height, child2.m_height);
+        node.m_aabb = child1.m_aabb.Union(child2.m_aabb);
+        index = node.m_parent;
+    }
+}
+
+void DynamicAABBTree::removeLeaf(uint32_t leaf) {
+    if (leaf == m_root) {
+        m_root = NullNode;
+        return;
+    }
+
+    uint32_t parent = m_nodes[leaf].m_parent;
+    uint32_t grand_parent = m_nodes[parent].m_parent;
+    uint32_t sibling = m_nodes[parent].m_child1 == leaf
+                           ? m_nodes[parent].m_child2
+                           : m_nodes[parent].m_child1;
+
+    if (grand_parent == NullNode) {
+        m_root = sibling;
+        m_nodes[sibling].m_parent = NullNode;
+        freeNode(parent);
+        return;
+    }
+
+    Node& gp = m_nodes[grand_parent];
+    if (gp.m_child1 == parent) {
+        gp.m_child1 = sibling;
+    } else {
+        gp.m_child2 = sibling;
+    }
+    m_nodes[sibling].m_parent = grand_parent;
+    freeNode(parent);
+
+    uint32_t index = grand_parent;
+    while (index != NullNode) {
+        index = balance(index);
+        Node& node = m_nodes[index];
+        const Node& child1 = m_nodes[node.m_child1];
+        const Node& child2 = m_nodes[node.m_child2];
+        node.m_aabb = child1.m_aabb.Union(child2.m_aabb);
+        node.m_height = 1 + std::max(child1.m_height, child2.m_height);
+        index = node.m_parent;
+    }
+}
+
+// rotate the taller grandchild up when A is unbalanced, returns the new
+// root of the subtree
+uint32_t DynamicAABBTree::balance(uint32_t ia) {
+    Node& a = m_nodes[ia];
+    if (a.IsLeaf() || a.m_height < 2) {
+        return ia;
+    }
+
+    uint32_t ib = a.m_child1;
+    uint32_t ic = a.m_child2;
+    Node& b = m_nodes[ib];
+    Node& c = m_nodes[ic];
+    int32_t diff = c.m_height - b.m_height;
+
+    auto replace_in_parent = [&](uint32_t old_child, uint32_t new_child) {
+        uint32_t parent = m_nodes[new_child].m_parent;
+        if (parent == NullNode) {
+            m_root = new_child;
+            return;
+        }
+        Node& p = m_nodes[parent];
+        if (p.m_child1 == old_child) {
+            p.m_child1 = new_child;
+        } else {
+            p.m_child2 = new_child;
+        }
+    };
+
+    // rotate C up
+    if (diff > 1) {
+        uint32_t i_f = c.m_child1;
+        uint32_t i_g = c.m_child2;
+        Node& f = m_nodes[i_f];
+        Node& g = m_nodes[i_g];
+
+        c.m_child1 = ia;
+        c.m_parent = a.m_parent;
+        a.m_parent = ic;
+        replace_in_parent(ia, ic);
+
+        if (f.m_height > g.m_height) {
+            c.m_child2 = i_f;
+            a.m_child2 = i_g;
+            g.m_parent = ia;
+            a.m_aabb = b.m_aabb.Union(g.m_aabb);
+            c.m_aabb = a.m_aabb.Union(f.m_aabb);
+            a.m_height = 1 + std::max(b.m_height, g.m_height);
+            c.m_height = 1 + std::max(a.m_height, f.m_height);
+        } else {
+            c.m_child2 = i_g;
+            a.m_child2 = i_f;
+            f.m_parent = ia;
+            a.m_aabb = b.m_aabb.Union(f.m_aabb);
+            c.m_aabb = a.m_aabb.Union(g.m_aabb);
+            a.m_height = 1 + std::max(b.m_height, f.m_height);
+            c.m_height = 1 + std::max(a.m_height, g.m_height);
+        }
+        return ic;
+    }
+
+    // rotate B up
+    if (diff < -1) {
+        uint32_t i_d = b.m_child1;
+        uint32_t i_e = b.m_child2;
+        Node& d = m_nodes[i_d];
+        Node& e = m_nodes[i_e];
+
+        b.m_child1 = ia;
+        b.m_parent = a.m_parent;
+        a.m_parent = ib;
+        replace_in_parent(ia, ib);
+
+        if (d.m_height > e.m_height) {
+            b.m_child2 = i_d;
+            a.m_child1 = i_e;
+            e.m_parent = ia;
+            a.m_aabb = c.m_aabb.Union(e.m_aabb);
+            b.m_aabb = a.m_aabb.Union(d.m_aabb);
+            a.m_height = 1 + std::max(c.m_height, e.m_height);
+            b.m_height = 1 + std::max(a.m_height, d.m_height);
+        } else {
+            b.m_child2 = i_e;
+            a.m_child1 = i_d;
+            d.m_parent = ia;
+            a.m_aabb = c.m_aabb.Union(d.m_aabb);
+            b.m_aabb = a.m_aabb.Union(e.m_aabb);
+            a.m_height = 1 + std::max(c.m_height, d.m_height);
+            b.m_height = 1 + std::max(a.m_height, e.m_height);
+        }
+        return ib;
+    }
+
+    return ia;
+}
+
+}
@@ -18,14 +18,14 @@ CapsuleGeometry* Geometry::AsCapsule() {
 }
 
 BoxGeometry::BoxGeometry(const Eigen::Vector3f& size)
-    : m_half_size{size} {
+    : Geometry{Type::Box}, m_half_size{size} {
 }
 
 SphereGeometry::SphereGeometry(float radius)
-    : m_radius{radius} {
+    : Geometry{Type::Sphere}, m_radius{radius} {
 }
 
 CapsuleGeometry::CapsuleGeometry(float radius, float height)
-    : m_radius{radius}, m_height{height} {
+    : Geometry{Type::Capsule}, m_radius{radius}, m_height{height} {
 }
 }
@@ -0,0 +1,123 @@
+#include "toy_physics/geometry_pool.hpp"
+#include "toy_physics/log.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+
+namespace toy_physics {
+
+// adding zero turns -0 into +0, so both intern to the same record
+static uint64_t KeyBits(float value) {
+    return std::bit_cast<uint32_t>(value + 0.0f);
+}
+
+static uint64_t MakeKey(float a, float b) {
+    return (KeyBits(a) << 32) | KeyBits(b);
+}
+
+static uint64_t NextVersion() {
+    static std::atomic<uint64_t> version{0};
+    return ++version;
+}
+
+static bool IsSame(const BoxGeometry& a, const BoxGeometry& b) {
+    return a.m_half_size == b.m_half_size;
+}
+
+static bool IsSame(const SphereGeometry& a, const SphereGeometry& b) {
+    return a.m_radius == b.m_radius;
+}
+
+static bool IsSame(const CapsuleGeometry& a, const CapsuleGeometry& b) {
+    return a.m_radius == b.m_radius && a.m_height == b.m_height;
+}
+
+GeometryHandle GeometryPool::Add(const BoxGeometry& box) {
+    // z is only compared along the collision chain
+    return intern(m_boxes, box,
+                  MakeKey(box.m_half_size.x(), box.m_half_size.y()));
+}
+
+GeometryHandle GeometryPool::Add(const SphereGeometry& sphere) {
+    return intern(m_spheres, sphere, KeyBits(sphere.m_radius));
+}
+
+GeometryHandle GeometryPool::Add(const CapsuleGeometry& capsule) {
+    return intern(m_capsules, capsule,
+                  MakeKey(capsule.m_radius, capsule.m_height));
+}
+
+GeometryHandle GeometryPool::Add(const Geometry& geom) {
+    switch (geom.GetType()) {
+        case Geometry::Type::Box:
+            return Add(static_cast<const BoxGeometry&>(geom));
+        case Geometry::Type::Sphere:
+            return Add(static_cast<const SphereGeometry&>(geom));
+        case Geometry::Type::Capsule:
+            return Add(static_cast<const CapsuleGeometry&>(geom));
+    }
+    return {};
+}
+
+const Geometry& GeometryPool::Get(GeometryHandle handle) const {
+    assert(handle && handle.GetType() <= Geometry::Type::Capsule);
+    switch (handle.GetType()) {
+        case Geometry::Type::Box:
+            return Get<BoxGeometry>(handle);
+        case Geometry::Type::Sphere:
+            return Get<SphereGeometry>(handle);
+        case Geometry::Type::Capsule:
+            return Get<CapsuleGeometry>(handle);
+    }
+    // never index a table the tag doesn't name, release builds get an
+    // empty sphere instead
+    LOGE("invalid geometry handle");
+    static const SphereGeometry empty{0.0f};
+    return empty;
+}
+
+bool GeometryPool::IsValid(GeometryHandle handle) const {
+    return handle && handle.GetType() <= Geometry::Type::Capsule &&
+           handle.GetIndex() < GetCount(handle.GetType());
+}
+
+size_t GeometryPool::GetCount(Geometry::Type type) const {
+    switch (type) {
+        case Geometry::Type::Box:
+            return m_boxes.m_records.size();
+        case Geometry::Type::Sphere:
+            return m_spheres.m_records.size();
+        case Geometry::Type::Capsule:
+            return m_capsules.m_records.size();
+    }
+    return 0;
+}
+
+template <typename T>
+GeometryHandle GeometryPool::intern(Records<T>& records, const T& geom,
+                                    uint64_t key) {
+    // the lookup map reserves UINT64_MAX as its empty key, a NaN bit
+    // pattern that never compares equal anyway
+    uint32_t* first = records.m_lookup.Find(key);
+    if (first) {
+        for (uint32_t i = *first; i != UINT32_MAX; i = records.m_next[i]) {
+            if (IsSame(records.m_records[i], geom)) {
+                return GeometryHandle::Make(geom.GetType(), i);
+            }
+        }
+    }
+
+    uint32_t index = static_cast<uint32_t>(records.m_records.size());
+    if (index > GeometryHandle::IndexMask || key == UINT64_MAX) {
+        LOGE("can't add geometry to pool");
+        return {};
+    }
+    records.m_records.push_back(geom);
+    records.m_next.push_back(first ? *first : UINT32_MAX);
+    records.m_lookup.Insert(key) = index;
+    m_version = NextVersion();
+    return GeometryHandle::Make(geom.GetType(), index);
+}
+
+}
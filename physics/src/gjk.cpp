@@ -0,0 +1,656 @@
+#include "toy_physics/gjk.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace toy_physics {
+
+constexpr float GjkEpsilon = 1e-6f;
+constexpr uint32_t GjkMaxIterations = 32;
+constexpr float GjkTolerance = 1e-5f;
+// cores closer than this get their normal from EPA, witness points are too
+// noisy to give a direction
+constexpr float GjkTouchDistance = 1e-4f;
+
+constexpr uint32_t EpaMaxVertices = 64;
+constexpr uint32_t EpaMaxFaces = 128;
+constexpr uint32_t EpaMaxIterations = 32;
+constexpr float EpaTolerance = 1e-4f;
+
+uint32_t ConvexProxy::Support(const Eigen::Vector3f& dir) const {
+    uint32_t best = 0;
+    float best_dot = m_vertices[0].dot(dir);
+    for (uint32_t i = 1; i < m_count; i++) {
+        float d = m_vertices[i].dot(dir);
+        if (d > best_dot) {
+            best = i;
+            best_dot = d;
+        }
+    }
+    return best;
+}
+
+ConvexProxy MakeConvexProxy(const BoxGeometry& box, const Pose& pose) {
+    Eigen::Matrix3f rot = pose.m_rotation.toRotationMatrix();
+    Eigen::Vector3f ex = rot.col(0) * box.m_half_size.x();
+    Eigen::Vector3f ey = rot.col(1) * box.m_half_size.y();
+    Eigen::Vector3f ez = rot.col(2) * box.m_half_size.z();
+
+    ConvexProxy proxy;
+    for (uint32_t i = 0; i < 8; i++) {
+        proxy.m_vertices[i] = pose.m_position + (i & 1 ? ex : -ex) +
+                              (i & 2 ? ey : -ey) + (i & 4 ? ez : -ez);
+    }
+    proxy.m_count = 8;
+    return proxy;
+}
+
+ConvexProxy MakeConvexProxy(const SphereGeometry& sphere, const Pose& pose) {
+    ConvexProxy proxy;
+    proxy.m_vertices[0] = pose.m_position;
+    proxy.m_count = 1;
+    proxy.m_radius = sphere.m_radius;
+    return proxy;
+}
+
+ConvexProxy MakeConvexProxy(const CapsuleGeometry& capsule,
+                            const Pose& pose) {
+    Eigen::Vector3f axis =
+        pose.m_rotation * Eigen::Vector3f{0, capsule.m_height * 0.5f, 0};
+    ConvexProxy proxy;
+    proxy.m_vertices[0] = pose.m_position - axis;
+    proxy.m_vertices[1] = pose.m_position + axis;
+    proxy.m_count = 2;
+    proxy.m_radius = capsule.m_radius;
+    return proxy;
+}
+
+ConvexProxy MakeConvexProxy(const Geometry& geom, const Pose& pose) {
+    switch (geom.GetType()) {
+        case Geometry::Type::Box:
+            return MakeConvexProxy(static_cast<const BoxGeometry&>(geom),
+                                   pose);
+        case Geometry::Type::Sphere:
+            return MakeConvexProxy(static_cast<const SphereGeometry&>(geom),
+                                   pose);
+        case Geometry::Type::Capsule:
+            return MakeConvexProxy(static_cast<const CapsuleGeometry&>(geom),
+                                   pose);
+    }
+    ConvexProxy proxy;
+    proxy.m_vertices[0] = pose.m_position;
+    proxy.m_count = 1;
+    return proxy;
+}
+
+struct SimplexVertex {
+    Eigen::Vector3f m_wa;
+    Eigen::Vector3f m_wb;
+    // m_wa - m_wb, a point of the minkowski difference
+    Eigen::Vector3f m_w;
+    float m_bary = 1;
+    uint8_t m_index_a = 0;
+    uint8_t m_index_b = 0;
+};
+
+static SimplexVertex MakeSimplexVertex(const ConvexProxy& a,
+                                       const ConvexProxy& b,
+                                       uint32_t index_a, uint32_t index_b) {
+    SimplexVertex v;
+    v.m_wa = a.m_vertices[index_a];
+    v.m_wb = b.m_vertices[index_b];
+    v.m_w = v.m_wa - v.m_wb;
+    v.m_index_a = static_cast<uint8_t>(index_a);
+    v.m_index_b = static_cast<uint8_t>(index_b);
+    return v;
+}
+
+// support point of the minkowski difference a - b along dir
+static SimplexVertex SupportVertex(const ConvexProxy& a, const ConvexProxy& b,
+                                   const Eigen::Vector3f& dir) {
+    return MakeSimplexVertex(a, b, a.Support(dir), b.Support(-dir));
+}
+
+struct Simplex {
+    std::array<SimplexVertex, 4> m_vertices;
+    uint32_t m_count = 0;
+
+    Eigen::Vector3f ClosestPoint() const {
+        Eigen::Vector3f p = Eigen::Vector3f::Zero();
+        for (uint32_t i = 0; i < m_count; i++) {
+            p += m_vertices[i].m_w * m_vertices[i].m_bary;
+        }
+        return p;
+    }
+
+    void Witness(Eigen::Vector3f& pa, Eigen::Vector3f& pb) const {
+        pa.setZero();
+        pb.setZero();
+        for (uint32_t i = 0; i < m_count; i++) {
+            pa += m_vertices[i].m_wa * m_vertices[i].m_bary;
+            pb += m_vertices[i].m_wb * m_vertices[i].m_bary;
+        }
+    }
+
+    bool Contains(uint8_t index_a, uint8_t index_b) const {
+        for (uint32_t i = 0; i < m_count; i++) {
+            if (m_vertices[i].m_index_a == index_a &&
+                m_vertices[i].m_index_b == index_b) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // reduces to the sub simplex closest to the origin and fills the
+    // barycentric coordinates. Returns false when the origin is inside the
+    // tetrahedron
+    bool Solve() {
+        switch (m_count) {
+            case 1:
+                m_vertices[0].m_bary = 1;
+                return true;
+            case 2:
+                solve2();
+                return true;
+            case 3:
+                solve3();
+                return true;
+            default:
+                return solve4();
+        }
+    }
+
+private:
+    void keep1(uint32_t i) {
+        m_vertices[0] = m_vertices[i];
+        m_vertices[0].m_bary = 1;
+        m_count = 1;
+    }
+
+    void keep2(uint32_t i, uint32_t j, float t) {
+        SimplexVertex vi = m_vertices[i];
+        SimplexVertex vj = m_vertices[j];
+        m_vertices[0] = vi;
+        m_vertices[1] = vj;
+        m_vertices[0].m_bary = 1 - t;
+        m_vertices[1].m_bary = t;
+        m_count = 2;
+    }
+
+    void solve2() {
+        const Eigen::Vector3f& a = m_vertices[0].m_w;
+        Eigen::Vector3f ab = m_vertices[1].m_w - a;
+        float t = -a.dot(ab);
+        float denom = ab.dot(ab);
+        if (t <= 0 || denom <= GjkEpsilon * GjkEpsilon) {
+            keep1(0);
+        } else if (t >= denom) {
+            keep1(1);
+        } else {
+            keep2(0, 1, t / denom);
+        }
+    }
+
+    // Ericson, Real-Time Collision Detection 5.1.5 with the query point at
+    // the origin
+    void solve3() {
+        const Eigen::Vector3f& a = m_vertices[0].m_w;
+        const Eigen::Vector3f& b = m_vertices[1].m_w;
+        const Eigen::Vector3f& c = m_vertices[2].m_w;
+        Eigen::Vector3f ab = b - a;
+        Eigen::Vector3f ac = c - a;
+
+        float d1 = -ab.dot(a);
+        float d2 = -ac.dot(a);
+        if (d1 <= 0 && d2 <= 0) {
+            keep1(0);
+            return;
+        }
+
+        float d3 = -ab.dot(b);
+        float d4 = -ac.dot(b);
+        if (d3 >= 0 && d4 <= d3) {
+            keep1(1);
+            return;
+        }
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+            keep2(0, 1, d1 / (d1 - d3));
+            return;
+        }
+
+        float d5 = -ab.dot(c);
+        float d6 = -ac.dot(c);
+        if (d6 >= 0 && d5 <= d6) {
+            keep1(2);
+            return;
+        }
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+            keep2(0, 2, d2 / (d2 - d6));
+            return;
+        }
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+            keep2(1, 2, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+            return;
+        }
+
+        float sum = va + vb + vc;
+        if (sum <= GjkEpsilon * GjkEpsilon) {
+            // collinear triangle, the closest edge is good enough
+            m_count = 2;
+            solve2();
+            return;
+        }
+        float inv = 1.0f / sum;
+        m_vertices[1].m_bary = vb * inv;
+        m_vertices[2].m_bary = vc * inv;
+        m_vertices[0].m_bary = 1 - m_vertices[1].m_bary - m_vertices[2].m_bary;
+    }
+
+    bool solve4() {
+        static constexpr uint32_t faces[4][4] = {
+            {0, 1, 2, 3},
+            {0, 3, 1, 2},
+            {0, 2, 3, 1},
+            {1, 3, 2, 0},
+        };
+
+        Eigen::Vector3f w0 = m_vertices[0].m_w;
+        Eigen::Vector3f e1 = m_vertices[1].m_w - w0;
+        Eigen::Vector3f e2 = m_vertices[2].m_w - w0;
+        Eigen::Vector3f e3 = m_vertices[3].m_w - w0;
+        // the side tests are noise for a nearly flat tetrahedron, try every
+        // face instead
+        bool flat = std::abs(e1.cross(e2).dot(e3)) <=
+                    1e-5f * e1.norm() * e2.norm() * e3.norm();
+
+        Simplex best;
+        float best_dist = std::numeric_limits<float>::max();
+        for (const auto& face : faces) {
+            const Eigen::Vector3f& a = m_vertices[face[0]].m_w;
+            Eigen::Vector3f n = (m_vertices[face[1]].m_w - a)
+                                    .cross(m_vertices[face[2]].m_w - a);
+            float side_origin = -n.dot(a);
+            float side_other = n.dot(m_vertices[face[3]].m_w - a);
+            if (!flat && side_origin * side_other >= 0) {
+                continue;
+            }
+
+            // a copy keeps the unused fourth vertex initialized
+            Simplex sub = *this;
+            sub.m_count = 3;
+            for (uint32_t i = 0; i < 3; i++) {
+                sub.m_vertices[i] = m_vertices[face[i]];
+            }
+            sub.solve3();
+            float dist = sub.ClosestPoint().squaredNorm();
+            if (dist < best_dist) {
+                best_dist = dist;
+                best = sub;
+            }
+        }
+
+        if (best.m_count == 0) {
+            return false;
+        }
+        *this = best;
+        return true;
+    }
+};
+
+static GjkOutput RunGjk(const ConvexProxy& a, const ConvexProxy& b,
+                        SimplexCache* cache, Simplex& simplex) {
+    simplex.m_count = 0;
+    if (cache) {
+        for (uint32_t i = 0; i < cache->m_count; i++) {
+            uint8_t index_a = cache->m_index_a[i];
+            uint8_t index_b = cache->m_index_b[i];
+            if (index_a < a.m_count && index_b < b.m_count &&
+                !simplex.Contains(index_a, index_b)) {
+                simplex.m_vertices[simplex.m_count++] =
+                    MakeSimplexVertex(a, b, index_a, index_b);
+            }
+        }
+    }
+    if (simplex.m_count == 0) {
+        simplex.m_vertices[0] = MakeSimplexVertex(a, b, 0, 0);
+        simplex.m_count = 1;
+    }
+
+    GjkOutput output;
+    bool overlap = false;
+    Simplex last = simplex;
+    float last_v2 = std::numeric_limits<float>::max();
+    for (uint32_t iter = 0; iter < GjkMaxIterations; iter++) {
+        output.m_iterations++;
+        if (!simplex.Solve()) {
+            overlap = true;
+            break;
+        }
+
+        Eigen::Vector3f v = simplex.ClosestPoint();
+        float v2 = v.squaredNorm();
+        // rounding can make the distance grow again near convergence, the
+        // previous simplex is the better answer then
+        if (v2 >= last_v2) {
+            simplex = last;
+            break;
+        }
+        if (v2 < GjkEpsilon * GjkEpsilon) {
+            break;
+        }
+
+        SimplexVertex vertex = SupportVertex(a, b, -v);
+        // no progress towards the origin, v is the closest point
+        if (simplex.Contains(vertex.m_index_a, vertex.m_index_b) ||
+            v2 - v.dot(vertex.m_w) <= GjkTolerance * v2) {
+            break;
+        }
+        last = simplex;
+        last_v2 = v2;
+        simplex.m_vertices[simplex.m_count++] = vertex;
+    }
+
+    if (overlap) {
+        // barycentric coordinates are not computed for a containing
+        // tetrahedron, report the centroid
+        for (uint32_t i = 0; i < simplex.m_count; i++) {
+            simplex.m_vertices[i].m_bary = 1.0f / simplex.m_count;
+        }
+    }
+    simplex.Witness(output.m_point_a, output.m_point_b);
+    output.m_distance =
+        overlap ? 0.0f : (output.m_point_b - output.m_point_a).norm();
+
+    if (cache) {
+        cache->m_count = simplex.m_count;
+        for (uint32_t i = 0; i < simplex.m_count; i++) {
+            cache->m_index_a[i] = simplex.m_vertices[i].m_index_a;
+            cache->m_index_b[i] = simplex.m_vertices[i].m_index_b;
+        }
+    }
+    return output;
+}
+
+GjkOutput GjkDistance(const ConvexProxy& a, const ConvexProxy& b,
+                      SimplexCache* cache) {
+    Simplex simplex;
+    return RunGjk(a, b, cache, simplex);
+}
+
+// EPA needs a tetrahedron, GJK may stop early on a lower simplex when the
+// origin lies on it
+static bool ExpandToTetrahedron(const ConvexProxy& a, const ConvexProxy& b,
+                                Simplex& simplex) {
+    static const Eigen::Vector3f axes[6] = {
+        Eigen::Vector3f::UnitX(),  -Eigen::Vector3f::UnitX(),
+        Eigen::Vector3f::UnitY(),  -Eigen::Vector3f::UnitY(),
+        Eigen::Vector3f::UnitZ(),  -Eigen::Vector3f::UnitZ(),
+    };
+
+    if (simplex.m_count == 1) {
+        for (const Eigen::Vector3f& dir : axes) {
+            SimplexVertex v = SupportVertex(a, b, dir);
+            if ((v.m_w - simplex.m_vertices[0].m_w).squaredNorm() >
+                GjkEpsilon) {
+                simplex.m_vertices[simplex.m_count++] = v;
+                break;
+            }
+        }
+        if (simplex.m_count < 2) {
+            return false;
+        }
+    }
+
+    if (simplex.m_count == 2) {
+        Eigen::Vector3f d =
+            simplex.m_vertices[1].m_w - simplex.m_vertices[0].m_w;
+        d.normalize();
+        int min_axis;
+        d.cwiseAbs().minCoeff(&min_axis);
+        Eigen::Vector3f u = d.cross(Eigen::Vector3f::Unit(min_axis)).normalized();
+        Eigen::Vector3f v = d.cross(u);
+        for (int i = 0; i < 6; i++) {
+            float angle = static_cast<float>(i) * 1.04719755f;
+            SimplexVertex vertex =
+                SupportVertex(a, b, u * std::cos(angle) + v * std::sin(angle));
+            Eigen::Vector3f offset = vertex.m_w - simplex.m_vertices[0].m_w;
+            if ((offset - d * offset.dot(d)).squaredNorm() > GjkEpsilon) {
+                simplex.m_vertices[simplex.m_count++] = vertex;
+                break;
+            }
+        }
+        if (simplex.m_count < 3) {
+            return false;
+        }
+    }
+
+    if (simplex.m_count == 3) {
+        const Eigen::Vector3f& w0 = simplex.m_vertices[0].m_w;
+        Eigen::Vector3f n = (simplex.m_vertices[1].m_w - w0)
+                                .cross(simplex.m_vertices[2].m_w - w0);
+        float len = n.norm();
+        if (len <= GjkEpsilon) {
+            return false;
+        }
+        n /= len;
+        for (float sign : {1.0f, -1.0f}) {
+            SimplexVertex vertex = SupportVertex(a, b, n * sign);
+            if (std::abs(n.dot(vertex.m_w - w0)) > GjkEpsilon * 10) {
+                simplex.m_vertices[simplex.m_count++] = vertex;
+                break;
+            }
+        }
+        if (simplex.m_count < 4) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct EpaFace {
+    std::array<uint8_t, 3> m_indices;
+    Eigen::Vector3f m_normal;
+    float m_distance;
+};
+
+struct EpaEdge {
+    uint8_t m_from;
+    uint8_t m_to;
+};
+
+static bool MakeEpaFace(const SimplexVertex* vertices, uint8_t i0, uint8_t i1,
+                        uint8_t i2, EpaFace& face) {
+    const Eigen::Vector3f& a = vertices[i0].m_w;
+    Eigen::Vector3f n = (vertices[i1].m_w - a).cross(vertices[i2].m_w - a);
+    float len = n.norm();
+    if (len <= GjkEpsilon * GjkEpsilon) {
+        return false;
+    }
+    face.m_indices = {i0, i1, i2};
+    face.m_normal = n / len;
+    face.m_distance = face.m_normal.dot(a);
+    return true;
+}
+
+static bool RunEpa(const ConvexProxy& a, const ConvexProxy& b,
+                   Simplex simplex, ConvexContact& contact) {
+    if (!ExpandToTetrahedron(a, b, simplex)) {
+        return false;
+    }
+
+    std::array<SimplexVertex, EpaMaxVertices> vertices;
+    std::array<EpaFace, EpaMaxFaces> faces;
+    std::array<EpaEdge, EpaMaxFaces> edges;
+    uint32_t vertex_count = 4;
+    uint32_t face_count = 0;
+    for (uint32_t i = 0; i < 4; i++) {
+        vertices[i] = simplex.m_vertices[i];
+    }
+
+    // wind the faces so the normals point away from the fourth vertex
+    const Eigen::Vector3f& w0 = vertices[0].m_w;
+    if ((vertices[1].m_w - w0)
+            .cross(vertices[2].m_w - w0)
+            .dot(vertices[3].m_w - w0) > 0) {
+        std::swap(vertices[1], vertices[2]);
+    }
+    static constexpr uint8_t initial[4][3] = {
+        {0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+    for (const auto& f : initial) {
+        if (!MakeEpaFace(vertices.data(), f[0], f[1], f[2],
+                         faces[face_count++])) {
+            return false;
+        }
+    }
+
+    uint32_t closest = 0;
+    for (uint32_t iter = 0; iter < EpaMaxIterations; iter++) {
+        closest = 0;
+        for (uint32_t i = 1; i < face_count; i++) {
+            if (faces[i].m_distance < faces[closest].m_distance) {
+                closest = i;
+            }
+        }
+
+        const EpaFace& face = faces[closest];
+        SimplexVertex vertex = SupportVertex(a, b, face.m_normal);
+        float advance = face.m_normal.dot(vertex.m_w) - face.m_distance;
+        if (advance < EpaTolerance || vertex_count == EpaMaxVertices) {
+            break;
+        }
+
+        bool duplicate = false;
+        for (uint32_t i = 0; i < vertex_count; i++) {
+            if (vertices[i].m_index_a == vertex.m_index_a &&
+                vertices[i].m_index_b == vertex.m_index_b) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) {
+            break;
+        }
+
+        uint8_t new_index = static_cast<uint8_t>(vertex_count);
+        vertices[vertex_count++] = vertex;
+
+        // remove every face the new vertex sees, their boundary is the
+        // horizon
+        uint32_t edge_count = 0;
+        for (uint32_t i = 0; i < face_count;) {
+            const EpaFace& f = faces[i];
+            if (f.m_normal.dot(vertex.m_w - vertices[f.m_indices[0]].m_w) <=
+                0) {
+                i++;
+                continue;
+            }
+            for (uint32_t k = 0; k < 3; k++) {
+                uint8_t from = f.m_indices[k];
+                uint8_t to = f.m_indices[(k + 1) % 3];
+                bool shared = false;
+                for (uint32_t e = 0; e < edge_count; e++) {
+                    if (edges[e].m_from == to && edges[e].m_to == from) {
+                        edges[e] = edges[--edge_count];
+                        shared = true;
+                        break;
+                    }
+                }
+                if (!shared && edge_count < edges.size()) {
+                    edges[edge_count++] = {from, to};
+                }
+            }
+            faces[i] = faces[--face_count];
+        }
+
+        bool valid = true;
+        for (uint32_t e = 0; e < edge_count && valid; e++) {
+            valid = face_count < EpaMaxFaces &&
+                    MakeEpaFace(vertices.data(), edges[e].m_from,
+                                edges[e].m_to, new_index,
+                                faces[face_count++]);
+        }
+        if (!valid || face_count == 0) {
+            return false;
+        }
+    }
+
+    closest = 0;
+    for (uint32_t i = 1; i < face_count; i++) {
+        if (faces[i].m_distance < faces[closest].m_distance) {
+            closest = i;
+        }
+    }
+    const EpaFace& face = faces[closest];
+
+    // barycentric coordinates of the origin projected on the face
+    const SimplexVertex& v0 = vertices[face.m_indices[0]];
+    const SimplexVertex& v1 = vertices[face.m_indices[1]];
+    const SimplexVertex& v2 = vertices[face.m_indices[2]];
+    Eigen::Vector3f p = face.m_normal * face.m_distance;
+    Eigen::Vector3f e0 = v1.m_w - v0.m_w;
+    Eigen::Vector3f e1 = v2.m_w - v0.m_w;
+    Eigen::Vector3f e2 = p - v0.m_w;
+    float d00 = e0.dot(e0);
+    float d01 = e0.dot(e1);
+    float d11 = e1.dot(e1);
+    float d20 = e2.dot(e0);
+    float d21 = e2.dot(e1);
+    float denom = d00 * d11 - d01 * d01;
+    float u = 1.0f / 3.0f, v = 1.0f / 3.0f;
+    if (std::abs(denom) > GjkEpsilon * GjkEpsilon) {
+        u = (d11 * d20 - d01 * d21) / denom;
+        v = (d00 * d21 - d01 * d20) / denom;
+    }
+    float w = 1.0f - u - v;
+
+    contact.m_normal = face.m_normal;
+    contact.m_point_a = v0.m_wa * w + v1.m_wa * u + v2.m_wa * v;
+    contact.m_point_b = v0.m_wb * w + v1.m_wb * u + v2.m_wb * v;
+    contact.m_depth = face.m_distance;
+    return true;
+}
+
+bool CollideConvex(const ConvexProxy& a, const ConvexProxy& b, float margin,
+                   SimplexCache* cache, ConvexContact& contact) {
+    Simplex simplex;
+    GjkOutput output = RunGjk(a, b, cache, simplex);
+    float radius = a.m_radius + b.m_radius;
+    if (output.m_distance > radius + margin) {
+        return false;
+    }
+
+    if (output.m_distance > GjkTouchDistance) {
+        Eigen::Vector3f normal =
+            (output.m_point_b - output.m_point_a) / output.m_distance;
+        contact.m_normal = normal;
+        contact.m_point_a = output.m_point_a + normal * a.m_radius;
+        contact.m_point_b = output.m_point_b - normal * b.m_radius;
+        contact.m_depth = radius - output.m_distance;
+        return true;
+    }
+
+    // the cores overlap, EPA gives the core penetration
+    ConvexContact core;
+    if (!RunEpa(a, b, simplex, core)) {
+        contact.m_normal = Eigen::Vector3f::UnitY();
+        contact.m_point_a = output.m_point_a;
+        contact.m_point_b = output.m_point_b;
+        contact.m_depth = radius;
+        return true;
+    }
+    contact.m_normal = core.m_normal;
+    contact.m_point_a = core.m_point_a + core.m_normal * a.m_radius;
+    contact.m_point_b = core.m_point_b - core.m_normal * b.m_radius;
+    contact.m_depth = core.m_depth + radius;
+    return true;
+}
+
+}
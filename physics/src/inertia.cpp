@@ -0,0 +1,70 @@
+#include "toy_physics/inertia.hpp"
+
+#include <numbers>
+
+namespace toy_physics {
+
+Eigen::Vector3f ComputeInvInertia(const BoxGeometry& box, float inv_mass) {
+    Eigen::Vector3f h2 = box.m_half_size.cwiseProduct(box.m_half_size);
+    Eigen::Vector3f inertia{h2.y() + h2.z(), h2.x() + h2.z(),
+                            h2.x() + h2.y()};
+    return (3.0f * inv_mass) * inertia.cwiseInverse();
+}
+
+Eigen::Vector3f ComputeInvInertia(const SphereGeometry& sphere,
+                                  float inv_mass) {
+    float r2 = sphere.m_radius * sphere.m_radius;
+    return Eigen::Vector3f::Constant(2.5f * inv_mass / r2);
+}
+
+Eigen::Vector3f ComputeInvInertia(const CapsuleGeometry& capsule,
+                                  float inv_mass) {
+    if (inv_mass == 0) {
+        return Eigen::Vector3f::Zero();
+    }
+
+    // split the mass between the cylinder and the two hemispheres by volume
+    constexpr float pi = std::numbers::pi_v<float>;
+    float r = capsule.m_radius;
+    float h = capsule.m_height;
+    float cylinder_volume = pi * r * r * h;
+    float sphere_volume = 4.0f / 3.0f * pi * r * r * r;
+    float mass = 1.0f / inv_mass;
+    float cylinder_mass =
+        mass * cylinder_volume / (cylinder_volume + sphere_volume);
+    float sphere_mass = mass - cylinder_mass;
+
+    float axial = cylinder_mass * r * r * 0.5f + sphere_mass * r * r * 0.4f;
+    float lateral = cylinder_mass * (h * h / 12.0f + r * r * 0.25f) +
+                    sphere_mass * (r * r * 0.4f + h * h * 0.25f +
+                                   h * r * 0.375f);
+    return Eigen::Vector3f{1.0f / lateral, 1.0f / axial, 1.0f / lateral};
+}
+
+Eigen::Matrix3f ComputeInvInertia(const Geometry& geom,
+                                  const Pose& local_pose, float inv_mass) {
+    if (inv_mass == 0) {
+        return Eigen::Matrix3f::Zero();
+    }
+
+    Eigen::Vector3f diagonal = Eigen::Vector3f::Zero();
+    switch (geom.GetType()) {
+        case Geometry::Type::Box:
+            diagonal = ComputeInvInertia(
+                static_cast<const BoxGeometry&>(geom), inv_mass);
+            break;
+        case Geometry::Type::Sphere:
+            diagonal = ComputeInvInertia(
+                static_cast<const SphereGeometry&>(geom), inv_mass);
+            break;
+        case Geometry::Type::Capsule:
+            diagonal = ComputeInvInertia(
+                static_cast<const CapsuleGeometry&>(geom), inv_mass);
+            break;
+    }
+
+    Eigen::Matrix3f rot = local_pose.m_rotation.toRotationMatrix();
+    return rot * diagonal.asDiagonal() * rot.transpose();
+}
+
+}
@@ -0,0 +1,364 @@
+#include "toy_physics/job_system.hpp"
+#include "toy_physics/arena.hpp"
+#include "toy_physics/log.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace toy_physics {
+
+static thread_local const JobSystem* t_job_system = nullptr;
+static thread_local uint32_t t_worker_index = 0;
+
+// marks the current thread as a worker, executor threads may already be
+// serving another job system
+class WorkerScope {
+public:
+    WorkerScope(const JobSystem* system, uint32_t worker)
+        : m_system{t_job_system}, m_worker{t_worker_index} {
+        t_job_system = system;
+        t_worker_index = worker;
+    }
+
+    ~WorkerScope() {
+        t_job_system = m_system;
+        t_worker_index = m_worker;
+    }
+
+private:
+    const JobSystem* m_system;
+    uint32_t m_worker;
+};
+
+uint32_t JobGraph::AddTask(TaskFn fn) {
+    m_tasks.push_back({std::move(fn), {}, 0});
+    return static_cast<uint32_t>(m_tasks.size() - 1);
+}
+
+void JobGraph::AddDependency(uint32_t before, uint32_t after) {
+    if (before >= m_tasks.size() || after >= m_tasks.size() ||
+        before == after) {
+        LOGE("invalid job graph dependency {} -> {}", before, after);
+        return;
+    }
+    m_tasks[before].m_successors.push_back(after);
+    m_tasks[after].m_dependency_count++;
+}
+
+void JobGraph::Clear() {
+    m_tasks.clear();
+}
+
+JobSystem::JobSystem(uint32_t worker_count) {
+    if (worker_count == 0) {
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (uint32_t i = 0; i < worker_count; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    m_threads.reserve(worker_count - 1);
+    for (uint32_t i = 1; i < worker_count; i++) {
+        m_threads.emplace_back([this, i] { workerMain(i); });
+    }
+}
+
+JobSystem::JobSystem(JobExecutor& executor) : m_executor{&executor} {
+    // one bit per helper slot, worker 0 stays with the calling thread
+    uint32_t worker_count =
+        std::clamp(executor.GetConcurrency() + 1, 1u, 64u);
+    for (uint32_t i = 0; i < worker_count; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    uint64_t slots = worker_count == 64 ? ~0ull : (1ull << worker_count) - 1;
+    m_free_helper_slots.store(slots & ~1ull, std::memory_order_relaxed);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard lock{m_sleep_mutex};
+        m_quit = true;
+    }
+    m_wake_cv.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+
+    // executor tasks may still be on their way out
+    while (m_pending_helpers.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+uint32_t JobSystem::GetWorkerCount() const {
+    return static_cast<uint32_t>(m_workers.size());
+}
+
+uint32_t JobSystem::GetCurrentWorker() const {
+    return t_job_system == this ? t_worker_index : 0;
+}
+
+// shared state of one parallel-for, lives on the calling thread's stack
+struct ParallelForData {
+    void (*m_fn)(const void*, uint32_t, uint32_t, uint32_t);
+    const void* m_data;
+    uint32_t m_count;
+    uint32_t m_grain_size;
+    std::atomic<uint32_t> m_next{0};
+};
+
+// helpers grab chunks from a shared counter, a helper that starts late just
+// finds nothing left
+static void RunChunks(void* data, uint32_t worker) {
+    PROFILE_SCOPE("ParallelFor");
+    auto& state = *static_cast<ParallelForData*>(data);
+    while (true) {
+        uint32_t begin =
+            state.m_next.fetch_add(state.m_grain_size,
+                                   std::memory_order_relaxed);
+        if (begin >= state.m_count) {
+            return;
+        }
+        state.m_fn(state.m_data, begin,
+                   std::min(begin + state.m_grain_size, state.m_count),
+                   worker);
+    }
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t grain_size,
+                            RawRangeFn fn, const void* data) {
+    if (count == 0) {
+        return;
+    }
+
+    grain_size = std::max(grain_size, 1u);
+    uint32_t worker = GetCurrentWorker();
+    uint32_t chunk_count = (count - 1) / grain_size + 1;
+    if (m_workers.size() == 1 || chunk_count == 1) {
+        fn(data, 0, count, worker);
+        return;
+    }
+
+    ParallelForData state{fn, data, count, grain_size};
+    std::atomic<uint32_t> pending{0};
+    uint32_t helper_count =
+        std::min(chunk_count, GetWorkerCount()) - 1;
+    for (uint32_t i = 0; i < helper_count; i++) {
+        submit(RunChunks, &state, &pending);
+    }
+    RunChunks(&state, worker);
+    Wait(pending);
+}
+
+void JobSystem::Run(JobGraph& graph) {
+    size_t task_count = graph.m_tasks.size();
+    if (task_count == 0) {
+        return;
+    }
+
+    if (graph.m_remaining_size != task_count) {
+        graph.m_remaining =
+            std::make_unique<std::atomic<uint32_t>[]>(task_count);
+        graph.m_runs = std::make_unique<JobGraph::TaskRun[]>(task_count);
+        graph.m_remaining_size = task_count;
+    }
+    for (size_t i = 0; i < task_count; i++) {
+        graph.m_remaining[i].store(graph.m_tasks[i].m_dependency_count,
+                                   std::memory_order_relaxed);
+        graph.m_runs[i] = {&graph, static_cast<uint32_t>(i)};
+    }
+
+    std::atomic<uint32_t> pending{0};
+    graph.m_system = this;
+    graph.m_pending = &pending;
+    for (uint32_t i = 0; i < task_count; i++) {
+        if (graph.m_tasks[i].m_dependency_count == 0) {
+            submit(runGraphTask, &graph.m_runs[i], &pending);
+        }
+    }
+    Wait(pending);
+    graph.m_pending = nullptr;
+}
+
+void JobSystem::Submit(JobFn fn, std::atomic<uint32_t>* counter) {
+    auto* owned = new JobFn{std::move(fn)};
+    submit(
+        [](void* data, uint32_t worker) {
+            std::unique_ptr<JobFn> fn{static_cast<JobFn*>(data)};
+            (*fn)(worker);
+        },
+        owned, counter);
+}
+
+void JobSystem::Wait(const std::atomic<uint32_t>& counter) {
+    uint32_t worker = GetCurrentWorker();
+    WorkerScope scope{this, worker};
+    while (counter.load(std::memory_order_acquire) != 0) {
+        if (!runOne(worker)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::submit(void (*fn)(void*, uint32_t), void* data,
+                       std::atomic<uint32_t>* counter) {
+    if (counter) {
+        counter->fetch_add(1, std::memory_order_relaxed);
+    }
+    push({fn, data, counter, IsInAllocationScope()}, GetCurrentWorker());
+}
+
+void JobSystem::push(Job job, uint32_t worker) {
+    {
+        Worker& w = *m_workers[worker];
+        std::lock_guard lock{w.m_mutex};
+        size_t capacity = w.m_jobs.size();
+        if (w.m_count == capacity) {
+            // unroll the ring into a buffer twice the size
+            std::vector<Job> jobs(std::max<size_t>(capacity * 2, 64));
+            for (size_t i = 0; i < w.m_count; i++) {
+                jobs[i] = w.m_jobs[(w.m_head + i) % capacity];
+            }
+            w.m_jobs.swap(jobs);
+            w.m_head = 0;
+            capacity = w.m_jobs.size();
+        }
+        w.m_jobs[(w.m_head + w.m_count) % capacity] = job;
+        w.m_count++;
+    }
+    m_queued.fetch_add(1, std::memory_order_release);
+
+    if (m_executor) {
+        requestHelpers();
+    } else if (!m_threads.empty()) {
+        // taking the lock orders the push before a worker's sleep check
+        { std::lock_guard lock{m_sleep_mutex}; }
+        m_wake_cv.notify_one();
+    }
+}
+
+bool JobSystem::runOne(uint32_t worker) {
+    Job job;
+    if (!pop(worker, job) && !steal(worker, job)) {
+        return false;
+    }
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+
+    if (job.m_tracked) {
+        AllocationScope scope;
+        job.m_fn(job.m_data, worker);
+    } else {
+        job.m_fn(job.m_data, worker);
+    }
+    if (job.m_counter) {
+        job.m_counter->fetch_sub(1, std::memory_order_release);
+    }
+    return true;
+}
+
+bool JobSystem::pop(uint32_t worker, Job& job) {
+    Worker& w = *m_workers[worker];
+    std::lock_guard lock{w.m_mutex};
+    if (w.m_count == 0) {
+        return false;
+    }
+    w.m_count--;
+    job = w.m_jobs[(w.m_head + w.m_count) % w.m_jobs.size()];
+    return true;
+}
+
+bool JobSystem::steal(uint32_t worker, Job& job) {
+    if (m_queued.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    size_t count = m_workers.size();
+    for (size_t i = 1; i < count; i++) {
+        Worker& victim = *m_workers[(worker + i) % count];
+        std::lock_guard lock{victim.m_mutex};
+        if (victim.m_count != 0) {
+            job = victim.m_jobs[victim.m_head];
+            victim.m_head = (victim.m_head + 1) % victim.m_jobs.size();
+            victim.m_count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::workerMain(uint32_t worker) {
+    PROFILE_THREAD_NAME("toy_physics worker");
+    WorkerScope scope{this, worker};
+    while (true) {
+        if (runOne(worker)) {
+            continue;
+        }
+
+        std::unique_lock lock{m_sleep_mutex};
+        m_wake_cv.wait(lock, [this] {
+            return m_quit || m_queued.load(std::memory_order_acquire) != 0;
+        });
+        if (m_quit) {
+            return;
+        }
+    }
+}
+
+void JobSystem::helperMain() {
+    uint64_t slots = m_free_helper_slots.load(std::memory_order_relaxed);
+    uint32_t worker = 0;
+    while (true) {
+        if (slots == 0) {
+            m_pending_helpers.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+        worker = static_cast<uint32_t>(std::countr_zero(slots));
+        if (m_free_helper_slots.compare_exchange_weak(
+                slots, slots & ~(1ull << worker),
+                std::memory_order_acquire)) {
+            break;
+        }
+    }
+
+    {
+        WorkerScope scope{this, worker};
+        while (runOne(worker)) {
+        }
+    }
+
+    m_free_helper_slots.fetch_or(1ull << worker, std::memory_order_release);
+    m_pending_helpers.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::requestHelpers() {
+    // the waiting thread always helps, so a missed request only costs
+    // parallelism, never progress
+    uint32_t helper_count = GetWorkerCount() - 1;
+    uint32_t wanted = std::min(
+        m_queued.load(std::memory_order_relaxed), helper_count);
+    uint32_t pending = m_pending_helpers.load(std::memory_order_relaxed);
+    while (pending < wanted) {
+        if (m_pending_helpers.compare_exchange_weak(
+                pending, pending + 1, std::memory_order_relaxed)) {
+            m_executor->Execute([this] { helperMain(); });
+            pending++;
+        }
+    }
+}
+
+void JobSystem::runGraphTask(void* data, uint32_t worker) {
+    auto& run = *static_cast<JobGraph::TaskRun*>(data);
+    JobGraph& graph = *run.m_graph;
+    JobSystem& system = *graph.m_system;
+    graph.m_tasks[run.m_index].m_fn(worker);
+    // successors are submitted before this task counts as done, so pending
+    // can't reach zero early
+    for (uint32_t next : graph.m_tasks[run.m_index].m_successors) {
+        if (graph.m_remaining[next].fetch_sub(1, std::memory_order_acq_rel) ==
+            1) {
+            system.submit(runGraphTask, &graph.m_runs[next], graph.m_pending);
+        }
+    }
+}
+
+}
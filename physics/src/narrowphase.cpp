@@ -0,0 +1,280 @@
+#include "toy_physics/narrowphase.hpp"
+#include "toy_physics/collision.hpp"
+#include "toy_physics/contact_batch.hpp"
+
+#include <algorithm>
+
+namespace toy_physics {
+
+// the bucket guarantees the type, so this goes straight to the typed array
+template <typename T>
+static const T& GetGeometry(const NarrowphaseContext& context,
+                            uint32_t index) {
+    return context.m_pool->Get<T>(context.m_geometries[index]);
+}
+
+template <typename GeomA, typename GeomB,
+          bool (*Fn)(const GeomA&, const Pose&, const GeomB&, const Pose&,
+                     float, ContactManifold&)>
+static void CollideBatch(const NarrowphaseContext& context,
+                         const NarrowphasePair* pairs, size_t count,
+                         std::vector<ContactManifold>& manifolds) {
+    for (size_t i = 0; i < count; i++) {
+        const NarrowphasePair& pair = pairs[i];
+        ContactManifold manifold;
+        manifold.m_body_a = pair.m_a;
+        manifold.m_body_b = pair.m_b;
+        if (Fn(GetGeometry<GeomA>(context, pair.m_a),
+               context.m_poses[pair.m_a],
+               GetGeometry<GeomB>(context, pair.m_b),
+               context.m_poses[pair.m_b], context.m_margin, manifold)) {
+            manifolds.push_back(manifold);
+        }
+    }
+}
+
+// Collide() touches every pair before the kernels run, so chunks on other
+// workers never insert while this one looks up
+static SimplexCache* FindSimplexCache(const NarrowphaseContext& context,
+                                      const NarrowphasePair& pair) {
+    if (!context.m_contact_cache || !context.m_ids) {
+        return nullptr;
+    }
+    ContactCacheEntry* entry = context.m_contact_cache->Find(
+        context.m_ids[pair.m_a], context.m_ids[pair.m_b]);
+    return entry ? &entry->m_simplex : nullptr;
+}
+
+static void CollideBoxCapsuleCached(const NarrowphaseContext& context,
+                                    const NarrowphasePair* pairs,
+                                    size_t count,
+                                    std::vector<ContactManifold>& manifolds) {
+    for (size_t i = 0; i < count; i++) {
+        const NarrowphasePair& pair = pairs[i];
+        ContactManifold manifold;
+        manifold.m_body_a = pair.m_a;
+        manifold.m_body_b = pair.m_b;
+        auto& a = GetGeometry<BoxGeometry>(context, pair.m_a);
+        auto& b = GetGeometry<CapsuleGeometry>(context, pair.m_b);
+        if (CollideBoxCapsule(a, context.m_poses[pair.m_a], b,
+                              context.m_poses[pair.m_b], context.m_margin,
+                              manifold, FindSimplexCache(context, pair))) {
+            manifolds.push_back(manifold);
+        }
+    }
+}
+
+// wide kernels run over chunks small enough to stay in cache
+constexpr size_t WideBatchSize = 256;
+
+static void AppendBatchContact(const ContactBatch& contacts, size_t i,
+                               const NarrowphasePair& pair, float margin,
+                               std::vector<ContactManifold>& manifolds) {
+    float depth = contacts.m_depth[i];
+    if (depth <= -margin) {
+        return;
+    }
+    ContactManifold manifold;
+    manifold.m_body_a = pair.m_a;
+    manifold.m_body_b = pair.m_b;
+    manifold.m_normal = contacts.m_normal.Get(i);
+    manifold.AddPoint(contacts.m_position.Get(i), depth, 0);
+    manifolds.push_back(manifold);
+}
+
+static void CollideSphereSphereWide(const NarrowphaseContext& context,
+                                    const NarrowphasePair* pairs,
+                                    size_t count,
+                                    std::vector<ContactManifold>& manifolds) {
+    thread_local SpherePairBatch batch;
+    thread_local ContactBatch contacts;
+
+    for (size_t begin = 0; begin < count; begin += WideBatchSize) {
+        size_t end = std::min(count, begin + WideBatchSize);
+        batch.Clear();
+        for (size_t i = begin; i < end; i++) {
+            const NarrowphasePair& pair = pairs[i];
+            auto& a = GetGeometry<SphereGeometry>(context, pair.m_a);
+            auto& b = GetGeometry<SphereGeometry>(context, pair.m_b);
+            batch.Push(context.m_poses[pair.m_a].m_position, a.m_radius,
+                       context.m_poses[pair.m_b].m_position, b.m_radius);
+        }
+
+        CollideSphereBatch(batch, contacts);
+        for (size_t i = begin; i < end; i++) {
+            AppendBatchContact(contacts, i - begin, pairs[i],
+                               context.m_margin, manifolds);
+        }
+    }
+}
+
+static void CollideCapsuleCapsuleWide(
+    const NarrowphaseContext& context, const NarrowphasePair* pairs,
+    size_t count, std::vector<ContactManifold>& manifolds) {
+    thread_local CapsulePairBatch batch;
+    thread_local ContactBatch contacts;
+
+    for (size_t begin = 0; begin < count; begin += WideBatchSize) {
+        size_t end = std::min(count, begin + WideBatchSize);
+        batch.Clear();
+        for (size_t i = begin; i < end; i++) {
+            const NarrowphasePair& pair = pairs[i];
+            auto& a = GetGeometry<CapsuleGeometry>(context, pair.m_a);
+            auto& b = GetGeometry<CapsuleGeometry>(context, pair.m_b);
+            Eigen::Vector3f p1, q1, p2, q2;
+            GetCapsuleSegment(a, context.m_poses[pair.m_a], p1, q1);
+            GetCapsuleSegment(b, context.m_poses[pair.m_b], p2, q2);
+            batch.Push(p1, q1, a.m_radius, p2, q2, b.m_radius);
+        }
+
+        CollideCapsuleBatch(batch, contacts);
+        for (size_t i = begin; i < end; i++) {
+            size_t lane = i - begin;
+            if (contacts.m_depth[lane] <= -context.m_margin) {
+                continue;
+            }
+
+            // nearly parallel capsules need the two point manifold from the
+            // scalar path
+            Eigen::Vector3f d1 = batch.m_q1.Get(lane) - batch.m_p1.Get(lane);
+            Eigen::Vector3f d2 = batch.m_q2.Get(lane) - batch.m_p2.Get(lane);
+            if (d1.cross(d2).squaredNorm() <=
+                0.0025f * d1.squaredNorm() * d2.squaredNorm()) {
+                const NarrowphasePair& pair = pairs[i];
+                CollideBatch<CapsuleGeometry, CapsuleGeometry,
+                             CollideCapsuleCapsule>(context, &pair, 1,
+                                                    manifolds);
+                continue;
+            }
+            AppendBatchContact(contacts, lane, pairs[i], context.m_margin,
+                               manifolds);
+        }
+    }
+}
+
+Narrowphase::Narrowphase() {
+    using Type = Geometry::Type;
+    SetKernel(Type::Box, Type::Box,
+              CollideBatch<BoxGeometry, BoxGeometry, CollideBoxBox>);
+    SetKernel(Type::Box, Type::Sphere,
+              CollideBatch<BoxGeometry, SphereGeometry, CollideBoxSphere>);
+    SetKernel(Type::Box, Type::Capsule, CollideBoxCapsuleCached);
+    SetKernel(Type::Sphere, Type::Sphere, CollideSphereSphereWide);
+    SetKernel(
+        Type::Sphere, Type::Capsule,
+        CollideBatch<SphereGeometry, CapsuleGeometry, CollideSphereCapsule>);
+    SetKernel(Type::Capsule, Type::Capsule, CollideCapsuleCapsuleWide);
+}
+
+void Narrowphase::SetKernel(Geometry::Type a, Geometry::Type b,
+                            CollideBatchFn kernel) {
+    m_kernels[static_cast<size_t>(a)][static_cast<size_t>(b)] = kernel;
+}
+
+CollideBatchFn Narrowphase::GetKernel(Geometry::Type a,
+                                      Geometry::Type b) const {
+    return m_kernels[static_cast<size_t>(a)][static_cast<size_t>(b)];
+}
+
+// small enough that a few hundred pairs still spread over the workers
+constexpr uint32_t ChunkSize = 64;
+
+void Narrowphase::Collide(const NarrowphaseContext& context,
+                          const NarrowphasePair* pairs, size_t count,
+                          std::vector<ContactManifold>& manifolds,
+                          JobSystem& jobs) {
+    for (auto& bucket : m_buckets) {
+        bucket.clear();
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        NarrowphasePair pair = pairs[i];
+        size_t type_a =
+            static_cast<size_t>(context.m_geometries[pair.m_a].GetType());
+        size_t type_b =
+            static_cast<size_t>(context.m_geometries[pair.m_b].GetType());
+        if (type_a > type_b) {
+            std::swap(pair.m_a, pair.m_b);
+            std::swap(type_a, type_b);
+        }
+        m_buckets[type_a * TypeCount + type_b].push_back(pair);
+    }
+
+    NarrowphaseContext bucket_context = context;
+    bucket_context.m_contact_cache = &m_contact_cache;
+    m_contact_cache.BeginStep();
+
+    m_chunks.clear();
+    for (size_t a = 0; a < TypeCount; a++) {
+        for (size_t b = a; b < TypeCount; b++) {
+            uint32_t bucket = static_cast<uint32_t>(a * TypeCount + b);
+            uint32_t size = static_cast<uint32_t>(m_buckets[bucket].size());
+            if (!m_kernels[a][b]) {
+                continue;
+            }
+            // kernels only look entries up, inserting would move them
+            // under the other workers
+            if (context.m_ids) {
+                for (const NarrowphasePair& pair : m_buckets[bucket]) {
+                    m_contact_cache.Touch(context.m_ids[pair.m_a],
+                                          context.m_ids[pair.m_b]);
+                }
+            }
+            for (uint32_t begin = 0; begin < size; begin += ChunkSize) {
+                Chunk chunk;
+                chunk.m_bucket = bucket;
+                chunk.m_begin = begin;
+                chunk.m_end = std::min(size, begin + ChunkSize);
+                m_chunks.push_back(chunk);
+            }
+        }
+    }
+
+    m_worker_manifolds.resize(jobs.GetWorkerCount());
+    for (auto& buffer : m_worker_manifolds) {
+        buffer.clear();
+    }
+    jobs.ParallelFor(
+        static_cast<uint32_t>(m_chunks.size()), 1,
+        [&](uint32_t begin, uint32_t end, uint32_t worker) {
+            std::vector<ContactManifold>& buffer = m_worker_manifolds[worker];
+            for (uint32_t i = begin; i < end; i++) {
+                Chunk& chunk = m_chunks[i];
+                const auto& bucket = m_buckets[chunk.m_bucket];
+                CollideBatchFn kernel = m_kernels[chunk.m_bucket / TypeCount]
+                                                 [chunk.m_bucket % TypeCount];
+                chunk.m_worker = worker;
+                chunk.m_first = buffer.size();
+                kernel(bucket_context, bucket.data() + chunk.m_begin,
+                       chunk.m_end - chunk.m_begin, buffer);
+                chunk.m_last = buffer.size();
+            }
+        });
+
+    // chunks are in bucket order, whichever worker ran them
+    size_t first = manifolds.size();
+    for (const Chunk& chunk : m_chunks) {
+        const auto& buffer = m_worker_manifolds[chunk.m_worker];
+        manifolds.insert(manifolds.end(), buffer.begin() + chunk.m_first,
+                         buffer.begin() + chunk.m_last);
+    }
+
+    if (context.m_ids) {
+        for (size_t i = first; i < manifolds.size(); i++) {
+            ContactManifold& manifold = manifolds[i];
+            m_contact_cache.WarmStart(context.m_ids[manifold.m_body_a],
+                                      context.m_ids[manifold.m_body_b],
+                                      manifold);
+        }
+    }
+}
+
+void Narrowphase::StoreImpulses(const uint32_t* ids,
+                                const std::vector<ContactManifold>& manifolds) {
+    for (const ContactManifold& manifold : manifolds) {
+        m_contact_cache.StoreImpulses(ids[manifold.m_body_a],
+                                      ids[manifold.m_body_b], manifold);
+    }
+}
+
+}
@@ -11,8 +11,22 @@ Pose Pose::TransformBy(const Pose& o) const {
 
 Pose Pose::RelativeBy(const Pose& child) const {
     Pose p;
-    p.m_position = m_position - child.m_position;
-    p.m_rotation = m_rotation * child.m_rotation.inverse();
+    p.m_rotation = m_rotation * child.m_rotation.conjugate();
+    p.m_position = m_position - p.m_rotation * child.m_position;
+    return p;
+}
+
+Pose Pose::Inverse() const {
+    Pose p;
+    p.m_rotation = m_rotation.conjugate();
+    p.m_position = -(p.m_rotation * m_position);
+    return p;
+}
+
+Pose Pose::Lerp(const Pose& to, float t) const {
+    Pose p;
+    p.m_position = m_position + (to.m_position - m_position) * t;
+    p.m_rotation = m_rotation.slerp(t, to.m_rotation);
     return p;
 }
 
@@ -0,0 +1,103 @@
+#include "toy_physics/pose_batch.hpp"
+#include "pose_batch_kernel.hpp"
+
+#include <algorithm>
+
+namespace toy_physics {
+
+// wide paths leave the tail to the narrower ones
+void ComposePoses(const PoseBatch& poses, const PoseBatch& children,
+                  PoseBatch& out, SimdLevel level) {
+    level = std::min(level, GetSimdLevel());
+    out.Resize(poses.Size());
+
+    size_t i = 0;
+#ifdef TOY_PHYSICS_X86
+    if (level == SimdLevel::AVX2) {
+        i = ComposePosesAVX2(poses, children, out);
+    }
+#endif
+#ifdef TOY_PHYSICS_SSE2
+    if (level >= SimdLevel::SSE2) {
+        i = ComposePoseLanes<Float4>(poses, children, out, i);
+    }
+#endif
+    ComposePoseLanes<Float1>(poses, children, out, i);
+}
+
+void InvertPoses(const PoseBatch& poses, PoseBatch& out, SimdLevel level) {
+    level = std::min(level, GetSimdLevel());
+    out.Resize(poses.Size());
+
+    size_t i = 0;
+#ifdef TOY_PHYSICS_X86
+    if (level == SimdLevel::AVX2) {
+        i = InvertPosesAVX2(poses, out);
+    }
+#endif
+#ifdef TOY_PHYSICS_SSE2
+    if (level >= SimdLevel::SSE2) {
+        i = InvertPoseLanes<Float4>(poses, out, i);
+    }
+#endif
+    InvertPoseLanes<Float1>(poses, out, i);
+}
+
+void RelativePoses(const PoseBatch& poses, const PoseBatch& children,
+                   PoseBatch& out, SimdLevel level) {
+    level = std::min(level, GetSimdLevel());
+    out.Resize(poses.Size());
+
+    size_t i = 0;
+#ifdef TOY_PHYSICS_X86
+    if (level == SimdLevel::AVX2) {
+        i = RelativePosesAVX2(poses, children, out);
+    }
+#endif
+#ifdef TOY_PHYSICS_SSE2
+    if (level >= SimdLevel::SSE2) {
+        i = RelativePoseLanes<Float4>(poses, children, out, i);
+    }
+#endif
+    RelativePoseLanes<Float1>(poses, children, out, i);
+}
+
+void TransformPoints(const PoseBatch& poses, const Vec3Column& points,
+                     Vec3Column& out, SimdLevel level) {
+    level = std::min(level, GetSimdLevel());
+    out.Resize(poses.Size());
+
+    size_t i = 0;
+#ifdef TOY_PHYSICS_X86
+    if (level == SimdLevel::AVX2) {
+        i = TransformPointsAVX2(poses, points, out);
+    }
+#endif
+#ifdef TOY_PHYSICS_SSE2
+    if (level >= SimdLevel::SSE2) {
+        i = TransformPointLanes<Float4>(poses, points, out, i);
+    }
+#endif
+    TransformPointLanes<Float1>(poses, points, out, i);
+}
+
+void LerpPoses(const PoseBatch& from, const PoseBatch& to, float t,
+               PoseBatch& out, SimdLevel level) {
+    level = std::min(level, GetSimdLevel());
+    out.Resize(from.Size());
+
+    size_t i = 0;
+#ifdef TOY_PHYSICS_X86
+    if (level == SimdLevel::AVX2) {
+        i = LerpPosesAVX2(from, to, t, out);
+    }
+#endif
+#ifdef TOY_PHYSICS_SSE2
+    if (level >= SimdLevel::SSE2) {
+        i = LerpPoseLanes<Float4>(from, to, t, out, i);
+    }
+#endif
+    LerpPoseLanes<Float1>(from, to, t, out, i);
+}
+
+}
@@ -0,0 +1,40 @@
+// built with AVX2 enabled, only called after the runtime cpu check
+#include "toy_physics/simd.hpp"
+
+#ifdef TOY_PHYSICS_X86
+
+#ifndef __AVX2__
+#error "pose_batch_avx2.cpp must be compiled with AVX2 enabled"
+#endif
+
+#include "pose_batch_kernel.hpp"
+
+namespace toy_physics {
+
+size_t ComposePosesAVX2(const PoseBatch& poses, const PoseBatch& children,
+                        PoseBatch& out) {
+    return ComposePoseLanes<Float8>(poses, children, out, 0);
+}
+
+size_t InvertPosesAVX2(const PoseBatch& poses, PoseBatch& out) {
+    return InvertPoseLanes<Float8>(poses, out, 0);
+}
+
+size_t RelativePosesAVX2(const PoseBatch& poses, const PoseBatch& children,
+                         PoseBatch& out) {
+    return RelativePoseLanes<Float8>(poses, children, out, 0);
+}
+
+size_t TransformPointsAVX2(const PoseBatch& poses, const Vec3Column& points,
+                           Vec3Column& out) {
+    return TransformPointLanes<Float8>(poses, points, out, 0);
+}
+
+size_t LerpPosesAVX2(const PoseBatch& from, const PoseBatch& to, float t,
+                     PoseBatch& out) {
+    return LerpPoseLanes<Float8>(from, to, t, out, 0);
+}
+
+}
+
+#endif
@@ -0,0 +1,188 @@
+#pragma once
+#include "toy_physics/pose_batch.hpp"
+#include "simd_lanes.hpp"
+
+// lane generic pose kernels shared by the scalar, SSE2 and AVX2
+// translation units, see simd_lanes.hpp
+
+namespace toy_physics {
+
+#ifdef TOY_PHYSICS_X86
+size_t ComposePosesAVX2(const PoseBatch& poses, const PoseBatch& children,
+                        PoseBatch& out);
+size_t InvertPosesAVX2(const PoseBatch& poses, PoseBatch& out);
+size_t RelativePosesAVX2(const PoseBatch& poses, const PoseBatch& children,
+                         PoseBatch& out);
+size_t TransformPointsAVX2(const PoseBatch& poses, const Vec3Column& points,
+                           Vec3Column& out);
+size_t LerpPosesAVX2(const PoseBatch& from, const PoseBatch& to, float t,
+                     PoseBatch& out);
+#endif
+
+namespace {
+
+template <typename F>
+struct QuatLanes {
+    Vec3Lanes<F> m_v;
+    F m_w;
+
+    static QuatLanes Load(const QuatColumn& column, size_t i) {
+        return {{F::Load(&column.m_x[i]), F::Load(&column.m_y[i]),
+                 F::Load(&column.m_z[i])},
+                F::Load(&column.m_w[i])};
+    }
+
+    void Store(QuatColumn& column, size_t i) const {
+        m_v.m_x.Store(&column.m_x[i]);
+        m_v.m_y.Store(&column.m_y[i]);
+        m_v.m_z.Store(&column.m_z[i]);
+        m_w.Store(&column.m_w[i]);
+    }
+
+    QuatLanes operator*(const QuatLanes& o) const {
+        return {o.m_v * m_w + m_v * o.m_w + m_v.Cross(o.m_v),
+                m_w * o.m_w - m_v.Dot(o.m_v)};
+    }
+
+    QuatLanes Conjugate() const {
+        return {Vec3Lanes<F>{F(0.0f), F(0.0f), F(0.0f)} - m_v, m_w};
+    }
+
+    // same steps as Eigen's quaternion times vector
+    Vec3Lanes<F> Rotate(const Vec3Lanes<F>& v) const {
+        Vec3Lanes<F> uv = m_v.Cross(v);
+        uv = uv + uv;
+        return v + uv * m_w + m_v.Cross(uv);
+    }
+};
+
+template <typename F>
+struct PoseLanes {
+    Vec3Lanes<F> m_position;
+    QuatLanes<F> m_rotation;
+
+    static PoseLanes Load(const PoseBatch& batch, size_t i) {
+        return {Vec3Lanes<F>::Load(batch.m_position, i),
+                QuatLanes<F>::Load(batch.m_rotation, i)};
+    }
+
+    void Store(PoseBatch& batch, size_t i) const {
+        m_position.Store(batch.m_position, i);
+        m_rotation.Store(batch.m_rotation, i);
+    }
+};
+
+template <typename F>
+size_t ComposePoseLanes(const PoseBatch& poses, const PoseBatch& children,
+                        PoseBatch& out, size_t begin) {
+    size_t count = poses.Size();
+    size_t i = begin;
+    for (; i + F::Width <= count; i += F::Width) {
+        PoseLanes<F> a = PoseLanes<F>::Load(poses, i);
+        PoseLanes<F> b = PoseLanes<F>::Load(children, i);
+        PoseLanes<F>{a.m_position + a.m_rotation.Rotate(b.m_position),
+                     a.m_rotation * b.m_rotation}
+            .Store(out, i);
+    }
+    return i;
+}
+
+template <typename F>
+size_t InvertPoseLanes(const PoseBatch& poses, PoseBatch& out,
+                       size_t begin) {
+    size_t count = poses.Size();
+    size_t i = begin;
+    for (; i + F::Width <= count; i += F::Width) {
+        PoseLanes<F> a = PoseLanes<F>::Load(poses, i);
+        QuatLanes<F> rotation = a.m_rotation.Conjugate();
+        Vec3Lanes<F> zero{F(0.0f), F(0.0f), F(0.0f)};
+        PoseLanes<F>{zero - rotation.Rotate(a.m_position), rotation}.Store(
+            out, i);
+    }
+    return i;
+}
+
+template <typename F>
+size_t RelativePoseLanes(const PoseBatch& poses, const PoseBatch& children,
+                         PoseBatch& out, size_t begin) {
+    size_t count = poses.Size();
+    size_t i = begin;
+    for (; i + F::Width <= count; i += F::Width) {
+        PoseLanes<F> a = PoseLanes<F>::Load(poses, i);
+        PoseLanes<F> b = PoseLanes<F>::Load(children, i);
+        QuatLanes<F> rotation = a.m_rotation * b.m_rotation.Conjugate();
+        PoseLanes<F>{a.m_position - rotation.Rotate(b.m_position), rotation}
+            .Store(out, i);
+    }
+    return i;
+}
+
+template <typename F>
+size_t TransformPointLanes(const PoseBatch& poses, const Vec3Column& points,
+                           Vec3Column& out, size_t begin) {
+    size_t count = poses.Size();
+    size_t i = begin;
+    for (; i + F::Width <= count; i += F::Width) {
+        PoseLanes<F> a = PoseLanes<F>::Load(poses, i);
+        Vec3Lanes<F> p = Vec3Lanes<F>::Load(points, i);
+        (a.m_position + a.m_rotation.Rotate(p)).Store(out, i);
+    }
+    return i;
+}
+
+// sin(t theta) / sin(theta) as a series in cos(theta) - 1, D. Eberly, "A
+// Fast and Accurate Algorithm for Computing SLERP". The last term is scaled
+// to make up for the cut off tail, fitted for theta up to 90 degrees. The
+// rotations stay within 5e-7 of Pose::Lerp, checked by pose_batch_test
+constexpr size_t SlerpTerms = 14;
+constexpr float SlerpTailScale = 1.9066f;
+
+template <typename F>
+F SlerpWeight(F t, F x_minus_1) {
+    F t2 = t * t;
+    F weight(1.0f);
+    for (size_t k = SlerpTerms; k > 0; k--) {
+        float u = 1.0f / float(k * (2 * k + 1));
+        float v = float(k) / float(2 * k + 1);
+        if (k == SlerpTerms) {
+            u *= SlerpTailScale;
+            v *= SlerpTailScale;
+        }
+        weight = F(1.0f) + (F(u) * t2 - F(v)) * x_minus_1 * weight;
+    }
+    return t * weight;
+}
+
+template <typename F>
+size_t LerpPoseLanes(const PoseBatch& from, const PoseBatch& to, float t,
+                     PoseBatch& out, size_t begin) {
+    size_t count = from.Size();
+    size_t i = begin;
+    F t_lanes(t);
+    F s_lanes(1.0f - t);
+    for (; i + F::Width <= count; i += F::Width) {
+        PoseLanes<F> a = PoseLanes<F>::Load(from, i);
+        PoseLanes<F> b = PoseLanes<F>::Load(to, i);
+
+        // take the short way around, the series needs cos(theta) >= 0
+        F dot = a.m_rotation.m_v.Dot(b.m_rotation.m_v) +
+                a.m_rotation.m_w * b.m_rotation.m_w;
+        F sign = Select(dot < F(0.0f), F(-1.0f), F(1.0f));
+        F x_minus_1 = dot * sign - F(1.0f);
+        F weight_a = SlerpWeight(s_lanes, x_minus_1);
+        F weight_b = SlerpWeight(t_lanes, x_minus_1) * sign;
+
+        QuatLanes<F> rotation{a.m_rotation.m_v * weight_a +
+                                  b.m_rotation.m_v * weight_b,
+                              a.m_rotation.m_w * weight_a +
+                                  b.m_rotation.m_w * weight_b};
+        PoseLanes<F>{a.m_position + (b.m_position - a.m_position) * t_lanes,
+                     rotation}
+            .Store(out, i);
+    }
+    return i;
+}
+
+}
+
+}
@@ -0,0 +1,349 @@
+#include "toy_physics/profiler.hpp"
+#include "toy_physics/log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace toy_physics {
+
+enum class ProfileEventKind : uint32_t {
+    Scope,
+    // TOY_PHYSICS_PROFILE_ONE_READ only, ends where the next scope or
+    // counter of its thread begins, or with its parent
+    NestedScope,
+    Counter,
+};
+
+// written when a scope ends, so a scope follows everything nested in it
+struct ProfileEvent {
+    const char* m_name;
+    // begin of a scope, time of a counter
+    uint64_t m_ticks;
+    // end ticks of a Scope, value of a counter
+    int64_t m_value;
+    ProfileEventKind m_kind;
+};
+
+// ring written by a single thread. m_head counts every event ever written,
+// the event n sits at n % BufferCapacity
+struct ProfileBuffer {
+    std::unique_ptr<ProfileEvent[]> m_events{
+        new ProfileEvent[Profiler::BufferCapacity]};
+    std::atomic<uint64_t> m_head{0};
+    // events before this were dropped by Clear()
+    std::atomic<uint64_t> m_first{0};
+
+    // guarded by the registry mutex
+    std::array<char, 32> m_thread_name{};
+    bool m_in_use = false;
+};
+
+// buffers outlive their threads, so a trace can be written after a job
+// system shut down. Buffers of finished threads are handed to new threads
+// and keep their events
+struct ProfileRegistry {
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<ProfileBuffer>> m_buffers;
+
+    // both clocks at the start of the trace, to convert ticks
+    bool m_started = false;
+    uint64_t m_start_ticks = 0;
+    std::chrono::steady_clock::time_point m_start_time;
+
+    void Start() {
+        m_started = true;
+        m_start_ticks = ReadProfileTicks();
+        m_start_time = std::chrono::steady_clock::now();
+    }
+};
+
+static ProfileRegistry& GetRegistry() {
+    static ProfileRegistry registry;
+    return registry;
+}
+
+static thread_local std::array<char, 32> t_thread_name{};
+// set while the thread holds a buffer. A plain pointer, so recording
+// skips the initialization guard of the lease
+static thread_local ProfileBuffer* t_buffer = nullptr;
+
+static void CopyName(std::array<char, 32>& out, const char* name) {
+    size_t size = std::min(std::char_traits<char>::length(name),
+                           out.size() - 1);
+    std::copy_n(name, size, out.begin());
+    out[size] = '\0';
+}
+
+// the calling thread's buffer while the thread lives
+class ProfileBufferLease {
+public:
+    ProfileBufferLease() {
+        ProfileRegistry& registry = GetRegistry();
+        std::lock_guard lock{registry.m_mutex};
+        for (auto& buffer : registry.m_buffers) {
+            if (!buffer->m_in_use) {
+                m_buffer = buffer.get();
+                break;
+            }
+        }
+        if (!m_buffer) {
+            registry.m_buffers.push_back(std::make_unique<ProfileBuffer>());
+            m_buffer = registry.m_buffers.back().get();
+        }
+        m_buffer->m_in_use = true;
+        if (t_thread_name[0] != '\0') {
+            m_buffer->m_thread_name = t_thread_name;
+        }
+        t_buffer = m_buffer;
+    }
+
+    ~ProfileBufferLease() {
+        std::lock_guard lock{GetRegistry().m_mutex};
+        m_buffer->m_in_use = false;
+        t_buffer = nullptr;
+    }
+
+    ProfileBuffer* GetBuffer() const { return m_buffer; }
+
+private:
+    ProfileBuffer* m_buffer = nullptr;
+};
+
+// keeps the cold path out of the recording functions, which otherwise
+// save and restore registers for it on every event
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TOY_PHYSICS_NOINLINE __declspec(noinline)
+#else
+#define TOY_PHYSICS_NOINLINE __attribute__((noinline))
+#endif
+
+// taken on the first event, threads that never record don't get a buffer
+TOY_PHYSICS_NOINLINE static ProfileBuffer& GetThreadBuffer() {
+    static thread_local ProfileBufferLease lease;
+    return *lease.GetBuffer();
+}
+
+// fields are stored one by one, copying an event built on the stack
+// stalls on store forwarding
+static void Record(const char* name, uint64_t ticks, int64_t value,
+                   ProfileEventKind kind) {
+    ProfileBuffer* buffer = t_buffer;
+    if (!buffer) [[unlikely]] {
+        buffer = &GetThreadBuffer();
+    }
+    uint64_t head = buffer->m_head.load(std::memory_order_relaxed);
+    ProfileEvent& event =
+        buffer->m_events[head & (Profiler::BufferCapacity - 1)];
+    event.m_name = name;
+    event.m_ticks = ticks;
+    event.m_value = value;
+    event.m_kind = kind;
+    buffer->m_head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::SetRecording(bool recording) {
+    if (recording) {
+        ProfileRegistry& registry = GetRegistry();
+        std::lock_guard lock{registry.m_mutex};
+        if (!registry.m_started) {
+            registry.Start();
+        }
+    }
+    s_recording.store(recording, std::memory_order_relaxed);
+}
+
+#ifdef TOY_PHYSICS_PROFILE_ONE_READ
+// the outermost scope reads the clock, kept out of line so nested scopes
+// don't pay for its registers
+TOY_PHYSICS_NOINLINE static void RecordOutermostScope(const char* name,
+                                                      uint64_t begin) {
+    Record(name, begin, static_cast<int64_t>(ReadProfileTicks()),
+           ProfileEventKind::Scope);
+}
+
+void Profiler::EndScope(const void* scope, const char* name,
+                        uint64_t begin) {
+    if (s_outermost_scope == scope) {
+        s_outermost_scope = nullptr;
+        RecordOutermostScope(name, begin);
+    } else {
+        Record(name, begin, 0, ProfileEventKind::NestedScope);
+    }
+}
+#else
+void Profiler::EndScope(const void*, const char* name, uint64_t begin) {
+    Record(name, begin, static_cast<int64_t>(ReadProfileTicks()),
+           ProfileEventKind::Scope);
+}
+#endif
+
+void Profiler::RecordCounter(const char* name, int64_t value) {
+    Record(name, ReadProfileTicks(), value, ProfileEventKind::Counter);
+}
+
+void Profiler::SetThreadName(const char* name) {
+    CopyName(t_thread_name, name);
+    // threads that didn't record yet pick the name up with their buffer
+    if (t_buffer) {
+        std::lock_guard lock{GetRegistry().m_mutex};
+        t_buffer->m_thread_name = t_thread_name;
+    }
+}
+
+void Profiler::Clear() {
+    ProfileRegistry& registry = GetRegistry();
+    std::lock_guard lock{registry.m_mutex};
+    for (auto& buffer : registry.m_buffers) {
+        buffer->m_first.store(buffer->m_head.load(std::memory_order_acquire),
+                              std::memory_order_relaxed);
+    }
+    registry.m_started = false;
+    if (IsRecording()) {
+        registry.Start();
+    }
+}
+
+static void WriteJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\' << *c;
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            out << ' ';
+        } else {
+            out << *c;
+        }
+    }
+    out << '"';
+}
+
+struct ScopeContext {
+    uint64_t m_begin;
+    uint64_t m_next;
+};
+
+void Profiler::WriteChromeTrace(std::ostream& out) {
+    ProfileRegistry& registry = GetRegistry();
+    std::lock_guard lock{registry.m_mutex};
+
+    // ticks per microsecond, measured over at least a millisecond
+    double ticks_per_us = 1;
+    if (registry.m_started) {
+        auto start = registry.m_start_time;
+        while (std::chrono::steady_clock::now() - start <
+               std::chrono::milliseconds{1}) {
+            std::this_thread::yield();
+        }
+        uint64_t ticks = ReadProfileTicks() - registry.m_start_ticks;
+        double us = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+        ticks_per_us = std::max(ticks / us, 1e-9);
+    }
+    // rounded to the printed nanosecond, so a scope ending where its
+    // parent ends doesn't reach past it by the last digit
+    auto to_us = [&](uint64_t ticks) {
+        return ticks < registry.m_start_ticks
+                   ? 0.0
+                   : std::round((ticks - registry.m_start_ticks) /
+                                ticks_per_us * 1000) /
+                         1000;
+    };
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    const char* separator = "\n";
+    std::vector<ProfileEvent> events;
+    std::vector<ScopeContext> contexts;
+    for (size_t track = 0; track < registry.m_buffers.size(); track++) {
+        const ProfileBuffer& buffer = *registry.m_buffers[track];
+        uint32_t tid = static_cast<uint32_t>(track + 1);
+        if (buffer.m_thread_name[0] != '\0') {
+            out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\","
+                << "\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":";
+            WriteJsonString(out, buffer.m_thread_name.data());
+            out << "}}";
+            separator = ",\n";
+        }
+
+        // copy, then drop whatever the owner may have overwritten meanwhile
+        uint64_t head = buffer.m_head.load(std::memory_order_acquire);
+        uint64_t first = std::max(
+            buffer.m_first.load(std::memory_order_relaxed),
+            head > BufferCapacity ? head - BufferCapacity : 0);
+        events.clear();
+        for (uint64_t i = first; i < head; i++) {
+            events.push_back(buffer.m_events[i & (BufferCapacity - 1)]);
+        }
+        uint64_t new_head = buffer.m_head.load(std::memory_order_acquire);
+        // the owner may be writing event new_head, which overwrites
+        // new_head - BufferCapacity, so that one is lost as well
+        if (new_head >= BufferCapacity &&
+            new_head - BufferCapacity + 1 > first) {
+            uint64_t lost = new_head - BufferCapacity + 1 - first;
+            events.erase(events.begin(),
+                         events.begin() + std::min<uint64_t>(
+                                              lost, events.size()));
+        }
+
+        // walking backwards, the stack holds the scopes the current event
+        // may be nested in, each with the begin of its next child. The
+        // bottom stands for the thread outside of any recorded scope
+        contexts.assign(1, {0, UINT64_MAX});
+        for (size_t i = events.size(); i-- > 0;) {
+            const ProfileEvent& event = events[i];
+            while (contexts.back().m_begin > event.m_ticks) {
+                contexts.pop_back();
+            }
+            ScopeContext& parent = contexts.back();
+            if (event.m_kind == ProfileEventKind::Counter) {
+                out << separator << "{\"name\":";
+                WriteJsonString(out, event.m_name);
+                out << ",\"ph\":\"C\",\"pid\":1,\"tid\":" << tid
+                    << ",\"ts\":" << to_us(event.m_ticks)
+                    << ",\"args\":{\"value\":" << event.m_value << "}}";
+                separator = ",\n";
+                parent.m_next = event.m_ticks;
+                continue;
+            }
+
+            uint64_t end = event.m_kind == ProfileEventKind::Scope
+                               ? static_cast<uint64_t>(event.m_value)
+                               : parent.m_next;
+            parent.m_next = event.m_ticks;
+            contexts.push_back({event.m_ticks, end});
+            // UINT64_MAX when the parent is still open
+            if (end == UINT64_MAX) {
+                continue;
+            }
+            double begin = to_us(event.m_ticks);
+            out << separator << "{\"name\":";
+            WriteJsonString(out, event.m_name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << begin
+                << ",\"dur\":" << std::max(to_us(end) - begin, 0.0) << "}";
+            separator = ",\n";
+        }
+    }
+    out << "\n]}\n";
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) {
+    std::ofstream file{path};
+    if (!file) {
+        LOGE("can't write {}", path);
+        return false;
+    }
+    WriteChromeTrace(file);
+    return static_cast<bool>(file);
+}
+
+}
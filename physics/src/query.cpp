@@ -0,0 +1,42 @@
+#include "toy_physics/query.hpp"
+
+#include <algorithm>
+
+namespace toy_physics {
+
+void AddQueryHit(QueryMode mode, const QueryHit& hit, QueryHit* hits,
+                 uint32_t capacity, uint32_t& count, float& max_distance) {
+    float distance = hit.m_hit.m_distance;
+    switch (mode) {
+        case QueryMode::Closest:
+            if (count == 0 || distance < hits[0].m_hit.m_distance) {
+                hits[0] = hit;
+                count = 1;
+                max_distance = distance;
+            }
+            return;
+        case QueryMode::Any:
+            hits[0] = hit;
+            count = 1;
+            max_distance = -1;
+            return;
+        case QueryMode::All: {
+            // sorted insert, the farthest falls off when full
+            uint32_t i = std::min(count, capacity - 1);
+            if (count == capacity && hits[i].m_hit.m_distance <= distance) {
+                return;
+            }
+            for (; i > 0 && hits[i - 1].m_hit.m_distance > distance; i--) {
+                hits[i] = hits[i - 1];
+            }
+            hits[i] = hit;
+            count = std::min(count + 1, capacity);
+            if (count == capacity) {
+                max_distance = hits[count - 1].m_hit.m_distance;
+            }
+            return;
+        }
+    }
+}
+
+}
@@ -0,0 +1,204 @@
+#include "toy_physics/query_snapshot.hpp"
+#include "toy_physics/log.hpp"
+
+namespace toy_physics {
+
+bool QuerySnapshot::IsValid(BodyHandle handle) const {
+    return getEntry(handle) != nullptr;
+}
+
+Pose QuerySnapshot::GetPose(BodyHandle handle) const {
+    const Entry* entry = getEntry(handle);
+    if (!entry) {
+        LOGE("access invalid body handle {}", handle.m_index);
+        return {};
+    }
+    return entry->m_pose;
+}
+
+template <typename T, typename CastFn>
+uint32_t QuerySnapshot::castOne(const T& query, QueryMode mode,
+                                QueryHit* hits, uint32_t capacity,
+                                const CastFn& fn) const {
+    if (capacity == 0) {
+        LOGE("query hit buffer has no capacity");
+        return 0;
+    }
+
+    uint32_t count = 0;
+    AABBCast aabb_cast = MakeAABBCast(query);
+    T limited = query;
+    m_tree.CastQuery(&aabb_cast, 1, [&](uint32_t, uint32_t proxy) {
+        uint32_t slot = m_tree.GetUserData(proxy);
+        const Entry& entry = m_entries[slot];
+        CastHit hit;
+        if (!fn(limited, m_geometries.Get(entry.m_geom), entry.m_shape_pose,
+                hit)) {
+            return;
+        }
+
+        AddQueryHit(mode, {{slot, entry.m_generation}, hit}, hits, capacity,
+                    count, limited.m_max_distance);
+        if (limited.m_max_distance < 0) {
+            aabb_cast.m_max_fraction = -1;
+        } else if (query.m_max_distance > 0) {
+            aabb_cast.m_max_fraction =
+                limited.m_max_distance / query.m_max_distance;
+        }
+    });
+    return count;
+}
+
+uint32_t QuerySnapshot::Raycast(const Ray& ray, QueryMode mode,
+                                QueryHit* hits, uint32_t capacity) const {
+    return castOne(ray, mode, hits, capacity,
+                   [](const Ray& ray, const Geometry& geom, const Pose& pose,
+                      CastHit& hit) {
+                       return toy_physics::Raycast(geom, pose, ray, hit);
+                   });
+}
+
+uint32_t QuerySnapshot::Sweep(const ShapeCast& cast, QueryMode mode,
+                              QueryHit* hits, uint32_t capacity) const {
+    return castOne(cast, mode, hits, capacity,
+                   [](const ShapeCast& cast, const Geometry& geom,
+                      const Pose& pose, CastHit& hit) {
+                       return CastShape(cast, geom, pose, hit);
+                   });
+}
+
+void QuerySnapshot::BeginUpdate(const GeometryPool& geometries,
+                                size_t slot_count,
+                                const Eigen::Vector3d& origin) {
+    m_update++;
+    // moving every proxy by the same offset keeps the tree valid, instead
+    // of every body looking like it jumped a region
+    if (origin != m_origin) {
+        Eigen::Vector3f offset = (m_origin - origin).cast<float>();
+        m_origin = origin;
+        m_tree.ShiftOrigin(offset);
+        for (Entry& entry : m_entries) {
+            entry.m_pose.m_position += offset;
+            entry.m_shape_pose.m_position += offset;
+            entry.m_aabb = entry.m_aabb.Translate(offset);
+        }
+    }
+    // the pool is only copied after it grew or was replaced, e.g. by
+    // loading a world snapshot
+    if (geometries.GetVersion() != m_geometries.GetVersion()) {
+        m_geometries = geometries;
+    }
+    if (m_entries.size() < slot_count) {
+        m_entries.resize(slot_count);
+    }
+}
+
+void QuerySnapshot::SetBody(uint32_t slot, uint32_t generation,
+                            const Pose& pose, const Pose& shape_pose,
+                            GeometryHandle geom, const AABB& aabb) {
+    Entry& entry = m_entries[slot];
+    entry.m_pose = pose;
+    entry.m_shape_pose = shape_pose;
+    entry.m_geom = geom;
+    entry.m_generation = generation;
+    entry.m_update = m_update;
+
+    if (!geom) {
+        if (entry.m_proxy != DynamicAABBTree::NullNode) {
+            m_tree.DestroyProxy(entry.m_proxy);
+            entry.m_proxy = DynamicAABBTree::NullNode;
+        }
+        return;
+    }
+
+    if (entry.m_proxy == DynamicAABBTree::NullNode) {
+        entry.m_proxy = m_tree.CreateProxy(aabb, slot);
+    } else {
+        m_tree.MoveProxy(entry.m_proxy, aabb,
+                         aabb.GetCenter() - entry.m_aabb.GetCenter());
+    }
+    entry.m_aabb = aabb;
+}
+
+void QuerySnapshot::EndUpdate() {
+    for (Entry& entry : m_entries) {
+        if (entry.m_update == m_update || entry.m_update == 0) {
+            continue;
+        }
+        if (entry.m_proxy != DynamicAABBTree::NullNode) {
+            m_tree.DestroyProxy(entry.m_proxy);
+            entry.m_proxy = DynamicAABBTree::NullNode;
+        }
+        entry.m_update = 0;
+    }
+}
+
+const QuerySnapshot::Entry* QuerySnapshot::getEntry(BodyHandle handle) const {
+    if (handle.m_index >= m_entries.size()) {
+        return nullptr;
+    }
+    const Entry& entry = m_entries[handle.m_index];
+    if (entry.m_update != m_update ||
+        entry.m_generation != handle.m_generation) {
+        return nullptr;
+    }
+    return &entry;
+}
+
+QuerySnapshotRef::~QuerySnapshotRef() {
+    if (m_snapshot) {
+        m_snapshot->m_readers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+QuerySnapshotRef::QuerySnapshotRef(QuerySnapshotRef&& other) noexcept
+    : m_snapshot{other.m_snapshot} {
+    other.m_snapshot = nullptr;
+}
+
+QuerySnapshotRef& QuerySnapshotRef::operator=(
+    QuerySnapshotRef&& other) noexcept {
+    if (this != &other) {
+        if (m_snapshot) {
+            m_snapshot->m_readers.fetch_sub(1, std::memory_order_release);
+        }
+        m_snapshot = other.m_snapshot;
+        other.m_snapshot = nullptr;
+    }
+    return *this;
+}
+
+QuerySnapshotRef QuerySnapshotPublisher::Acquire() const {
+    // pin, then make sure the snapshot is still current. The writer checks
+    // the pin after swapping the current one, so either it sees the pin or
+    // we see the swap and retry. Only a publish in between makes us retry
+    while (true) {
+        QuerySnapshot* snapshot = m_current.load();
+        if (!snapshot) {
+            return {};
+        }
+        snapshot->m_readers.fetch_add(1);
+        if (m_current.load() == snapshot) {
+            return QuerySnapshotRef{snapshot};
+        }
+        snapshot->m_readers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+QuerySnapshot& QuerySnapshotPublisher::BeginWrite() {
+    QuerySnapshot* current = m_current.load(std::memory_order_relaxed);
+    for (auto& snapshot : m_snapshots) {
+        if (snapshot.get() != current && snapshot->m_readers.load() == 0) {
+            return *snapshot;
+        }
+    }
+    m_snapshots.push_back(std::make_unique<QuerySnapshot>());
+    return *m_snapshots.back();
+}
+
+void QuerySnapshotPublisher::Publish(QuerySnapshot& snapshot) {
+    snapshot.m_epoch = ++m_epoch;
+    m_current.store(&snapshot);
+}
+
+}
@@ -0,0 +1,234 @@
+#include "toy_physics/raycast.hpp"
+#include "toy_physics/collision.hpp"
+#include "toy_physics/gjk.hpp"
+#include "toy_physics/toi.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace toy_physics {
+
+static bool HitInside(const Ray& ray, CastHit& hit) {
+    hit.m_distance = 0;
+    hit.m_point = ray.m_origin;
+    hit.m_normal = -ray.m_direction;
+    return true;
+}
+
+// first entry of a ray starting outside the sphere
+static bool RaySphere(const Eigen::Vector3f& origin,
+                      const Eigen::Vector3f& direction,
+                      const Eigen::Vector3f& center, float radius, float& t) {
+    Eigen::Vector3f oc = origin - center;
+    float b = oc.dot(direction);
+    float c = oc.squaredNorm() - radius * radius;
+    float h = b * b - c;
+    if (b > 0 || h < 0) {
+        return false;
+    }
+    t = -b - std::sqrt(h);
+    return true;
+}
+
+static Eigen::Vector3f ClosestPointOnSegment(const Eigen::Vector3f& p,
+                                             const Eigen::Vector3f& q,
+                                             const Eigen::Vector3f& point) {
+    Eigen::Vector3f pq = q - p;
+    float length2 = pq.squaredNorm();
+    if (length2 <= std::numeric_limits<float>::epsilon()) {
+        return p;
+    }
+    float s = std::clamp((point - p).dot(pq) / length2, 0.0f, 1.0f);
+    return p + pq * s;
+}
+
+bool Raycast(const BoxGeometry& box, const Pose& pose, const Ray& ray,
+             CastHit& hit) {
+    Eigen::Quaternionf inv_rotation = pose.m_rotation.conjugate();
+    Eigen::Vector3f origin = inv_rotation * (ray.m_origin - pose.m_position);
+    Eigen::Vector3f direction = inv_rotation * ray.m_direction;
+
+    float enter = -std::numeric_limits<float>::max();
+    float exit = std::numeric_limits<float>::max();
+    int axis = 0;
+    for (int i = 0; i < 3; i++) {
+        float half = box.m_half_size[i];
+        if (std::abs(direction[i]) < 1e-8f) {
+            if (std::abs(origin[i]) > half) {
+                return false;
+            }
+            continue;
+        }
+        float inv = 1.0f / direction[i];
+        float t1 = (-half - origin[i]) * inv;
+        float t2 = (half - origin[i]) * inv;
+        if (t1 > t2) {
+            std::swap(t1, t2);
+        }
+        if (t1 > enter) {
+            enter = t1;
+            axis = i;
+        }
+        exit = std::min(exit, t2);
+    }
+
+    if (enter > exit || exit < 0 || enter > ray.m_max_distance) {
+        return false;
+    }
+    if (enter < 0) {
+        return HitInside(ray, hit);
+    }
+
+    Eigen::Vector3f normal = Eigen::Vector3f::Zero();
+    normal[axis] = direction[axis] > 0 ? -1.0f : 1.0f;
+    hit.m_distance = enter;
+    hit.m_point = ray.m_origin + ray.m_direction * enter;
+    hit.m_normal = pose.m_rotation * normal;
+    return true;
+}
+
+bool Raycast(const SphereGeometry& sphere, const Pose& pose, const Ray& ray,
+             CastHit& hit) {
+    if ((ray.m_origin - pose.m_position).squaredNorm() <=
+        sphere.m_radius * sphere.m_radius) {
+        return HitInside(ray, hit);
+    }
+
+    float t;
+    if (!RaySphere(ray.m_origin, ray.m_direction, pose.m_position,
+                   sphere.m_radius, t) ||
+        t > ray.m_max_distance) {
+        return false;
+    }
+    hit.m_distance = t;
+    hit.m_point = ray.m_origin + ray.m_direction * t;
+    hit.m_normal = (hit.m_point - pose.m_position).normalized();
+    return true;
+}
+
+bool Raycast(const CapsuleGeometry& capsule, const Pose& pose, const Ray& ray,
+             CastHit& hit) {
+    Eigen::Vector3f p, q;
+    GetCapsuleSegment(capsule, pose, p, q);
+    float radius2 = capsule.m_radius * capsule.m_radius;
+    if ((ray.m_origin - ClosestPointOnSegment(p, q, ray.m_origin))
+            .squaredNorm() <= radius2) {
+        return HitInside(ray, hit);
+    }
+
+    // the capsule is the union of its side and end spheres, the first
+    // entry of the union is the first entry of any part
+    float best = std::numeric_limits<float>::max();
+    Eigen::Vector3f ba = q - p;
+    Eigen::Vector3f oa = ray.m_origin - p;
+    float baba = ba.dot(ba);
+    float bard = ba.dot(ray.m_direction);
+    float baoa = ba.dot(oa);
+    float a = baba - bard * bard;
+    if (a > 1e-6f * baba) {
+        float b = baba * ray.m_direction.dot(oa) - baoa * bard;
+        float c = baba * oa.dot(oa) - baoa * baoa - radius2 * baba;
+        float h = b * b - a * c;
+        if (h >= 0) {
+            float t = (-b - std::sqrt(h)) / a;
+            float y = baoa + t * bard;
+            if (t >= 0 && y > 0 && y < baba) {
+                best = t;
+            }
+        }
+    }
+
+    float t;
+    for (const Eigen::Vector3f& end : {p, q}) {
+        if (RaySphere(ray.m_origin, ray.m_direction, end, capsule.m_radius,
+                      t)) {
+            best = std::min(best, t);
+        }
+    }
+    if (best > ray.m_max_distance) {
+        return false;
+    }
+
+    hit.m_distance = best;
+    hit.m_point = ray.m_origin + ray.m_direction * best;
+    hit.m_normal =
+        (hit.m_point - ClosestPointOnSegment(p, q, hit.m_point)).normalized();
+    return true;
+}
+
+bool Raycast(const Geometry& geom, const Pose& pose, const Ray& ray,
+             CastHit& hit) {
+    switch (geom.GetType()) {
+        case Geometry::Type::Box:
+            return Raycast(static_cast<const BoxGeometry&>(geom), pose, ray,
+                           hit);
+        case Geometry::Type::Sphere:
+            return Raycast(static_cast<const SphereGeometry&>(geom), pose,
+                           ray, hit);
+        case Geometry::Type::Capsule:
+            return Raycast(static_cast<const CapsuleGeometry&>(geom), pose,
+                           ray, hit);
+    }
+    return false;
+}
+
+bool CastShape(const ShapeCast& cast, const Geometry& geom, const Pose& pose,
+               CastHit& hit) {
+    SphereGeometry sphere{cast.m_radius};
+    CapsuleGeometry capsule{cast.m_radius, cast.m_height};
+    const Geometry& cast_geom =
+        cast.m_height > 0 ? static_cast<const Geometry&>(capsule) : sphere;
+
+    Sweep sweep;
+    sweep.m_body = cast.m_pose;
+    sweep.m_linear = cast.m_direction * cast.m_max_distance;
+    Sweep target;
+    target.m_body = pose;
+
+    // accurate to a millimeter, the shapes are allowed to touch
+    ToiSettings settings;
+    settings.m_target_separation = 0;
+    settings.m_tolerance = 1e-3f;
+    ToiOutput output = TimeOfImpact(cast_geom, sweep, geom, target, settings);
+    if (output.m_state == ToiOutput::State::Separated) {
+        return false;
+    }
+    if (output.m_state == ToiOutput::State::Touching) {
+        hit.m_distance = 0;
+        hit.m_point = cast.m_pose.m_position;
+        hit.m_normal = -cast.m_direction;
+        return true;
+    }
+
+    ConvexProxy proxy_a =
+        MakeConvexProxy(cast_geom, sweep.GetShapePose(output.m_t));
+    ConvexProxy proxy_b = MakeConvexProxy(geom, pose);
+    GjkOutput gjk = GjkDistance(proxy_a, proxy_b, nullptr);
+    // points from the hit shape towards the cast
+    Eigen::Vector3f normal = -cast.m_direction;
+    if (gjk.m_distance > 1e-6f) {
+        normal = (gjk.m_point_a - gjk.m_point_b) / gjk.m_distance;
+    }
+    hit.m_distance = output.m_t * cast.m_max_distance;
+    hit.m_point = gjk.m_point_b + normal * proxy_b.m_radius;
+    hit.m_normal = normal;
+    return true;
+}
+
+AABBCast MakeAABBCast(const Ray& ray) {
+    return AABBCast::Make(ray.m_origin, ray.m_direction * ray.m_max_distance,
+                          Eigen::Vector3f::Zero());
+}
+
+AABBCast MakeAABBCast(const ShapeCast& cast) {
+    AABB aabb = cast.m_height > 0
+                    ? ComputeAABB(CapsuleGeometry{cast.m_radius, cast.m_height},
+                                  cast.m_pose)
+                    : ComputeAABB(SphereGeometry{cast.m_radius}, cast.m_pose);
+    return AABBCast::Make(aabb.GetCenter(),
+                          cast.m_direction * cast.m_max_distance,
+                          aabb.GetHalfSize());
+}
+
+}
@@ -0,0 +1,61 @@
+#include "toy_physics/simd.hpp"
+
+#if defined(TOY_PHYSICS_X86) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace toy_physics {
+
+static bool SupportAVX2() {
+#if !defined(TOY_PHYSICS_X86)
+    return false;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool os_xsave = info[2] & (1 << 27);
+    bool avx = info[2] & (1 << 28);
+    // the os must save ymm registers on context switch
+    if (!os_xsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static SimdLevel DetectSimdLevel() {
+    if (SupportAVX2()) {
+        return SimdLevel::AVX2;
+    }
+#ifdef TOY_PHYSICS_SSE2
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel GetSimdLevel() {
+    static SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+const char* GetSimdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar:
+            return "scalar";
+        case SimdLevel::SSE2:
+            return "sse2";
+        case SimdLevel::AVX2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+}
@@ -0,0 +1,275 @@
+#pragma once
+#include "toy_physics/simd.hpp"
+
+#include <cmath>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// lane types for the batched kernels shared by the scalar, SSE2 and AVX2
+// translation units. Every lane type performs the same IEEE operations in
+// the same order (no fma, no approximate rcp/rsqrt), so the paths produce
+// identical bits. Everything lives in an anonymous namespace so each
+// translation unit keeps the instantiations compiled for its own target
+
+namespace toy_physics {
+
+namespace {
+
+struct Float1 {
+    static constexpr size_t Width = 1;
+    using Mask = bool;
+
+    float m_v;
+
+    Float1(float v) : m_v{v} {}
+
+    static Float1 Load(const float* p) { return {*p}; }
+
+    void Store(float* p) const { *p = m_v; }
+};
+
+inline Float1 operator+(Float1 a, Float1 b) {
+    return {a.m_v + b.m_v};
+}
+
+inline Float1 operator-(Float1 a, Float1 b) {
+    return {a.m_v - b.m_v};
+}
+
+inline Float1 operator*(Float1 a, Float1 b) {
+    return {a.m_v * b.m_v};
+}
+
+inline Float1 operator/(Float1 a, Float1 b) {
+    return {a.m_v / b.m_v};
+}
+
+inline bool operator<(Float1 a, Float1 b) {
+    return a.m_v < b.m_v;
+}
+
+inline bool operator>(Float1 a, Float1 b) {
+    return a.m_v > b.m_v;
+}
+
+inline bool operator<=(Float1 a, Float1 b) {
+    return a.m_v <= b.m_v;
+}
+
+inline Float1 Sqrt(Float1 a) {
+    return {std::sqrt(a.m_v)};
+}
+
+// same operand order as minps/maxps
+inline Float1 Min(Float1 a, Float1 b) {
+    return {a.m_v < b.m_v ? a.m_v : b.m_v};
+}
+
+inline Float1 Max(Float1 a, Float1 b) {
+    return {a.m_v > b.m_v ? a.m_v : b.m_v};
+}
+
+inline Float1 Select(bool mask, Float1 a, Float1 b) {
+    return mask ? a : b;
+}
+
+inline bool Or(bool a, bool b) {
+    return a || b;
+}
+
+inline bool And(bool a, bool b) {
+    return a && b;
+}
+
+#ifdef TOY_PHYSICS_SSE2
+struct Mask4 {
+    __m128 m_v;
+};
+
+struct Float4 {
+    static constexpr size_t Width = 4;
+    using Mask = Mask4;
+
+    __m128 m_v;
+
+    Float4(__m128 v) : m_v{v} {}
+
+    Float4(float v) : m_v{_mm_set1_ps(v)} {}
+
+    static Float4 Load(const float* p) { return {_mm_loadu_ps(p)}; }
+
+    void Store(float* p) const { _mm_storeu_ps(p, m_v); }
+};
+
+inline Float4 operator+(Float4 a, Float4 b) {
+    return {_mm_add_ps(a.m_v, b.m_v)};
+}
+
+inline Float4 operator-(Float4 a, Float4 b) {
+    return {_mm_sub_ps(a.m_v, b.m_v)};
+}
+
+inline Float4 operator*(Float4 a, Float4 b) {
+    return {_mm_mul_ps(a.m_v, b.m_v)};
+}
+
+inline Float4 operator/(Float4 a, Float4 b) {
+    return {_mm_div_ps(a.m_v, b.m_v)};
+}
+
+inline Mask4 operator<(Float4 a, Float4 b) {
+    return {_mm_cmplt_ps(a.m_v, b.m_v)};
+}
+
+inline Mask4 operator>(Float4 a, Float4 b) {
+    return {_mm_cmpgt_ps(a.m_v, b.m_v)};
+}
+
+inline Mask4 operator<=(Float4 a, Float4 b) {
+    return {_mm_cmple_ps(a.m_v, b.m_v)};
+}
+
+inline Float4 Sqrt(Float4 a) {
+    return {_mm_sqrt_ps(a.m_v)};
+}
+
+inline Float4 Min(Float4 a, Float4 b) {
+    return {_mm_min_ps(a.m_v, b.m_v)};
+}
+
+inline Float4 Max(Float4 a, Float4 b) {
+    return {_mm_max_ps(a.m_v, b.m_v)};
+}
+
+inline Float4 Select(Mask4 mask, Float4 a, Float4 b) {
+    return {_mm_or_ps(_mm_and_ps(mask.m_v, a.m_v),
+                      _mm_andnot_ps(mask.m_v, b.m_v))};
+}
+
+inline Mask4 Or(Mask4 a, Mask4 b) {
+    return {_mm_or_ps(a.m_v, b.m_v)};
+}
+
+inline Mask4 And(Mask4 a, Mask4 b) {
+    return {_mm_and_ps(a.m_v, b.m_v)};
+}
+#endif
+
+#ifdef __AVX2__
+struct Mask8 {
+    __m256 m_v;
+};
+
+struct Float8 {
+    static constexpr size_t Width = 8;
+    using Mask = Mask8;
+
+    __m256 m_v;
+
+    Float8(__m256 v) : m_v{v} {}
+
+    Float8(float v) : m_v{_mm256_set1_ps(v)} {}
+
+    static Float8 Load(const float* p) { return {_mm256_loadu_ps(p)}; }
+
+    void Store(float* p) const { _mm256_storeu_ps(p, m_v); }
+};
+
+inline Float8 operator+(Float8 a, Float8 b) {
+    return {_mm256_add_ps(a.m_v, b.m_v)};
+}
+
+inline Float8 operator-(Float8 a, Float8 b) {
+    return {_mm256_sub_ps(a.m_v, b.m_v)};
+}
+
+inline Float8 operator*(Float8 a, Float8 b) {
+    return {_mm256_mul_ps(a.m_v, b.m_v)};
+}
+
+inline Float8 operator/(Float8 a, Float8 b) {
+    return {_mm256_div_ps(a.m_v, b.m_v)};
+}
+
+inline Mask8 operator<(Float8 a, Float8 b) {
+    return {_mm256_cmp_ps(a.m_v, b.m_v, _CMP_LT_OQ)};
+}
+
+inline Mask8 operator>(Float8 a, Float8 b) {
+    return {_mm256_cmp_ps(a.m_v, b.m_v, _CMP_GT_OQ)};
+}
+
+inline Mask8 operator<=(Float8 a, Float8 b) {
+    return {_mm256_cmp_ps(a.m_v, b.m_v, _CMP_LE_OQ)};
+}
+
+inline Float8 Sqrt(Float8 a) {
+    return {_mm256_sqrt_ps(a.m_v)};
+}
+
+inline Float8 Min(Float8 a, Float8 b) {
+    return {_mm256_min_ps(a.m_v, b.m_v)};
+}
+
+inline Float8 Max(Float8 a, Float8 b) {
+    return {_mm256_max_ps(a.m_v, b.m_v)};
+}
+
+inline Float8 Select(Mask8 mask, Float8 a, Float8 b) {
+    return {_mm256_blendv_ps(b.m_v, a.m_v, mask.m_v)};
+}
+
+inline Mask8 Or(Mask8 a, Mask8 b) {
+    return {_mm256_or_ps(a.m_v, b.m_v)};
+}
+
+inline Mask8 And(Mask8 a, Mask8 b) {
+    return {_mm256_and_ps(a.m_v, b.m_v)};
+}
+#endif
+
+template <typename F>
+struct Vec3Lanes {
+    F m_x, m_y, m_z;
+
+    static Vec3Lanes Load(const Vec3Column& column, size_t i) {
+        return {F::Load(&column.m_x[i]), F::Load(&column.m_y[i]),
+                F::Load(&column.m_z[i])};
+    }
+
+    void Store(Vec3Column& column, size_t i) const {
+        m_x.Store(&column.m_x[i]);
+        m_y.Store(&column.m_y[i]);
+        m_z.Store(&column.m_z[i]);
+    }
+
+    Vec3Lanes operator+(const Vec3Lanes& o) const {
+        return {m_x + o.m_x, m_y + o.m_y, m_z + o.m_z};
+    }
+
+    Vec3Lanes operator-(const Vec3Lanes& o) const {
+        return {m_x - o.m_x, m_y - o.m_y, m_z - o.m_z};
+    }
+
+    Vec3Lanes operator*(F s) const { return {m_x * s, m_y * s, m_z * s}; }
+
+    F Dot(const Vec3Lanes& o) const {
+        return m_x * o.m_x + m_y * o.m_y + m_z * o.m_z;
+    }
+
+    Vec3Lanes Cross(const Vec3Lanes& o) const {
+        return {m_y * o.m_z - m_z * o.m_y, m_z * o.m_x - m_x * o.m_z,
+                m_x * o.m_y - m_y * o.m_x};
+    }
+};
+
+template <typename F>
+F Clamp01(F x) {
+    return Min(Max(x, F(0.0f)), F(1.0f));
+}
+
+}
+
+}
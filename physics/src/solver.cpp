@@ -0,0 +1,672 @@
+#include "toy_physics/solver.hpp"
+#include "solver_batch.hpp"
+#include "toy_physics/log.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+namespace toy_physics {
+
+constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+static void ApplyImpulse(ContactSolver::SolverBody& body,
+                         const Eigen::Vector3f& impulse,
+                         const Eigen::Vector3f& r) {
+    // static bodies are shared between islands, never write to them
+    if (body.m_inv_mass > 0) {
+        body.m_velocity += impulse * body.m_inv_mass;
+        body.m_angular_velocity += body.m_inv_inertia * r.cross(impulse);
+    }
+}
+
+static float EffectiveMass(const ContactSolver::SolverBody& a,
+                           const ContactSolver::SolverBody& b,
+                           const Eigen::Vector3f& ra,
+                           const Eigen::Vector3f& rb,
+                           const Eigen::Vector3f& dir) {
+    Eigen::Vector3f ra_n = ra.cross(dir);
+    Eigen::Vector3f rb_n = rb.cross(dir);
+    float k = a.m_inv_mass + b.m_inv_mass +
+              ra_n.dot(a.m_inv_inertia * ra_n) +
+              rb_n.dot(b.m_inv_inertia * rb_n);
+    return k > 0 ? 1.0f / k : 0.0f;
+}
+
+static Eigen::Vector3f RelativeVelocity(const ContactSolver::SolverBody& a,
+                                        const ContactSolver::SolverBody& b,
+                                        const Eigen::Vector3f& ra,
+                                        const Eigen::Vector3f& rb) {
+    return b.m_velocity + b.m_angular_velocity.cross(rb) - a.m_velocity -
+           a.m_angular_velocity.cross(ra);
+}
+
+void ContactSolver::Solve(const SolverBodies& bodies,
+                          std::vector<ContactManifold>& manifolds,
+                          float delta_time, JobSystem& jobs) {
+    m_positions = bodies.m_positions;
+    m_body_count = bodies.m_count;
+    m_bodies.resize(m_body_count + 1);
+    m_bodies[m_body_count] = {Eigen::Vector3f::Zero(),
+                              Eigen::Vector3f::Zero(),
+                              Eigen::Matrix3f::Zero(), 0.0f};
+    jobs.ParallelFor(bodies.m_count, 256,
+                     [&](uint32_t begin, uint32_t end, uint32_t) {
+                         for (uint32_t i = begin; i < end; i++) {
+                             Eigen::Matrix3f rot =
+                                 bodies.m_rotations[i].toRotationMatrix();
+                             SolverBody& body = m_bodies[i];
+                             body.m_velocity = bodies.m_velocities[i];
+                             body.m_angular_velocity =
+                                 bodies.m_angular_velocities[i];
+                             body.m_inv_mass = bodies.m_inv_masses[i];
+                             body.m_inv_inertia = rot *
+                                                  bodies.m_inv_inertias[i] *
+                                                  rot.transpose();
+                         }
+                     });
+
+    buildIslands(bodies, manifolds);
+    m_constraints.resize(m_order.size());
+
+    m_small_islands.clear();
+    m_large_islands.clear();
+    for (uint32_t i = 0; i < m_islands.size(); i++) {
+        uint32_t count = m_islands[i].m_end - m_islands[i].m_begin;
+        if (count > m_settings.m_split_constraint_count) {
+            m_large_islands.push_back(i);
+        } else {
+            m_small_islands.push_back(i);
+        }
+    }
+
+    // biggest islands first so the tail of the parallel-for stays short.
+    // ties break on the index, stable_sort would borrow a heap buffer
+    std::sort(m_small_islands.begin(), m_small_islands.end(),
+              [this](uint32_t a, uint32_t b) {
+                  uint32_t size_a = m_islands[a].m_end - m_islands[a].m_begin;
+                  uint32_t size_b = m_islands[b].m_end - m_islands[b].m_begin;
+                  return size_a != size_b ? size_a > size_b : a < b;
+              });
+    jobs.ParallelFor(static_cast<uint32_t>(m_small_islands.size()), 1,
+                     [&](uint32_t begin, uint32_t end, uint32_t) {
+                         for (uint32_t i = begin; i < end; i++) {
+                             solveIsland(m_islands[m_small_islands[i]],
+                                         manifolds, delta_time);
+                         }
+                     });
+
+    bool coloring =
+        m_settings.m_large_island_mode == LargeIslandMode::Coloring;
+    if (!m_large_islands.empty()) {
+        if (coloring) {
+            // islands never share dynamic bodies, one reset is enough
+            m_body_colors.assign(m_body_count, 0);
+        } else {
+            m_partition_of_body.assign(m_body_count + 1, InvalidIndex);
+            m_copy_of_body.resize(m_body_count + 1);
+            m_partition_stamp = 0;
+        }
+    }
+    for (uint32_t index : m_large_islands) {
+        if (coloring) {
+            solveColoredIsland(m_islands[index], manifolds, delta_time, jobs);
+        } else {
+            solveSplitIsland(m_islands[index], manifolds, delta_time, jobs);
+        }
+    }
+
+    jobs.ParallelFor(
+        static_cast<uint32_t>(m_order.size()), 256,
+        [&](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t k = begin; k < end; k++) {
+                const Constraint& constraint = m_constraints[k];
+                ContactManifold& manifold = manifolds[m_order[k]];
+                for (uint32_t i = 0; i < constraint.m_point_count; i++) {
+                    manifold.m_points[i].m_normal_impulse =
+                        constraint.m_points[i].m_normal_impulse;
+                    manifold.m_points[i].m_tangent_impulse =
+                        constraint.m_points[i].m_tangent_impulse;
+                }
+            }
+        });
+
+    jobs.ParallelFor(bodies.m_count, 256,
+                     [&](uint32_t begin, uint32_t end, uint32_t) {
+                         for (uint32_t i = begin; i < end; i++) {
+                             if (m_bodies[i].m_inv_mass > 0) {
+                                 bodies.m_velocities[i] =
+                                     m_bodies[i].m_velocity;
+                                 bodies.m_angular_velocities[i] =
+                                     m_bodies[i].m_angular_velocity;
+                             }
+                         }
+                     });
+}
+
+uint32_t ContactSolver::findRoot(uint32_t body) {
+    while (m_parents[body] != body) {
+        m_parents[body] = m_parents[m_parents[body]];
+        body = m_parents[body];
+    }
+    return body;
+}
+
+void ContactSolver::buildIslands(
+    const SolverBodies& bodies, const std::vector<ContactManifold>& manifolds) {
+    m_parents.resize(bodies.m_count);
+    std::iota(m_parents.begin(), m_parents.end(), 0u);
+
+    // static bodies don't link islands, a floor would merge everything
+    for (const ContactManifold& manifold : manifolds) {
+        uint32_t a = solverIndex(manifold.m_body_a);
+        uint32_t b = solverIndex(manifold.m_body_b);
+        if (m_bodies[a].m_inv_mass > 0 && m_bodies[b].m_inv_mass > 0) {
+            uint32_t root_a = findRoot(a);
+            uint32_t root_b = findRoot(b);
+            if (root_a != root_b) {
+                m_parents[std::max(root_a, root_b)] = std::min(root_a, root_b);
+            }
+        }
+    }
+
+    // islands are numbered by first appearance so the order is stable
+    m_island_of_root.assign(bodies.m_count, InvalidIndex);
+    m_manifold_islands.resize(manifolds.size());
+    m_islands.clear();
+    for (size_t i = 0; i < manifolds.size(); i++) {
+        uint32_t a = solverIndex(manifolds[i].m_body_a);
+        uint32_t b = solverIndex(manifolds[i].m_body_b);
+        uint32_t body = m_bodies[a].m_inv_mass > 0 ? a : b;
+        if (m_bodies[body].m_inv_mass == 0) {
+            m_manifold_islands[i] = InvalidIndex;
+            continue;
+        }
+        uint32_t root = findRoot(body);
+        uint32_t& island = m_island_of_root[root];
+        if (island == InvalidIndex) {
+            island = static_cast<uint32_t>(m_islands.size());
+            m_islands.push_back({0, 0});
+        }
+        m_islands[island].m_end++;
+        m_manifold_islands[i] = island;
+    }
+
+    uint32_t offset = 0;
+    for (SolverIsland& island : m_islands) {
+        uint32_t count = island.m_end;
+        island.m_begin = offset;
+        island.m_end = offset;
+        offset += count;
+    }
+    m_order.resize(offset);
+    for (size_t i = 0; i < manifolds.size(); i++) {
+        uint32_t island = m_manifold_islands[i];
+        if (island != InvalidIndex) {
+            m_order[m_islands[island].m_end++] = static_cast<uint32_t>(i);
+        }
+    }
+}
+
+void ContactSolver::prepare(Constraint& constraint,
+                            const ContactManifold& manifold,
+                            const SolverBody* bodies,
+                            float delta_time) const {
+    const SolverBody& a = bodies[constraint.m_body_a];
+    const SolverBody& b = bodies[constraint.m_body_b];
+    const Eigen::Vector3f& n = manifold.m_normal;
+
+    // tangent basis only depends on the normal so cached friction impulses
+    // stay meaningful
+    Eigen::Vector3f t1 =
+        std::abs(n.x()) >= 0.57735f
+            ? Eigen::Vector3f{n.y(), -n.x(), 0}.normalized()
+            : Eigen::Vector3f{0, n.z(), -n.y()}.normalized();
+    constraint.m_normal = n;
+    constraint.m_tangents = {t1, n.cross(t1)};
+    constraint.m_point_count = manifold.m_point_count;
+
+    const Eigen::Vector3f& xa = m_positions[manifold.m_body_a];
+    const Eigen::Vector3f& xb = m_positions[manifold.m_body_b];
+    float inv_dt = 1.0f / delta_time;
+    for (uint32_t i = 0; i < manifold.m_point_count; i++) {
+        const ContactPoint& contact = manifold.m_points[i];
+        ConstraintPoint& point = constraint.m_points[i];
+        point.m_ra = contact.m_position - xa;
+        point.m_rb = contact.m_position - xb;
+        point.m_normal_mass = EffectiveMass(a, b, point.m_ra, point.m_rb, n);
+        for (int k = 0; k < 2; k++) {
+            point.m_tangent_mass[k] = EffectiveMass(
+                a, b, point.m_ra, point.m_rb, constraint.m_tangents[k]);
+        }
+
+        // speculative contacts may close the gap within this step,
+        // penetration is pushed out a fraction per step
+        if (contact.m_depth < 0) {
+            point.m_target_velocity = contact.m_depth * inv_dt;
+        } else {
+            point.m_target_velocity = std::min(
+                m_settings.m_baumgarte *
+                    std::max(contact.m_depth - m_settings.m_linear_slop,
+                             0.0f) *
+                    inv_dt,
+                m_settings.m_max_correction_velocity);
+        }
+        point.m_normal_impulse = contact.m_normal_impulse;
+        point.m_tangent_impulse = contact.m_tangent_impulse;
+    }
+}
+
+void ContactSolver::warmStart(const Constraint& constraint,
+                              SolverBody* bodies) const {
+    SolverBody& a = bodies[constraint.m_body_a];
+    SolverBody& b = bodies[constraint.m_body_b];
+    for (uint32_t i = 0; i < constraint.m_point_count; i++) {
+        const ConstraintPoint& point = constraint.m_points[i];
+        Eigen::Vector3f impulse =
+            constraint.m_normal * point.m_normal_impulse +
+            constraint.m_tangents[0] * point.m_tangent_impulse[0] +
+            constraint.m_tangents[1] * point.m_tangent_impulse[1];
+        ApplyImpulse(a, -impulse, point.m_ra);
+        ApplyImpulse(b, impulse, point.m_rb);
+    }
+}
+
+void ContactSolver::solveVelocity(Constraint& constraint,
+                                  SolverBody* bodies) const {
+    SolverBody& a = bodies[constraint.m_body_a];
+    SolverBody& b = bodies[constraint.m_body_b];
+    float friction = m_settings.m_friction;
+
+    // friction first, non-penetration matters more so it goes last
+    for (uint32_t i = 0; i < constraint.m_point_count; i++) {
+        ConstraintPoint& point = constraint.m_points[i];
+        float max_friction = friction * point.m_normal_impulse;
+        for (int k = 0; k < 2; k++) {
+            const Eigen::Vector3f& t = constraint.m_tangents[k];
+            float vt = RelativeVelocity(a, b, point.m_ra, point.m_rb).dot(t);
+            float lambda = -point.m_tangent_mass[k] * vt;
+            float old_impulse = point.m_tangent_impulse[k];
+            point.m_tangent_impulse[k] = std::clamp(
+                old_impulse + lambda, -max_friction, max_friction);
+            Eigen::Vector3f impulse =
+                t * (point.m_tangent_impulse[k] - old_impulse);
+            ApplyImpulse(a, -impulse, point.m_ra);
+            ApplyImpulse(b, impulse, point.m_rb);
+        }
+    }
+
+    for (uint32_t i = 0; i < constraint.m_point_count; i++) {
+        ConstraintPoint& point = constraint.m_points[i];
+        float vn = RelativeVelocity(a, b, point.m_ra, point.m_rb)
+                       .dot(constraint.m_normal);
+        float lambda = point.m_normal_mass * (point.m_target_velocity - vn);
+        float old_impulse = point.m_normal_impulse;
+        point.m_normal_impulse = std::max(old_impulse + lambda, 0.0f);
+        Eigen::Vector3f impulse =
+            constraint.m_normal * (point.m_normal_impulse - old_impulse);
+        ApplyImpulse(a, -impulse, point.m_ra);
+        ApplyImpulse(b, impulse, point.m_rb);
+    }
+}
+
+void ContactSolver::solveIsland(const SolverIsland& island,
+                                const std::vector<ContactManifold>& manifolds,
+                                float delta_time) {
+    for (uint32_t k = island.m_begin; k < island.m_end; k++) {
+        const ContactManifold& manifold = manifolds[m_order[k]];
+        Constraint& constraint = m_constraints[k];
+        constraint.m_body_a = solverIndex(manifold.m_body_a);
+        constraint.m_body_b = solverIndex(manifold.m_body_b);
+        prepare(constraint, manifold, m_bodies.data(), delta_time);
+        warmStart(constraint, m_bodies.data());
+    }
+
+    for (uint32_t iter = 0; iter < m_settings.m_velocity_iterations; iter++) {
+        for (uint32_t k = island.m_begin; k < island.m_end; k++) {
+            solveVelocity(m_constraints[k], m_bodies.data());
+        }
+    }
+}
+
+// greedy coloring in constraint order, so the colors only depend on the
+// manifold order. Constraints in one color never share a dynamic body and
+// are solved in parallel, static bodies are never written so they don't
+// take a color
+void ContactSolver::solveColoredIsland(
+    const SolverIsland& island, const std::vector<ContactManifold>& manifolds,
+    float delta_time, JobSystem& jobs) {
+    PROFILE_SCOPE("ContactSolver::solveColoredIsland");
+    uint32_t count = island.m_end - island.m_begin;
+    uint32_t color_count = std::clamp(m_settings.m_max_colors, 1u, 64u);
+    uint64_t color_mask =
+        color_count == 64 ? ~0ull : (1ull << color_count) - 1;
+    uint32_t overflow = color_count;
+
+    m_constraint_colors.resize(count);
+    m_color_offsets.assign(color_count + 2, 0);
+    for (uint32_t i = 0; i < count; i++) {
+        const ContactManifold& manifold =
+            manifolds[m_order[island.m_begin + i]];
+        uint32_t a = solverIndex(manifold.m_body_a);
+        uint32_t b = solverIndex(manifold.m_body_b);
+        bool dynamic_a = m_bodies[a].m_inv_mass > 0;
+        bool dynamic_b = m_bodies[b].m_inv_mass > 0;
+
+        uint64_t used = (dynamic_a ? m_body_colors[a] : 0) |
+                        (dynamic_b ? m_body_colors[b] : 0);
+        uint64_t free = ~used & color_mask;
+        uint32_t color = overflow;
+        if (free != 0) {
+            color = static_cast<uint32_t>(std::countr_zero(free));
+            if (dynamic_a) {
+                m_body_colors[a] |= 1ull << color;
+            }
+            if (dynamic_b) {
+                m_body_colors[b] |= 1ull << color;
+            }
+        }
+        m_constraint_colors[i] = color;
+        m_color_offsets[color + 1]++;
+    }
+
+    // stable counting sort of the island range by color, overflow last
+    for (uint32_t c = 0; c <= color_count; c++) {
+        m_color_offsets[c + 1] += m_color_offsets[c];
+    }
+    m_colored_order.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        m_colored_order[m_color_offsets[m_constraint_colors[i]]++] =
+            m_order[island.m_begin + i];
+    }
+    std::copy(m_colored_order.begin(), m_colored_order.end(),
+              m_order.begin() + island.m_begin);
+    for (uint32_t c = color_count + 1; c > 0; c--) {
+        m_color_offsets[c] = m_color_offsets[c - 1] + island.m_begin;
+    }
+    m_color_offsets[0] = island.m_begin;
+
+    // every color is padded to whole blocks of ConstraintBlock::Width
+    constexpr uint32_t Width = ConstraintBlock::Width;
+    m_color_block_offsets.resize(color_count + 1);
+    m_color_block_offsets[0] = 0;
+    for (uint32_t c = 0; c < color_count; c++) {
+        uint32_t size = m_color_offsets[c + 1] - m_color_offsets[c];
+        m_color_block_offsets[c + 1] =
+            m_color_block_offsets[c] + (size + Width - 1) / Width;
+    }
+    m_blocks.resize(m_color_block_offsets[color_count]);
+    for (uint32_t c = 0; c < color_count; c++) {
+        uint32_t first = m_color_offsets[c];
+        for (uint32_t i = m_color_block_offsets[c];
+             i < m_color_block_offsets[c + 1]; i++) {
+            m_blocks[i].m_first = first;
+            m_blocks[i].m_count = std::min(m_color_offsets[c + 1] - first,
+                                           Width);
+            first += Width;
+        }
+    }
+
+    jobs.ParallelFor(count, 64, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t i = begin; i < end; i++) {
+            uint32_t k = island.m_begin + i;
+            const ContactManifold& manifold = manifolds[m_order[k]];
+            m_constraints[k].m_body_a = solverIndex(manifold.m_body_a);
+            m_constraints[k].m_body_b = solverIndex(manifold.m_body_b);
+            prepare(m_constraints[k], manifold, m_bodies.data(), delta_time);
+        }
+    });
+    jobs.ParallelFor(static_cast<uint32_t>(m_blocks.size()), 8,
+                     [&](uint32_t begin, uint32_t end, uint32_t) {
+                         for (uint32_t i = begin; i < end; i++) {
+                             packBlock(m_blocks[i]);
+                         }
+                     });
+
+    // the colors run on the wide kernels, the overflow color is serial
+    auto solve_colors = [&](auto&& solve_blocks, auto&& solve) {
+        for (uint32_t c = 0; c < color_count; c++) {
+            uint32_t first = m_color_block_offsets[c];
+            jobs.ParallelFor(m_color_block_offsets[c + 1] - first, 8,
+                             [&](uint32_t begin, uint32_t end, uint32_t) {
+                                 solve_blocks(&m_blocks[first + begin],
+                                              end - begin);
+                             });
+        }
+        for (uint32_t k = m_color_offsets[overflow];
+             k < m_color_offsets[overflow + 1]; k++) {
+            solve(m_constraints[k]);
+        }
+    };
+
+    SimdLevel level = m_settings.m_simd_level;
+    solve_colors(
+        [&](ConstraintBlock* blocks, uint32_t size) {
+            WarmStartConstraintBlocks(blocks, size, m_bodies.data(), level);
+        },
+        [this](Constraint& constraint) {
+            warmStart(constraint, m_bodies.data());
+        });
+    for (uint32_t iter = 0; iter < m_settings.m_velocity_iterations; iter++) {
+        solve_colors(
+            [&](ConstraintBlock* blocks, uint32_t size) {
+                SolveConstraintBlocks(blocks, size, m_bodies.data(),
+                                      m_settings.m_friction, level);
+            },
+            [this](Constraint& constraint) {
+                solveVelocity(constraint, m_bodies.data());
+            });
+    }
+
+    jobs.ParallelFor(static_cast<uint32_t>(m_blocks.size()), 8,
+                     [&](uint32_t begin, uint32_t end, uint32_t) {
+                         for (uint32_t i = begin; i < end; i++) {
+                             unpackBlock(m_blocks[i]);
+                         }
+                     });
+}
+
+void ContactSolver::packBlock(ConstraintBlock& block) const {
+    block.m_point_count = 0;
+    for (uint32_t lane = 0; lane < ConstraintBlock::Width; lane++) {
+        // padding lanes act on the static body, which is never written
+        const Constraint* constraint =
+            lane < block.m_count ? &m_constraints[block.m_first + lane]
+                                 : nullptr;
+        uint32_t a = constraint ? constraint->m_body_a : m_body_count;
+        uint32_t b = constraint ? constraint->m_body_b : m_body_count;
+        block.m_body_a[lane] = a;
+        block.m_body_b[lane] = b;
+        block.m_inv_mass_a[lane] = m_bodies[a].m_inv_mass;
+        block.m_inv_mass_b[lane] = m_bodies[b].m_inv_mass;
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                block.m_inv_inertia_a[r * 3 + c][lane] =
+                    m_bodies[a].m_inv_inertia(r, c);
+                block.m_inv_inertia_b[r * 3 + c][lane] =
+                    m_bodies[b].m_inv_inertia(r, c);
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            block.m_normal[c][lane] = constraint ? constraint->m_normal[c] : 0;
+            for (int k = 0; k < 2; k++) {
+                block.m_tangents[k][c][lane] =
+                    constraint ? constraint->m_tangents[k][c] : 0;
+            }
+        }
+
+        uint32_t point_count = constraint ? constraint->m_point_count : 0;
+        block.m_point_count = std::max(block.m_point_count, point_count);
+        for (uint32_t i = 0; i < ContactManifold::MaxPoints; i++) {
+            static const ConstraintPoint missing{
+                Eigen::Vector3f::Zero(), Eigen::Vector3f::Zero(), 0, {0, 0},
+                0, 0, {0, 0}};
+            const ConstraintPoint& point =
+                i < point_count ? constraint->m_points[i] : missing;
+            ConstraintBlock::Point& out = block.m_points[i];
+            for (int c = 0; c < 3; c++) {
+                out.m_ra[c][lane] = point.m_ra[c];
+                out.m_rb[c][lane] = point.m_rb[c];
+            }
+            out.m_normal_mass[lane] = point.m_normal_mass;
+            out.m_target_velocity[lane] = point.m_target_velocity;
+            out.m_normal_impulse[lane] = point.m_normal_impulse;
+            for (int k = 0; k < 2; k++) {
+                out.m_tangent_mass[k][lane] = point.m_tangent_mass[k];
+                out.m_tangent_impulse[k][lane] = point.m_tangent_impulse[k];
+            }
+        }
+    }
+}
+
+void ContactSolver::unpackBlock(const ConstraintBlock& block) {
+    for (uint32_t lane = 0; lane < block.m_count; lane++) {
+        Constraint& constraint = m_constraints[block.m_first + lane];
+        for (uint32_t i = 0; i < constraint.m_point_count; i++) {
+            const ConstraintBlock::Point& point = block.m_points[i];
+            constraint.m_points[i].m_normal_impulse =
+                point.m_normal_impulse[lane];
+            constraint.m_points[i].m_tangent_impulse = {
+                point.m_tangent_impulse[0][lane],
+                point.m_tangent_impulse[1][lane]};
+        }
+    }
+}
+
+// mass splitting: every partition works on its own copy of the bodies it
+// touches, with the mass divided by the number of copies, and the copies
+// are averaged after each iteration
+void ContactSolver::solveSplitIsland(
+    const SolverIsland& island, const std::vector<ContactManifold>& manifolds,
+    float delta_time, JobSystem& jobs) {
+    PROFILE_SCOPE("ContactSolver::solveSplitIsland");
+    uint32_t count = island.m_end - island.m_begin;
+    uint32_t split = m_settings.m_split_constraint_count;
+    uint32_t partition_count = (count + split - 1) / split;
+    uint32_t chunk = (count + partition_count - 1) / partition_count;
+
+    m_partition_offsets.resize(partition_count + 1);
+    for (uint32_t p = 0; p <= partition_count; p++) {
+        m_partition_offsets[p] = island.m_begin + std::min(p * chunk, count);
+    }
+
+    m_copies.clear();
+    m_copy_owner.clear();
+    auto copy_for = [&](uint32_t body, uint32_t stamp) {
+        if (m_partition_of_body[body] != stamp) {
+            m_partition_of_body[body] = stamp;
+            m_copy_of_body[body] = static_cast<uint32_t>(m_copies.size());
+            m_copies.push_back(m_bodies[body]);
+            m_copy_owner.push_back(body);
+        }
+        return m_copy_of_body[body];
+    };
+    for (uint32_t p = 0; p < partition_count; p++) {
+        // stamps are unique across islands, static bodies are shared
+        uint32_t stamp = m_partition_stamp++;
+        for (uint32_t k = m_partition_offsets[p];
+             k < m_partition_offsets[p + 1]; k++) {
+            const ContactManifold& manifold = manifolds[m_order[k]];
+            m_constraints[k].m_body_a =
+                copy_for(solverIndex(manifold.m_body_a), stamp);
+            m_constraints[k].m_body_b =
+                copy_for(solverIndex(manifold.m_body_b), stamp);
+        }
+    }
+
+    // group the copies of each dynamic body
+    m_body_copies.clear();
+    for (uint32_t i = 0; i < m_copies.size(); i++) {
+        if (m_copies[i].m_inv_mass > 0) {
+            m_body_copies.push_back(i);
+        }
+    }
+    std::sort(m_body_copies.begin(), m_body_copies.end(),
+              [this](uint32_t a, uint32_t b) {
+                  return m_copy_owner[a] < m_copy_owner[b] ||
+                         (m_copy_owner[a] == m_copy_owner[b] && a < b);
+              });
+    m_body_copy_offsets.clear();
+    for (uint32_t i = 0; i < m_body_copies.size(); i++) {
+        if (i == 0 || m_copy_owner[m_body_copies[i]] !=
+                          m_copy_owner[m_body_copies[i - 1]]) {
+            m_body_copy_offsets.push_back(i);
+        }
+    }
+    uint32_t group_count = static_cast<uint32_t>(m_body_copy_offsets.size());
+    m_body_copy_offsets.push_back(
+        static_cast<uint32_t>(m_body_copies.size()));
+
+    for (uint32_t g = 0; g < group_count; g++) {
+        uint32_t begin = m_body_copy_offsets[g];
+        uint32_t end = m_body_copy_offsets[g + 1];
+        float scale = static_cast<float>(end - begin);
+        for (uint32_t i = begin; i < end; i++) {
+            SolverBody& copy = m_copies[m_body_copies[i]];
+            copy.m_inv_mass *= scale;
+            copy.m_inv_inertia *= scale;
+        }
+    }
+
+    auto average = [&] {
+        jobs.ParallelFor(
+            group_count, 64, [&](uint32_t begin, uint32_t end, uint32_t) {
+                for (uint32_t g = begin; g < end; g++) {
+                    uint32_t first = m_body_copy_offsets[g];
+                    uint32_t last = m_body_copy_offsets[g + 1];
+                    Eigen::Vector3f v = Eigen::Vector3f::Zero();
+                    Eigen::Vector3f w = Eigen::Vector3f::Zero();
+                    for (uint32_t i = first; i < last; i++) {
+                        v += m_copies[m_body_copies[i]].m_velocity;
+                        w += m_copies[m_body_copies[i]].m_angular_velocity;
+                    }
+                    float inv_count = 1.0f / static_cast<float>(last - first);
+                    v *= inv_count;
+                    w *= inv_count;
+                    for (uint32_t i = first; i < last; i++) {
+                        m_copies[m_body_copies[i]].m_velocity = v;
+                        m_copies[m_body_copies[i]].m_angular_velocity = w;
+                    }
+                }
+            });
+    };
+
+    jobs.ParallelFor(partition_count, 1,
+                     [&](uint32_t begin, uint32_t end, uint32_t) {
+                         for (uint32_t p = begin; p < end; p++) {
+                             for (uint32_t k = m_partition_offsets[p];
+                                  k < m_partition_offsets[p + 1]; k++) {
+                                 prepare(m_constraints[k],
+                                         manifolds[m_order[k]],
+                                         m_copies.data(), delta_time);
+                                 warmStart(m_constraints[k], m_copies.data());
+                             }
+                         }
+                     });
+    average();
+
+    for (uint32_t iter = 0; iter < m_settings.m_velocity_iterations; iter++) {
+        jobs.ParallelFor(partition_count, 1,
+                         [&](uint32_t begin, uint32_t end, uint32_t) {
+                             for (uint32_t p = begin; p < end; p++) {
+                                 for (uint32_t k = m_partition_offsets[p];
+                                      k < m_partition_offsets[p + 1]; k++) {
+                                     solveVelocity(m_constraints[k],
+                                                   m_copies.data());
+                                 }
+                             }
+                         });
+        average();
+    }
+
+    for (uint32_t g = 0; g < group_count; g++) {
+        const SolverBody& copy =
+            m_copies[m_body_copies[m_body_copy_offsets[g]]];
+        SolverBody& body = m_bodies[m_copy_owner[m_body_copies[
+            m_body_copy_offsets[g]]]];
+        body.m_velocity = copy.m_velocity;
+        body.m_angular_velocity = copy.m_angular_velocity;
+    }
+}
+
+}
@@ -0,0 +1,48 @@
+#include "solver_batch_kernel.hpp"
+
+#include <algorithm>
+
+namespace toy_physics {
+
+// blocks are padded to eight lanes, so every level covers whole blocks and
+// there is no tail
+void WarmStartConstraintBlocks(ContactSolver::ConstraintBlock* blocks,
+                               size_t count,
+                               ContactSolver::SolverBody* bodies,
+                               SimdLevel level) {
+    level = std::min(level, GetSimdLevel());
+#ifdef TOY_PHYSICS_X86
+    if (level == SimdLevel::AVX2) {
+        WarmStartConstraintBlocksAVX2(blocks, count, bodies);
+        return;
+    }
+#endif
+#ifdef TOY_PHYSICS_SSE2
+    if (level >= SimdLevel::SSE2) {
+        WarmStartBlockLanes<Float4>(blocks, count, bodies);
+        return;
+    }
+#endif
+    WarmStartBlockLanes<Float1>(blocks, count, bodies);
+}
+
+void SolveConstraintBlocks(ContactSolver::ConstraintBlock* blocks,
+                           size_t count, ContactSolver::SolverBody* bodies,
+                           float friction, SimdLevel level) {
+    level = std::min(level, GetSimdLevel());
+#ifdef TOY_PHYSICS_X86
+    if (level == SimdLevel::AVX2) {
+        SolveConstraintBlocksAVX2(blocks, count, bodies, friction);
+        return;
+    }
+#endif
+#ifdef TOY_PHYSICS_SSE2
+    if (level >= SimdLevel::SSE2) {
+        SolveBlockLanes<Float4>(blocks, count, bodies, friction);
+        return;
+    }
+#endif
+    SolveBlockLanes<Float1>(blocks, count, bodies, friction);
+}
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "toy_physics/simd.hpp"
+#include "toy_physics/solver.hpp"
+
+// wide warm start and velocity iteration over the blocks of one color, see
+// ContactSolver::ConstraintBlock. Blocks must not share dynamic bodies
+
+namespace toy_physics {
+
+void WarmStartConstraintBlocks(ContactSolver::ConstraintBlock* blocks,
+                               size_t count,
+                               ContactSolver::SolverBody* bodies,
+                               SimdLevel level);
+void SolveConstraintBlocks(ContactSolver::ConstraintBlock* blocks,
+                           size_t count, ContactSolver::SolverBody* bodies,
+                           float friction, SimdLevel level);
+
+}
@@ -0,0 +1,29 @@
+// built with AVX2 enabled, only called after the runtime cpu check
+#include "toy_physics/simd.hpp"
+
+#ifdef TOY_PHYSICS_X86
+
+#ifndef __AVX2__
+#error "solver_batch_avx2.cpp must be compiled with AVX2 enabled"
+#endif
+
+#include "solver_batch_kernel.hpp"
+
+namespace toy_physics {
+
+void WarmStartConstraintBlocksAVX2(ContactSolver::ConstraintBlock* blocks,
+                                   size_t count,
+                                   ContactSolver::SolverBody* bodies) {
+    WarmStartBlockLanes<Float8>(blocks, count, bodies);
+}
+
+void SolveConstraintBlocksAVX2(ContactSolver::ConstraintBlock* blocks,
+                               size_t count,
+                               ContactSolver::SolverBody* bodies,
+                               float friction) {
+    SolveBlockLanes<Float8>(blocks, count, bodies, friction);
+}
+
+}
+
+#endif
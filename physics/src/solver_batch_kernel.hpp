@@ -0,0 +1,232 @@
+#pragma once
+#include "solver_batch.hpp"
+#include "simd_lanes.hpp"
+
+// lane generic solver kernels shared by the scalar, SSE2 and AVX2
+// translation units, see simd_lanes.hpp
+
+namespace toy_physics {
+
+#ifdef TOY_PHYSICS_X86
+void WarmStartConstraintBlocksAVX2(ContactSolver::ConstraintBlock* blocks,
+                                   size_t count,
+                                   ContactSolver::SolverBody* bodies);
+void SolveConstraintBlocksAVX2(ContactSolver::ConstraintBlock* blocks,
+                               size_t count,
+                               ContactSolver::SolverBody* bodies,
+                               float friction);
+#endif
+
+namespace {
+
+using Block = ContactSolver::ConstraintBlock;
+
+// velocities of the bodies on one side of a block, gathered once per block
+// and written back after all of its points
+struct BlockVelocities {
+    std::array<Block::Lanes, 3> m_linear;
+    std::array<Block::Lanes, 3> m_angular;
+};
+
+inline void GatherVelocities(const std::array<uint32_t, Block::Width>& body,
+                             const ContactSolver::SolverBody* bodies,
+                             BlockVelocities& out) {
+    for (uint32_t lane = 0; lane < Block::Width; lane++) {
+        const ContactSolver::SolverBody& source = bodies[body[lane]];
+        for (int c = 0; c < 3; c++) {
+            out.m_linear[c][lane] = source.m_velocity[c];
+            out.m_angular[c][lane] = source.m_angular_velocity[c];
+        }
+    }
+}
+
+// static bodies are shared between lanes and islands, never write to them
+inline void ScatterVelocities(const std::array<uint32_t, Block::Width>& body,
+                              const Block::Lanes& inv_mass,
+                              const BlockVelocities& in,
+                              ContactSolver::SolverBody* bodies) {
+    for (uint32_t lane = 0; lane < Block::Width; lane++) {
+        if (inv_mass[lane] > 0) {
+            ContactSolver::SolverBody& target = bodies[body[lane]];
+            target.m_velocity = {in.m_linear[0][lane], in.m_linear[1][lane],
+                                 in.m_linear[2][lane]};
+            target.m_angular_velocity = {in.m_angular[0][lane],
+                                         in.m_angular[1][lane],
+                                         in.m_angular[2][lane]};
+        }
+    }
+}
+
+template <typename F>
+Vec3Lanes<F> LoadLanes(const std::array<Block::Lanes, 3>& v, uint32_t lane) {
+    return {F::Load(&v[0][lane]), F::Load(&v[1][lane]),
+            F::Load(&v[2][lane])};
+}
+
+template <typename F>
+void StoreLanes(const Vec3Lanes<F>& v, std::array<Block::Lanes, 3>& out,
+                uint32_t lane) {
+    v.m_x.Store(&out[0][lane]);
+    v.m_y.Store(&out[1][lane]);
+    v.m_z.Store(&out[2][lane]);
+}
+
+// one side of the constraints in lanes [lane, lane + F::Width)
+template <typename F>
+struct BodyLanes {
+    Vec3Lanes<F> m_velocity;
+    Vec3Lanes<F> m_angular_velocity;
+    F m_inv_mass;
+    const std::array<Block::Lanes, 9>& m_inv_inertia;
+    uint32_t m_lane;
+
+    BodyLanes(const BlockVelocities& velocities, const Block::Lanes& inv_mass,
+              const std::array<Block::Lanes, 9>& inv_inertia, uint32_t lane)
+        : m_velocity{LoadLanes<F>(velocities.m_linear, lane)},
+          m_angular_velocity{LoadLanes<F>(velocities.m_angular, lane)},
+          m_inv_mass{F::Load(&inv_mass[lane])},
+          m_inv_inertia{inv_inertia},
+          m_lane{lane} {}
+
+    void Store(BlockVelocities& velocities) const {
+        StoreLanes(m_velocity, velocities.m_linear, m_lane);
+        StoreLanes(m_angular_velocity, velocities.m_angular, m_lane);
+    }
+
+    Vec3Lanes<F> PointVelocity(const Vec3Lanes<F>& r) const {
+        return m_velocity + m_angular_velocity.Cross(r);
+    }
+
+    Vec3Lanes<F> InvInertiaTimes(const Vec3Lanes<F>& v) const {
+        auto row = [&](int r) {
+            return F::Load(&m_inv_inertia[r * 3][m_lane]) * v.m_x +
+                   F::Load(&m_inv_inertia[r * 3 + 1][m_lane]) * v.m_y +
+                   F::Load(&m_inv_inertia[r * 3 + 2][m_lane]) * v.m_z;
+        };
+        return {row(0), row(1), row(2)};
+    }
+
+    void AddImpulse(const Vec3Lanes<F>& impulse, const Vec3Lanes<F>& r) {
+        m_velocity = m_velocity + impulse * m_inv_mass;
+        m_angular_velocity =
+            m_angular_velocity + InvInertiaTimes(r.Cross(impulse));
+    }
+
+    void SubtractImpulse(const Vec3Lanes<F>& impulse, const Vec3Lanes<F>& r) {
+        m_velocity = m_velocity - impulse * m_inv_mass;
+        m_angular_velocity =
+            m_angular_velocity - InvInertiaTimes(r.Cross(impulse));
+    }
+};
+
+template <typename F>
+void ApplyLanes(BodyLanes<F>& a, BodyLanes<F>& b, const Vec3Lanes<F>& impulse,
+                const Vec3Lanes<F>& ra, const Vec3Lanes<F>& rb) {
+    a.SubtractImpulse(impulse, ra);
+    b.AddImpulse(impulse, rb);
+}
+
+template <typename F>
+void WarmStartLanes(const Block& block, BlockVelocities& a,
+                    BlockVelocities& b, uint32_t lane) {
+    BodyLanes<F> body_a{a, block.m_inv_mass_a, block.m_inv_inertia_a, lane};
+    BodyLanes<F> body_b{b, block.m_inv_mass_b, block.m_inv_inertia_b, lane};
+    Vec3Lanes<F> n = LoadLanes<F>(block.m_normal, lane);
+    Vec3Lanes<F> t0 = LoadLanes<F>(block.m_tangents[0], lane);
+    Vec3Lanes<F> t1 = LoadLanes<F>(block.m_tangents[1], lane);
+    for (uint32_t i = 0; i < block.m_point_count; i++) {
+        const Block::Point& point = block.m_points[i];
+        Vec3Lanes<F> impulse =
+            n * F::Load(&point.m_normal_impulse[lane]) +
+            t0 * F::Load(&point.m_tangent_impulse[0][lane]) +
+            t1 * F::Load(&point.m_tangent_impulse[1][lane]);
+        ApplyLanes(body_a, body_b, impulse, LoadLanes<F>(point.m_ra, lane),
+                   LoadLanes<F>(point.m_rb, lane));
+    }
+    body_a.Store(a);
+    body_b.Store(b);
+}
+
+// same sequence as ContactSolver::solveVelocity, points missing from a lane
+// have zero masses and impulses so they apply nothing
+template <typename F>
+void SolveLanes(Block& block, BlockVelocities& a, BlockVelocities& b,
+                float friction, uint32_t lane) {
+    BodyLanes<F> body_a{a, block.m_inv_mass_a, block.m_inv_inertia_a, lane};
+    BodyLanes<F> body_b{b, block.m_inv_mass_b, block.m_inv_inertia_b, lane};
+    auto relative_velocity = [&](const Vec3Lanes<F>& ra,
+                                 const Vec3Lanes<F>& rb) {
+        return body_b.PointVelocity(rb) - body_a.PointVelocity(ra);
+    };
+
+    for (uint32_t i = 0; i < block.m_point_count; i++) {
+        Block::Point& point = block.m_points[i];
+        Vec3Lanes<F> ra = LoadLanes<F>(point.m_ra, lane);
+        Vec3Lanes<F> rb = LoadLanes<F>(point.m_rb, lane);
+        F max_friction =
+            F(friction) * F::Load(&point.m_normal_impulse[lane]);
+        F min_friction = F(0.0f) - max_friction;
+        for (int k = 0; k < 2; k++) {
+            Vec3Lanes<F> t = LoadLanes<F>(block.m_tangents[k], lane);
+            F vt = relative_velocity(ra, rb).Dot(t);
+            F lambda = F::Load(&point.m_tangent_mass[k][lane]) * vt;
+            F old_impulse = F::Load(&point.m_tangent_impulse[k][lane]);
+            F impulse = Min(Max(old_impulse - lambda, min_friction),
+                            max_friction);
+            impulse.Store(&point.m_tangent_impulse[k][lane]);
+            ApplyLanes(body_a, body_b, t * (impulse - old_impulse), ra, rb);
+        }
+    }
+
+    Vec3Lanes<F> n = LoadLanes<F>(block.m_normal, lane);
+    for (uint32_t i = 0; i < block.m_point_count; i++) {
+        Block::Point& point = block.m_points[i];
+        Vec3Lanes<F> ra = LoadLanes<F>(point.m_ra, lane);
+        Vec3Lanes<F> rb = LoadLanes<F>(point.m_rb, lane);
+        F vn = relative_velocity(ra, rb).Dot(n);
+        F lambda = F::Load(&point.m_normal_mass[lane]) *
+                   (F::Load(&point.m_target_velocity[lane]) - vn);
+        F old_impulse = F::Load(&point.m_normal_impulse[lane]);
+        F impulse = Max(old_impulse + lambda, F(0.0f));
+        impulse.Store(&point.m_normal_impulse[lane]);
+        ApplyLanes(body_a, body_b, n * (impulse - old_impulse), ra, rb);
+    }
+    body_a.Store(a);
+    body_b.Store(b);
+}
+
+template <typename F>
+void WarmStartBlockLanes(Block* blocks, size_t count,
+                         ContactSolver::SolverBody* bodies) {
+    BlockVelocities a, b;
+    for (size_t i = 0; i < count; i++) {
+        Block& block = blocks[i];
+        GatherVelocities(block.m_body_a, bodies, a);
+        GatherVelocities(block.m_body_b, bodies, b);
+        for (uint32_t lane = 0; lane < Block::Width; lane += F::Width) {
+            WarmStartLanes<F>(block, a, b, lane);
+        }
+        ScatterVelocities(block.m_body_a, block.m_inv_mass_a, a, bodies);
+        ScatterVelocities(block.m_body_b, block.m_inv_mass_b, b, bodies);
+    }
+}
+
+template <typename F>
+void SolveBlockLanes(Block* blocks, size_t count,
+                     ContactSolver::SolverBody* bodies, float friction) {
+    BlockVelocities a, b;
+    for (size_t i = 0; i < count; i++) {
+        Block& block = blocks[i];
+        GatherVelocities(block.m_body_a, bodies, a);
+        GatherVelocities(block.m_body_b, bodies, b);
+        for (uint32_t lane = 0; lane < Block::Width; lane += F::Width) {
+            SolveLanes<F>(block, a, b, friction, lane);
+        }
+        ScatterVelocities(block.m_body_a, block.m_inv_mass_a, a, bodies);
+        ScatterVelocities(block.m_body_b, block.m_inv_mass_b, b, bodies);
+    }
+}
+
+}
+
+}
@@ -0,0 +1,414 @@
+#include "toy_physics/spatial_hash_grid.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace toy_physics {
+
+constexpr uint32_t InvalidDense = UINT32_MAX;
+
+SpatialHashGrid::SpatialHashGrid(JobSystem* job_system)
+    : m_job_system{job_system} {
+}
+
+void SpatialHashGrid::Add(uint32_t id, const AABB& aabb) {
+    if (id >= m_dense.size()) {
+        m_dense.resize(id + 1, InvalidDense);
+        m_moved.resize(id + 1, 0);
+    }
+    m_dense[id] = static_cast<uint32_t>(m_ids.size());
+    m_ids.push_back(id);
+    m_boxes.push_back(aabb);
+    // new proxies start active
+    swapDense(m_dense[id], m_active_count);
+    m_active_count++;
+    m_structure_changed = true;
+}
+
+void SpatialHashGrid::Remove(uint32_t id) {
+    if (!Contains(id)) {
+        return;
+    }
+
+    // keep the active range packed, then move the proxy to the back
+    uint32_t dense = m_dense[id];
+    if (dense < m_active_count) {
+        m_active_count--;
+        swapDense(dense, m_active_count);
+        dense = m_active_count;
+    } else {
+        m_resting_changed = true;
+    }
+    swapDense(dense, static_cast<uint32_t>(m_ids.size() - 1));
+    m_ids.pop_back();
+    m_boxes.pop_back();
+    m_dense[id] = InvalidDense;
+    m_structure_changed = true;
+}
+
+void SpatialHashGrid::Update(uint32_t id, const AABB& aabb,
+                             const Eigen::Vector3f& displacement) {
+    m_boxes[m_dense[id]] = aabb.Sweep(displacement);
+    if (m_dense[id] >= m_active_count) {
+        m_resting_changed = true;
+    }
+    if (!m_moved[id]) {
+        m_moved[id] = 1;
+        m_moved_ids.push_back(id);
+    }
+}
+
+bool SpatialHashGrid::Contains(uint32_t id) const {
+    return id < m_dense.size() && m_dense[id] != InvalidDense;
+}
+
+void SpatialHashGrid::ShiftOrigin(const Eigen::Vector3f& offset) {
+    for (AABB& box : m_boxes) {
+        box = box.Translate(offset);
+    }
+    // the cells are rebuilt by the next update, queries scan until then
+    m_structure_changed = true;
+    m_resting_changed = true;
+}
+
+void SpatialHashGrid::SetResting(uint32_t id, bool resting) {
+    if (!Contains(id) || (m_dense[id] >= m_active_count) == resting) {
+        return;
+    }
+    if (resting) {
+        m_active_count--;
+        swapDense(m_dense[id], m_active_count);
+    } else {
+        swapDense(m_dense[id], m_active_count);
+        m_active_count++;
+    }
+    m_structure_changed = true;
+    m_resting_changed = true;
+}
+
+void SpatialHashGrid::swapDense(uint32_t a, uint32_t b) {
+    if (a == b) {
+        return;
+    }
+    std::swap(m_boxes[a], m_boxes[b]);
+    std::swap(m_ids[a], m_ids[b]);
+    m_dense[m_ids[a]] = a;
+    m_dense[m_ids[b]] = b;
+}
+
+Eigen::Vector3i SpatialHashGrid::Grid::CellOf(
+    const Eigen::Vector3f& point) const {
+    // far away or broken proxies share the border cells, the conversion
+    // to int has to stay in range
+    constexpr float CellLimit = 1 << 20;
+    Eigen::Vector3f cell = (point * m_inv_cell_size).array().floor();
+    if (cell.hasNaN()) {
+        return Eigen::Vector3i::Zero();
+    }
+    return cell.cwiseMax(-CellLimit).cwiseMin(CellLimit).cast<int>();
+}
+
+uint32_t SpatialHashGrid::Grid::BucketOf(const Eigen::Vector3i& cell) const {
+    uint32_t hash = static_cast<uint32_t>(cell.x()) * 73856093u ^
+                    static_cast<uint32_t>(cell.y()) * 19349663u ^
+                    static_cast<uint32_t>(cell.z()) * 83492791u;
+    return hash & m_table_mask;
+}
+
+template <typename F>
+bool SpatialHashGrid::Grid::Visit(const AABB& aabb, const F& fn) const {
+    uint32_t count = static_cast<uint32_t>(m_ids.size());
+    if (count == 0) {
+        return true;
+    }
+
+    // a grid proxy overlapping the query has its center within half a cell
+    float half_cell = 0.5f / m_inv_cell_size;
+    Eigen::Vector3i min_cell =
+        CellOf(aabb.m_min - Eigen::Vector3f::Constant(half_cell));
+    Eigen::Vector3i max_cell =
+        CellOf(aabb.m_max + Eigen::Vector3f::Constant(half_cell));
+    Eigen::Vector3i span = max_cell - min_cell + Eigen::Vector3i::Ones();
+
+    // fall back to a linear scan when the query covers more cells than
+    // there are proxies
+    if (span.cast<double>().prod() > static_cast<double>(count)) {
+        for (uint32_t k = 0; k < count; k++) {
+            if (m_boxes[k].Intersect(aabb) && !fn(k)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // every grid proxy sits in exactly one cell, so visiting each cell's
+    // bucket and keeping only that cell's proxies reports them once even
+    // when cells share a bucket
+    for (int x = min_cell.x(); x <= max_cell.x(); x++) {
+        for (int y = min_cell.y(); y <= max_cell.y(); y++) {
+            for (int z = min_cell.z(); z <= max_cell.z(); z++) {
+                Eigen::Vector3i cell{x, y, z};
+                uint32_t bucket = BucketOf(cell);
+                for (uint32_t k = m_bucket_start[bucket];
+                     k < m_bucket_start[bucket + 1]; k++) {
+                    if (m_cells[k] == cell && m_boxes[k].Intersect(aabb) &&
+                        !fn(k)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    uint32_t oversized = m_table_mask + 1;
+    for (uint32_t k = m_bucket_start[oversized];
+         k < m_bucket_start[oversized + 1]; k++) {
+        if (m_boxes[k].Intersect(aabb) && !fn(k)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// bins the dense proxies [first, first + count) into grid
+void SpatialHashGrid::buildGrid(Grid& grid, uint32_t first, uint32_t count) {
+    constexpr uint32_t GrainSize = 512;
+
+    const AABB* boxes = m_boxes.data() + first;
+    const uint32_t* ids = m_ids.data() + first;
+    uint32_t worker_count =
+        m_job_system ? m_job_system->GetWorkerCount() : 1;
+
+    // overlapping proxies no larger than a cell always sit in neighbouring
+    // cells. The median keeps a few huge proxies from inflating the cells
+    float cell_size = m_cell_size;
+    if (cell_size <= 0 && count > 0) {
+        m_extents.resize(count);
+        parallelFor(count, GrainSize,
+                    [this, boxes](uint32_t begin, uint32_t end, uint32_t) {
+                        for (uint32_t i = begin; i < end; i++) {
+                            const AABB& box = boxes[i];
+                            m_extents[i] = (box.m_max - box.m_min).maxCoeff();
+                        }
+                    });
+        m_extent_order.assign(m_extents.begin(), m_extents.end());
+        auto median = m_extent_order.begin() + count / 2;
+        std::nth_element(m_extent_order.begin(), median, m_extent_order.end());
+        float limit = *median * OversizeFactor;
+
+        m_worker_max_extent.assign(worker_count, 0.0f);
+        parallelFor(count, GrainSize,
+                    [this, limit](uint32_t begin, uint32_t end,
+                                  uint32_t worker) {
+                        float extent = m_worker_max_extent[worker];
+                        for (uint32_t i = begin; i < end; i++) {
+                            if (m_extents[i] <= limit) {
+                                extent = std::max(extent, m_extents[i]);
+                            }
+                        }
+                        m_worker_max_extent[worker] = extent;
+                    });
+        cell_size = *std::max_element(m_worker_max_extent.begin(),
+                                      m_worker_max_extent.end());
+    }
+    grid.m_inv_cell_size = 1.0f / std::max(cell_size, 1e-4f);
+
+    uint32_t table_size = 1;
+    while (table_size < count * 2) {
+        table_size <<= 1;
+    }
+    grid.m_table_mask = table_size - 1;
+
+    m_cells.resize(count);
+    m_buckets.resize(count);
+    m_sorted.resize(count);
+    grid.m_bucket_start.assign(table_size + 2, 0);
+
+    // counting sort: histogram, prefix sum, scatter
+    parallelFor(count, GrainSize,
+                [this, &grid, boxes, table_size](uint32_t begin, uint32_t end,
+                                                 uint32_t) {
+                    for (uint32_t i = begin; i < end; i++) {
+                        const AABB& box = boxes[i];
+                        m_cells[i] = grid.CellOf(box.GetCenter());
+                        float extent = (box.m_max - box.m_min).maxCoeff();
+                        m_buckets[i] = extent * grid.m_inv_cell_size > 1
+                                           ? table_size
+                                           : grid.BucketOf(m_cells[i]);
+                        std::atomic_ref<uint32_t>{
+                            grid.m_bucket_start[m_buckets[i] + 1]}
+                            .fetch_add(1, std::memory_order_relaxed);
+                    }
+                });
+
+    for (uint32_t i = 0; i <= table_size; i++) {
+        grid.m_bucket_start[i + 1] += grid.m_bucket_start[i];
+    }
+    m_bucket_cursor.assign(grid.m_bucket_start.begin(),
+                           grid.m_bucket_start.end() - 1);
+
+    parallelFor(count, GrainSize,
+                [this](uint32_t begin, uint32_t end, uint32_t) {
+                    for (uint32_t i = begin; i < end; i++) {
+                        uint32_t slot =
+                            std::atomic_ref<uint32_t>{
+                                m_bucket_cursor[m_buckets[i]]}
+                                .fetch_add(1, std::memory_order_relaxed);
+                        m_sorted[slot] = i;
+                    }
+                });
+
+    // the atomic scatter leaves buckets in arbitrary order, sort the (tiny)
+    // buckets by dense index to keep results deterministic
+    parallelFor(table_size + 1, GrainSize * 4,
+                [this, &grid](uint32_t begin, uint32_t end, uint32_t) {
+                    for (uint32_t b = begin; b < end; b++) {
+                        uint32_t first = grid.m_bucket_start[b];
+                        uint32_t last = grid.m_bucket_start[b + 1];
+                        if (last - first > 1) {
+                            std::sort(m_sorted.begin() + first,
+                                      m_sorted.begin() + last);
+                        }
+                    }
+                });
+
+    // gather proxies in bucket order so candidate reads stay sequential
+    grid.m_boxes.resize(count);
+    grid.m_cells.resize(count);
+    grid.m_ids.resize(count);
+    parallelFor(count, GrainSize,
+                [this, &grid, boxes, ids](uint32_t begin, uint32_t end,
+                                          uint32_t) {
+                    for (uint32_t k = begin; k < end; k++) {
+                        uint32_t i = m_sorted[k];
+                        grid.m_boxes[k] = boxes[i];
+                        grid.m_cells[k] = m_cells[i];
+                        grid.m_ids[k] = ids[i];
+                    }
+                });
+}
+
+void SpatialHashGrid::UpdatePairs() {
+    constexpr uint32_t GrainSize = 512;
+
+    m_pairs.clear();
+    m_structure_changed = false;
+    for (uint32_t id : m_moved_ids) {
+        m_moved[id] = 0;
+    }
+    m_moved_ids.clear();
+    uint32_t worker_count =
+        m_job_system ? m_job_system->GetWorkerCount() : 1;
+    m_worker_pairs.resize(worker_count);
+    for (auto& pairs : m_worker_pairs) {
+        pairs.clear();
+    }
+
+    if (m_resting_changed) {
+        buildGrid(m_resting_grid, m_active_count,
+                  static_cast<uint32_t>(m_ids.size()) - m_active_count);
+        m_resting_changed = false;
+    }
+    buildGrid(m_active_grid, 0, m_active_count);
+
+    // every chunk remembers where its pairs landed in the worker buffer so
+    // the output can be stitched together in a deterministic order
+    const Grid& grid = m_active_grid;
+    uint32_t count = m_active_count;
+    uint32_t pair_grain = GrainSize / 4;
+    uint32_t oversized = grid.m_bucket_start[grid.m_table_mask + 1];
+    m_chunk_ranges.resize((count + pair_grain - 1) / pair_grain);
+    parallelFor(count, pair_grain, [this, &grid, pair_grain, oversized, count](
+                                       uint32_t begin, uint32_t end,
+                                       uint32_t worker) {
+        auto& pairs = m_worker_pairs[worker];
+        ChunkRange& range = m_chunk_ranges[begin / pair_grain];
+        range.m_worker = worker;
+        range.m_begin = static_cast<uint32_t>(pairs.size());
+
+        for (uint32_t k = begin; k < end; k++) {
+            const AABB& box = grid.m_boxes[k];
+            uint32_t id = grid.m_ids[k];
+            // resting proxies only pair with active ones
+            m_resting_grid.Visit(box, [&](uint32_t k2) {
+                uint32_t other = m_resting_grid.m_ids[k2];
+                pairs.push_back({std::min(id, other), std::max(id, other)});
+                return true;
+            });
+
+            // oversized proxies pair with every proxy of the grid and the
+            // oversized ones sorted after them
+            if (k >= oversized) {
+                for (uint32_t k2 = 0; k2 < count; k2++) {
+                    if ((k2 < oversized || k2 > k) &&
+                        box.Intersect(grid.m_boxes[k2])) {
+                        uint32_t other = grid.m_ids[k2];
+                        pairs.push_back(
+                            {std::min(id, other), std::max(id, other)});
+                    }
+                }
+                continue;
+            }
+            for (int x = -1; x <= 1; x++) {
+                for (int y = -1; y <= 1; y++) {
+                    for (int z = -1; z <= 1; z++) {
+                        Eigen::Vector3i cell =
+                            grid.m_cells[k] + Eigen::Vector3i{x, y, z};
+                        uint32_t bucket = grid.BucketOf(cell);
+                        uint32_t first =
+                            std::max(grid.m_bucket_start[bucket], k + 1);
+                        uint32_t last = grid.m_bucket_start[bucket + 1];
+                        for (uint32_t k2 = first; k2 < last; k2++) {
+                            // skip proxies of other cells hashed into the
+                            // same bucket, they are visited through their
+                            // own cell
+                            if (grid.m_cells[k2] != cell ||
+                                !box.Intersect(grid.m_boxes[k2])) {
+                                continue;
+                            }
+                            uint32_t other = grid.m_ids[k2];
+                            pairs.push_back({std::min(id, other),
+                                             std::max(id, other)});
+                        }
+                    }
+                }
+            }
+        }
+        range.m_end = static_cast<uint32_t>(pairs.size());
+    });
+
+    for (const ChunkRange& range : m_chunk_ranges) {
+        const auto& pairs = m_worker_pairs[range.m_worker];
+        m_pairs.insert(m_pairs.end(), pairs.begin() + range.m_begin,
+                       pairs.begin() + range.m_end);
+    }
+}
+
+void SpatialHashGrid::Query(
+    const AABB& aabb, const std::function<bool(uint32_t)>& callback) const {
+    // the grids are stale, scan everything
+    if (m_structure_changed) {
+        for (size_t i = 0; i < m_ids.size(); i++) {
+            if (m_boxes[i].Intersect(aabb) && !callback(m_ids[i])) {
+                return;
+            }
+        }
+        return;
+    }
+
+    for (const Grid* grid : {&m_resting_grid, &m_active_grid}) {
+        bool more = grid->Visit(aabb, [&](uint32_t k) {
+            uint32_t id = grid->m_ids[k];
+            return m_moved[id] || callback(id);
+        });
+        if (!more) {
+            return;
+        }
+    }
+    for (uint32_t id : m_moved_ids) {
+        if (m_boxes[m_dense[id]].Intersect(aabb) && !callback(id)) {
+            return;
+        }
+    }
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// raw copies for the saved broadphase states of world snapshots
+
+namespace toy_physics {
+
+template <typename T>
+void AppendBytes(std::vector<std::byte>& out, const T* data, size_t count) {
+    size_t size = count * sizeof(T);
+    if (size == 0) {
+        return;
+    }
+    size_t old_size = out.size();
+    out.resize(old_size + size);
+    std::memcpy(out.data() + old_size, static_cast<const void*>(data), size);
+}
+
+// the input may be a mapped file without any alignment, so records are
+// copied out instead of read in place. T has to be trivially copyable
+// apart from its default member initializers
+template <typename T>
+const std::byte* ReadBytes(const std::byte* in, T* data, size_t count) {
+    size_t size = count * sizeof(T);
+    if (size != 0) {
+        std::memcpy(static_cast<void*>(data), in, size);
+    }
+    return in + size;
+}
+
+}
@@ -0,0 +1,115 @@
+#include "toy_physics/stepper.hpp"
+
+#include <algorithm>
+
+namespace toy_physics {
+
+FixedStepper::FixedStepper(World& world, float fixed_delta_time)
+    : m_fixed_delta_time{fixed_delta_time}, m_world{world} {}
+
+uint32_t FixedStepper::Advance(float delta_time) {
+    uint32_t max_steps = std::max(m_max_steps, 1u);
+    m_accumulator = std::min(m_accumulator + std::max(delta_time, 0.0f),
+                             m_fixed_delta_time * max_steps);
+
+    uint32_t steps = 0;
+    while (steps < max_steps && m_accumulator >= m_fixed_delta_time) {
+        m_accumulator -= m_fixed_delta_time;
+        steps++;
+    }
+
+    uint32_t substeps = std::max(m_substeps, 1u);
+    float substep_time = m_fixed_delta_time / substeps;
+    for (uint32_t i = 0; i < steps; i++) {
+        // only the last step is interpolated from
+        if (i + 1 == steps) {
+            capturePoses();
+        }
+        for (uint32_t j = 0; j < substeps; j++) {
+            m_world.Step(substep_time);
+        }
+        m_step_count++;
+    }
+    return steps;
+}
+
+float FixedStepper::GetAlpha() const {
+    return std::clamp(m_accumulator / m_fixed_delta_time, 0.0f, 1.0f);
+}
+
+Pose FixedStepper::GetInterpolatedPose(BodyHandle handle) const {
+    Pose current = m_world.GetPose(handle);
+    const PreviousPose* previous = findPrevious(handle);
+    if (!previous) {
+        return current;
+    }
+    Pose from = previous->m_pose;
+    from.m_position += getOriginShift();
+    return from.Lerp(current, GetAlpha());
+}
+
+void FixedStepper::GetInterpolatedPoses(PoseBatch& poses) const {
+    const BodyColumns& bodies = m_world.GetBodies();
+    poses.Clear();
+    m_from.Clear();
+    Eigen::Vector3f shift = getOriginShift();
+    for (size_t i = 0; i < bodies.Size(); i++) {
+        Pose current{bodies.m_positions[i], bodies.m_rotations[i]};
+        const PreviousPose* previous =
+            findPrevious(m_world.GetHandle(static_cast<uint32_t>(i)));
+        // lerping a pose to itself gives it back
+        Pose from = current;
+        if (previous) {
+            from = previous->m_pose;
+            from.m_position += shift;
+        }
+        m_from.Push(from);
+        poses.Push(current);
+    }
+    LerpPoses(m_from, poses, GetAlpha(), poses);
+}
+
+void FixedStepper::GetInterpolatedPoses(std::vector<Pose>& poses) const {
+    GetInterpolatedPoses(m_interpolated);
+    poses.resize(m_interpolated.Size());
+    for (size_t i = 0; i < poses.size(); i++) {
+        poses[i] = m_interpolated.Get(i);
+    }
+}
+
+void FixedStepper::capturePoses() {
+    // sleeping and static bodies don't move in the step, their stale
+    // entries make them fall back to the current pose
+    const BodyColumns& bodies = m_world.GetBodies();
+    m_previous_origin = m_world.GetOrigin();
+    for (size_t i = 0; i < bodies.m_awake_count; i++) {
+        BodyHandle handle = m_world.GetHandle(static_cast<uint32_t>(i));
+        if (handle.m_index >= m_previous_poses.size()) {
+            m_previous_poses.resize(handle.m_index + 1);
+        }
+        PreviousPose& previous = m_previous_poses[handle.m_index];
+        previous.m_pose = {bodies.m_positions[i], bodies.m_rotations[i]};
+        previous.m_generation = handle.m_generation;
+        previous.m_step = m_step_count;
+    }
+}
+
+const FixedStepper::PreviousPose* FixedStepper::findPrevious(
+    BodyHandle handle) const {
+    if (!m_world.IsValid(handle) || m_step_count == 0 ||
+        handle.m_index >= m_previous_poses.size()) {
+        return nullptr;
+    }
+    const PreviousPose& previous = m_previous_poses[handle.m_index];
+    if (previous.m_generation != handle.m_generation ||
+        previous.m_step != m_step_count - 1) {
+        return nullptr;
+    }
+    return &previous;
+}
+
+Eigen::Vector3f FixedStepper::getOriginShift() const {
+    return (m_previous_origin - m_world.GetOrigin()).cast<float>();
+}
+
+}
@@ -0,0 +1,500 @@
+#include "toy_physics/sweep_and_prune.hpp"
+#include "state_bytes.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace toy_physics {
+
+// header of the saved state, followed by the per id columns, the active
+// and resting endpoints and the pairs
+struct SweepAndPruneState {
+    uint32_t m_id_count;
+    uint32_t m_active_count;
+    uint32_t m_resting_count;
+    uint32_t m_pair_count;
+};
+
+namespace {
+
+// {max_y, max_z, -min_y, -min_z} of a packed box, b overlaps it iff every
+// lane of b is smaller or equal
+struct YZBounds {
+#ifdef TOY_PHYSICS_SSE2
+    __m128 m_q;
+
+    explicit YZBounds(const float* a) {
+        __m128 pa = _mm_load_ps(a);
+        m_q = _mm_sub_ps(_mm_setzero_ps(),
+                         _mm_shuffle_ps(pa, pa, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+
+    bool Overlaps(const float* b) const {
+        return _mm_movemask_ps(_mm_cmple_ps(_mm_load_ps(b), m_q)) == 0xF;
+    }
+#else
+    float m_q[4];
+
+    explicit YZBounds(const float* a) : m_q{-a[2], -a[3], -a[0], -a[1]} {}
+
+    bool Overlaps(const float* b) const {
+        return b[0] <= m_q[0] && b[1] <= m_q[1] && b[2] <= m_q[2] &&
+               b[3] <= m_q[3];
+    }
+#endif
+};
+
+}
+
+void SweepAndPrune::Add(uint32_t id, const AABB& aabb) {
+    if (id >= m_boxes.size()) {
+        m_boxes.resize(id + 1);
+        m_in_use.resize(id + 1, 0);
+        m_resting.resize(id + 1, 0);
+        m_list.resize(id + 1, NoList);
+        m_keys.resize(id + 1);
+    }
+
+    // an id removed and reused before the next update keeps its endpoint,
+    // the next update moves it back to the active list
+    if (m_list[id] == NoList) {
+        m_active.m_endpoints.push_back({aabb.m_min.x(), id});
+        m_list[id] = ActiveList;
+        m_keys[id] = aabb.m_min.x();
+    } else {
+        SweepList& list = listOf(id);
+        if (aabb.m_min.x() < m_boxes[id].m_min.x()) {
+            list.m_has_lowered = true;
+        }
+        list.m_reach =
+            std::max(list.m_reach, double(aabb.m_max.x()) - m_keys[id]);
+        if (m_list[id] == RestingList) {
+            m_lists_changed = true;
+        }
+    }
+
+    m_boxes[id] = aabb;
+    m_in_use[id] = 1;
+    m_resting[id] = 0;
+}
+
+void SweepAndPrune::Remove(uint32_t id) {
+    if (!Contains(id)) {
+        return;
+    }
+    m_in_use[id] = 0;
+    m_lists_changed = true;
+}
+
+void SweepAndPrune::Update(uint32_t id, const AABB& aabb,
+                           const Eigen::Vector3f& displacement) {
+    AABB box = aabb.Sweep(displacement);
+    // a box that only moved up in x still starts after its endpoint
+    SweepList& list = listOf(id);
+    if (box.m_min.x() < m_boxes[id].m_min.x()) {
+        list.m_has_lowered = true;
+    }
+    list.m_reach = std::max(list.m_reach, double(box.m_max.x()) - m_keys[id]);
+    if (m_list[id] == RestingList) {
+        m_resting_changed = true;
+    }
+    m_boxes[id] = box;
+}
+
+bool SweepAndPrune::Contains(uint32_t id) const {
+    return id < m_in_use.size() && m_in_use[id];
+}
+
+void SweepAndPrune::ShiftOrigin(const Eigen::Vector3f& offset) {
+    // a common offset keeps the endpoint order, the sweep columns are
+    // rebuilt from the boxes by the next update
+    for (AABB& box : m_boxes) {
+        box = box.Translate(offset);
+    }
+    for (SweepList* list : {&m_active, &m_resting_list}) {
+        for (Endpoint& e : list->m_endpoints) {
+            e.m_min_x += offset.x();
+            m_keys[e.m_id] = e.m_min_x;
+        }
+        // rounding can move a max x further from its endpoint
+        measureReach(*list);
+    }
+    m_resting_changed = true;
+}
+
+void SweepAndPrune::SetResting(uint32_t id, bool resting) {
+    if (!Contains(id) || m_resting[id] == resting) {
+        return;
+    }
+    m_resting[id] = resting;
+    m_lists_changed = true;
+}
+
+bool SweepAndPrune::SaveState(std::vector<std::byte>& out) const {
+    SweepAndPruneState state;
+    state.m_id_count = static_cast<uint32_t>(m_boxes.size());
+    state.m_active_count = static_cast<uint32_t>(m_active.m_endpoints.size());
+    state.m_resting_count =
+        static_cast<uint32_t>(m_resting_list.m_endpoints.size());
+    state.m_pair_count = static_cast<uint32_t>(m_pairs.size());
+
+    out.clear();
+    out.reserve(sizeof(state) +
+                m_boxes.size() * (sizeof(AABB) + 3 * sizeof(uint8_t)) +
+                (state.m_active_count + state.m_resting_count) *
+                    sizeof(Endpoint) +
+                m_pairs.size() * sizeof(BroadphasePair));
+    AppendBytes(out, &state, 1);
+    AppendBytes(out, m_boxes.data(), m_boxes.size());
+    AppendBytes(out, m_in_use.data(), m_in_use.size());
+    AppendBytes(out, m_resting.data(), m_resting.size());
+    AppendBytes(out, m_list.data(), m_list.size());
+    AppendBytes(out, m_active.m_endpoints.data(), m_active.m_endpoints.size());
+    AppendBytes(out, m_resting_list.m_endpoints.data(),
+                m_resting_list.m_endpoints.size());
+    AppendBytes(out, m_pairs.data(), m_pairs.size());
+    return true;
+}
+
+bool SweepAndPrune::LoadState(std::span<const std::byte> data) {
+    SweepAndPruneState state;
+    if (data.size() < sizeof(state)) {
+        return false;
+    }
+    const std::byte* in = ReadBytes(data.data(), &state, 1);
+    size_t size = sizeof(state) +
+                  state.m_id_count * (sizeof(AABB) + 3 * sizeof(uint8_t)) +
+                  (size_t(state.m_active_count) + state.m_resting_count) *
+                      sizeof(Endpoint) +
+                  state.m_pair_count * sizeof(BroadphasePair);
+    if (data.size() != size) {
+        return false;
+    }
+
+    m_boxes.resize(state.m_id_count);
+    in = ReadBytes(in, m_boxes.data(), m_boxes.size());
+    m_in_use.resize(state.m_id_count);
+    in = ReadBytes(in, m_in_use.data(), m_in_use.size());
+    m_resting.resize(state.m_id_count);
+    in = ReadBytes(in, m_resting.data(), m_resting.size());
+    m_list.resize(state.m_id_count);
+    in = ReadBytes(in, m_list.data(), m_list.size());
+    m_keys.resize(state.m_id_count);
+    m_active.m_endpoints.resize(state.m_active_count);
+    in = ReadBytes(in, m_active.m_endpoints.data(),
+                   m_active.m_endpoints.size());
+    m_resting_list.m_endpoints.resize(state.m_resting_count);
+    in = ReadBytes(in, m_resting_list.m_endpoints.data(),
+                   m_resting_list.m_endpoints.size());
+    m_pairs.resize(state.m_pair_count);
+    ReadBytes(in, m_pairs.data(), m_pairs.size());
+
+    // one endpoint in the list its id names, registered ids need theirs
+    std::vector<uint8_t> endpoint_seen(state.m_id_count, 0);
+    auto check_list = [&](const SweepList& list, ListTag tag) {
+        for (const Endpoint& e : list.m_endpoints) {
+            if (e.m_id >= state.m_id_count || m_list[e.m_id] != tag ||
+                endpoint_seen[e.m_id]) {
+                return false;
+            }
+            endpoint_seen[e.m_id] = 1;
+        }
+        return true;
+    };
+    if (!check_list(m_active, ActiveList) ||
+        !check_list(m_resting_list, RestingList)) {
+        return false;
+    }
+    for (uint32_t id = 0; id < state.m_id_count; id++) {
+        if ((m_list[id] != NoList) != (endpoint_seen[id] != 0) ||
+            (m_in_use[id] && m_list[id] == NoList)) {
+            return false;
+        }
+    }
+    for (const BroadphasePair& pair : m_pairs) {
+        if (pair.m_a >= pair.m_b || pair.m_b >= state.m_id_count) {
+            return false;
+        }
+    }
+
+    // a state saved before the next sort ends in unsorted endpoints, and
+    // boxes may have moved below their endpoints
+    for (SweepList* list : {&m_active, &m_resting_list}) {
+        const std::vector<Endpoint>& endpoints = list->m_endpoints;
+        list->m_sorted_count = 1;
+        while (list->m_sorted_count < endpoints.size() &&
+               endpoints[list->m_sorted_count - 1].m_min_x <=
+                   endpoints[list->m_sorted_count].m_min_x) {
+            list->m_sorted_count++;
+        }
+        list->m_sorted_count =
+            std::min(list->m_sorted_count, endpoints.size());
+        list->m_has_lowered = false;
+        for (const Endpoint& e : endpoints) {
+            if (m_boxes[e.m_id].m_min.x() < e.m_min_x) {
+                list->m_has_lowered = true;
+            }
+            m_keys[e.m_id] = e.m_min_x;
+        }
+    }
+    // no box counts as wide until the next update finds them again
+    m_wide.clear();
+    m_is_wide.assign(m_resting_list.m_endpoints.size(), 0);
+    measureReach(m_active);
+    measureReach(m_resting_list);
+    // both are order preserving, redoing them gives the same lists
+    m_lists_changed = true;
+    m_resting_changed = true;
+    return true;
+}
+
+SweepAndPrune::SweepList& SweepAndPrune::listOf(uint32_t id) {
+    return m_list[id] == RestingList ? m_resting_list : m_active;
+}
+
+// drops the endpoints of removed ids and moves the ones whose id changed
+// between active and resting to the end of the other list. Both lists keep
+// their order
+void SweepAndPrune::moveEndpoints() {
+    auto move = [this](SweepList& from, ListTag tag, SweepList& to,
+                       ListTag to_tag) {
+        size_t count = from.m_endpoints.size();
+        std::erase_if(from.m_endpoints, [&](const Endpoint& e) {
+            if (!m_in_use[e.m_id]) {
+                m_list[e.m_id] = NoList;
+                return true;
+            }
+            if ((m_resting[e.m_id] != 0) == (tag == RestingList)) {
+                return false;
+            }
+            to.m_endpoints.push_back(e);
+            m_list[e.m_id] = to_tag;
+            return true;
+        });
+        return from.m_endpoints.size() != count;
+    };
+
+    size_t resting_count = m_resting_list.m_endpoints.size();
+    move(m_active, ActiveList, m_resting_list, RestingList);
+    bool resting_changed = m_resting_list.m_endpoints.size() != resting_count;
+    resting_changed |= move(m_resting_list, RestingList, m_active, ActiveList);
+    m_resting_changed |= resting_changed;
+    m_lists_changed = false;
+}
+
+void SweepAndPrune::sortEndpoints(SweepList& list) {
+    std::vector<Endpoint>& endpoints = list.m_endpoints;
+    list.m_has_lowered = false;
+    for (Endpoint& e : endpoints) {
+        e.m_min_x = m_boxes[e.m_id].m_min.x();
+        m_keys[e.m_id] = e.m_min_x;
+    }
+
+    // a bulk add leaves the new endpoints in random order. Both sorts are
+    // stable, so they give the same order
+    size_t count = endpoints.size();
+    size_t added = count - std::min(list.m_sorted_count, count);
+    list.m_sorted_count = count;
+    if (added > count / 4) {
+        std::stable_sort(endpoints.begin(), endpoints.end(),
+                         [](const Endpoint& a, const Endpoint& b) {
+                             return a.m_min_x < b.m_min_x;
+                         });
+        return;
+    }
+
+    // the previous order is nearly sorted, insertion sort repairs it in
+    // roughly O(n + swaps)
+    for (size_t i = 1; i < count; i++) {
+        Endpoint e = endpoints[i];
+        size_t j = i;
+        while (j > 0 && endpoints[j - 1].m_min_x > e.m_min_x) {
+            endpoints[j] = endpoints[j - 1];
+            j--;
+        }
+        endpoints[j] = e;
+    }
+}
+
+void SweepAndPrune::buildColumns(SweepList& list) {
+    size_t count = list.m_endpoints.size();
+    list.m_max_x.resize(count);
+    list.m_yz.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const AABB& box = m_boxes[list.m_endpoints[i].m_id];
+        list.m_max_x[i] = box.m_max.x();
+        list.m_yz[i] = {box.m_min.y(), box.m_min.z(), -box.m_max.y(),
+                        -box.m_max.z()};
+    }
+}
+
+// a ground plane spanning the scene would stretch the resting window over
+// everything, boxes much wider than the median get tested on their own
+void SweepAndPrune::findWideBoxes() {
+    const std::vector<Endpoint>& endpoints = m_resting_list.m_endpoints;
+    const std::vector<float>& max_x = m_resting_list.m_max_x;
+    size_t count = endpoints.size();
+    m_widths.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        m_widths[i] = max_x[i] - endpoints[i].m_min_x;
+    }
+    float limit = std::numeric_limits<float>::infinity();
+    if (count > 0) {
+        auto median = m_widths.begin() + count / 2;
+        std::nth_element(m_widths.begin(), median, m_widths.end());
+        limit = *median * WideFactor;
+    }
+
+    m_wide.clear();
+    m_is_wide.assign(count, 0);
+    for (size_t i = 0; i < count; i++) {
+        if (max_x[i] - endpoints[i].m_min_x > limit) {
+            m_wide.push_back(static_cast<uint32_t>(i));
+            m_is_wide[i] = 1;
+        }
+    }
+    measureReach(m_resting_list);
+}
+
+void SweepAndPrune::measureReach(SweepList& list) {
+    const std::vector<Endpoint>& endpoints = list.m_endpoints;
+    size_t sorted = std::min(list.m_sorted_count, endpoints.size());
+    bool resting = &list == &m_resting_list;
+    list.m_reach = 0;
+    for (size_t i = 0; i < sorted; i++) {
+        if (resting && m_is_wide[i]) {
+            continue;
+        }
+        // exact for float bounds
+        list.m_reach = std::max(list.m_reach,
+                                double(m_boxes[endpoints[i].m_id].m_max.x()) -
+                                    double(endpoints[i].m_min_x));
+    }
+}
+
+void SweepAndPrune::sweepActive() {
+    size_t count = m_active.m_endpoints.size();
+    const Endpoint* endpoints = m_active.m_endpoints.data();
+    const PackedYZ* yz = m_active.m_yz.data();
+    for (size_t i = 0; i < count; i++) {
+        float max_x = m_active.m_max_x[i];
+        uint32_t id = endpoints[i].m_id;
+        YZBounds bounds{yz[i].m_v};
+        for (size_t j = i + 1; j < count && endpoints[j].m_min_x <= max_x;
+             j++) {
+            if (bounds.Overlaps(yz[j].m_v)) {
+                uint32_t other = endpoints[j].m_id;
+                m_pairs.push_back({std::min(id, other), std::max(id, other)});
+            }
+        }
+    }
+}
+
+void SweepAndPrune::sweepResting() {
+    size_t count = m_active.m_endpoints.size();
+    size_t resting_count = m_resting_list.m_endpoints.size();
+    const Endpoint* endpoints = m_active.m_endpoints.data();
+    const Endpoint* resting = m_resting_list.m_endpoints.data();
+    const float* resting_max_x = m_resting_list.m_max_x.data();
+    const PackedYZ* resting_yz = m_resting_list.m_yz.data();
+    size_t first = 0;
+    for (size_t i = 0; i < count; i++) {
+        float min_x = endpoints[i].m_min_x;
+        float max_x = m_active.m_max_x[i];
+        uint32_t id = endpoints[i].m_id;
+        YZBounds bounds{m_active.m_yz[i].m_v};
+
+        // a resting box starting more than the widest one before min_x
+        // ends before it. Active boxes come in min x order, so the window
+        // only moves forward
+        while (first < resting_count &&
+               double(resting[first].m_min_x) + m_resting_list.m_reach <
+                   double(min_x)) {
+            first++;
+        }
+        for (size_t j = first; j < resting_count && resting[j].m_min_x <= max_x;
+             j++) {
+            if (!m_is_wide[j] && resting_max_x[j] >= min_x &&
+                bounds.Overlaps(resting_yz[j].m_v)) {
+                uint32_t other = resting[j].m_id;
+                m_pairs.push_back({std::min(id, other), std::max(id, other)});
+            }
+        }
+        for (uint32_t j : m_wide) {
+            if (resting[j].m_min_x <= max_x && resting_max_x[j] >= min_x &&
+                bounds.Overlaps(resting_yz[j].m_v)) {
+                uint32_t other = resting[j].m_id;
+                m_pairs.push_back({std::min(id, other), std::max(id, other)});
+            }
+        }
+    }
+}
+
+void SweepAndPrune::UpdatePairs() {
+    if (m_lists_changed) {
+        moveEndpoints();
+    }
+    sortEndpoints(m_active);
+    buildColumns(m_active);
+    measureReach(m_active);
+    if (m_resting_changed) {
+        sortEndpoints(m_resting_list);
+        buildColumns(m_resting_list);
+        findWideBoxes();
+        m_resting_changed = false;
+    }
+
+    m_pairs.clear();
+    sweepActive();
+    sweepResting();
+    std::sort(m_pairs.begin(), m_pairs.end());
+}
+
+// walks the order of the last UpdatePairs() and tests current boxes, from
+// min x minus the reach of the list on. Endpoints added since then are
+// scanned after the sorted ones
+void SweepAndPrune::Query(const AABB& aabb,
+                          const std::function<bool(uint32_t)>& callback) const {
+    auto visit = [&](const Endpoint& e) {
+        return !m_in_use[e.m_id] || !m_boxes[e.m_id].Intersect(aabb) ||
+               callback(e.m_id);
+    };
+    auto walk = [&](const SweepList& list, const uint8_t* is_wide) {
+        const std::vector<Endpoint>& endpoints = list.m_endpoints;
+        size_t sorted = std::min(list.m_sorted_count, endpoints.size());
+        size_t first = static_cast<size_t>(
+            std::partition_point(endpoints.begin(), endpoints.begin() + sorted,
+                                 [&](const Endpoint& e) {
+                                     return double(e.m_min_x) + list.m_reach <
+                                            double(aabb.m_min.x());
+                                 }) -
+            endpoints.begin());
+        for (size_t i = first; i < sorted; i++) {
+            const Endpoint& e = endpoints[i];
+            if (!list.m_has_lowered && e.m_min_x > aabb.m_max.x()) {
+                break;
+            }
+            if ((!is_wide || !is_wide[i]) && !visit(e)) {
+                return false;
+            }
+        }
+        for (size_t i = sorted; i < endpoints.size(); i++) {
+            if (!visit(endpoints[i])) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (!walk(m_active, nullptr)) {
+        return;
+    }
+    for (uint32_t i : m_wide) {
+        if (!visit(m_resting_list.m_endpoints[i])) {
+            return;
+        }
+    }
+    walk(m_resting_list, m_is_wide.data());
+}
+
+}
@@ -0,0 +1,90 @@
+#include "toy_physics/toi.hpp"
+#include "toy_physics/gjk.hpp"
+
+namespace toy_physics {
+
+Pose Sweep::GetBodyPose(float t) const {
+    Pose pose = m_body;
+    pose.m_position += m_linear * t;
+    float angle = m_angular.norm() * t;
+    if (angle > 1e-6f) {
+        pose.m_rotation =
+            Eigen::AngleAxisf{angle, m_angular.normalized()} * pose.m_rotation;
+        pose.m_rotation.normalize();
+    }
+    return pose;
+}
+
+Pose Sweep::GetShapePose(float t) const {
+    return GetBodyPose(t).TransformBy(m_local);
+}
+
+float ComputeSweepRadius(const Geometry& geom, const Pose& local_pose) {
+    float offset = local_pose.m_position.norm();
+    switch (geom.GetType()) {
+        case Geometry::Type::Box:
+            return offset +
+                   static_cast<const BoxGeometry&>(geom).m_half_size.norm();
+        case Geometry::Type::Sphere:
+            if (offset == 0) {
+                return 0;
+            }
+            return offset + static_cast<const SphereGeometry&>(geom).m_radius;
+        case Geometry::Type::Capsule: {
+            auto& capsule = static_cast<const CapsuleGeometry&>(geom);
+            return offset + capsule.m_height * 0.5f + capsule.m_radius;
+        }
+    }
+    return offset;
+}
+
+ToiOutput TimeOfImpact(const Geometry& a, const Sweep& sweep_a,
+                       const Geometry& b, const Sweep& sweep_b,
+                       const ToiSettings& settings) {
+    // a point of a spinning shape moves at most |w| * radius
+    float angular_bound =
+        sweep_a.m_angular.norm() * ComputeSweepRadius(a, sweep_a.m_local) +
+        sweep_b.m_angular.norm() * ComputeSweepRadius(b, sweep_b.m_local);
+    Eigen::Vector3f relative = sweep_b.m_linear - sweep_a.m_linear;
+    float target = settings.m_target_separation;
+
+    ToiOutput output;
+    SimplexCache cache;
+    float t = 0;
+    while (output.m_iterations < settings.m_max_iterations) {
+        output.m_iterations++;
+        ConvexProxy proxy_a = MakeConvexProxy(a, sweep_a.GetShapePose(t));
+        ConvexProxy proxy_b = MakeConvexProxy(b, sweep_b.GetShapePose(t));
+        GjkOutput gjk = GjkDistance(proxy_a, proxy_b, &cache);
+        float separation =
+            gjk.m_distance - proxy_a.m_radius - proxy_b.m_radius;
+        if (separation <= target + settings.m_tolerance) {
+            output.m_state = t == 0 ? ToiOutput::State::Touching
+                                    : ToiOutput::State::Hit;
+            output.m_t = t;
+            output.m_separation = separation;
+            return output;
+        }
+
+        // separation is positive, so the cores are apart and the normal is
+        // well defined
+        Eigen::Vector3f normal =
+            (gjk.m_point_b - gjk.m_point_a) / gjk.m_distance;
+        float approach = angular_bound - relative.dot(normal);
+        if (approach <= 0) {
+            return output;
+        }
+        t += (separation - target) / approach;
+        if (t >= 1) {
+            return output;
+        }
+    }
+
+    // every advance was safe, stopping early only stops short
+    output.m_state = ToiOutput::State::Hit;
+    output.m_t = t;
+    output.m_separation = settings.m_target_separation;
+    return output;
+}
+
+}
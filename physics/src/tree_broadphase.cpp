@@ -0,0 +1,221 @@
+#include "toy_physics/tree_broadphase.hpp"
+#include "state_bytes.hpp"
+
+#include <algorithm>
+
+namespace toy_physics {
+
+// header of the saved state, followed by the nodes, the id -> proxy table,
+// the resting flags, the pairs and the move buffer
+struct TreeState {
+    uint32_t m_node_count;
+    uint32_t m_root;
+    uint32_t m_free_list;
+    uint32_t m_proxy_count;
+    uint32_t m_id_count;
+    uint32_t m_pair_count;
+    uint32_t m_move_count;
+};
+
+void TreeBroadphase::Add(uint32_t id, const AABB& aabb) {
+    if (id >= m_proxies.size()) {
+        m_proxies.resize(id + 1, DynamicAABBTree::NullNode);
+        m_moved.resize(id + 1, 0);
+        m_resting.resize(id + 1, 0);
+    }
+    m_proxies[id] = m_tree.CreateProxy(aabb, id);
+    m_resting[id] = 0;
+    markMoved(id);
+}
+
+void TreeBroadphase::Remove(uint32_t id) {
+    if (!Contains(id)) {
+        return;
+    }
+    m_tree.DestroyProxy(m_proxies[id]);
+    m_proxies[id] = DynamicAABBTree::NullNode;
+}
+
+void TreeBroadphase::Update(uint32_t id, const AABB& aabb,
+                            const Eigen::Vector3f& displacement) {
+    if (m_tree.MoveProxy(m_proxies[id], aabb, displacement)) {
+        markMoved(id);
+    }
+}
+
+bool TreeBroadphase::Contains(uint32_t id) const {
+    return id < m_proxies.size() && m_proxies[id] != DynamicAABBTree::NullNode;
+}
+
+void TreeBroadphase::ShiftOrigin(const Eigen::Vector3f& offset) {
+    m_tree.ShiftOrigin(offset);
+}
+
+void TreeBroadphase::SetResting(uint32_t id, bool resting) {
+    if (!Contains(id) || m_resting[id] == resting) {
+        return;
+    }
+    m_resting[id] = resting;
+    // pairs with resting neighbours were dropped while it rested, a query
+    // finds them again
+    if (!resting) {
+        markMoved(id);
+    }
+}
+
+void TreeBroadphase::Query(
+    const AABB& aabb, const std::function<bool(uint32_t)>& callback) const {
+    m_tree.Query(aabb, [&](uint32_t proxy) {
+        return callback(m_tree.GetUserData(proxy));
+    });
+}
+
+void TreeBroadphase::CastQuery(
+    AABBCast* casts, uint32_t count,
+    const std::function<void(uint32_t, uint32_t)>& callback) const {
+    m_tree.CastQuery(casts, count, [&](uint32_t cast, uint32_t proxy) {
+        callback(cast, m_tree.GetUserData(proxy));
+    });
+}
+
+bool TreeBroadphase::SaveState(std::vector<std::byte>& out) const {
+    const auto& nodes = m_tree.GetNodes();
+    TreeState state;
+    state.m_node_count = static_cast<uint32_t>(nodes.size());
+    state.m_root = m_tree.GetRoot();
+    state.m_free_list = m_tree.GetFreeList();
+    state.m_proxy_count = static_cast<uint32_t>(m_tree.GetProxyCount());
+    state.m_id_count = static_cast<uint32_t>(m_proxies.size());
+    state.m_pair_count = static_cast<uint32_t>(m_pairs.size());
+    state.m_move_count = static_cast<uint32_t>(m_move_buffer.size());
+
+    out.clear();
+    out.reserve(sizeof(state) + nodes.size() * sizeof(DynamicAABBTree::Node) +
+                (m_proxies.size() + m_move_buffer.size()) * sizeof(uint32_t) +
+                m_resting.size() * sizeof(uint8_t) +
+                m_pairs.size() * sizeof(BroadphasePair));
+    AppendBytes(out, &state, 1);
+    AppendBytes(out, nodes.data(), nodes.size());
+    AppendBytes(out, m_proxies.data(), m_proxies.size());
+    AppendBytes(out, m_resting.data(), m_resting.size());
+    AppendBytes(out, m_pairs.data(), m_pairs.size());
+    AppendBytes(out, m_move_buffer.data(), m_move_buffer.size());
+    return true;
+}
+
+bool TreeBroadphase::LoadState(std::span<const std::byte> data) {
+    TreeState state;
+    if (data.size() < sizeof(state)) {
+        return false;
+    }
+    const std::byte* in = ReadBytes(data.data(), &state, 1);
+    size_t size = sizeof(state) +
+                  state.m_node_count * sizeof(DynamicAABBTree::Node) +
+                  state.m_id_count * (sizeof(uint32_t) + sizeof(uint8_t)) +
+                  state.m_pair_count * sizeof(BroadphasePair) +
+                  state.m_move_count * sizeof(uint32_t);
+    if (data.size() != size) {
+        return false;
+    }
+
+    std::vector<DynamicAABBTree::Node> nodes(state.m_node_count);
+    in = ReadBytes(in, nodes.data(), nodes.size());
+    if (!m_tree.Restore(std::move(nodes), state.m_root, state.m_free_list,
+                        state.m_proxy_count)) {
+        return false;
+    }
+    m_proxies.resize(state.m_id_count);
+    in = ReadBytes(in, m_proxies.data(), m_proxies.size());
+    m_resting.resize(state.m_id_count);
+    in = ReadBytes(in, m_resting.data(), m_resting.size());
+    m_pairs.resize(state.m_pair_count);
+    in = ReadBytes(in, m_pairs.data(), m_pairs.size());
+    m_move_buffer.resize(state.m_move_count);
+    ReadBytes(in, m_move_buffer.data(), m_move_buffer.size());
+
+    // ids and proxies have to point at each other, every leaf is a proxy
+    const auto& tree_nodes = m_tree.GetNodes();
+    size_t proxy_count = 0;
+    for (uint32_t id = 0; id < m_proxies.size(); id++) {
+        uint32_t proxy = m_proxies[id];
+        if (proxy == DynamicAABBTree::NullNode) {
+            continue;
+        }
+        if (proxy >= tree_nodes.size() || tree_nodes[proxy].m_height != 0 ||
+            tree_nodes[proxy].m_user_data != id) {
+            return false;
+        }
+        proxy_count++;
+    }
+    if (proxy_count != m_tree.GetProxyCount()) {
+        return false;
+    }
+    for (const BroadphasePair& pair : m_pairs) {
+        if (pair.m_a >= pair.m_b || pair.m_b >= state.m_id_count) {
+            return false;
+        }
+    }
+
+    m_moved.assign(m_proxies.size(), 0);
+    for (uint32_t id : m_move_buffer) {
+        if (id >= m_moved.size() || m_moved[id]) {
+            return false;
+        }
+        m_moved[id] = 1;
+    }
+    return true;
+}
+
+void TreeBroadphase::markMoved(uint32_t id) {
+    if (!m_moved[id]) {
+        m_moved[id] = 1;
+        m_move_buffer.push_back(id);
+    }
+}
+
+void TreeBroadphase::UpdatePairs() {
+    // drop pairs whose proxies went away, came to rest or whose fat AABBs
+    // separated
+    std::erase_if(m_pairs, [this](const BroadphasePair& pair) {
+        if (!Contains(pair.m_a) || !Contains(pair.m_b) ||
+            (m_resting[pair.m_a] && m_resting[pair.m_b])) {
+            return true;
+        }
+        return !m_tree.GetFatAABB(m_proxies[pair.m_a])
+                    .Intersect(m_tree.GetFatAABB(m_proxies[pair.m_b]));
+    });
+
+    m_new_pairs.clear();
+    for (uint32_t id : m_move_buffer) {
+        m_moved[id] = 0;
+        if (!Contains(id)) {
+            continue;
+        }
+
+        const AABB& fat = m_tree.GetFatAABB(m_proxies[id]);
+        m_tree.Query(fat, [&](uint32_t proxy) {
+            uint32_t other = m_tree.GetUserData(proxy);
+            if (other != id && !(m_resting[id] && m_resting[other])) {
+                m_new_pairs.push_back(
+                    {std::min(id, other), std::max(id, other)});
+            }
+            return true;
+        });
+    }
+    m_move_buffer.clear();
+
+    if (m_new_pairs.empty()) {
+        return;
+    }
+
+    std::sort(m_new_pairs.begin(), m_new_pairs.end());
+    m_merged_pairs.clear();
+    std::merge(m_pairs.begin(), m_pairs.end(), m_new_pairs.begin(),
+               m_new_pairs.end(), std::back_inserter(m_merged_pairs));
+    m_merged_pairs.erase(
+        std::unique(m_merged_pairs.begin(), m_merged_pairs.end()),
+        m_merged_pairs.end());
+    std::swap(m_pairs, m_merged_pairs);
+}
+
+}
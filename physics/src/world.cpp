@@ -0,0 +1,1292 @@
+#include "toy_physics/world.hpp"
+#include "toy_physics/inertia.hpp"
+#include "toy_physics/log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <span>
+
+namespace toy_physics {
+
+static double GetSeconds() {
+    return std::chrono::duration<double>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// runs fn and stores its wall time in seconds
+template <typename F>
+static void Timed(double& seconds, const F& fn) {
+    double start = GetSeconds();
+    fn();
+    seconds = GetSeconds() - start;
+}
+
+World::World(Broadphase::Type broadphase, uint32_t worker_count)
+    : m_job_system{std::make_unique<JobSystem>(worker_count)},
+      m_broadphase{CreateBroadphase(broadphase, m_job_system.get())} {
+    buildStepGraph();
+}
+
+World::World(Broadphase::Type broadphase, JobExecutor& executor)
+    : m_job_system{std::make_unique<JobSystem>(executor)},
+      m_broadphase{CreateBroadphase(broadphase, m_job_system.get())} {
+    buildStepGraph();
+}
+
+BodyHandle World::CreateBody(const Body& body) {
+    Shape shape = body.m_geometry;
+    if (shape.m_geom && !m_geometries.IsValid(shape.m_geom)) {
+        LOGE("geometry handle doesn't belong to this world's pool");
+        shape.m_geom = {};
+    }
+
+    uint32_t slot_index;
+    if (m_free_slots.empty()) {
+        slot_index = static_cast<uint32_t>(m_slots.size());
+        m_slots.emplace_back();
+    } else {
+        slot_index = m_free_slots.back();
+        m_free_slots.pop_back();
+    }
+
+    Slot& slot = m_slots[slot_index];
+    slot.m_dense = static_cast<uint32_t>(m_bodies.Size());
+    slot.m_sleeping_island = BodyHandle::InvalidIndex;
+
+    m_bodies.m_positions.push_back(body.m_pose.m_position);
+    m_bodies.m_rotations.push_back(body.m_pose.m_rotation);
+    m_bodies.m_velocities.push_back(body.m_velocity);
+    m_bodies.m_angular_velocities.push_back(body.m_angular_velocity);
+    m_bodies.m_inv_masses.push_back(body.m_inv_mass);
+    m_bodies.m_inv_inertias.push_back(
+        shape.m_geom ? ComputeInvInertia(m_geometries.Get(shape.m_geom),
+                                         shape.m_local_pose, body.m_inv_mass)
+                     : Eigen::Matrix3f::Zero());
+    m_bodies.m_shapes.push_back(shape);
+    m_bodies.m_shape_poses.emplace_back();
+    m_bodies.m_aabbs.emplace_back();
+    m_bodies.m_shape_geometries.push_back(shape.m_geom);
+    m_bodies.m_sleep_times.push_back(0);
+    m_bodies.m_bullets.push_back(body.m_bullet);
+    m_bodies.m_slots.push_back(slot_index);
+    updateShape(slot.m_dense);
+    m_moved_slots.resize((m_slots.size() + 63) / 64);
+
+    // new dynamic bodies start awake
+    if (body.m_inv_mass > 0) {
+        swapBodies(slot.m_dense, static_cast<uint32_t>(m_bodies.m_awake_count));
+        m_bodies.m_awake_count++;
+    }
+
+    if (shape.m_geom) {
+        m_broadphase->Add(slot_index, m_bodies.m_aabbs[slot.m_dense]);
+        setResting(slot_index, body.m_inv_mass == 0);
+    }
+
+    return {slot_index, slot.m_generation};
+}
+
+void World::RemoveBody(BodyHandle handle) {
+    if (!IsValid(handle)) {
+        LOGW("remove invalid body handle {}", handle.m_index);
+        return;
+    }
+
+    Slot& slot = m_slots[handle.m_index];
+    if (slot.m_sleeping_island != BodyHandle::InvalidIndex) {
+        wakeIsland(slot.m_sleeping_island);
+    }
+    if (m_broadphase->Contains(handle.m_index)) {
+        // whatever rested on the body has to notice it is gone
+        wakeTouching(m_bodies.m_aabbs[slot.m_dense]);
+        m_broadphase->Remove(handle.m_index);
+    }
+    m_moved_slots[handle.m_index / 64] &= ~(1ull << (handle.m_index % 64));
+    // contacts are keyed by slot, a body created into it must start cold
+    m_narrowphase.GetContactCache().RemoveId(handle.m_index);
+
+    // keep the awake range packed, then move the body to the back
+    uint32_t dense = slot.m_dense;
+    if (dense < m_bodies.m_awake_count) {
+        m_bodies.m_awake_count--;
+        swapBodies(dense, static_cast<uint32_t>(m_bodies.m_awake_count));
+        dense = static_cast<uint32_t>(m_bodies.m_awake_count);
+    }
+    swapBodies(dense, static_cast<uint32_t>(m_bodies.Size() - 1));
+
+    m_bodies.m_positions.pop_back();
+    m_bodies.m_rotations.pop_back();
+    m_bodies.m_velocities.pop_back();
+    m_bodies.m_angular_velocities.pop_back();
+    m_bodies.m_inv_masses.pop_back();
+    m_bodies.m_inv_inertias.pop_back();
+    m_bodies.m_shapes.pop_back();
+    m_bodies.m_shape_poses.pop_back();
+    m_bodies.m_aabbs.pop_back();
+    m_bodies.m_shape_geometries.pop_back();
+    m_bodies.m_sleep_times.pop_back();
+    m_bodies.m_bullets.pop_back();
+    m_bodies.m_slots.pop_back();
+
+    slot.m_dense = BodyHandle::InvalidIndex;
+    slot.m_generation++;
+    m_free_slots.push_back(handle.m_index);
+}
+
+bool World::IsValid(BodyHandle handle) const {
+    return handle.m_index < m_slots.size() &&
+           m_slots[handle.m_index].m_generation == handle.m_generation &&
+           m_slots[handle.m_index].m_dense != BodyHandle::InvalidIndex;
+}
+
+size_t World::GetBodyCount() const {
+    return m_bodies.Size();
+}
+
+void World::Reserve(size_t count) {
+    m_bodies.m_positions.reserve(count);
+    m_bodies.m_rotations.reserve(count);
+    m_bodies.m_velocities.reserve(count);
+    m_bodies.m_angular_velocities.reserve(count);
+    m_bodies.m_inv_masses.reserve(count);
+    m_bodies.m_inv_inertias.reserve(count);
+    m_bodies.m_shapes.reserve(count);
+    m_bodies.m_shape_poses.reserve(count);
+    m_bodies.m_aabbs.reserve(count);
+    m_bodies.m_shape_geometries.reserve(count);
+    m_bodies.m_sleep_times.reserve(count);
+    m_bodies.m_bullets.reserve(count);
+    m_bodies.m_slots.reserve(count);
+    m_slots.reserve(count);
+}
+
+Body World::GetBody(BodyHandle handle) const {
+    Body body;
+    uint32_t dense = GetDenseIndex(handle);
+    if (dense == BodyHandle::InvalidIndex) {
+        return body;
+    }
+
+    body.m_pose.m_position = m_bodies.m_positions[dense];
+    body.m_pose.m_rotation = m_bodies.m_rotations[dense];
+    body.m_velocity = m_bodies.m_velocities[dense];
+    body.m_angular_velocity = m_bodies.m_angular_velocities[dense];
+    body.m_inv_mass = m_bodies.m_inv_masses[dense];
+    body.m_bullet = m_bodies.m_bullets[dense];
+    body.m_geometry = m_bodies.m_shapes[dense];
+    return body;
+}
+
+Pose World::GetPose(BodyHandle handle) const {
+    uint32_t dense = GetDenseIndex(handle);
+    if (dense == BodyHandle::InvalidIndex) {
+        return {};
+    }
+    return {m_bodies.m_positions[dense], m_bodies.m_rotations[dense]};
+}
+
+void World::SetPose(BodyHandle handle, const Pose& pose) {
+    uint32_t dense = getAwakeDenseIndex(handle);
+    if (dense == BodyHandle::InvalidIndex) {
+        return;
+    }
+
+    // static bodies never touch sleeping ones in the step, wake the
+    // neighbours at both ends of the move
+    bool wake_neighbours = m_bodies.m_inv_masses[dense] == 0 &&
+                           m_broadphase->Contains(handle.m_index);
+    if (wake_neighbours) {
+        wakeTouching(m_bodies.m_aabbs[dense]);
+        dense = m_slots[handle.m_index].m_dense;
+    }
+
+    m_bodies.m_positions[dense] = pose.m_position;
+    m_bodies.m_rotations[dense] = pose.m_rotation;
+    updateShape(dense);
+
+    // teleports reach the broadphase right away, so queries before the
+    // next step see them
+    if (m_broadphase->Contains(handle.m_index)) {
+        m_broadphase->Update(handle.m_index, m_bodies.m_aabbs[dense],
+                            Eigen::Vector3f::Zero());
+    }
+    if (wake_neighbours) {
+        wakeTouching(m_bodies.m_aabbs[dense]);
+    }
+}
+
+Eigen::Vector3f World::GetVelocity(BodyHandle handle) const {
+    uint32_t dense = GetDenseIndex(handle);
+    if (dense == BodyHandle::InvalidIndex) {
+        return Eigen::Vector3f::Zero();
+    }
+    return m_bodies.m_velocities[dense];
+}
+
+void World::SetVelocity(BodyHandle handle, const Eigen::Vector3f& velocity) {
+    uint32_t dense = getAwakeDenseIndex(handle);
+    if (dense == BodyHandle::InvalidIndex) {
+        return;
+    }
+    m_bodies.m_velocities[dense] = velocity;
+}
+
+Eigen::Vector3f World::GetAngularVelocity(BodyHandle handle) const {
+    uint32_t dense = GetDenseIndex(handle);
+    if (dense == BodyHandle::InvalidIndex) {
+        return Eigen::Vector3f::Zero();
+    }
+    return m_bodies.m_angular_velocities[dense];
+}
+
+void World::SetAngularVelocity(BodyHandle handle,
+                               const Eigen::Vector3f& velocity) {
+    uint32_t dense = getAwakeDenseIndex(handle);
+    if (dense == BodyHandle::InvalidIndex) {
+        return;
+    }
+    m_bodies.m_angular_velocities[dense] = velocity;
+}
+
+bool World::IsBullet(BodyHandle handle) const {
+    uint32_t dense = GetDenseIndex(handle);
+    return dense != BodyHandle::InvalidIndex && m_bodies.m_bullets[dense];
+}
+
+void World::SetBullet(BodyHandle handle, bool bullet) {
+    uint32_t dense = GetDenseIndex(handle);
+    if (dense == BodyHandle::InvalidIndex) {
+        return;
+    }
+    m_bodies.m_bullets[dense] = bullet;
+}
+
+bool World::IsSleeping(BodyHandle handle) const {
+    return IsValid(handle) && m_slots[handle.m_index].m_sleeping_island !=
+                                  BodyHandle::InvalidIndex;
+}
+
+void World::WakeUp(BodyHandle handle) {
+    getAwakeDenseIndex(handle);
+}
+
+uint32_t World::GetDenseIndex(BodyHandle handle) const {
+    if (!IsValid(handle)) {
+        LOGE("access invalid body handle {}", handle.m_index);
+        return BodyHandle::InvalidIndex;
+    }
+    return m_slots[handle.m_index].m_dense;
+}
+
+uint32_t World::getAwakeDenseIndex(BodyHandle handle) {
+    uint32_t dense = GetDenseIndex(handle);
+    if (dense == BodyHandle::InvalidIndex) {
+        return dense;
+    }
+    uint32_t island = m_slots[handle.m_index].m_sleeping_island;
+    if (island != BodyHandle::InvalidIndex) {
+        wakeIsland(island);
+        dense = m_slots[handle.m_index].m_dense;
+    }
+    return dense;
+}
+
+BodyHandle World::GetHandle(uint32_t dense_index) const {
+    if (dense_index >= m_bodies.Size()) {
+        return {};
+    }
+    uint32_t slot = m_bodies.m_slots[dense_index];
+    return {slot, m_slots[slot].m_generation};
+}
+
+const std::vector<BroadphasePair>& World::GetBroadphasePairs() const {
+    return m_broadphase->GetPairs();
+}
+
+template <typename T, typename CastFn>
+void World::castBatch(const T* queries, size_t count, QueryMode mode,
+                      const QueryHitBuffer& out, const CastFn& cast) const {
+    if (count == 0) {
+        return;
+    }
+    if (out.m_capacity == 0) {
+        LOGE("query hit buffer has no capacity");
+        return;
+    }
+
+    constexpr uint32_t packet_size = Broadphase::MaxCastPacket;
+    uint32_t packet_count =
+        static_cast<uint32_t>((count + packet_size - 1) / packet_size);
+    m_job_system->ParallelFor(packet_count, 1, [&](uint32_t begin,
+                                                   uint32_t end, uint32_t) {
+        std::array<AABBCast, packet_size> casts;
+        for (uint32_t packet = begin; packet < end; packet++) {
+            size_t first = size_t(packet) * packet_size;
+            uint32_t size =
+                static_cast<uint32_t>(std::min<size_t>(packet_size,
+                                                       count - first));
+            for (uint32_t i = 0; i < size; i++) {
+                casts[i] = MakeAABBCast(queries[first + i]);
+                out.m_counts[first + i] = 0;
+            }
+
+            auto visit = [&](uint32_t i, uint32_t slot) {
+                uint32_t dense = m_slots[slot].m_dense;
+                const Shape& shape = m_bodies.m_shapes[dense];
+                if (!shape.m_geom) {
+                    return;
+                }
+
+                // only hits closer than the current limit count
+                T query = queries[first + i];
+                float max_distance = query.m_max_distance;
+                query.m_max_distance *= casts[i].m_max_fraction;
+                CastHit hit;
+                if (!cast(query, m_geometries.Get(shape.m_geom),
+                          m_bodies.m_shape_poses[dense], hit)) {
+                    return;
+                }
+
+                QueryHit* hits = out.m_hits + (first + i) * out.m_capacity;
+                AddQueryHit(mode, {{slot, m_slots[slot].m_generation}, hit},
+                            hits, out.m_capacity, out.m_counts[first + i],
+                            query.m_max_distance);
+                if (query.m_max_distance < 0) {
+                    casts[i].m_max_fraction = -1;
+                } else if (max_distance > 0) {
+                    casts[i].m_max_fraction =
+                        query.m_max_distance / max_distance;
+                }
+            };
+            // a single captured reference keeps std::function off the heap
+            m_broadphase->CastQuery(
+                casts.data(), size,
+                [&visit](uint32_t i, uint32_t slot) { visit(i, slot); });
+        }
+    });
+}
+
+void World::RaycastBatch(const Ray* rays, size_t count, QueryMode mode,
+                         const QueryHitBuffer& out) const {
+    castBatch(rays, count, mode, out,
+              [](const Ray& ray, const Geometry& geom, const Pose& pose,
+                 CastHit& hit) { return Raycast(geom, pose, ray, hit); });
+}
+
+void World::SweepBatch(const ShapeCast* casts, size_t count, QueryMode mode,
+                       const QueryHitBuffer& out) const {
+    castBatch(casts, count, mode, out,
+              [](const ShapeCast& cast, const Geometry& geom,
+                 const Pose& pose,
+                 CastHit& hit) { return CastShape(cast, geom, pose, hit); });
+}
+
+void World::Step(float delta_time) {
+    PROFILE_SCOPE("World::Step");
+    double start = GetSeconds();
+    if (m_auto_rebase) {
+        rebaseToAwakeBodies();
+    }
+
+    m_step_delta_time = delta_time;
+    uint64_t allocations = GetTrackedAllocationCount();
+    {
+        AllocationScope scope;
+        m_job_system->Run(m_step_graph);
+    }
+    m_step_allocation_count = GetTrackedAllocationCount() - allocations;
+
+    // scratch bound to the arenas is rebound before its next use
+    for (auto& arena : m_arenas) {
+        arena->Reset();
+    }
+
+    double publish = GetSeconds();
+    if (m_publish_query_snapshots) {
+        publishQuerySnapshot();
+    }
+    m_step_timings.m_publish = GetSeconds() - publish;
+    m_step_timings.m_total = GetSeconds() - start;
+
+    PROFILE_COUNTER("awake bodies", m_bodies.m_awake_count);
+    PROFILE_COUNTER("manifolds", m_manifolds.size());
+    PROFILE_COUNTER("step allocations", m_step_allocation_count);
+
+    if (m_assert_no_step_allocations && m_step_allocation_count != 0) {
+        LOGE("step made {} heap allocations", m_step_allocation_count);
+        assert(m_step_allocation_count == 0);
+    }
+}
+
+// the section has to hold exactly count records of T
+template <typename T>
+static bool HasRecords(const WorldSnapshotView& snapshot,
+                       WorldSnapshotSection section, size_t count) {
+    return snapshot.GetBytes(section).size() == count * sizeof(T);
+}
+
+// indices in a manifold read from a file, count is the body count
+static bool IsValidManifold(const ContactManifold& manifold, size_t count) {
+    return manifold.m_body_a < count && manifold.m_body_b < count &&
+           manifold.m_point_count <= ContactManifold::MaxPoints;
+}
+
+static bool AllBelow(std::span<const uint32_t> values, size_t limit) {
+    return std::all_of(values.begin(), values.end(),
+                       [limit](uint32_t value) { return value < limit; });
+}
+
+template <typename T>
+static void CopyRecords(const WorldSnapshotView& snapshot,
+                        WorldSnapshotSection section, std::vector<T>& out) {
+    std::span<const T> records = snapshot.Get<T>(section);
+    out.assign(records.begin(), records.end());
+}
+
+void World::SaveSnapshot(std::vector<std::byte>& out) const {
+    using Section = WorldSnapshotSection;
+    WorldSnapshotWriter writer{out};
+    WorldSnapshotHeader& header = writer.GetHeader();
+    header.m_broadphase = static_cast<uint32_t>(m_broadphase->GetType());
+    header.m_awake_count = m_bodies.m_awake_count;
+    header.m_contact_step = m_narrowphase.GetContactCache().GetStep();
+    header.m_origin = {m_origin.x(), m_origin.y(), m_origin.z()};
+
+    writer.Write(Section::Positions, m_bodies.m_positions);
+    writer.Write(Section::Rotations, m_bodies.m_rotations);
+    writer.Write(Section::Velocities, m_bodies.m_velocities);
+    writer.Write(Section::AngularVelocities, m_bodies.m_angular_velocities);
+    writer.Write(Section::InvMasses, m_bodies.m_inv_masses);
+    writer.Write(Section::InvInertias, m_bodies.m_inv_inertias);
+    writer.Write(Section::Shapes, m_bodies.m_shapes);
+    writer.Write(Section::ShapePoses, m_bodies.m_shape_poses);
+    writer.Write(Section::AABBs, m_bodies.m_aabbs);
+    writer.Write(Section::SleepTimes, m_bodies.m_sleep_times);
+    writer.Write(Section::Bullets, m_bodies.m_bullets);
+    writer.Write(Section::BodySlots, m_bodies.m_slots);
+
+    writer.Write(Section::Slots, m_slots);
+    writer.Write(Section::FreeSlots, m_free_slots);
+    std::vector<uint32_t> island_offsets{0};
+    std::vector<uint32_t> island_slots;
+    for (const auto& island : m_sleeping_islands) {
+        island_slots.insert(island_slots.end(), island.begin(), island.end());
+        island_offsets.push_back(static_cast<uint32_t>(island_slots.size()));
+    }
+    writer.Write(Section::IslandOffsets, island_offsets);
+    writer.Write(Section::IslandSlots, island_slots);
+    writer.Write(Section::FreeIslands, m_free_sleeping_islands);
+    writer.Write(Section::MovedSlots, m_moved_slots);
+
+    writer.Write(Section::Boxes, m_geometries.GetRecords<BoxGeometry>());
+    writer.Write(Section::Spheres, m_geometries.GetRecords<SphereGeometry>());
+    writer.Write(Section::Capsules,
+                 m_geometries.GetRecords<CapsuleGeometry>());
+
+    std::vector<ContactCacheRecord> contacts;
+    m_narrowphase.GetContactCache().Save(contacts);
+    writer.Write(Section::ContactCache, contacts);
+    writer.Write(Section::Manifolds, m_manifolds);
+    std::vector<std::byte> broadphase;
+    if (m_broadphase->SaveState(broadphase)) {
+        writer.Write(Section::Broadphase, broadphase);
+    }
+    writer.Finish();
+}
+
+bool World::SaveSnapshot(const std::string& path) const {
+    std::vector<std::byte> data;
+    SaveSnapshot(data);
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()),
+               static_cast<std::streamsize>(data.size()));
+    if (!file) {
+        LOGE("can't write world snapshot {}", path);
+        return false;
+    }
+    return true;
+}
+
+bool World::LoadSnapshot(const WorldSnapshotView& snapshot) {
+    using Section = WorldSnapshotSection;
+    if (!snapshot.IsValid()) {
+        LOGE("load invalid world snapshot");
+        return false;
+    }
+
+    const WorldSnapshotHeader& header = snapshot.GetHeader();
+    size_t count = snapshot.Get<Eigen::Vector3f>(Section::Positions).size();
+    size_t slot_count = snapshot.Get<Slot>(Section::Slots).size();
+    std::span<const uint32_t> island_offsets =
+        snapshot.Get<uint32_t>(Section::IslandOffsets);
+    if (!HasRecords<Eigen::Quaternionf>(snapshot, Section::Rotations,
+                                        count) ||
+        !HasRecords<Eigen::Vector3f>(snapshot, Section::Velocities, count) ||
+        !HasRecords<Eigen::Vector3f>(snapshot, Section::AngularVelocities,
+                                     count) ||
+        !HasRecords<float>(snapshot, Section::InvMasses, count) ||
+        !HasRecords<Eigen::Matrix3f>(snapshot, Section::InvInertias,
+                                     count) ||
+        !HasRecords<Shape>(snapshot, Section::Shapes, count) ||
+        !HasRecords<Pose>(snapshot, Section::ShapePoses, count) ||
+        !HasRecords<AABB>(snapshot, Section::AABBs, count) ||
+        !HasRecords<float>(snapshot, Section::SleepTimes, count) ||
+        !HasRecords<uint8_t>(snapshot, Section::Bullets, count) ||
+        !HasRecords<uint32_t>(snapshot, Section::BodySlots, count) ||
+        !HasRecords<uint64_t>(snapshot, Section::MovedSlots,
+                              (slot_count + 63) / 64) ||
+        header.m_awake_count > count || island_offsets.empty() ||
+        island_offsets.back() !=
+            snapshot.Get<uint32_t>(Section::IslandSlots).size()) {
+        LOGE("world snapshot sections don't match");
+        return false;
+    }
+    // handles are resolved through the slots, they must point at each
+    // other
+    std::span<const uint32_t> body_slots =
+        snapshot.Get<uint32_t>(Section::BodySlots);
+    std::span<const Slot> slots = snapshot.Get<Slot>(Section::Slots);
+    for (size_t i = 0; i < count; i++) {
+        if (body_slots[i] >= slot_count || slots[body_slots[i]].m_dense != i) {
+            LOGE("world snapshot slots are corrupt");
+            return false;
+        }
+    }
+
+    // every other index read from the file is checked before it is used
+    size_t island_count = island_offsets.size() - 1;
+    std::span<const uint32_t> island_slots =
+        snapshot.Get<uint32_t>(Section::IslandSlots);
+    std::span<const uint32_t> free_slots =
+        snapshot.Get<uint32_t>(Section::FreeSlots);
+    std::span<const uint32_t> free_islands =
+        snapshot.Get<uint32_t>(Section::FreeIslands);
+    bool valid =
+        std::is_sorted(island_offsets.begin(), island_offsets.end()) &&
+        AllBelow(island_slots, slot_count) &&
+        AllBelow(free_slots, slot_count) &&
+        AllBelow(free_islands, island_count);
+    // CreateBody() reuses free slots, they hold no body and are listed once
+    std::vector<uint8_t> free_slot_seen(valid ? slot_count : 0, 0);
+    for (uint32_t slot : free_slots) {
+        valid = valid && !free_slot_seen[slot] &&
+                slots[slot].m_dense == BodyHandle::InvalidIndex;
+        if (valid) {
+            free_slot_seen[slot] = 1;
+        }
+    }
+    // wakeIsland() moves every listed body to the end of the awake range,
+    // so each sleeping body is listed once, by the island its slot names,
+    // and sits after that range
+    std::vector<uint8_t> listed(valid ? slot_count : 0, 0);
+    for (size_t island = 0; valid && island < island_count; island++) {
+        for (uint32_t i = island_offsets[island];
+             valid && i < island_offsets[island + 1]; i++) {
+            const Slot& slot = slots[island_slots[i]];
+            valid = !listed[island_slots[i]] &&
+                    slot.m_dense != BodyHandle::InvalidIndex &&
+                    slot.m_dense >= header.m_awake_count &&
+                    slot.m_sleeping_island == island;
+            listed[island_slots[i]] = 1;
+        }
+    }
+    // free islands are reused by the next island put to sleep, they are
+    // empty and listed once
+    std::vector<uint8_t> free_island_seen(valid ? island_count : 0, 0);
+    for (uint32_t island : free_islands) {
+        valid = valid && !free_island_seen[island] &&
+                island_offsets[island] == island_offsets[island + 1];
+        if (valid) {
+            free_island_seen[island] = 1;
+        }
+    }
+    for (size_t i = 0; valid && i < slot_count; i++) {
+        const Slot& slot = slots[i];
+        valid = (slot.m_dense == BodyHandle::InvalidIndex ||
+                 (slot.m_dense < count && body_slots[slot.m_dense] == i)) &&
+                (slot.m_sleeping_island == BodyHandle::InvalidIndex ||
+                 (slot.m_sleeping_island < island_count && listed[i]));
+    }
+    for (const ContactManifold& manifold :
+         snapshot.Get<ContactManifold>(Section::Manifolds)) {
+        valid = valid && IsValidManifold(manifold, count);
+    }
+    // cache keys are slot pairs, the cached manifolds only keep impulses
+    for (const ContactCacheRecord& record :
+         snapshot.Get<ContactCacheRecord>(Section::ContactCache)) {
+        const ContactCacheEntry& entry = record.m_entry;
+        valid = valid && (record.m_key >> 32) < slot_count &&
+                (record.m_key & UINT32_MAX) < slot_count &&
+                entry.m_simplex.m_count <= entry.m_simplex.m_index_a.size() &&
+                entry.m_manifold.m_point_count <= ContactManifold::MaxPoints;
+    }
+    if (!valid) {
+        LOGE("world snapshot indices are out of range");
+        return false;
+    }
+
+    GeometryPool geometries;
+    for (const BoxGeometry& box : snapshot.Get<BoxGeometry>(Section::Boxes)) {
+        geometries.Add(box);
+    }
+    for (const SphereGeometry& sphere :
+         snapshot.Get<SphereGeometry>(Section::Spheres)) {
+        geometries.Add(sphere);
+    }
+    for (const CapsuleGeometry& capsule :
+         snapshot.Get<CapsuleGeometry>(Section::Capsules)) {
+        geometries.Add(capsule);
+    }
+    // records were interned when saved, so each one keeps its index
+    for (const Shape& shape : snapshot.Get<Shape>(Section::Shapes)) {
+        if (shape.m_geom && !geometries.IsValid(shape.m_geom)) {
+            LOGE("world snapshot references a missing geometry");
+            return false;
+        }
+    }
+    m_geometries = std::move(geometries);
+
+    CopyRecords(snapshot, Section::Positions, m_bodies.m_positions);
+    CopyRecords(snapshot, Section::Rotations, m_bodies.m_rotations);
+    CopyRecords(snapshot, Section::Velocities, m_bodies.m_velocities);
+    CopyRecords(snapshot, Section::AngularVelocities,
+                m_bodies.m_angular_velocities);
+    CopyRecords(snapshot, Section::InvMasses, m_bodies.m_inv_masses);
+    CopyRecords(snapshot, Section::InvInertias, m_bodies.m_inv_inertias);
+    CopyRecords(snapshot, Section::Shapes, m_bodies.m_shapes);
+    CopyRecords(snapshot, Section::ShapePoses, m_bodies.m_shape_poses);
+    CopyRecords(snapshot, Section::AABBs, m_bodies.m_aabbs);
+    CopyRecords(snapshot, Section::SleepTimes, m_bodies.m_sleep_times);
+    CopyRecords(snapshot, Section::Bullets, m_bodies.m_bullets);
+    CopyRecords(snapshot, Section::BodySlots, m_bodies.m_slots);
+    m_bodies.m_shape_geometries.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        m_bodies.m_shape_geometries[i] = m_bodies.m_shapes[i].m_geom;
+    }
+    m_bodies.m_awake_count = header.m_awake_count;
+
+    CopyRecords(snapshot, Section::Slots, m_slots);
+    CopyRecords(snapshot, Section::FreeSlots, m_free_slots);
+    m_sleeping_islands.resize(island_offsets.size() - 1);
+    for (size_t i = 0; i + 1 < island_offsets.size(); i++) {
+        m_sleeping_islands[i].assign(
+            island_slots.begin() + island_offsets[i],
+            island_slots.begin() + island_offsets[i + 1]);
+    }
+    CopyRecords(snapshot, Section::FreeIslands, m_free_sleeping_islands);
+    CopyRecords(snapshot, Section::MovedSlots, m_moved_slots);
+    m_origin = {header.m_origin[0], header.m_origin[1], header.m_origin[2]};
+
+    std::span<const ContactCacheRecord> contacts =
+        snapshot.Get<ContactCacheRecord>(Section::ContactCache);
+    ContactCache& contact_cache = m_narrowphase.GetContactCache();
+    contact_cache.Load(contacts.data(), contacts.size(),
+                       header.m_contact_step);
+    for (size_t i = m_bodies.m_awake_count; i < count; i++) {
+        contact_cache.SetResting(m_bodies.m_slots[i], true);
+    }
+    CopyRecords(snapshot, Section::Manifolds, m_manifolds);
+
+    Broadphase::Type type = m_broadphase->GetType();
+    m_broadphase = CreateBroadphase(type, m_job_system.get());
+    std::span<const std::byte> broadphase =
+        snapshot.GetBytes(Section::Broadphase);
+    if (header.m_broadphase != static_cast<uint32_t>(type) ||
+        broadphase.empty() || !m_broadphase->LoadState(broadphase) ||
+        !hasBodyProxies()) {
+        m_broadphase = CreateBroadphase(type, m_job_system.get());
+        for (uint32_t i = 0; i < count; i++) {
+            if (m_bodies.m_shapes[i].m_geom) {
+                m_broadphase->Add(m_bodies.m_slots[i], m_bodies.m_aabbs[i]);
+                m_broadphase->SetResting(m_bodies.m_slots[i],
+                                         i >= m_bodies.m_awake_count);
+            }
+        }
+        m_broadphase->UpdatePairs();
+    }
+    return true;
+}
+
+// a loaded broadphase state has to hold exactly the bodies with geometry,
+// its ids are used as slots
+bool World::hasBodyProxies() const {
+    size_t proxy_count = 0;
+    for (uint32_t i = 0; i < m_bodies.Size(); i++) {
+        if (m_bodies.m_shapes[i].m_geom) {
+            if (!m_broadphase->Contains(m_bodies.m_slots[i])) {
+                return false;
+            }
+            proxy_count++;
+        }
+    }
+
+    float inf = std::numeric_limits<float>::infinity();
+    AABB everything{Eigen::Vector3f::Constant(-inf),
+                    Eigen::Vector3f::Constant(inf)};
+    size_t found = 0;
+    bool valid = true;
+    m_broadphase->Query(everything, [&](uint32_t slot) {
+        valid = slot < m_slots.size() &&
+                m_slots[slot].m_dense != BodyHandle::InvalidIndex &&
+                m_bodies.m_shapes[m_slots[slot].m_dense].m_geom;
+        found++;
+        return valid;
+    });
+    return valid && found <= proxy_count;
+}
+
+bool World::LoadSnapshot(const std::string& path) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+    return LoadSnapshot(WorldSnapshotView{file.GetData()});
+}
+
+void World::SetOrigin(const Eigen::Vector3d& origin) {
+    PROFILE_SCOPE("World::SetOrigin");
+    Eigen::Vector3d anchor = origin;
+    if (m_region_size > 0) {
+        anchor = (origin / m_region_size).array().round() * m_region_size;
+    }
+    if (anchor == m_origin) {
+        return;
+    }
+
+    // anchors are whole regions apart, so the offset is exact in float
+    Eigen::Vector3f offset = (m_origin - anchor).cast<float>();
+    m_origin = anchor;
+    for (size_t i = 0; i < m_bodies.Size(); i++) {
+        m_bodies.m_positions[i] += offset;
+        m_bodies.m_shape_poses[i].m_position += offset;
+        m_bodies.m_aabbs[i] = m_bodies.m_aabbs[i].Translate(offset);
+    }
+    m_broadphase->ShiftOrigin(offset);
+    m_narrowphase.GetContactCache().ShiftOrigin(offset);
+    for (ContactManifold& manifold : m_manifolds) {
+        for (uint32_t i = 0; i < manifold.m_point_count; i++) {
+            manifold.m_points[i].m_position += offset;
+        }
+    }
+}
+
+void World::rebaseToAwakeBodies() {
+    size_t count = m_bodies.m_awake_count;
+    if (count == 0 || m_region_size <= 0) {
+        return;
+    }
+
+    Eigen::Vector3f min = m_bodies.m_positions[0];
+    Eigen::Vector3f max = min;
+    for (size_t i = 1; i < count; i++) {
+        min = min.cwiseMin(m_bodies.m_positions[i]);
+        max = max.cwiseMax(m_bodies.m_positions[i]);
+    }
+    Eigen::Vector3f center = (min + max) * 0.5f;
+    if (center.cwiseAbs().maxCoeff() > m_region_size) {
+        SetOrigin(ToWorld(center));
+    }
+}
+
+void World::buildStepGraph() {
+    for (uint32_t i = 0; i < m_job_system->GetWorkerCount(); i++) {
+        m_arenas.push_back(std::make_unique<FrameArena>());
+    }
+
+    // contacts are found at the start poses, with speculative points
+    // covering the motion of this step. The narrowphase never reads
+    // velocities, so gravity is applied next to it
+    uint32_t broadphase = m_step_graph.AddTask([this](uint32_t) {
+        Timed(m_step_timings.m_broadphase,
+              [&] { updateBroadphase(m_step_delta_time); });
+    });
+    uint32_t contacts = m_step_graph.AddTask([this](uint32_t worker) {
+        Timed(m_step_timings.m_narrowphase,
+              [&] { updateContacts(*m_arenas[worker]); });
+    });
+    uint32_t velocities = m_step_graph.AddTask([this](uint32_t) {
+        Timed(m_step_timings.m_integrate_velocities,
+              [&] { integrateVelocities(m_step_delta_time); });
+    });
+    // islands come from this step's manifolds, so they can't be built
+    // before contacts are done. The solver's union-find over the manifolds
+    // is a short serial pass and its islands are what it parallelizes over,
+    // a node of its own would only add a sync point. Sleep reuses them
+    uint32_t solve = m_step_graph.AddTask([this](uint32_t) {
+        Timed(m_step_timings.m_solve,
+              [&] { solveContacts(m_step_delta_time); });
+    });
+    uint32_t impacts = m_step_graph.AddTask([this](uint32_t worker) {
+        Timed(m_step_timings.m_ccd,
+              [&] { findImpacts(m_step_delta_time, *m_arenas[worker]); });
+    });
+    uint32_t positions = m_step_graph.AddTask([this](uint32_t) {
+        Timed(m_step_timings.m_integrate_positions, [&] {
+            integratePositions(m_step_delta_time);
+            rewindToImpacts();
+        });
+    });
+    uint32_t sleep = m_step_graph.AddTask([this](uint32_t worker) {
+        Timed(m_step_timings.m_sleep,
+              [&] { updateSleep(m_step_delta_time, *m_arenas[worker]); });
+    });
+
+    m_step_graph.AddDependency(broadphase, contacts);
+    // broadphase predicts motion from the velocities
+    m_step_graph.AddDependency(broadphase, velocities);
+    m_step_graph.AddDependency(contacts, solve);
+    m_step_graph.AddDependency(velocities, solve);
+    // sweeps start at the step's start poses with the solved velocities
+    m_step_graph.AddDependency(solve, impacts);
+    m_step_graph.AddDependency(impacts, positions);
+    m_step_graph.AddDependency(positions, sleep);
+}
+
+void World::integrateVelocities(float delta_time) {
+    PROFILE_SCOPE("World::integrateVelocities");
+    // only awake bodies, which are all dynamic
+    uint32_t count = static_cast<uint32_t>(m_bodies.m_awake_count);
+    Eigen::Vector3f* velocities = m_bodies.m_velocities.data();
+
+    Eigen::Vector3f gravity_delta = m_gravity * delta_time;
+    m_job_system->ParallelFor(
+        count, 1024, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t i = begin; i < end; i++) {
+                velocities[i] += gravity_delta;
+            }
+        });
+}
+
+void World::integratePositions(float delta_time) {
+    PROFILE_SCOPE("World::integratePositions");
+    uint32_t count = static_cast<uint32_t>(m_bodies.m_awake_count);
+    const Eigen::Vector3f* velocities = m_bodies.m_velocities.data();
+    const Eigen::Vector3f* angular_velocities =
+        m_bodies.m_angular_velocities.data();
+    Eigen::Vector3f* positions = m_bodies.m_positions.data();
+    Eigen::Quaternionf* rotations = m_bodies.m_rotations.data();
+
+    float half_dt = delta_time * 0.5f;
+    m_job_system->ParallelFor(
+        count, 1024, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t i = begin; i < end; i++) {
+                positions[i] += velocities[i] * delta_time;
+            }
+            for (uint32_t i = begin; i < end; i++) {
+                const Eigen::Vector3f& w = angular_velocities[i];
+                if (w == Eigen::Vector3f::Zero()) {
+                    continue;
+                }
+                Eigen::Quaternionf& q = rotations[i];
+                Eigen::Quaternionf dq =
+                    Eigen::Quaternionf{0, w.x(), w.y(), w.z()} * q;
+                q.coeffs() += dq.coeffs() * half_dt;
+                q.normalize();
+            }
+            // bodies at rest keep their cached shape
+            for (uint32_t i = begin; i < end; i++) {
+                if (velocities[i] != Eigen::Vector3f::Zero() ||
+                    angular_velocities[i] != Eigen::Vector3f::Zero()) {
+                    updateShape(i);
+                    markMoved(m_bodies.m_slots[i]);
+                }
+            }
+        });
+}
+
+void World::updateBroadphase(float delta_time) {
+    PROFILE_SCOPE("World::updateBroadphase");
+    // only bodies the integrator moved, sleeping and static ones cost
+    // nothing
+    for (size_t word = 0; word < m_moved_slots.size(); word++) {
+        for (uint64_t bits = m_moved_slots[word]; bits != 0;
+             bits &= bits - 1) {
+            uint32_t slot =
+                static_cast<uint32_t>(word * 64 + std::countr_zero(bits));
+            if (!m_broadphase->Contains(slot)) {
+                continue;
+            }
+            uint32_t dense = m_slots[slot].m_dense;
+            m_broadphase->Update(slot, m_bodies.m_aabbs[dense],
+                                m_bodies.m_velocities[dense] * delta_time);
+        }
+        m_moved_slots[word] = 0;
+    }
+    m_broadphase->UpdatePairs();
+}
+
+void World::updateContacts(FrameArena& arena) {
+    PROFILE_SCOPE("World::updateContacts");
+    // broadphase reports slots, the narrowphase works on dense indices.
+    // Static and sleeping bodies rest in the broadphase, so every pair has
+    // an awake body
+    BindToArena(m_narrowphase_pairs, arena);
+    m_narrowphase_pairs.reserve(m_broadphase->GetPairs().size());
+    for (const BroadphasePair& pair : m_broadphase->GetPairs()) {
+        m_narrowphase_pairs.push_back(
+            {m_slots[pair.m_a].m_dense, m_slots[pair.m_b].m_dense});
+    }
+
+    NarrowphaseContext context;
+    context.m_poses = m_bodies.m_shape_poses.data();
+    context.m_geometries = m_bodies.m_shape_geometries.data();
+    context.m_pool = &m_geometries;
+    context.m_ids = m_bodies.m_slots.data();
+    context.m_margin = m_contact_margin;
+
+    m_manifolds.clear();
+    m_narrowphase.Collide(context, m_narrowphase_pairs.data(),
+                          m_narrowphase_pairs.size(), m_manifolds,
+                          *m_job_system);
+}
+
+void World::solveContacts(float delta_time) {
+    PROFILE_SCOPE("World::solveContacts");
+    SolverBodies bodies;
+    bodies.m_positions = m_bodies.m_positions.data();
+    bodies.m_rotations = m_bodies.m_rotations.data();
+    bodies.m_velocities = m_bodies.m_velocities.data();
+    bodies.m_angular_velocities = m_bodies.m_angular_velocities.data();
+    bodies.m_inv_masses = m_bodies.m_inv_masses.data();
+    bodies.m_inv_inertias = m_bodies.m_inv_inertias.data();
+    bodies.m_count = static_cast<uint32_t>(m_bodies.m_awake_count);
+
+    m_solver.Solve(bodies, m_manifolds, delta_time, *m_job_system);
+    m_narrowphase.StoreImpulses(m_bodies.m_slots.data(), m_manifolds);
+}
+
+// thinnest extent of the shape, what it may move per step before it can
+// skip over something as thin as itself
+static float ComputeMinExtent(const Geometry& geom) {
+    switch (geom.GetType()) {
+        case Geometry::Type::Box:
+            return static_cast<const BoxGeometry&>(geom).m_half_size.minCoeff();
+        case Geometry::Type::Sphere:
+            return static_cast<const SphereGeometry&>(geom).m_radius;
+        case Geometry::Type::Capsule:
+            return static_cast<const CapsuleGeometry&>(geom).m_radius;
+    }
+    return 0;
+}
+
+void World::findImpacts(float delta_time, FrameArena& arena) {
+    PROFILE_SCOPE("World::findImpacts");
+    BindToArena(m_ccd_bodies, arena);
+    BindToArena(m_impacts, arena);
+    if (!m_enable_ccd) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < m_bodies.m_awake_count; i++) {
+        const Shape& shape = m_bodies.m_shapes[i];
+        if (!shape.m_geom) {
+            continue;
+        }
+        float motion = m_bodies.m_velocities[i].norm() * delta_time;
+        float extent = ComputeMinExtent(m_geometries.Get(shape.m_geom));
+        if (m_bodies.m_bullets[i] ||
+            motion > m_ccd_motion_threshold * extent) {
+            m_ccd_bodies.push_back(i);
+        }
+    }
+
+    m_impacts.resize(m_ccd_bodies.size());
+    m_job_system->ParallelFor(
+        static_cast<uint32_t>(m_ccd_bodies.size()), 4,
+        [&](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t i = begin; i < end; i++) {
+                m_impacts[i] = sweepBody(m_ccd_bodies[i], delta_time);
+            }
+        });
+}
+
+World::Impact World::sweepBody(uint32_t dense, float delta_time) const {
+    const Geometry& geom = m_geometries.Get(m_bodies.m_shapes[dense].m_geom);
+    Sweep sweep = makeSweep(dense, delta_time);
+
+    // endpoints plus how far spinning may bulge the shape in between
+    float spin = sweep.m_angular.norm() *
+                 ComputeSweepRadius(geom, sweep.m_local);
+    AABB bounds = m_bodies.m_aabbs[dense]
+                      .Union(ComputeAABB(geom, sweep.GetShapePose(1)))
+                      .Expand(spin);
+
+    // stopping inside the contact margin leaves the rest to a speculative
+    // contact in the next step
+    ToiSettings settings;
+    settings.m_target_separation = m_contact_margin * 0.5f;
+    settings.m_tolerance = m_contact_margin * 0.25f;
+
+    Impact impact;
+    impact.m_body = dense;
+    auto visit = [&](uint32_t slot) {
+        uint32_t other = m_slots[slot].m_dense;
+        if (other == dense) {
+            return true;
+        }
+        const Shape& other_shape = m_bodies.m_shapes[other];
+        // sleeping bodies count as static for this step
+        Sweep other_sweep = other < m_bodies.m_awake_count
+                                ? makeSweep(other, delta_time)
+                                : makeSweep(other, 0);
+        const Geometry& other_geom = m_geometries.Get(other_shape.m_geom);
+        ToiOutput output =
+            TimeOfImpact(geom, sweep, other_geom, other_sweep, settings);
+        // already inside the target, e.g. stopped there last step. Resting
+        // contacts are left to the solver, anything further away may close
+        // half of the gap, so spinning shapes can't swing through
+        if (output.m_state == ToiOutput::State::Touching &&
+            output.m_separation > settings.m_tolerance) {
+            ToiSettings closer = settings;
+            closer.m_target_separation = output.m_separation * 0.5f;
+            closer.m_tolerance = closer.m_target_separation * 0.5f;
+            output =
+                TimeOfImpact(geom, sweep, other_geom, other_sweep, closer);
+        }
+        if (output.m_state == ToiOutput::State::Hit &&
+            output.m_t < impact.m_t) {
+            impact.m_t = output.m_t;
+        }
+        return true;
+    };
+    // a single captured reference keeps std::function off the heap
+    m_broadphase->Query(bounds,
+                        [&visit](uint32_t slot) { return visit(slot); });
+
+    if (impact.m_t < 1) {
+        impact.m_pose = sweep.GetBodyPose(impact.m_t);
+    }
+    return impact;
+}
+
+Sweep World::makeSweep(uint32_t dense, float delta_time) const {
+    Sweep sweep;
+    sweep.m_body = {m_bodies.m_positions[dense], m_bodies.m_rotations[dense]};
+    sweep.m_local = m_bodies.m_shapes[dense].m_local_pose;
+    sweep.m_linear = m_bodies.m_velocities[dense] * delta_time;
+    sweep.m_angular = m_bodies.m_angular_velocities[dense] * delta_time;
+    return sweep;
+}
+
+void World::rewindToImpacts() {
+    PROFILE_SCOPE("World::rewindToImpacts");
+    // velocities are kept, the next step's contacts take them out
+    for (const Impact& impact : m_impacts) {
+        if (impact.m_t < 1) {
+            m_bodies.m_positions[impact.m_body] = impact.m_pose.m_position;
+            m_bodies.m_rotations[impact.m_body] = impact.m_pose.m_rotation;
+            updateShape(impact.m_body);
+        }
+    }
+}
+
+void World::publishQuerySnapshot() {
+    PROFILE_SCOPE("World::publishQuerySnapshot");
+    QuerySnapshot& snapshot = m_query_snapshots.BeginWrite();
+    snapshot.BeginUpdate(m_geometries, m_slots.size(), m_origin);
+    for (uint32_t i = 0; i < m_bodies.Size(); i++) {
+        uint32_t slot = m_bodies.m_slots[i];
+        snapshot.SetBody(slot, m_slots[slot].m_generation,
+                         {m_bodies.m_positions[i], m_bodies.m_rotations[i]},
+                         m_bodies.m_shape_poses[i],
+                         m_bodies.m_shape_geometries[i], m_bodies.m_aabbs[i]);
+    }
+    snapshot.EndUpdate();
+    m_query_snapshots.Publish(snapshot);
+}
+
+void World::updateSleep(float delta_time, FrameArena& arena) {
+    PROFILE_SCOPE("World::updateSleep");
+    size_t awake_count = m_bodies.m_awake_count;
+    float linear2 = m_sleep_linear_velocity * m_sleep_linear_velocity;
+    float angular2 = m_sleep_angular_velocity * m_sleep_angular_velocity;
+    for (size_t i = 0; i < awake_count; i++) {
+        if (m_bodies.m_velocities[i].squaredNorm() > linear2 ||
+            m_bodies.m_angular_velocities[i].squaredNorm() > angular2) {
+            m_bodies.m_sleep_times[i] = 0;
+        } else {
+            m_bodies.m_sleep_times[i] += delta_time;
+        }
+    }
+
+    // sleeping bodies were treated as static this step. Touching one wakes
+    // its island for the next step and keeps the toucher awake
+    BindToArena(m_wake_requests, arena);
+    for (const ContactManifold& manifold : m_manifolds) {
+        uint32_t a = manifold.m_body_a;
+        uint32_t b = manifold.m_body_b;
+        uint32_t sleeping = a < awake_count ? b : a;
+        uint32_t island = m_slots[m_bodies.m_slots[sleeping]].m_sleeping_island;
+        if (island != BodyHandle::InvalidIndex) {
+            m_wake_requests.push_back(island);
+            m_bodies.m_sleep_times[a < awake_count ? a : b] = 0;
+        }
+    }
+
+    // islands come from the solver, every body of an island has to be ready
+    size_t sleep_count = 0;
+    BindToArena(m_island_sleep_times, arena);
+    BindToArena(m_island_sleep_ids, arena);
+    if (m_allow_sleeping) {
+        m_island_sleep_times.assign(awake_count,
+                                    std::numeric_limits<float>::max());
+        for (uint32_t i = 0; i < awake_count; i++) {
+            float& time = m_island_sleep_times[m_solver.FindIslandRoot(i)];
+            time = std::min(time, m_bodies.m_sleep_times[i]);
+        }
+        for (uint32_t i = 0; i < awake_count; i++) {
+            if (m_island_sleep_times[m_solver.FindIslandRoot(i)] >=
+                m_time_to_sleep) {
+                sleep_count++;
+            }
+        }
+    }
+    if (m_wake_requests.empty() && sleep_count == 0) {
+        return;
+    }
+
+    // islands are put to sleep by slot, moving bodies changes dense indices
+    m_island_sleep_ids.assign(awake_count, BodyHandle::InvalidIndex);
+    for (uint32_t i = 0; sleep_count > 0 && i < awake_count; i++) {
+        uint32_t root = m_solver.FindIslandRoot(i);
+        if (m_island_sleep_times[root] < m_time_to_sleep) {
+            continue;
+        }
+        uint32_t& island = m_island_sleep_ids[root];
+        if (island == BodyHandle::InvalidIndex) {
+            if (m_free_sleeping_islands.empty()) {
+                island = static_cast<uint32_t>(m_sleeping_islands.size());
+                m_sleeping_islands.emplace_back();
+            } else {
+                island = m_free_sleeping_islands.back();
+                m_free_sleeping_islands.pop_back();
+            }
+        }
+        m_sleeping_islands[island].push_back(m_bodies.m_slots[i]);
+    }
+
+    manifoldsToSlots();
+    for (uint32_t island : m_wake_requests) {
+        wakeIsland(island);
+    }
+    for (uint32_t i = 0; i < awake_count; i++) {
+        uint32_t island = m_island_sleep_ids[i];
+        if (island == BodyHandle::InvalidIndex) {
+            continue;
+        }
+        for (uint32_t slot : m_sleeping_islands[island]) {
+            m_slots[slot].m_sleeping_island = island;
+            setResting(slot, true);
+            m_bodies.m_awake_count--;
+            uint32_t dense = static_cast<uint32_t>(m_bodies.m_awake_count);
+            swapBodies(m_slots[slot].m_dense, dense);
+            m_bodies.m_velocities[dense].setZero();
+            m_bodies.m_angular_velocities[dense].setZero();
+        }
+    }
+    manifoldsToDense();
+}
+
+void World::wakeIsland(uint32_t island) {
+    std::vector<uint32_t>& slots = m_sleeping_islands[island];
+    for (uint32_t slot : slots) {
+        m_slots[slot].m_sleeping_island = BodyHandle::InvalidIndex;
+        setResting(slot, false);
+        uint32_t dense = static_cast<uint32_t>(m_bodies.m_awake_count);
+        swapBodies(m_slots[slot].m_dense, dense);
+        m_bodies.m_sleep_times[dense] = 0;
+        m_bodies.m_awake_count++;
+    }
+    // an island can be requested twice in one step
+    if (!slots.empty()) {
+        slots.clear();
+        m_free_sleeping_islands.push_back(island);
+    }
+}
+
+// sleeping and static bodies rest in the broadphase and keep their cached
+// contacts
+void World::setResting(uint32_t slot, bool resting) {
+    m_broadphase->SetResting(slot, resting);
+    m_narrowphase.GetContactCache().SetResting(slot, resting);
+}
+
+// waking swaps body columns and changes resting proxies, so the islands are
+// only collected during the query. The bounds are copied since they often
+// come from the body columns themselves
+void World::wakeTouching(AABB aabb) {
+    std::vector<uint32_t> islands;
+    m_broadphase->Query(aabb, [this, &islands](uint32_t slot) {
+        uint32_t island = m_slots[slot].m_sleeping_island;
+        if (island != BodyHandle::InvalidIndex) {
+            islands.push_back(island);
+        }
+        return true;
+    });
+    for (uint32_t island : islands) {
+        wakeIsland(island);
+    }
+}
+
+void World::swapBodies(uint32_t a, uint32_t b) {
+    if (a == b) {
+        return;
+    }
+    std::swap(m_bodies.m_positions[a], m_bodies.m_positions[b]);
+    std::swap(m_bodies.m_rotations[a], m_bodies.m_rotations[b]);
+    std::swap(m_bodies.m_velocities[a], m_bodies.m_velocities[b]);
+    std::swap(m_bodies.m_angular_velocities[a],
+              m_bodies.m_angular_velocities[b]);
+    std::swap(m_bodies.m_inv_masses[a], m_bodies.m_inv_masses[b]);
+    std::swap(m_bodies.m_inv_inertias[a], m_bodies.m_inv_inertias[b]);
+    std::swap(m_bodies.m_shapes[a], m_bodies.m_shapes[b]);
+    std::swap(m_bodies.m_shape_poses[a], m_bodies.m_shape_poses[b]);
+    std::swap(m_bodies.m_aabbs[a], m_bodies.m_aabbs[b]);
+    std::swap(m_bodies.m_shape_geometries[a], m_bodies.m_shape_geometries[b]);
+    std::swap(m_bodies.m_sleep_times[a], m_bodies.m_sleep_times[b]);
+    std::swap(m_bodies.m_bullets[a], m_bodies.m_bullets[b]);
+    std::swap(m_bodies.m_slots[a], m_bodies.m_slots[b]);
+    m_slots[m_bodies.m_slots[a]].m_dense = a;
+    m_slots[m_bodies.m_slots[b]].m_dense = b;
+}
+
+// GetManifolds() reports dense indices, keep them pointing at the same
+// bodies while the step moves bodies between the awake and sleeping ranges
+void World::manifoldsToSlots() {
+    for (ContactManifold& manifold : m_manifolds) {
+        manifold.m_body_a = m_bodies.m_slots[manifold.m_body_a];
+        manifold.m_body_b = m_bodies.m_slots[manifold.m_body_b];
+    }
+}
+
+void World::manifoldsToDense() {
+    for (ContactManifold& manifold : m_manifolds) {
+        manifold.m_body_a = m_slots[manifold.m_body_a].m_dense;
+        manifold.m_body_b = m_slots[manifold.m_body_b].m_dense;
+    }
+}
+
+void World::updateShape(uint32_t dense) {
+    const Shape& shape = m_bodies.m_shapes[dense];
+    Pose body_pose{m_bodies.m_positions[dense], m_bodies.m_rotations[dense]};
+    Pose& shape_pose = m_bodies.m_shape_poses[dense];
+    shape_pose = body_pose.TransformBy(shape.m_local_pose);
+    m_bodies.m_aabbs[dense] =
+        shape.m_geom ? ComputeAABB(m_geometries.Get(shape.m_geom), shape_pose)
+                     : AABB{shape_pose.m_position, shape_pose.m_position};
+}
+
+// called by several workers at once
+void World::markMoved(uint32_t slot) {
+    std::atomic_ref<uint64_t>{m_moved_slots[slot / 64]}.fetch_or(
+        1ull << (slot % 64), std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,210 @@
+#include "toy_physics/world_snapshot.hpp"
+#include "toy_physics/body.hpp"
+#include "toy_physics/contact_cache.hpp"
+#include "toy_physics/dynamic_aabb_tree.hpp"
+#include "toy_physics/log.hpp"
+
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace toy_physics {
+
+uint32_t WorldSnapshotHeader::GetLayout() {
+    // FNV-1a over the record sizes and a byte order probe
+    const uint32_t values[] = {
+        sizeof(WorldSnapshotHeader), sizeof(Eigen::Vector3f),
+        sizeof(Eigen::Quaternionf),  sizeof(Eigen::Matrix3f),
+        sizeof(Pose),                sizeof(Shape),
+        sizeof(AABB),                sizeof(ContactManifold),
+        sizeof(ContactCacheRecord),  sizeof(DynamicAABBTree::Node),
+        sizeof(BoxGeometry),         sizeof(SphereGeometry),
+        sizeof(CapsuleGeometry),     0x01020304u,
+    };
+    uint32_t hash = 2166136261u;
+    for (uint32_t value : values) {
+        for (int i = 0; i < 4; i++) {
+            hash = (hash ^ ((value >> (i * 8)) & 0xff)) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+WorldSnapshotView::WorldSnapshotView(std::span<const std::byte> data) {
+    if (data.size() < sizeof(WorldSnapshotHeader)) {
+        LOGE("world snapshot is too small");
+        return;
+    }
+    // the header is only read through a copy until it is known to be sane
+    WorldSnapshotHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.m_magic != WorldSnapshotHeader::Magic) {
+        LOGE("not a world snapshot");
+        return;
+    }
+    if (header.m_version != WorldSnapshotHeader::Version) {
+        LOGE("world snapshot version {} is not supported", header.m_version);
+        return;
+    }
+    if (header.m_layout != WorldSnapshotHeader::GetLayout()) {
+        LOGE("world snapshot was written by an incompatible build");
+        return;
+    }
+    if (reinterpret_cast<uintptr_t>(data.data()) %
+            WorldSnapshotHeader::DataAlignment !=
+        0) {
+        LOGE("world snapshot data is not {} byte aligned",
+             WorldSnapshotHeader::DataAlignment);
+        return;
+    }
+    for (const auto& section : header.m_sections) {
+        if (section.m_offset > data.size() ||
+            section.m_size > data.size() - section.m_offset) {
+            LOGE("world snapshot is truncated");
+            return;
+        }
+    }
+    m_data = data;
+}
+
+const WorldSnapshotHeader& WorldSnapshotView::GetHeader() const {
+    return *reinterpret_cast<const WorldSnapshotHeader*>(m_data.data());
+}
+
+std::span<const std::byte> WorldSnapshotView::GetBytes(
+    WorldSnapshotSection section) const {
+    if (!IsValid()) {
+        return {};
+    }
+    const auto& range = GetHeader().m_sections[size_t(section)];
+    return m_data.subspan(range.m_offset, range.m_size);
+}
+
+WorldSnapshotWriter::WorldSnapshotWriter(std::vector<std::byte>& out)
+    : m_out{out} {
+    m_out.clear();
+    m_out.resize(sizeof(WorldSnapshotHeader));
+    m_header.m_layout = WorldSnapshotHeader::GetLayout();
+}
+
+void WorldSnapshotWriter::Write(WorldSnapshotSection section,
+                                const void* data, size_t size) {
+    size_t offset = (m_out.size() + WorldSnapshotHeader::Alignment - 1) &
+                    ~(WorldSnapshotHeader::Alignment - 1);
+    m_out.resize(offset + size);
+    if (size > 0) {
+        std::memcpy(m_out.data() + offset, data, size);
+    }
+    m_header.m_sections[size_t(section)] = {offset, size};
+}
+
+void WorldSnapshotWriter::Finish() {
+    std::memcpy(m_out.data(), &m_header, sizeof(m_header));
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data{other.m_data}, m_size{other.m_size} {
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        m_data = other.m_data;
+        m_size = other.m_size;
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOGE("can't open {}", path);
+        return false;
+    }
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping =
+            CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    // the view keeps the file mapped after both handles are closed
+    if (mapping) {
+        m_data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if (!m_data) {
+        LOGE("can't map {}", path);
+        return false;
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        LOGE("can't open {}", path);
+        return false;
+    }
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (fstat(file, &info) == 0 && info.st_size > 0) {
+        data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                    MAP_PRIVATE, file, 0);
+    }
+    // the mapping keeps the file alive after the descriptor is closed
+    close(file);
+    if (data == MAP_FAILED) {
+        LOGE("can't map {}", path);
+        return false;
+    }
+    m_data = data;
+    m_size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_data) {
+        munmap(const_cast<void*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+}
@@ -0,0 +1,230 @@
+#include "toy_physics/broadphase.hpp"
+#include "toy_physics/job_system.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace toy_physics;
+
+// every backend against a brute force reference on random boxes. Queries
+// run both right after Add/Update/Remove and after UpdatePairs(), pairs
+// after UpdatePairs(). Sweep and prune and the hash grid report exact
+// overlaps of the boxes swept by their displacement, the tree reports
+// overlaps of its fat boxes and may report more.
+// Proxies are set resting and active at random, none may report a pair of
+// two resting proxies
+
+constexpr uint32_t IdCount = 600;
+constexpr int RoundCount = 40;
+
+struct Reference {
+    // swept by the last displacement, what the backends pair
+    std::vector<AABB> m_boxes;
+    // where the next move starts
+    std::vector<AABB> m_placed;
+    std::vector<uint8_t> m_in_use;
+    std::vector<uint8_t> m_resting;
+
+    bool IsRestingPair(const BroadphasePair& pair) const {
+        return m_resting[pair.m_a] && m_resting[pair.m_b];
+    }
+
+    std::vector<uint32_t> Query(const AABB& aabb) const {
+        std::vector<uint32_t> ids;
+        for (uint32_t id = 0; id < m_boxes.size(); id++) {
+            if (m_in_use[id] && m_boxes[id].Intersect(aabb)) {
+                ids.push_back(id);
+            }
+        }
+        return ids;
+    }
+
+    std::vector<BroadphasePair> GetPairs() const {
+        std::vector<BroadphasePair> pairs;
+        for (uint32_t a = 0; a < m_boxes.size(); a++) {
+            for (uint32_t b = a + 1; m_in_use[a] && b < m_boxes.size(); b++) {
+                if (m_in_use[b] && !IsRestingPair({a, b}) &&
+                    m_boxes[a].Intersect(m_boxes[b])) {
+                    pairs.push_back({a, b});
+                }
+            }
+        }
+        return pairs;
+    }
+};
+
+static const char* GetName(Broadphase::Type type) {
+    switch (type) {
+        case Broadphase::Type::Tree:
+            return "tree";
+        case Broadphase::Type::SweepAndPrune:
+            return "sap";
+        case Broadphase::Type::HashGrid:
+            return "hash_grid";
+    }
+    return "?";
+}
+
+// mostly small boxes, a few large ones like grounds and walls
+static AABB RandomBox(std::mt19937& random) {
+    std::uniform_real_distribution<float> position{-40, 40};
+    std::uniform_real_distribution<float> size{0.2f, 2.0f};
+    Eigen::Vector3f center{position(random), position(random) * 0.25f,
+                           position(random)};
+    Eigen::Vector3f half_size{size(random), size(random), size(random)};
+    if (random() % 50 == 0) {
+        half_size.x() *= 20;
+        half_size.z() *= 20;
+    }
+    return {center - half_size, center + half_size};
+}
+
+static AABB Move(std::mt19937& random, const AABB& box) {
+    // a few teleports, the rest coherent motion
+    if (random() % 10 == 0) {
+        return RandomBox(random);
+    }
+    std::uniform_real_distribution<float> step{-0.5f, 0.5f};
+    return box.Translate({step(random), step(random), step(random)});
+}
+
+static bool Expect(bool exact, std::vector<uint32_t> ids,
+                   const std::vector<uint32_t>& expected) {
+    std::sort(ids.begin(), ids.end());
+    if (std::adjacent_find(ids.begin(), ids.end()) != ids.end()) {
+        return false;
+    }
+    if (exact) {
+        return ids == expected;
+    }
+    return std::includes(ids.begin(), ids.end(), expected.begin(),
+                         expected.end());
+}
+
+static int CheckQueries(Broadphase& broadphase, const Reference& reference,
+                        std::mt19937& random, const char* stage, int round) {
+    bool exact = broadphase.GetType() != Broadphase::Type::Tree;
+    int failures = 0;
+    for (int q = 0; q < 20; q++) {
+        AABB query = RandomBox(random);
+        std::vector<uint32_t> ids;
+        broadphase.Query(query, [&](uint32_t id) {
+            ids.push_back(id);
+            return true;
+        });
+        if (!Expect(exact, ids, reference.Query(query))) {
+            std::printf("%s: round %d, query %s: %zu hits, expected %zu\n",
+                        GetName(broadphase.GetType()), round, stage,
+                        ids.size(), reference.Query(query).size());
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static int CheckPairs(Broadphase& broadphase, const Reference& reference,
+                      int round) {
+    std::vector<BroadphasePair> pairs = broadphase.GetPairs();
+    std::sort(pairs.begin(), pairs.end());
+    std::vector<BroadphasePair> expected = reference.GetPairs();
+    bool ok = std::adjacent_find(pairs.begin(), pairs.end()) == pairs.end() &&
+              std::none_of(pairs.begin(), pairs.end(),
+                           [&](const BroadphasePair& pair) {
+                               return reference.IsRestingPair(pair);
+                           });
+    if (broadphase.GetType() == Broadphase::Type::Tree) {
+        ok = ok && std::includes(pairs.begin(), pairs.end(), expected.begin(),
+                                 expected.end());
+    } else {
+        ok = ok && pairs == expected;
+    }
+    if (!ok) {
+        std::printf("%s: round %d: %zu pairs, expected %zu\n",
+                    GetName(broadphase.GetType()), round, pairs.size(),
+                    expected.size());
+        return 1;
+    }
+    return 0;
+}
+
+static int Run(Broadphase::Type type, JobSystem* job_system) {
+    std::unique_ptr<Broadphase> broadphase =
+        CreateBroadphase(type, job_system);
+    Reference reference;
+    reference.m_boxes.resize(IdCount);
+    reference.m_placed.resize(IdCount);
+    reference.m_in_use.resize(IdCount, 0);
+    reference.m_resting.resize(IdCount, 0);
+
+    std::mt19937 random{7};
+    int failures = 0;
+    for (int round = 0; round < RoundCount; round++) {
+        // some rounds only move proxies, backends that track added and
+        // removed proxies must still see the moves
+        bool moves_only = round % 3 == 2;
+        for (uint32_t id = 0; id < IdCount; id++) {
+            uint32_t op = random() % 8;
+            if (!reference.m_in_use[id]) {
+                if (!moves_only && op < 4) {
+                    reference.m_boxes[id] = RandomBox(random);
+                    reference.m_placed[id] = reference.m_boxes[id];
+                    reference.m_in_use[id] = 1;
+                    reference.m_resting[id] = 0;
+                    broadphase->Add(id, reference.m_boxes[id]);
+                }
+            } else if (!moves_only && op == 0) {
+                reference.m_in_use[id] = 0;
+                broadphase->Remove(id);
+            } else if (op < 6) {
+                AABB box = Move(random, reference.m_placed[id]);
+                Eigen::Vector3f displacement =
+                    box.m_min - reference.m_placed[id].m_min;
+                broadphase->Update(id, box, displacement);
+                reference.m_boxes[id] = box.Sweep(displacement);
+                reference.m_placed[id] = box;
+            } else if (op == 6) {
+                // most proxies rest, like sleeping bodies in a settled scene
+                bool resting = random() % 4 != 0;
+                reference.m_resting[id] = resting;
+                broadphase->SetResting(id, resting);
+            }
+        }
+        if (round % 10 == 5) {
+            Eigen::Vector3f offset{-3.5f, 1.0f, 2.25f};
+            for (AABB& box : reference.m_boxes) {
+                box = box.Translate(offset);
+            }
+            for (AABB& box : reference.m_placed) {
+                box = box.Translate(offset);
+            }
+            broadphase->ShiftOrigin(offset);
+        }
+
+        failures += CheckQueries(*broadphase, reference, random,
+                                 "before update", round);
+        broadphase->UpdatePairs();
+        failures += CheckPairs(*broadphase, reference, round);
+        failures += CheckQueries(*broadphase, reference, random, "after update",
+                                 round);
+    }
+    return failures;
+}
+
+int main() {
+    JobSystem job_system{4};
+    int failures = 0;
+    for (Broadphase::Type type :
+         {Broadphase::Type::Tree, Broadphase::Type::SweepAndPrune,
+          Broadphase::Type::HashGrid}) {
+        failures += Run(type, nullptr);
+        failures += Run(type, &job_system);
+    }
+    if (failures) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all broadphases agree\n");
+    return 0;
+}
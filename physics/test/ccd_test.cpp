@@ -0,0 +1,106 @@
+#include "toy_physics/world.hpp"
+
+#include <cstdio>
+
+using namespace toy_physics;
+
+// a small sphere fired at a thin static plate at 60 Hz moves several times
+// the plate's thickness per step. Without continuous collision it tunnels,
+// with it the sphere stops at the time of impact, on every broadphase
+
+struct Backend {
+    Broadphase::Type m_type;
+    const char* m_name;
+};
+
+constexpr Backend Backends[] = {
+    {Broadphase::Type::Tree, "tree"},
+    {Broadphase::Type::SweepAndPrune, "sap"},
+    {Broadphase::Type::HashGrid, "hash_grid"},
+};
+
+constexpr float DeltaTime = 1.0f / 60.0f;
+constexpr float PlateHalfThickness = 0.02f;
+constexpr float Radius = 0.1f;
+
+struct Checker {
+    const char* m_backend = "";
+    int m_failures = 0;
+
+    void Expect(bool ok, const char* what) {
+        if (!ok) {
+            std::printf("%s: %s\n", m_backend, what);
+            m_failures++;
+        }
+    }
+};
+
+struct Shot {
+    World m_world;
+    BodyHandle m_sphere;
+
+    Shot(Broadphase::Type type, bool ccd, bool bullet) : m_world{type, 1} {
+        m_world.m_enable_ccd = ccd;
+        Body plate;
+        plate.m_geometry.m_geom = m_world.GetGeometryPool().Add(
+            BoxGeometry{Eigen::Vector3f{2, PlateHalfThickness, 2}});
+        m_world.CreateBody(plate);
+
+        // 4 units per step, the impact falls inside the second step
+        Body sphere;
+        sphere.m_inv_mass = 1;
+        sphere.m_pose.m_position = {0, 5, 0};
+        sphere.m_velocity = {0, -240, 0};
+        sphere.m_bullet = bullet;
+        sphere.m_geometry.m_geom =
+            m_world.GetGeometryPool().Add(SphereGeometry{Radius});
+        m_sphere = m_world.CreateBody(sphere);
+    }
+
+    float GetHeight() const {
+        return m_world.GetPose(m_sphere).m_position.y();
+    }
+};
+
+static void CheckShot(Checker& checker, Broadphase::Type type, bool bullet) {
+    Shot unswept{type, false, bullet};
+    for (int i = 0; i < 2; i++) {
+        unswept.m_world.Step(DeltaTime);
+    }
+    checker.Expect(unswept.GetHeight() < -PlateHalfThickness,
+                   "without ccd the sphere tunnels");
+
+    Shot swept{type, true, bullet};
+    swept.m_world.Step(DeltaTime);
+    swept.m_world.Step(DeltaTime);
+    // stops within the contact margin of the plate
+    float touching = PlateHalfThickness + Radius;
+    float height = swept.GetHeight();
+    checker.Expect(height >= touching &&
+                       height <= touching + swept.m_world.m_contact_margin,
+                   bullet ? "the bullet stops at the time of impact"
+                          : "the fast sphere stops at the time of impact");
+
+    bool above = true;
+    for (int i = 0; i < 60; i++) {
+        swept.m_world.Step(DeltaTime);
+        above = above && swept.GetHeight() > PlateHalfThickness;
+    }
+    checker.Expect(above, "the sphere stays on the plate");
+}
+
+int main() {
+    int failures = 0;
+    for (const Backend& backend : Backends) {
+        Checker checker{backend.m_name};
+        CheckShot(checker, backend.m_type, true);
+        CheckShot(checker, backend.m_type, false);
+        failures += checker.m_failures;
+    }
+    if (failures) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("fast spheres stop at the plate on every broadphase\n");
+    return 0;
+}
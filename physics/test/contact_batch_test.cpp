@@ -0,0 +1,115 @@
+#include "simd_check.hpp"
+#include "toy_physics/contact_batch.hpp"
+
+#include <cstdio>
+#include <random>
+
+using namespace toy_physics;
+using namespace toy_physics::test;
+
+// the wide sphere and capsule kernels at every simd level against the
+// scalar path, bit for bit. Some pairs are degenerate: coincident centers,
+// point segments, parallel and overlapping segments
+
+static Eigen::Vector3f RandomPoint(std::mt19937& random) {
+    std::uniform_real_distribution<float> position{-2, 2};
+    return {position(random), position(random), position(random)};
+}
+
+static float RandomRadius(std::mt19937& random) {
+    std::uniform_real_distribution<float> radius{0, 1};
+    return random() % 8 == 0 ? 0.0f : radius(random);
+}
+
+static void FillSpheres(std::mt19937& random, size_t count,
+                        SpherePairBatch& batch) {
+    batch.Clear();
+    for (size_t i = 0; i < count; i++) {
+        Eigen::Vector3f a = RandomPoint(random);
+        Eigen::Vector3f b = random() % 4 == 0 ? a : RandomPoint(random);
+        batch.Push(a, RandomRadius(random), b, RandomRadius(random));
+    }
+}
+
+static void FillCapsules(std::mt19937& random, size_t count,
+                         CapsulePairBatch& batch) {
+    batch.Clear();
+    for (size_t i = 0; i < count; i++) {
+        Eigen::Vector3f p1 = RandomPoint(random);
+        Eigen::Vector3f q1 = RandomPoint(random);
+        Eigen::Vector3f p2 = RandomPoint(random);
+        Eigen::Vector3f q2 = RandomPoint(random);
+        switch (random() % 6) {
+            case 0:
+                // point against segment
+                q1 = p1;
+                break;
+            case 1:
+                // two points
+                q1 = p1;
+                q2 = p2;
+                break;
+            case 2:
+                // parallel
+                q2 = p2 + (q1 - p1) * 0.5f;
+                break;
+            case 3:
+                // same line, overlapping
+                p2 = p1 + (q1 - p1) * 0.25f;
+                q2 = p1 + (q1 - p1) * 1.5f;
+                break;
+            case 4:
+                // the same segment
+                p2 = p1;
+                q2 = q1;
+                break;
+            default:
+                break;
+        }
+        batch.Push(p1, q1, RandomRadius(random), p2, q2, RandomRadius(random));
+    }
+}
+
+static bool SameContacts(const ContactBatch& a, const ContactBatch& b) {
+    return SameBits(a.m_normal, b.m_normal) &&
+           SameBits(a.m_position, b.m_position) &&
+           SameBits(a.m_depth, b.m_depth);
+}
+
+int main() {
+    std::mt19937 random{6};
+    SpherePairBatch spheres;
+    CapsulePairBatch capsules;
+    ContactBatch reference, contacts;
+    int failures = 0;
+    ForEachBatchSize(20, [&](size_t count) {
+        FillSpheres(random, count, spheres);
+        CollideSphereBatch(spheres, reference, SimdLevel::Scalar);
+        for (SimdLevel level : Levels) {
+            CollideSphereBatch(spheres, contacts, level);
+            if (!SameContacts(reference, contacts)) {
+                std::printf("spheres: %s differs from scalar, %zu pairs\n",
+                            GetSimdLevelName(level), count);
+                failures++;
+            }
+        }
+
+        FillCapsules(random, count, capsules);
+        CollideCapsuleBatch(capsules, reference, SimdLevel::Scalar);
+        for (SimdLevel level : Levels) {
+            CollideCapsuleBatch(capsules, contacts, level);
+            if (!SameContacts(reference, contacts)) {
+                std::printf("capsules: %s differs from scalar, %zu pairs\n",
+                            GetSimdLevelName(level), count);
+                failures++;
+            }
+        }
+    });
+    if (failures) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("every simd level matches scalar, best is %s\n",
+                GetSimdLevelName(GetSimdLevel()));
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include "toy_physics/gjk.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace toy_physics;
+
+// EPA against the separating axis test on random overlapping box-box and
+// box-capsule cores, where SAT over the face normals and edge cross
+// products is exact. Then GJK warm started from a cached simplex on
+// resting pairs
+
+constexpr int PairCount = 2000;
+
+struct Checker {
+    int m_failures = 0;
+
+    void Expect(bool ok, const char* what, int index) {
+        if (!ok) {
+            std::printf("%s: pair %d\n", what, index);
+            m_failures++;
+        }
+    }
+};
+
+struct SatAxis {
+    // points from A to B
+    Eigen::Vector3f m_normal;
+    float m_depth;
+};
+
+// every candidate axis with the core overlap along it, both directions
+static std::vector<SatAxis> ComputeSat(const ConvexProxy& a,
+                                       const ConvexProxy& b,
+                                       const std::vector<Eigen::Vector3f>&
+                                           axes) {
+    std::vector<SatAxis> result;
+    for (Eigen::Vector3f axis : axes) {
+        if (axis.squaredNorm() < 1e-6f) {
+            continue;
+        }
+        axis.normalize();
+        float min_a = FLT_MAX, max_a = -FLT_MAX;
+        float min_b = FLT_MAX, max_b = -FLT_MAX;
+        for (uint32_t i = 0; i < a.m_count; i++) {
+            min_a = std::min(min_a, a.m_vertices[i].dot(axis));
+            max_a = std::max(max_a, a.m_vertices[i].dot(axis));
+        }
+        for (uint32_t i = 0; i < b.m_count; i++) {
+            min_b = std::min(min_b, b.m_vertices[i].dot(axis));
+            max_b = std::max(max_b, b.m_vertices[i].dot(axis));
+        }
+        result.push_back({axis, max_a - min_b});
+        result.push_back({-axis, max_b - min_a});
+    }
+    return result;
+}
+
+// EPA has to find the shallowest axis. The normal is only compared when no
+// other direction comes close to the same depth
+static void CheckAgainstSat(Checker& checker, const char* what, int index,
+                            const ConvexProxy& a, const ConvexProxy& b,
+                            const std::vector<Eigen::Vector3f>& axes) {
+    std::vector<SatAxis> sat = ComputeSat(a, b, axes);
+    const SatAxis* best = &sat[0];
+    for (const SatAxis& axis : sat) {
+        if (axis.m_depth < best->m_depth) {
+            best = &axis;
+        }
+    }
+    float second = FLT_MAX;
+    for (const SatAxis& axis : sat) {
+        if (axis.m_normal.dot(best->m_normal) < 0.99f) {
+            second = std::min(second, axis.m_depth);
+        }
+    }
+
+    ConvexContact contact;
+    bool hit = CollideConvex(a, b, 0, nullptr, contact);
+    float core_depth = contact.m_depth - a.m_radius - b.m_radius;
+    checker.Expect(hit && std::abs(core_depth - best->m_depth) < 2e-3f, what,
+                   index);
+    if (second - best->m_depth > 0.02f) {
+        checker.Expect(contact.m_normal.dot(best->m_normal) > 0.999f, what,
+                       index);
+    }
+}
+
+static Pose RandomPose(std::mt19937& random, float spread) {
+    std::uniform_real_distribution<float> position{-spread, spread};
+    std::normal_distribution<float> normal;
+    Eigen::Quaternionf rotation{normal(random), normal(random),
+                                normal(random), normal(random)};
+    return {{position(random), position(random), position(random)},
+            rotation.normalized()};
+}
+
+static Eigen::Vector3f RandomHalfSize(std::mt19937& random) {
+    std::uniform_real_distribution<float> size{0.2f, 1.5f};
+    return {size(random), size(random), size(random)};
+}
+
+static void AddBoxAxes(const Pose& pose, std::vector<Eigen::Vector3f>& axes) {
+    Eigen::Matrix3f rot = pose.m_rotation.toRotationMatrix();
+    for (int i = 0; i < 3; i++) {
+        axes.push_back(rot.col(i));
+    }
+}
+
+static void CheckBoxBox(Checker& checker, std::mt19937& random) {
+    for (int i = 0; i < PairCount; i++) {
+        Pose pose_a = RandomPose(random, 0);
+        Pose pose_b = RandomPose(random, 0.8f);
+        ConvexProxy a =
+            MakeConvexProxy(BoxGeometry{RandomHalfSize(random)}, pose_a);
+        ConvexProxy b =
+            MakeConvexProxy(BoxGeometry{RandomHalfSize(random)}, pose_b);
+
+        std::vector<Eigen::Vector3f> axes;
+        AddBoxAxes(pose_a, axes);
+        AddBoxAxes(pose_b, axes);
+        for (int j = 0; j < 3; j++) {
+            for (int k = 3; k < 6; k++) {
+                axes.push_back(axes[j].cross(axes[k]));
+            }
+        }
+        // separated cores go through GJK, not EPA
+        bool overlap = true;
+        for (const SatAxis& axis : ComputeSat(a, b, axes)) {
+            overlap = overlap && axis.m_depth > 0;
+        }
+        if (overlap) {
+            CheckAgainstSat(checker, "box-box depth or normal", i, a, b, axes);
+        }
+    }
+}
+
+static void CheckBoxCapsule(Checker& checker, std::mt19937& random) {
+    std::uniform_real_distribution<float> radius{0.05f, 0.5f};
+    for (int i = 0; i < PairCount; i++) {
+        Pose pose_a = RandomPose(random, 0);
+        Eigen::Vector3f half_size = RandomHalfSize(random);
+        ConvexProxy a = MakeConvexProxy(BoxGeometry{half_size}, pose_a);
+        // segment center inside the box, so the cores overlap
+        Pose pose_b = RandomPose(random, 1);
+        pose_b.m_position =
+            pose_a.m_rotation * pose_b.m_position.cwiseProduct(half_size);
+        CapsuleGeometry capsule{radius(random), radius(random) * 3};
+        ConvexProxy b = MakeConvexProxy(capsule, pose_b);
+
+        std::vector<Eigen::Vector3f> axes;
+        AddBoxAxes(pose_a, axes);
+        Eigen::Vector3f d = b.m_vertices[1] - b.m_vertices[0];
+        for (int j = 0; j < 3; j++) {
+            axes.push_back(axes[j].cross(d));
+        }
+        CheckAgainstSat(checker, "box-capsule depth or normal", i, a, b, axes);
+    }
+}
+
+// a resting pair barely moves between steps, the cached simplex of the
+// last query is already the answer
+static void CheckWarmStart(Checker& checker, const char* what,
+                           const ConvexProxy& a, const Geometry& geom_b,
+                           Pose pose_b) {
+    SimplexCache cache;
+    GjkOutput cold = GjkDistance(a, MakeConvexProxy(geom_b, pose_b), &cache);
+    for (int step = 0; step < 10; step++) {
+        pose_b.m_position.x() += 1e-4f;
+        ConvexProxy b = MakeConvexProxy(geom_b, pose_b);
+        GjkOutput warm = GjkDistance(a, b, &cache);
+        checker.Expect(warm.m_iterations <= 2 &&
+                           std::abs(warm.m_distance - cold.m_distance) < 1e-3f,
+                       what, step);
+    }
+}
+
+int main() {
+    Checker checker;
+    std::mt19937 random{7};
+    CheckBoxBox(checker, random);
+    CheckBoxCapsule(checker, random);
+
+    BoxGeometry ground{Eigen::Vector3f{5, 0.5f, 5}};
+    ConvexProxy a = MakeConvexProxy(
+        ground, {{0, -0.5f, 0}, Eigen::Quaternionf::Identity()});
+    CheckWarmStart(checker, "box resting on a box", a,
+                   BoxGeometry{Eigen::Vector3f{.5f, .5f, .5f}},
+                   {{0.3f, 0.51f, -0.2f}, Eigen::Quaternionf::Identity()});
+    Eigen::Quaternionf lying =
+        Eigen::AngleAxisf(0.3f, Eigen::Vector3f::UnitY()) *
+        Eigen::AngleAxisf(1.5707964f, Eigen::Vector3f::UnitZ());
+    CheckWarmStart(checker, "capsule lying on a box", a,
+                   CapsuleGeometry{0.25f, 0.5f}, {{-1, 0.26f, 0.5f}, lying});
+
+    if (checker.m_failures) {
+        std::printf("%d checks failed\n", checker.m_failures);
+        return 1;
+    }
+    std::printf("epa agrees with sat and warm gjk converges at once\n");
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include "simd_check.hpp"
+#include "toy_physics/pose_batch.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+using namespace toy_physics;
+using namespace toy_physics::test;
+
+// the batched pose operations at every simd level against the scalar
+// path bit for bit, and against the Pose methods within rounding. Also
+// checks that RelativeBy undoes TransformBy
+
+constexpr float LerpTs[] = {0.0f, 0.1f, 0.25f, 0.5f, 0.77f, 1.0f};
+
+// largest difference of LerpPoses rotations from Pose::Lerp, per component
+constexpr float SlerpTolerance = 5e-7f;
+// positions are within [-10, 10]
+constexpr float PositionTolerance = 1e-5f;
+constexpr float RotationTolerance = 1e-6f;
+
+static Eigen::Quaternionf RandomRotation(std::mt19937& random) {
+    std::uniform_real_distribution<float> component{-1, 1};
+    return Eigen::Quaternionf{Eigen::Vector4f{component(random),
+                                              component(random),
+                                              component(random),
+                                              component(random)}
+                                  .normalized()};
+}
+
+static Pose RandomPose(std::mt19937& random) {
+    std::uniform_real_distribution<float> position{-10, 10};
+    return {{position(random), position(random), position(random)},
+            RandomRotation(random)};
+}
+
+// every third target is a small rotation away from its source, where the
+// slerp weights are hardest to get right
+static void FillPoses(std::mt19937& random, size_t count, PoseBatch& a,
+                      PoseBatch& b) {
+    std::uniform_real_distribution<float> nudge{-1e-3f, 1e-3f};
+    a.Clear();
+    b.Clear();
+    for (size_t i = 0; i < count; i++) {
+        Pose pose_a = RandomPose(random);
+        Pose pose_b = RandomPose(random);
+        if (i % 3 == 0) {
+            Eigen::Vector4f nudged{nudge(random), nudge(random),
+                                   nudge(random), nudge(random)};
+            Eigen::Vector4f near = pose_a.m_rotation.coeffs() + nudged;
+            pose_b.m_rotation = Eigen::Quaternionf{near.normalized()};
+        }
+        a.Push(pose_a);
+        b.Push(pose_b);
+    }
+}
+
+static bool SamePoses(const PoseBatch& a, const PoseBatch& b) {
+    return SameBits(a.m_position, b.m_position) &&
+           SameBits(a.m_rotation.m_x, b.m_rotation.m_x) &&
+           SameBits(a.m_rotation.m_y, b.m_rotation.m_y) &&
+           SameBits(a.m_rotation.m_z, b.m_rotation.m_z) &&
+           SameBits(a.m_rotation.m_w, b.m_rotation.m_w);
+}
+
+// q and -q are the same rotation
+static float RotationError(const Eigen::Quaternionf& a,
+                           const Eigen::Quaternionf& b) {
+    return std::min((a.coeffs() - b.coeffs()).cwiseAbs().maxCoeff(),
+                    (a.coeffs() + b.coeffs()).cwiseAbs().maxCoeff());
+}
+
+static bool NearPose(const Pose& a, const Pose& b, float rotation_tolerance) {
+    return (a.m_position - b.m_position).cwiseAbs().maxCoeff() <=
+               PositionTolerance &&
+           RotationError(a.m_rotation, b.m_rotation) <= rotation_tolerance;
+}
+
+struct Checker {
+    int m_failures = 0;
+
+    void Expect(bool ok, const char* what, SimdLevel level, size_t count) {
+        if (!ok) {
+            std::printf("%s: %s failed, %zu poses\n", what,
+                        GetSimdLevelName(level), count);
+            m_failures++;
+        }
+    }
+};
+
+static void CheckLevels(Checker& checker, const PoseBatch& a,
+                        const PoseBatch& b, const Vec3Column& points) {
+    size_t count = a.Size();
+    PoseBatch reference, out;
+    Vec3Column reference_points, out_points;
+    for (SimdLevel level : Levels) {
+        ComposePoses(a, b, reference, SimdLevel::Scalar);
+        ComposePoses(a, b, out, level);
+        checker.Expect(SamePoses(reference, out), "compose", level, count);
+
+        InvertPoses(a, reference, SimdLevel::Scalar);
+        InvertPoses(a, out, level);
+        checker.Expect(SamePoses(reference, out), "invert", level, count);
+
+        RelativePoses(a, b, reference, SimdLevel::Scalar);
+        RelativePoses(a, b, out, level);
+        checker.Expect(SamePoses(reference, out), "relative", level, count);
+
+        TransformPoints(a, points, reference_points, SimdLevel::Scalar);
+        TransformPoints(a, points, out_points, level);
+        checker.Expect(SameBits(reference_points, out_points), "transform",
+                       level, count);
+
+        for (float t : LerpTs) {
+            LerpPoses(a, b, t, reference, SimdLevel::Scalar);
+            LerpPoses(a, b, t, out, level);
+            checker.Expect(SamePoses(reference, out), "lerp", level, count);
+        }
+    }
+}
+
+static void CheckAgainstPose(Checker& checker, const PoseBatch& a,
+                             const PoseBatch& b, const Vec3Column& points) {
+    size_t count = a.Size();
+    SimdLevel level = GetSimdLevel();
+    PoseBatch composed, inverted, relative, lerped;
+    Vec3Column transformed;
+    ComposePoses(a, b, composed, level);
+    InvertPoses(a, inverted, level);
+    RelativePoses(a, b, relative, level);
+    TransformPoints(a, points, transformed, level);
+    for (size_t i = 0; i < count; i++) {
+        Pose pose = a.Get(i);
+        Pose child = b.Get(i);
+        checker.Expect(NearPose(composed.Get(i), pose.TransformBy(child),
+                                RotationTolerance),
+                       "compose vs Pose::TransformBy", level, count);
+        checker.Expect(
+            NearPose(inverted.Get(i), pose.Inverse(), RotationTolerance),
+            "invert vs Pose::Inverse", level, count);
+        checker.Expect(NearPose(relative.Get(i), pose.RelativeBy(child),
+                                RotationTolerance),
+                       "relative vs Pose::RelativeBy", level, count);
+        Eigen::Vector3f point =
+            pose.m_position + pose.m_rotation * points.Get(i);
+        checker.Expect((transformed.Get(i) - point).cwiseAbs().maxCoeff() <=
+                           PositionTolerance,
+                       "transform vs Pose", level, count);
+
+        // P.RelativeBy(c).TransformBy(c) == P
+        checker.Expect(NearPose(pose.RelativeBy(child).TransformBy(child),
+                                pose, RotationTolerance),
+                       "RelativeBy round trip", level, count);
+    }
+
+    for (float t : LerpTs) {
+        LerpPoses(a, b, t, lerped, level);
+        for (size_t i = 0; i < count; i++) {
+            checker.Expect(NearPose(lerped.Get(i), a.Get(i).Lerp(b.Get(i), t),
+                                    SlerpTolerance),
+                           "lerp vs Pose::Lerp", level, count);
+        }
+    }
+}
+
+int main() {
+    std::mt19937 random{19};
+    std::uniform_real_distribution<float> position{-10, 10};
+    PoseBatch a, b;
+    Vec3Column points;
+    Checker checker;
+    ForEachBatchSize(20, [&](size_t count) {
+        FillPoses(random, count, a, b);
+        points.Clear();
+        for (size_t i = 0; i < count; i++) {
+            points.Push(
+                {position(random), position(random), position(random)});
+        }
+        CheckLevels(checker, a, b, points);
+        CheckAgainstPose(checker, a, b, points);
+    });
+    if (checker.m_failures) {
+        std::printf("%d checks failed\n", checker.m_failures);
+        return 1;
+    }
+    std::printf("pose batches match at every simd level, best is %s\n",
+                GetSimdLevelName(GetSimdLevel()));
+    return 0;
+}
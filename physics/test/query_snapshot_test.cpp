@@ -0,0 +1,166 @@
+#include "toy_physics/world.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace toy_physics;
+
+// query snapshots read while their writer goes on. The publisher alone:
+// a held snapshot is never rebuilt, the writer adds snapshots instead.
+// Then reader threads acquiring and querying while the world steps, each
+// seeing epochs that only grow and snapshots that don't change under it
+
+constexpr int StepCount = 300;
+constexpr int ReaderCount = 3;
+constexpr uint32_t BodyCount = 64;
+
+struct Checker {
+    std::atomic<int> m_failures{0};
+
+    void Expect(bool ok, const char* what) {
+        if (!ok) {
+            std::printf("%s\n", what);
+            m_failures++;
+        }
+    }
+};
+
+static void Write(QuerySnapshotPublisher& publisher, const GeometryPool& pool,
+                  GeometryHandle geom, float x) {
+    QuerySnapshot& snapshot = publisher.BeginWrite();
+    snapshot.BeginUpdate(pool, 1, Eigen::Vector3d::Zero());
+    Pose pose{{x, 0, 0}, Eigen::Quaternionf::Identity()};
+    snapshot.SetBody(0, 0, pose, pose, geom,
+                     {pose.m_position - Eigen::Vector3f::Ones(),
+                      pose.m_position + Eigen::Vector3f::Ones()});
+    snapshot.EndUpdate();
+    publisher.Publish(snapshot);
+}
+
+static void CheckPublisher(Checker& checker) {
+    GeometryPool pool;
+    GeometryHandle geom = pool.Add(SphereGeometry{1});
+    QuerySnapshotPublisher publisher;
+    checker.Expect(!publisher.Acquire(), "nothing to acquire before publish");
+
+    Write(publisher, pool, geom, 0);
+    QuerySnapshotRef held = publisher.Acquire();
+    const QuerySnapshot* held_snapshot = &*held;
+    for (int i = 1; i <= 10; i++) {
+        Write(publisher, pool, geom, float(i));
+    }
+    checker.Expect(held->GetEpoch() == 1 &&
+                       held->GetPose({0, 0}).m_position.x() == 0,
+                   "a held snapshot is never rebuilt");
+    checker.Expect(publisher.GetSnapshotCount() == 3,
+                   "the writer adds a snapshot instead of waiting");
+    QuerySnapshotRef current = publisher.Acquire();
+    checker.Expect(current->GetEpoch() == 11 &&
+                       current->GetPose({0, 0}).m_position.x() == 10,
+                   "readers acquire the last publish");
+
+    // released snapshots are rebuilt again, the count stays
+    held = {};
+    current = {};
+    for (int i = 0; i < 10; i++) {
+        Write(publisher, pool, geom, 0);
+    }
+    checker.Expect(publisher.GetSnapshotCount() == 3,
+                   "released snapshots are reused");
+    bool reused = false;
+    for (int i = 0; i < 2; i++) {
+        reused = reused || &*publisher.Acquire() == held_snapshot;
+        Write(publisher, pool, geom, 0);
+    }
+    checker.Expect(reused, "the released snapshot is written again");
+}
+
+static void Read(const World& world, Checker& checker,
+                 const std::atomic<bool>& done, bool hold) {
+    uint64_t last_epoch = 0;
+    while (!done.load()) {
+        QuerySnapshotRef snapshot = world.AcquireQuerySnapshot();
+        if (!snapshot) {
+            continue;
+        }
+        uint64_t epoch = snapshot->GetEpoch();
+        checker.Expect(epoch >= last_epoch, "epochs never go back");
+        last_epoch = epoch;
+
+        uint32_t count = 0;
+        AABB everything{Eigen::Vector3f::Constant(-1e4f),
+                        Eigen::Vector3f::Constant(1e4f)};
+        snapshot->Query(everything, [&](BodyHandle handle) {
+            count += snapshot->IsValid(handle);
+            return true;
+        });
+        checker.Expect(count == BodyCount + 1,
+                       "a snapshot holds every body");
+
+        // the holding reader keeps its snapshot until three more steps
+        // were published, following a falling body
+        if (hold) {
+            BodyHandle body{1, 0};
+            Pose pose = snapshot->GetPose(body);
+            while (!done.load() &&
+                   world.AcquireQuerySnapshot()->GetEpoch() < epoch + 3) {
+                std::this_thread::yield();
+            }
+            checker.Expect(snapshot->GetEpoch() == epoch &&
+                               snapshot->GetPose(body).m_position ==
+                                   pose.m_position,
+                           "a held snapshot doesn't change");
+        }
+    }
+}
+
+static void CheckReaders(Checker& checker) {
+    World world{Broadphase::Type::Tree, 2};
+    world.m_publish_query_snapshots = true;
+    Body ground;
+    ground.m_pose.m_position = {0, -1, 0};
+    ground.m_geometry.m_geom = world.GetGeometryPool().Add(
+        BoxGeometry{Eigen::Vector3f{50, 1, 50}});
+    world.CreateBody(ground);
+    GeometryHandle sphere = world.GetGeometryPool().Add(SphereGeometry{0.5f});
+    for (uint32_t i = 0; i < BodyCount; i++) {
+        Body body;
+        body.m_inv_mass = 1;
+        body.m_pose.m_position = {float(i % 8) * 1.5f - 6, 2.0f + i / 8,
+                                  float(i / 8) * 1.5f - 6};
+        body.m_geometry.m_geom = sphere;
+        world.CreateBody(body);
+    }
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < ReaderCount; i++) {
+        readers.emplace_back(Read, std::cref(world), std::ref(checker),
+                             std::cref(done), i == 0);
+    }
+    for (int i = 0; i < StepCount; i++) {
+        world.Step(1.0f / 60.0f);
+    }
+    done.store(true);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    QuerySnapshotRef last = world.AcquireQuerySnapshot();
+    checker.Expect(last && last->GetEpoch() == StepCount,
+                   "every step publishes one epoch");
+}
+
+int main() {
+    Checker checker;
+    CheckPublisher(checker);
+    CheckReaders(checker);
+    if (checker.m_failures) {
+        std::printf("%d checks failed\n", checker.m_failures.load());
+        return 1;
+    }
+    std::printf("readers see whole snapshots while the world steps\n");
+    return 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "toy_physics/simd.hpp"
+
+#include <cstring>
+#include <vector>
+
+// shared by the tests that run a kernel at every simd level and compare
+// the results with the scalar level bit for bit
+namespace toy_physics::test {
+
+constexpr SimdLevel Levels[] = {SimdLevel::Scalar, SimdLevel::SSE2,
+                                SimdLevel::AVX2};
+
+// not multiples of the lane counts, so the tails run on the narrower paths
+constexpr size_t BatchSizes[] = {0, 1, 3, 7, 9, 13, 17, 31, 100, 257};
+
+// fn(count) for every batch size, rounds times over
+template <typename Fn>
+void ForEachBatchSize(int rounds, Fn&& fn) {
+    for (int round = 0; round < rounds; round++) {
+        for (size_t count : BatchSizes) {
+            fn(count);
+        }
+    }
+}
+
+template <typename T>
+bool SameBits(const std::vector<T>& a, const std::vector<T>& b) {
+    return a.size() == b.size() &&
+           (a.empty() ||
+            std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+inline bool SameBits(const Vec3Column& a, const Vec3Column& b) {
+    return SameBits(a.m_x, b.m_x) && SameBits(a.m_y, b.m_y) &&
+           SameBits(a.m_z, b.m_z);
+}
+
+}
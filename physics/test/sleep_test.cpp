@@ -0,0 +1,216 @@
+#include "toy_physics/world.hpp"
+
+#include <cstdio>
+#include <vector>
+
+using namespace toy_physics;
+
+// sleeping and waking at the world level, on every broadphase backend
+
+struct Backend {
+    Broadphase::Type m_type;
+    const char* m_name;
+};
+
+constexpr Backend Backends[] = {
+    {Broadphase::Type::Tree, "tree"},
+    {Broadphase::Type::SweepAndPrune, "sap"},
+    {Broadphase::Type::HashGrid, "hash_grid"},
+};
+
+constexpr float DeltaTime = 1.0f / 60.0f;
+
+struct Checker {
+    const char* m_backend = "";
+    int m_failures = 0;
+
+    void Expect(bool ok, const char* what) {
+        if (!ok) {
+            std::printf("%s: %s\n", m_backend, what);
+            m_failures++;
+        }
+    }
+};
+
+static BodyHandle CreateGround(World& world) {
+    Body ground;
+    ground.m_pose.m_position = {0, -1, 0};
+    ground.m_geometry.m_geom = world.GetGeometryPool().Add(
+        BoxGeometry{Eigen::Vector3f{50, 1, 50}});
+    return world.CreateBody(ground);
+}
+
+static BodyHandle CreateBox(World& world, const Eigen::Vector3f& position) {
+    Body body;
+    body.m_inv_mass = 1;
+    body.m_pose.m_position = position;
+    body.m_geometry.m_geom = world.GetGeometryPool().Add(
+        BoxGeometry{Eigen::Vector3f{.5f, .5f, .5f}});
+    return world.CreateBody(body);
+}
+
+static bool AllSleeping(const World& world,
+                        const std::vector<BodyHandle>& bodies) {
+    for (BodyHandle body : bodies) {
+        if (!world.IsSleeping(body)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool NoneSleeping(const World& world,
+                         const std::vector<BodyHandle>& bodies) {
+    for (BodyHandle body : bodies) {
+        if (world.IsSleeping(body)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void StepUntilAsleep(World& world,
+                            const std::vector<BodyHandle>& bodies) {
+    for (int i = 0; i < 600 && !AllSleeping(world, bodies); i++) {
+        world.Step(DeltaTime);
+    }
+}
+
+static std::vector<BodyHandle> CreateStack(World& world, float x, int count) {
+    std::vector<BodyHandle> stack;
+    for (int i = 0; i < count; i++) {
+        stack.push_back(CreateBox(world, {x, 0.5f + i, 0}));
+    }
+    return stack;
+}
+
+// two stacks settle into two islands, waking one body wakes its whole
+// island and nothing else
+static void CheckIslands(Checker& checker, Broadphase::Type type) {
+    World world{type, 1};
+    CreateGround(world);
+    std::vector<BodyHandle> left = CreateStack(world, -5, 3);
+    std::vector<BodyHandle> right = CreateStack(world, 5, 3);
+    checker.Expect(world.GetAwakeBodyCount() == 6, "new bodies are awake");
+
+    std::vector<BodyHandle> all = left;
+    all.insert(all.end(), right.begin(), right.end());
+    StepUntilAsleep(world, all);
+    checker.Expect(AllSleeping(world, all), "resting stacks fall asleep");
+    checker.Expect(world.GetAwakeBodyCount() == 0,
+                   "sleeping bodies leave the awake range");
+
+    world.WakeUp(left[2]);
+    checker.Expect(NoneSleeping(world, left), "waking a body wakes its island");
+    checker.Expect(AllSleeping(world, right), "other islands keep sleeping");
+    checker.Expect(world.GetAwakeBodyCount() == 3,
+                   "the woken island joins the awake range");
+
+    StepUntilAsleep(world, all);
+    checker.Expect(AllSleeping(world, all), "a woken island sleeps again");
+}
+
+// a falling box wakes the sleeping box it lands on
+static void CheckWakeOnContact(Checker& checker, Broadphase::Type type) {
+    World world{type, 1};
+    CreateGround(world);
+    std::vector<BodyHandle> resting{CreateBox(world, {0, 0.5f, 0})};
+    StepUntilAsleep(world, resting);
+    checker.Expect(AllSleeping(world, resting), "a resting box falls asleep");
+
+    CreateBox(world, {0, 3, 0});
+    checker.Expect(world.GetAwakeBodyCount() == 1,
+                   "only the falling box is awake");
+    bool woke = false;
+    for (int i = 0; i < 120 && !woke; i++) {
+        world.Step(DeltaTime);
+        woke = !world.IsSleeping(resting[0]);
+    }
+    checker.Expect(woke, "a falling box wakes the box it lands on");
+    checker.Expect(world.GetAwakeBodyCount() == 2,
+                   "both boxes are awake after the contact");
+}
+
+// moving or removing the bottom of a sleeping stack wakes the rest of it
+static void CheckMovedBottom(Checker& checker, Broadphase::Type type,
+                             bool remove) {
+    World world{type, 1};
+    CreateGround(world);
+    std::vector<BodyHandle> stack = CreateStack(world, 0, 3);
+    StepUntilAsleep(world, stack);
+    checker.Expect(AllSleeping(world, stack), "the stack falls asleep");
+
+    BodyHandle bottom = stack[0];
+    stack.erase(stack.begin());
+    if (remove) {
+        world.RemoveBody(bottom);
+    } else {
+        world.SetPose(bottom, {{20, 0.5f, 0}, Eigen::Quaternionf::Identity()});
+    }
+    checker.Expect(NoneSleeping(world, stack),
+                   remove ? "removing the bottom box wakes the stack"
+                          : "moving the bottom box wakes the stack");
+    checker.Expect(world.GetAwakeBodyCount() == (remove ? 2u : 3u),
+                   "the woken stack joins the awake range");
+}
+
+// boxes far apart sleep as separate islands. Moving the ground away has to
+// wake every one of them, also when the ground sits right at the end of
+// the awake range, where waking the first island moves a woken body over
+// the ground's columns
+static void CheckMovedSupport(Checker& checker, Broadphase::Type type,
+                              bool remove) {
+    World world{type, 1};
+    BodyHandle ground = CreateGround(world);
+    std::vector<BodyHandle> boxes;
+    for (int i = 0; i < 4; i++) {
+        boxes.push_back(CreateBox(world, {i * 10.0f - 15, 0.5f, 0}));
+    }
+    StepUntilAsleep(world, boxes);
+    checker.Expect(AllSleeping(world, boxes), "boxes on the ground sleep");
+
+    // swap-remove moves the ground, the last body, into dense index 0
+    BodyHandle first = world.GetHandle(0);
+    world.RemoveBody(first);
+    std::erase(boxes, first);
+    checker.Expect(AllSleeping(world, boxes), "other islands keep sleeping");
+    checker.Expect(world.GetDenseIndex(ground) == world.GetAwakeBodyCount(),
+                   "ground sits at the end of the awake range");
+
+    if (remove) {
+        world.RemoveBody(ground);
+    } else {
+        world.SetPose(ground, {{0, -100, 0}, Eigen::Quaternionf::Identity()});
+    }
+    checker.Expect(NoneSleeping(world, boxes),
+                   remove ? "removing the ground wakes every island"
+                          : "moving the ground wakes every island");
+    for (int i = 0; i < 30; i++) {
+        world.Step(DeltaTime);
+    }
+    bool fell = true;
+    for (BodyHandle box : boxes) {
+        fell = fell && world.GetPose(box).m_position.y() < 0;
+    }
+    checker.Expect(fell, "boxes fall once the ground is gone");
+}
+
+int main() {
+    int failures = 0;
+    for (const Backend& backend : Backends) {
+        Checker checker{backend.m_name};
+        CheckIslands(checker, backend.m_type);
+        CheckWakeOnContact(checker, backend.m_type);
+        CheckMovedBottom(checker, backend.m_type, false);
+        CheckMovedBottom(checker, backend.m_type, true);
+        CheckMovedSupport(checker, backend.m_type, false);
+        CheckMovedSupport(checker, backend.m_type, true);
+        failures += checker.m_failures;
+    }
+    if (failures) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("sleeping and waking agree on every broadphase\n");
+    return 0;
+}
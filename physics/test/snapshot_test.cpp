@@ -0,0 +1,147 @@
+#include "toy_physics/world.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+using namespace toy_physics;
+
+// world snapshots whose sleeping islands were tampered with have to be
+// rejected before anything is loaded. The scene has two sleeping stacks,
+// a removed body for a free slot and one awake body
+
+using Section = WorldSnapshotSection;
+
+struct Scene {
+    World m_world{Broadphase::Type::Tree, 1};
+    BodyHandle m_awake;
+
+    Scene() {
+        Body ground;
+        ground.m_pose.m_position = {0, -1, 0};
+        ground.m_geometry.m_geom = m_world.GetGeometryPool().Add(
+            BoxGeometry{Eigen::Vector3f{50, 1, 50}});
+        m_world.CreateBody(ground);
+
+        GeometryHandle box = m_world.GetGeometryPool().Add(
+            BoxGeometry{Eigen::Vector3f{.5f, .5f, .5f}});
+        for (int stack = 0; stack < 2; stack++) {
+            for (int i = 0; i < 3; i++) {
+                Body body;
+                body.m_inv_mass = 1;
+                body.m_pose.m_position = {stack * 10.0f, 0.5f + i, 0};
+                body.m_geometry.m_geom = box;
+                m_world.CreateBody(body);
+            }
+        }
+        for (int i = 0; i < 300; i++) {
+            m_world.Step(1.0f / 60.0f);
+        }
+
+        // far from the stacks, neither wakes them
+        Body awake;
+        awake.m_inv_mass = 1;
+        awake.m_pose.m_position = {-10, 5, 0};
+        awake.m_geometry.m_geom = box;
+        m_awake = m_world.CreateBody(awake);
+        awake.m_pose.m_position = {30, 5, 0};
+        m_world.RemoveBody(m_world.CreateBody(awake));
+    }
+};
+
+static std::span<uint32_t> GetIndices(std::vector<std::byte>& data,
+                                      Section section) {
+    WorldSnapshotHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    const auto& entry = header.m_sections[size_t(section)];
+    return {reinterpret_cast<uint32_t*>(data.data() + entry.m_offset),
+            entry.m_size / sizeof(uint32_t)};
+}
+
+int main() {
+    Scene scene;
+    std::vector<std::byte> saved;
+    scene.m_world.SaveSnapshot(saved);
+    std::span<uint32_t> island_slots =
+        GetIndices(saved, Section::IslandSlots);
+    std::span<uint32_t> free_slots = GetIndices(saved, Section::FreeSlots);
+    if (island_slots.size() < 6 || free_slots.empty()) {
+        std::printf("scene didn't settle: %zu sleeping, %zu free slots\n",
+                    island_slots.size(), free_slots.size());
+        return 1;
+    }
+
+    struct Tamper {
+        const char* m_name;
+        std::function<void(std::vector<std::byte>&)> m_fn;
+    };
+    uint32_t awake_slot = scene.m_awake.m_index;
+    uint32_t free_slot = free_slots[0];
+    const Tamper tampers[] = {
+        {"free slot in an island",
+         [&](std::vector<std::byte>& data) {
+             GetIndices(data, Section::IslandSlots)[0] = free_slot;
+         }},
+        {"awake body in an island",
+         [&](std::vector<std::byte>& data) {
+             GetIndices(data, Section::IslandSlots)[0] = awake_slot;
+         }},
+        {"body listed twice",
+         [](std::vector<std::byte>& data) {
+             std::span<uint32_t> slots =
+                 GetIndices(data, Section::IslandSlots);
+             slots[1] = slots[0];
+         }},
+        {"body listed by another island",
+         [](std::vector<std::byte>& data) {
+             std::span<uint32_t> slots =
+                 GetIndices(data, Section::IslandSlots);
+             std::swap(slots[0], slots[slots.size() - 1]);
+         }},
+        {"sleeping body in the awake range",
+         [](std::vector<std::byte>& data) {
+             WorldSnapshotHeader header;
+             std::memcpy(&header, data.data(), sizeof(header));
+             header.m_awake_count =
+                 header.m_sections[size_t(Section::Positions)].m_size /
+                 sizeof(Eigen::Vector3f);
+             std::memcpy(data.data(), &header, sizeof(header));
+         }},
+        {"island offsets past a sleeping body",
+         [](std::vector<std::byte>& data) {
+             GetIndices(data, Section::IslandOffsets)[1]--;
+         }},
+        {"live slot in the free list",
+         [&](std::vector<std::byte>& data) {
+             GetIndices(data, Section::FreeSlots)[0] = awake_slot;
+         }},
+    };
+
+    int failures = 0;
+    World world{Broadphase::Type::Tree, 1};
+    for (const Tamper& tamper : tampers) {
+        std::vector<std::byte> data = saved;
+        tamper.m_fn(data);
+        if (world.LoadSnapshot(WorldSnapshotView{data})) {
+            std::printf("%s: loaded\n", tamper.m_name);
+            failures++;
+        }
+    }
+
+    if (!world.LoadSnapshot(WorldSnapshotView{saved})) {
+        std::printf("untampered snapshot didn't load\n");
+        failures++;
+    }
+    world.WakeUp(scene.m_awake);
+    for (int i = 0; i < 10; i++) {
+        world.Step(1.0f / 60.0f);
+    }
+
+    if (failures) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("every tampered island section is rejected\n");
+    return 0;
+}
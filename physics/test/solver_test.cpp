@@ -0,0 +1,149 @@
+#include "simd_check.hpp"
+#include "toy_physics/world.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace toy_physics;
+using namespace toy_physics::test;
+
+// the colored island kernels at every simd level and thread count against
+// the scalar level on one thread, bit for bit. The scene is a settled box
+// pyramid, one island of about 600 manifolds. Few colors push constraints
+// into the serial overflow color as well
+
+constexpr uint32_t ThreadCounts[] = {1, 4};
+constexpr uint32_t MaxColors[] = {16, 4};
+
+struct Scene {
+    BodyColumns m_bodies;
+    std::vector<ContactManifold> m_manifolds;
+
+    Scene() {
+        World world{Broadphase::Type::Tree, 1};
+        Body ground;
+        ground.m_pose.m_position = {0, -1, 0};
+        ground.m_geometry.m_geom = world.GetGeometryPool().Add(
+            BoxGeometry{Eigen::Vector3f{50, 1, 50}});
+        world.CreateBody(ground);
+
+        GeometryHandle box = world.GetGeometryPool().Add(
+            BoxGeometry{Eigen::Vector3f{.5f, .5f, .5f}});
+        for (int row = 0; row < 20; row++) {
+            for (int i = 0; i < 20 - row; i++) {
+                Body body;
+                body.m_inv_mass = 1;
+                body.m_pose.m_position = {(i - (19 - row) * 0.5f) * 1.01f,
+                                          0.5f + row * 1.0f, 0};
+                body.m_geometry.m_geom = box;
+                world.CreateBody(body);
+            }
+        }
+        world.m_allow_sleeping = false;
+        for (int i = 0; i < 30; i++) {
+            world.Step(1.0f / 60.0f);
+        }
+        m_bodies = world.GetBodies();
+        m_manifolds = world.GetManifolds();
+    }
+};
+
+struct Result {
+    std::vector<Eigen::Vector3f> m_velocities;
+    std::vector<Eigen::Vector3f> m_angular_velocities;
+    std::vector<ContactManifold> m_manifolds;
+};
+
+static Result Solve(const Scene& scene, SimdLevel level, uint32_t threads,
+                    uint32_t max_colors) {
+    Result result{scene.m_bodies.m_velocities,
+                  scene.m_bodies.m_angular_velocities, scene.m_manifolds};
+    ContactSolver solver;
+    solver.m_settings.m_split_constraint_count = 64;
+    solver.m_settings.m_max_colors = max_colors;
+    solver.m_settings.m_simd_level = level;
+    JobSystem jobs{threads};
+
+    SolverBodies bodies;
+    bodies.m_positions = scene.m_bodies.m_positions.data();
+    bodies.m_rotations = scene.m_bodies.m_rotations.data();
+    bodies.m_velocities = result.m_velocities.data();
+    bodies.m_angular_velocities = result.m_angular_velocities.data();
+    bodies.m_inv_masses = scene.m_bodies.m_inv_masses.data();
+    bodies.m_inv_inertias = scene.m_bodies.m_inv_inertias.data();
+    bodies.m_count = static_cast<uint32_t>(scene.m_bodies.m_awake_count);
+    solver.Solve(bodies, result.m_manifolds, 1.0f / 60.0f, jobs);
+    return result;
+}
+
+static bool SameImpulses(const std::vector<ContactManifold>& a,
+                         const std::vector<ContactManifold>& b) {
+    for (size_t i = 0; i < a.size(); i++) {
+        for (uint32_t k = 0; k < a[i].m_point_count; k++) {
+            const ContactPoint& pa = a[i].m_points[k];
+            const ContactPoint& pb = b[i].m_points[k];
+            if (std::memcmp(&pa.m_normal_impulse, &pb.m_normal_impulse,
+                            sizeof(float)) != 0 ||
+                std::memcmp(pa.m_tangent_impulse.data(),
+                            pb.m_tangent_impulse.data(),
+                            2 * sizeof(float)) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// impulses push apart and the stack stays close to rest
+static bool Plausible(const Result& result) {
+    for (const ContactManifold& manifold : result.m_manifolds) {
+        for (uint32_t k = 0; k < manifold.m_point_count; k++) {
+            if (!(manifold.m_points[k].m_normal_impulse >= 0)) {
+                return false;
+            }
+        }
+    }
+    for (const Eigen::Vector3f& v : result.m_velocities) {
+        if (!(v.norm() < 1.0f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    Scene scene;
+    int failures = 0;
+    for (uint32_t max_colors : MaxColors) {
+        Result reference = Solve(scene, SimdLevel::Scalar, 1, max_colors);
+        if (!Plausible(reference)) {
+            std::printf("%u colors: scalar result is off\n", max_colors);
+            failures++;
+        }
+        for (SimdLevel level : Levels) {
+            for (uint32_t threads : ThreadCounts) {
+                Result result = Solve(scene, level, threads, max_colors);
+                if (!SameBits(reference.m_velocities, result.m_velocities) ||
+                    !SameBits(reference.m_angular_velocities,
+                              result.m_angular_velocities) ||
+                    !SameImpulses(reference.m_manifolds,
+                                  result.m_manifolds)) {
+                    std::printf(
+                        "%u colors: %s on %u threads differs from scalar\n",
+                        max_colors, GetSimdLevelName(level), threads);
+                    failures++;
+                }
+            }
+        }
+    }
+    if (failures) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("colored solves match at every simd level, best is %s, "
+                "%zu manifolds\n",
+                GetSimdLevelName(GetSimdLevel()), scene.m_manifolds.size());
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "toy_physics/stepper.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace toy_physics;
+
+// fixed steps from variable frame times: the step cap after a hitch,
+// substeps, the interpolation factor, bodies without a previous pose and
+// interpolation across an automatic origin rebase
+
+constexpr float FixedDeltaTime = 1.0f / 60.0f;
+
+struct Checker {
+    int m_failures = 0;
+
+    void Expect(bool ok, const char* what) {
+        if (!ok) {
+            std::printf("%s\n", what);
+            m_failures++;
+        }
+    }
+};
+
+static BodyHandle CreateSphere(World& world, const Eigen::Vector3f& position,
+                               float inv_mass = 1) {
+    Body body;
+    body.m_inv_mass = inv_mass;
+    body.m_pose.m_position = position;
+    body.m_geometry.m_geom = world.GetGeometryPool().Add(SphereGeometry{0.5f});
+    return world.CreateBody(body);
+}
+
+static bool Near(const Eigen::Vector3f& a, const Eigen::Vector3f& b,
+                 float tolerance = 1e-4f) {
+    return (a - b).cwiseAbs().maxCoeff() <= tolerance;
+}
+
+// a free falling body tells how much time was simulated
+static void CheckHitch(Checker& checker) {
+    World world{Broadphase::Type::Tree, 1};
+    BodyHandle body = CreateSphere(world, Eigen::Vector3f::Zero());
+    FixedStepper stepper{world, FixedDeltaTime};
+    stepper.m_max_steps = 4;
+
+    checker.Expect(stepper.Advance(1.0f) == 4, "a hitch runs m_max_steps");
+    checker.Expect(stepper.GetAlpha() < 1e-3f, "time past the cap is dropped");
+    checker.Expect(stepper.Advance(0) == 0, "dropped time never comes back");
+    float velocity = world.GetVelocity(body).y();
+    checker.Expect(std::abs(velocity - world.m_gravity.y() * 4 *
+                                           FixedDeltaTime) < 1e-4f,
+                   "the world ran four fixed steps");
+}
+
+// semi-implicit Euler falls g * h^2 * n * (n + 1) / 2 in n steps of h, so
+// the distance tells the substep count apart from the step length
+static void CheckSubsteps(Checker& checker) {
+    for (uint32_t substeps : {1u, 3u}) {
+        World world{Broadphase::Type::Tree, 1};
+        BodyHandle body = CreateSphere(world, Eigen::Vector3f::Zero());
+        FixedStepper stepper{world, FixedDeltaTime};
+        stepper.m_substeps = substeps;
+
+        checker.Expect(stepper.Advance(FixedDeltaTime * 1.5f) == 1,
+                       "substeps count as one fixed step");
+        float h = FixedDeltaTime / substeps;
+        float expected =
+            world.m_gravity.y() * h * h * substeps * (substeps + 1) * 0.5f;
+        checker.Expect(
+            std::abs(world.GetPose(body).m_position.y() - expected) < 1e-6f,
+            "every substep runs as a world step");
+        checker.Expect(std::abs(world.GetVelocity(body).y() -
+                                world.m_gravity.y() * FixedDeltaTime) < 1e-5f,
+                       "substeps cover one fixed step");
+    }
+}
+
+static void CheckAlpha(Checker& checker) {
+    World world{Broadphase::Type::Tree, 1};
+    CreateSphere(world, Eigen::Vector3f::Zero());
+    FixedStepper stepper{world, FixedDeltaTime};
+
+    stepper.Advance(FixedDeltaTime * 0.5f);
+    checker.Expect(std::abs(stepper.GetAlpha() - 0.5f) < 1e-4f,
+                   "alpha is the accumulated fraction of a step");
+
+    std::mt19937 random{3};
+    std::uniform_real_distribution<float> frame{0, FixedDeltaTime * 6};
+    bool in_range = true;
+    for (int i = 0; i < 1000; i++) {
+        stepper.Advance(i % 100 == 0 ? -1.0f : frame(random));
+        float alpha = stepper.GetAlpha();
+        in_range = in_range && alpha >= 0 && alpha <= 1;
+    }
+    checker.Expect(in_range, "alpha stays in [0, 1]");
+}
+
+// bodies created, woken or reusing a slot between steps have no pose from
+// the last step and are drawn where they are
+static void CheckNewBodies(Checker& checker) {
+    World world{Broadphase::Type::Tree, 1};
+    CreateSphere(world, {0, -50.5f, 0}, 0);
+    BodyHandle resting = CreateSphere(world, {0, -49.5f, 0});
+    BodyHandle falling = CreateSphere(world, {10, 0, 0});
+    BodyHandle removed = CreateSphere(world, {20, 0, 0});
+    FixedStepper stepper{world, FixedDeltaTime};
+    for (int i = 0; i < 120 && !world.IsSleeping(resting); i++) {
+        stepper.Advance(FixedDeltaTime);
+    }
+    checker.Expect(world.IsSleeping(resting), "the resting body sleeps");
+
+    stepper.Advance(FixedDeltaTime * 1.5f);
+    world.WakeUp(resting);
+    world.RemoveBody(removed);
+    BodyHandle reused = CreateSphere(world, {30, 0, 0});
+    BodyHandle created = CreateSphere(world, {40, 0, 0});
+    checker.Expect(reused.m_index == removed.m_index,
+                   "the new body reuses the removed slot");
+
+    for (BodyHandle body : {resting, reused, created}) {
+        checker.Expect(stepper.GetInterpolatedPose(body).m_position ==
+                           world.GetPose(body).m_position,
+                       "bodies without a previous pose are not lerped");
+    }
+    Pose pose = stepper.GetInterpolatedPose(falling);
+    checker.Expect(pose.m_position.y() > world.GetPose(falling).m_position.y(),
+                   "falling bodies are drawn between the last two steps");
+
+    std::vector<Pose> poses;
+    stepper.GetInterpolatedPoses(poses);
+    bool same = poses.size() == world.GetBodyCount();
+    for (uint32_t i = 0; same && i < poses.size(); i++) {
+        Pose single = stepper.GetInterpolatedPose(world.GetHandle(i));
+        same = Near(poses[i].m_position, single.m_position);
+    }
+    checker.Expect(same, "batched and single interpolation agree");
+
+    // one step later the new bodies have a previous pose of their own
+    stepper.Advance(FixedDeltaTime);
+    pose = stepper.GetInterpolatedPose(created);
+    checker.Expect(pose.m_position.y() > world.GetPose(created).m_position.y(),
+                   "created bodies are lerped after their first step");
+}
+
+// a body flying at constant speed through small regions makes the world
+// rebase while the stepper holds poses in the old frame
+static void CheckRebase(Checker& checker) {
+    World world{Broadphase::Type::Tree, 1};
+    world.m_gravity = Eigen::Vector3f::Zero();
+    world.m_region_size = 16;
+    Body body;
+    body.m_inv_mass = 1;
+    body.m_velocity = {300, 0, 0};
+    body.m_geometry.m_geom = world.GetGeometryPool().Add(SphereGeometry{0.5f});
+    BodyHandle handle = world.CreateBody(body);
+    FixedStepper stepper{world, FixedDeltaTime};
+
+    int rebases = 0;
+    bool continuous = true;
+    for (int i = 0; i < 30; i++) {
+        Eigen::Vector3d origin = world.GetOrigin();
+        stepper.Advance(FixedDeltaTime * (i % 2 ? 0.75f : 1.25f));
+        rebases += world.GetOrigin() != origin;
+
+        Eigen::Vector3d current =
+            world.ToWorld(world.GetPose(handle).m_position);
+        Eigen::Vector3d interpolated =
+            world.ToWorld(stepper.GetInterpolatedPose(handle).m_position);
+        double behind = (1 - stepper.GetAlpha()) * 300.0 * FixedDeltaTime;
+        continuous = continuous &&
+                     std::abs(current.x() - behind - interpolated.x()) < 1e-2;
+    }
+    checker.Expect(rebases > 0, "the world rebased on its own");
+    checker.Expect(continuous, "interpolation follows the origin shift");
+}
+
+int main() {
+    Checker checker;
+    CheckHitch(checker);
+    CheckSubsteps(checker);
+    CheckAlpha(checker);
+    CheckNewBodies(checker);
+    CheckRebase(checker);
+    if (checker.m_failures) {
+        std::printf("%d checks failed\n", checker.m_failures);
+        return 1;
+    }
+    std::printf("fixed steps and interpolation hold up\n");
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include "toy_physics/world.hpp"
+
+#include <cstdio>
+#include <vector>
+
+using namespace toy_physics;
+
+// generational handles and the dense body columns behind them: removing
+// swaps the last body into the hole, slots are reused with a new
+// generation, and handles of removed bodies stay rejected
+
+struct Checker {
+    int m_failures = 0;
+
+    void Expect(bool ok, const char* what) {
+        if (!ok) {
+            std::printf("%s\n", what);
+            m_failures++;
+        }
+    }
+};
+
+struct Tracked {
+    BodyHandle m_handle;
+    Eigen::Vector3f m_position;
+};
+
+static Tracked CreateBody(World& world, float x, bool dynamic) {
+    Body body;
+    body.m_inv_mass = dynamic ? 1.0f : 0.0f;
+    body.m_pose.m_position = {x, 0, 0};
+    body.m_geometry.m_geom =
+        world.GetGeometryPool().Add(SphereGeometry{0.25f});
+    return {world.CreateBody(body), body.m_pose.m_position};
+}
+
+// every live handle and every dense index have to point at each other
+static bool IsConsistent(const World& world,
+                         const std::vector<Tracked>& bodies) {
+    if (world.GetBodyCount() != bodies.size() ||
+        world.GetBodies().Size() != bodies.size()) {
+        return false;
+    }
+    for (const Tracked& tracked : bodies) {
+        if (!world.IsValid(tracked.m_handle)) {
+            return false;
+        }
+        uint32_t dense = world.GetDenseIndex(tracked.m_handle);
+        Pose pose = world.GetPose(tracked.m_handle);
+        if (world.GetHandle(dense) != tracked.m_handle ||
+            world.GetBodies().m_slots[dense] != tracked.m_handle.m_index ||
+            pose.m_position != tracked.m_position) {
+            return false;
+        }
+        bool dynamic = world.GetBodies().m_inv_masses[dense] != 0;
+        if (dynamic != (dense < world.GetAwakeBodyCount())) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < world.GetBodies().Size(); i++) {
+        if (world.GetDenseIndex(world.GetHandle(i)) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void CheckSwapRemove(Checker& checker) {
+    World world{Broadphase::Type::Tree, 1};
+    std::vector<Tracked> bodies;
+    for (int i = 0; i < 12; i++) {
+        bodies.push_back(CreateBody(world, i * 2.0f, i % 3 != 0));
+    }
+    checker.Expect(IsConsistent(world, bodies), "created bodies are indexed");
+
+    // first, last and middle of both the awake and the static range
+    for (int i = 0; i < 4; i++) {
+        uint32_t awake = static_cast<uint32_t>(world.GetAwakeBodyCount());
+        uint32_t last = static_cast<uint32_t>(world.GetBodyCount() - 1);
+        uint32_t dense = i == 0   ? 0
+                         : i == 1 ? last
+                         : i == 2 ? awake / 2
+                                  : awake;
+        BodyHandle removed = world.GetHandle(dense);
+        world.RemoveBody(removed);
+        std::erase_if(bodies, [&](const Tracked& tracked) {
+            return tracked.m_handle == removed;
+        });
+        checker.Expect(!world.IsValid(removed), "removed handle is rejected");
+        checker.Expect(IsConsistent(world, bodies),
+                       "swap-remove keeps slots and dense indices in sync");
+    }
+}
+
+static void CheckStaleHandles(Checker& checker) {
+    World world{Broadphase::Type::Tree, 1};
+    std::vector<Tracked> bodies;
+    for (int i = 0; i < 4; i++) {
+        bodies.push_back(CreateBody(world, i * 2.0f, true));
+    }
+
+    BodyHandle stale = bodies[1].m_handle;
+    world.RemoveBody(stale);
+    bodies.erase(bodies.begin() + 1);
+    checker.Expect(!world.IsValid(stale), "removed handle is rejected");
+    checker.Expect(world.GetDenseIndex(stale) == BodyHandle::InvalidIndex,
+                   "removed handle has no dense index");
+    checker.Expect(!world.IsValid(BodyHandle{}), "default handle is rejected");
+    checker.Expect(!world.IsValid(BodyHandle{100, 0}),
+                   "handle past the slots is rejected");
+
+    // removing twice must not take another body with it
+    world.RemoveBody(stale);
+    checker.Expect(IsConsistent(world, bodies),
+                   "removing a stale handle changes nothing");
+
+    // the freed slot comes back with a new generation
+    Tracked reused = CreateBody(world, 20, true);
+    bodies.push_back(reused);
+    checker.Expect(reused.m_handle.m_index == stale.m_index,
+                   "freed slot is reused");
+    checker.Expect(reused.m_handle.m_generation != stale.m_generation,
+                   "reused slot gets a new generation");
+    checker.Expect(!world.IsValid(stale), "old handle stays rejected");
+    checker.Expect(world.GetPose(stale).m_position != reused.m_position,
+                   "old handle doesn't reach the new body");
+    world.SetPose(stale, {{-5, -5, -5}, Eigen::Quaternionf::Identity()});
+    world.RemoveBody(stale);
+    checker.Expect(IsConsistent(world, bodies),
+                   "writes through the old handle are ignored");
+}
+
+static void CheckReserve(Checker& checker) {
+    World world{Broadphase::Type::Tree, 1};
+    world.Reserve(64);
+    const BodyColumns& columns = world.GetBodies();
+    checker.Expect(columns.m_positions.capacity() >= 64 &&
+                       columns.m_slots.capacity() >= 64 &&
+                       columns.m_bullets.capacity() >= 64,
+                   "reserve sizes the columns");
+
+    std::vector<Tracked> bodies{CreateBody(world, 0, true)};
+    const Eigen::Vector3f* positions = columns.m_positions.data();
+    const uint32_t* slots = columns.m_slots.data();
+    for (int i = 1; i < 64; i++) {
+        bodies.push_back(CreateBody(world, i * 2.0f, i % 2 == 0));
+    }
+    checker.Expect(columns.m_positions.data() == positions &&
+                       columns.m_slots.data() == slots,
+                   "reserved columns don't reallocate");
+    checker.Expect(IsConsistent(world, bodies),
+                   "bodies created after reserve are indexed");
+}
+
+int main() {
+    Checker checker;
+    CheckSwapRemove(checker);
+    CheckStaleHandles(checker);
+    CheckReserve(checker);
+    if (checker.m_failures) {
+        std::printf("%d checks failed\n", checker.m_failures);
+        return 1;
+    }
+    std::printf("handles and dense columns stay consistent\n");
+    return 0;
+}
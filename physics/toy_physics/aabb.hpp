@@ -0,0 +1,88 @@
+#pragma once
+#include "toy_physics/geometry.hpp"
+#include "toy_physics/pose.hpp"
+
+#include <algorithm>
+
+namespace toy_physics {
+
+struct AABB {
+    Eigen::Vector3f m_min = Eigen::Vector3f::Zero();
+    Eigen::Vector3f m_max = Eigen::Vector3f::Zero();
+
+    // non short-circuit on purpose, broadphase results are unpredictable
+    // and a branch per axis mispredicts constantly
+    bool Intersect(const AABB& o) const {
+        return (m_min.x() <= o.m_max.x()) & (o.m_min.x() <= m_max.x()) &
+               (m_min.y() <= o.m_max.y()) & (o.m_min.y() <= m_max.y()) &
+               (m_min.z() <= o.m_max.z()) & (o.m_min.z() <= m_max.z());
+    }
+
+    bool Contains(const AABB& o) const {
+        return (m_min.array() <= o.m_min.array()).all() &&
+               (o.m_max.array() <= m_max.array()).all();
+    }
+
+    AABB Union(const AABB& o) const {
+        return {m_min.cwiseMin(o.m_min), m_max.cwiseMax(o.m_max)};
+    }
+
+    AABB Expand(float margin) const {
+        Eigen::Vector3f offset = Eigen::Vector3f::Constant(margin);
+        return {m_min - offset, m_max + offset};
+    }
+
+    AABB Translate(const Eigen::Vector3f& offset) const {
+        return {m_min + offset, m_max + offset};
+    }
+
+    // covers the box along its whole move by offset
+    AABB Sweep(const Eigen::Vector3f& offset) const {
+        return {m_min + offset.cwiseMin(0.0f), m_max + offset.cwiseMax(0.0f)};
+    }
+
+    float SurfaceArea() const {
+        Eigen::Vector3f d = m_max - m_min;
+        return 2.0f * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+    }
+
+    Eigen::Vector3f GetCenter() const { return (m_min + m_max) * 0.5f; }
+
+    Eigen::Vector3f GetHalfSize() const { return (m_max - m_min) * 0.5f; }
+};
+
+// segment from m_origin to m_origin + m_delta * m_max_fraction. Boxes are
+// grown by m_extent before the test, so swept shapes traverse like rays. A
+// negative m_max_fraction retires the cast
+struct AABBCast {
+    Eigen::Vector3f m_origin = Eigen::Vector3f::Zero();
+    Eigen::Vector3f m_delta = Eigen::Vector3f::Zero();
+    Eigen::Vector3f m_inv_delta = Eigen::Vector3f::Zero();
+    Eigen::Vector3f m_extent = Eigen::Vector3f::Zero();
+    float m_max_fraction = 1;
+
+    static AABBCast Make(const Eigen::Vector3f& origin,
+                         const Eigen::Vector3f& delta,
+                         const Eigen::Vector3f& extent);
+
+    // slab test
+    bool Intersect(const AABB& aabb) const {
+        Eigen::Array3f lo =
+            (aabb.m_min - m_extent - m_origin).array() * m_inv_delta.array();
+        Eigen::Array3f hi =
+            (aabb.m_max + m_extent - m_origin).array() * m_inv_delta.array();
+        float enter = std::max(lo.min(hi).maxCoeff(), 0.0f);
+        float exit = std::min(lo.max(hi).minCoeff(), m_max_fraction);
+        return enter <= exit;
+    }
+
+    // bounds of the whole remaining segment
+    AABB GetBounds() const;
+};
+
+AABB ComputeAABB(const BoxGeometry& box, const Pose& pose);
+AABB ComputeAABB(const SphereGeometry& sphere, const Pose& pose);
+AABB ComputeAABB(const CapsuleGeometry& capsule, const Pose& pose);
+AABB ComputeAABB(const Geometry& geom, const Pose& pose);
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace toy_physics {
+
+// linear allocator for data that only lives for one step. Allocation bumps
+// an offset, nothing is freed until Reset(). Not thread safe, every worker
+// gets its own
+class FrameArena {
+public:
+    explicit FrameArena(size_t block_size = 64 * 1024);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* Allocate(size_t size, size_t alignment);
+
+    // frees everything at once. When the step needed more than one block
+    // they are merged, so the next step of the same size stays in one block
+    // and never touches the heap
+    void Reset();
+
+    size_t GetUsedBytes() const { return m_used + m_offset; }
+    size_t GetCapacity() const;
+
+private:
+    struct Block {
+        std::byte* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    std::vector<Block> m_blocks;
+    size_t m_block_size;
+    size_t m_current = 0;
+    size_t m_offset = 0;
+    // bytes handed out from blocks before m_current
+    size_t m_used = 0;
+
+    void addBlock(size_t min_size);
+};
+
+// std allocator over a FrameArena, deallocation is a no-op. A default
+// constructed allocator falls back to the heap. Containers using it must be
+// rebound to a fresh allocator after the arena was reset, their old storage
+// is simply dropped, so only trivially destructible elements are allowed
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() = default;
+    explicit ArenaAllocator(FrameArena& arena) : m_arena{&arena} {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& o) : m_arena{o.GetArena()} {}
+
+    T* allocate(size_t n) {
+        if (!m_arena) {
+            return std::allocator<T>{}.allocate(n);
+        }
+        return static_cast<T*>(m_arena->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (!m_arena) {
+            std::allocator<T>{}.deallocate(p, n);
+        }
+    }
+
+    FrameArena* GetArena() const { return m_arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& o) const {
+        return m_arena == o.GetArena();
+    }
+
+private:
+    FrameArena* m_arena = nullptr;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// binds a per step container to an arena, dropping its previous storage
+template <typename T>
+void BindToArena(ArenaVector<T>& vector, FrameArena& arena) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "arena storage is dropped without running destructors");
+    vector = ArenaVector<T>{ArenaAllocator<T>{arena}};
+}
+
+// heap allocations made on threads inside an AllocationScope, and by jobs
+// submitted from one. Only counted when the library is built with
+// TOY_PHYSICS_TRACK_ALLOCATIONS, otherwise always zero
+uint64_t GetTrackedAllocationCount();
+// whether the library was built to count allocations at all
+bool IsAllocationTrackingCompiled();
+// whether the calling thread is inside an AllocationScope
+bool IsInAllocationScope();
+
+class AllocationScope {
+public:
+    AllocationScope();
+    ~AllocationScope();
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+};
+
+}
@@ -1,13 +1,29 @@
 #pragma once
 #include "shape.hpp"
 
+#include <cstdint>
+
 namespace toy_physics {
 
+struct BodyHandle {
+    static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+    uint32_t m_index = InvalidIndex;
+    uint32_t m_generation = 0;
+
+    bool operator==(const BodyHandle&) const noexcept = default;
+
+    explicit operator bool() const noexcept { return m_index != InvalidIndex; }
+};
+
 struct Body {
     Pose m_pose;
-    Eigen::Vector3f m_velocity;
+    Eigen::Vector3f m_velocity = Eigen::Vector3f::Zero();
+    Eigen::Vector3f m_angular_velocity = Eigen::Vector3f::Zero();
     float m_inv_mass = 0.0;
-    
+    // always swept by continuous collision, for small fast projectiles
+    bool m_bullet = false;
+
     Shape m_geometry;
 };
 
@@ -0,0 +1,82 @@
+#pragma once
+#include "toy_physics/aabb.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace toy_physics {
+
+// ids are whatever the owner registered the proxy with, m_a < m_b
+struct BroadphasePair {
+    uint32_t m_a;
+    uint32_t m_b;
+
+    bool operator==(const BroadphasePair&) const noexcept = default;
+};
+
+inline bool operator<(const BroadphasePair& p1, const BroadphasePair& p2) {
+    return p1.m_a < p2.m_a || (p1.m_a == p2.m_a && p1.m_b < p2.m_b);
+}
+
+class Broadphase {
+public:
+    enum class Type {
+        Tree,
+        SweepAndPrune,
+        HashGrid,
+    };
+
+    virtual ~Broadphase() = default;
+    virtual Type GetType() const = 0;
+
+    virtual void Add(uint32_t id, const AABB& aabb) = 0;
+    virtual void Remove(uint32_t id) = 0;
+    // displacement is the predicted motion until the next update. Pairs
+    // and queries cover the box swept by it, so a fast body is paired with
+    // what it moves into and gets a speculative contact
+    virtual void Update(uint32_t id, const AABB& aabb,
+                        const Eigen::Vector3f& displacement) = 0;
+    virtual bool Contains(uint32_t id) const = 0;
+    // moves every proxy by offset after the owner moved its origin, the
+    // pairs stay the same
+    virtual void ShiftOrigin(const Eigen::Vector3f& offset) = 0;
+    // resting proxies, static or sleeping ones, are kept apart from the
+    // active ones and only revisited when one of them changes. Pairs of two
+    // resting proxies are never reported. Proxies are added active
+    virtual void SetResting(uint32_t id, bool resting) = 0;
+
+    // refresh the list of overlapping pairs with at least one active proxy.
+    // Pair order is deterministic but backend specific
+    virtual void UpdatePairs() = 0;
+    virtual const std::vector<BroadphasePair>& GetPairs() const = 0;
+
+    // callback(id) returns false to stop the query
+    virtual void Query(const AABB& aabb,
+                       const std::function<bool(uint32_t)>& callback) const = 0;
+
+    // callback(cast, id) for every proxy a cast of the packet crosses, at
+    // most MaxCastPacket casts. The callback may shorten or retire its cast.
+    // Backends without a packet traversal query each cast's bounds
+    static constexpr uint32_t MaxCastPacket = 32;
+    virtual void CastQuery(
+        AABBCast* casts, uint32_t count,
+        const std::function<void(uint32_t, uint32_t)>& callback) const;
+
+    // raw state for world snapshots, only loaded by the same backend type.
+    // Backends that are cheap to rebuild return false and get their proxies
+    // added again instead
+    virtual bool SaveState(std::vector<std::byte>& out) const;
+    virtual bool LoadState(std::span<const std::byte> data);
+};
+
+class JobSystem;
+
+// job_system is optional, backends that can run in parallel use it
+std::unique_ptr<Broadphase> CreateBroadphase(Broadphase::Type type,
+                                             JobSystem* job_system = nullptr);
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "toy_physics/contact.hpp"
+#include "toy_physics/geometry.hpp"
+#include "toy_physics/gjk.hpp"
+#include "toy_physics/pose.hpp"
+
+namespace toy_physics {
+
+// single pair contact generation. Every function fills the manifold normal
+// (pointing from the first shape to the second) and points, and returns
+// false when the shapes are further apart than margin
+
+bool CollideSphereSphere(const SphereGeometry& a, const Pose& pose_a,
+                         const SphereGeometry& b, const Pose& pose_b,
+                         float margin, ContactManifold& manifold);
+bool CollideBoxSphere(const BoxGeometry& a, const Pose& pose_a,
+                      const SphereGeometry& b, const Pose& pose_b,
+                      float margin, ContactManifold& manifold);
+// GJK/EPA based, cache warm starts GJK with last step's simplex
+bool CollideBoxCapsule(const BoxGeometry& a, const Pose& pose_a,
+                       const CapsuleGeometry& b, const Pose& pose_b,
+                       float margin, ContactManifold& manifold,
+                       SimplexCache* cache = nullptr);
+bool CollideSphereCapsule(const SphereGeometry& a, const Pose& pose_a,
+                          const CapsuleGeometry& b, const Pose& pose_b,
+                          float margin, ContactManifold& manifold);
+bool CollideCapsuleCapsule(const CapsuleGeometry& a, const Pose& pose_a,
+                           const CapsuleGeometry& b, const Pose& pose_b,
+                           float margin, ContactManifold& manifold);
+bool CollideBoxBox(const BoxGeometry& a, const Pose& pose_a,
+                   const BoxGeometry& b, const Pose& pose_b, float margin,
+                   ContactManifold& manifold);
+
+// single point contact for any pair of convex shapes through GJK/EPA
+bool CollideConvexShapes(const Geometry& a, const Pose& pose_a,
+                         const Geometry& b, const Pose& pose_b, float margin,
+                         ContactManifold& manifold,
+                         SimplexCache* cache = nullptr);
+
+// closest points between segments p1q1 and p2q2, returns the segment
+// parameters
+void ClosestPointsSegmentSegment(const Eigen::Vector3f& p1,
+                                 const Eigen::Vector3f& q1,
+                                 const Eigen::Vector3f& p2,
+                                 const Eigen::Vector3f& q2, float& s,
+                                 float& t);
+
+// world space end points of the capsule's inner segment
+void GetCapsuleSegment(const CapsuleGeometry& capsule, const Pose& pose,
+                       Eigen::Vector3f& p, Eigen::Vector3f& q);
+
+}
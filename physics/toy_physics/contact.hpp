@@ -0,0 +1,46 @@
+#pragma once
+#include "Eigen/Dense"
+
+#include <array>
+#include <cstdint>
+
+namespace toy_physics {
+
+struct ContactPoint {
+    // world space, halfway between the two surfaces
+    Eigen::Vector3f m_position = Eigen::Vector3f::Zero();
+    // > 0 when penetrating, < 0 for speculative contacts
+    float m_depth = 0;
+    // identifies the feature pair that produced the point so it can be
+    // matched across frames
+    uint32_t m_feature = 0;
+
+    // accumulated solver impulses, carried over from the matching point of
+    // the previous step for warm starting
+    float m_normal_impulse = 0;
+    std::array<float, 2> m_tangent_impulse{};
+};
+
+struct ContactManifold {
+    static constexpr uint32_t MaxPoints = 4;
+
+    uint32_t m_body_a = 0;
+    uint32_t m_body_b = 0;
+    // points from A to B
+    Eigen::Vector3f m_normal = Eigen::Vector3f::UnitY();
+    std::array<ContactPoint, MaxPoints> m_points;
+    uint32_t m_point_count = 0;
+
+    void AddPoint(const Eigen::Vector3f& position, float depth,
+                  uint32_t feature) {
+        if (m_point_count < MaxPoints) {
+            ContactPoint& point = m_points[m_point_count++];
+            point = {};
+            point.m_position = position;
+            point.m_depth = depth;
+            point.m_feature = feature;
+        }
+    }
+};
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "toy_physics/simd.hpp"
+
+#include <vector>
+
+namespace toy_physics {
+
+// structure of arrays pair batches for the wide contact kernels
+struct SpherePairBatch {
+    Vec3Column m_center_a;
+    Vec3Column m_center_b;
+    std::vector<float> m_radius_a;
+    std::vector<float> m_radius_b;
+
+    size_t Size() const { return m_radius_a.size(); }
+    void Clear();
+    void Push(const Eigen::Vector3f& center_a, float radius_a,
+              const Eigen::Vector3f& center_b, float radius_b);
+};
+
+struct CapsulePairBatch {
+    // inner segment end points
+    Vec3Column m_p1, m_q1;
+    Vec3Column m_p2, m_q2;
+    std::vector<float> m_radius_a;
+    std::vector<float> m_radius_b;
+
+    size_t Size() const { return m_radius_a.size(); }
+    void Clear();
+    void Push(const Eigen::Vector3f& p1, const Eigen::Vector3f& q1,
+              float radius_a, const Eigen::Vector3f& p2,
+              const Eigen::Vector3f& q2, float radius_b);
+};
+
+// one closest contact per pair, depth < -margin means separated.
+// Normal points from A to B, UnitY when the closest points coincide
+struct ContactBatch {
+    Vec3Column m_normal;
+    Vec3Column m_position;
+    std::vector<float> m_depth;
+
+    size_t Size() const { return m_depth.size(); }
+    void Resize(size_t count);
+};
+
+// every level gives bit identical results, the scalar path is the
+// reference. A level the cpu can't run falls back to GetSimdLevel()
+void CollideSphereBatch(const SpherePairBatch& batch, ContactBatch& contacts,
+                        SimdLevel level = GetSimdLevel());
+void CollideCapsuleBatch(const CapsulePairBatch& batch,
+                         ContactBatch& contacts,
+                         SimdLevel level = GetSimdLevel());
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "toy_physics/contact.hpp"
+#include "toy_physics/gjk.hpp"
+#include "toy_physics/pair_map.hpp"
+
+#include <vector>
+
+namespace toy_physics {
+
+struct ContactCacheEntry {
+    SimplexCache m_simplex;
+    // manifold of the step m_manifold_step, with final solver impulses
+    ContactManifold m_manifold;
+    uint32_t m_manifold_step = 0;
+    uint32_t m_touched_step = 0;
+};
+
+struct ContactCacheRecord {
+    uint64_t m_key;
+    ContactCacheEntry m_entry;
+};
+
+// per shape pair state that survives between steps, keyed by stable ids.
+// Pairs not touched during a step are dropped by the next BeginStep(),
+// unless both ids rest. Resting pairs are never collided, they keep their
+// manifold and impulses for the warm start after they wake
+class ContactCache {
+public:
+    // entry of the pair, created when new. Marks the pair as alive
+    ContactCacheEntry& Touch(uint32_t id_a, uint32_t id_b);
+    // nullptr for unknown pairs. Never inserts, so threads may look up
+    // different pairs at once
+    ContactCacheEntry* Find(uint32_t id_a, uint32_t id_b);
+
+    // copies the accumulated impulses of last step's matching points into
+    // manifold and remembers it. Points match by feature id first, then by
+    // the closest old point within m_match_distance
+    void WarmStart(uint32_t id_a, uint32_t id_b, ContactManifold& manifold);
+
+    // writes solved impulses back so the next step starts from them
+    void StoreImpulses(uint32_t id_a, uint32_t id_b,
+                       const ContactManifold& manifold);
+
+    // drops every pair of id at the next BeginStep(), before the id can
+    // be reused by another shape
+    void RemoveId(uint32_t id);
+
+    // sleeping and static shapes rest, mirrors Broadphase::SetResting()
+    void SetResting(uint32_t id, bool resting);
+
+    void BeginStep();
+    // keeps the remembered points matching after the owner moved its origin
+    void ShiftOrigin(const Eigen::Vector3f& offset);
+
+    size_t Size() const { return m_entries.Size(); }
+
+    // flat copy of the pairs and the step counter, for world snapshots.
+    // Resting flags are not saved, Load() clears them
+    void Save(std::vector<ContactCacheRecord>& records) const;
+    void Load(const ContactCacheRecord* records, size_t count, uint32_t step);
+    uint32_t GetStep() const { return m_step; }
+
+    float m_match_distance = 0.05f;
+
+private:
+    PairMap<ContactCacheEntry> m_entries;
+    uint32_t m_step = 1;
+    // one flag per id passed to RemoveId() since the last BeginStep()
+    std::vector<uint8_t> m_removed;
+    size_t m_removed_count = 0;
+    std::vector<uint8_t> m_resting;  // id -> SetResting() flag
+
+    bool isRemoved(uint64_t key) const;
+    bool isResting(uint64_t key) const;
+};
+
+}
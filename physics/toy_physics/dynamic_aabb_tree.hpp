@@ -0,0 +1,184 @@
+#pragma once
+#include "toy_physics/aabb.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace toy_physics {
+
+// stack that lives on the call stack for shallow traversals and only
+// touches the heap for pathological trees
+template <typename T, size_t N>
+class GrowableStack {
+public:
+    void Push(const T& value) {
+        if (m_heap.empty() && m_count < N) {
+            m_inline[m_count++] = value;
+            return;
+        }
+        if (m_heap.empty()) {
+            m_heap.assign(m_inline.begin(), m_inline.begin() + m_count);
+        }
+        m_heap.push_back(value);
+        m_count++;
+    }
+
+    T Pop() {
+        m_count--;
+        if (m_heap.empty()) {
+            return m_inline[m_count];
+        }
+        T value = m_heap.back();
+        m_heap.pop_back();
+        return value;
+    }
+
+    bool Empty() const { return m_count == 0; }
+
+private:
+    std::array<T, N> m_inline;
+    std::vector<T> m_heap;
+    size_t m_count = 0;
+};
+
+// bounding volume hierarchy whose leaves hold fat AABBs. Leaves are only
+// reinserted when their tight AABB escapes the fat one, and the tree is kept
+// balanced with AVL style rotations on every insert/remove
+class DynamicAABBTree {
+public:
+    static constexpr uint32_t NullNode = UINT32_MAX;
+
+    struct Node {
+        AABB m_aabb;
+        // parent when in tree, next free node when in free list
+        uint32_t m_parent = NullNode;
+        uint32_t m_child1 = NullNode;
+        uint32_t m_child2 = NullNode;
+        int32_t m_height = -1;
+        uint32_t m_user_data = 0;
+
+        bool IsLeaf() const { return m_child1 == NullNode; }
+    };
+
+
+    uint32_t CreateProxy(const AABB& aabb, uint32_t user_data);
+    void DestroyProxy(uint32_t proxy);
+
+    // returns true if the proxy left its fat AABB and got reinserted
+    bool MoveProxy(uint32_t proxy, const AABB& aabb,
+                   const Eigen::Vector3f& displacement);
+    // moves every node, the structure stays as it is
+    void ShiftOrigin(const Eigen::Vector3f& offset);
+
+    const AABB& GetFatAABB(uint32_t proxy) const {
+        return m_nodes[proxy].m_aabb;
+    }
+
+    uint32_t GetUserData(uint32_t proxy) const {
+        return m_nodes[proxy].m_user_data;
+    }
+
+    uint32_t GetRoot() const { return m_root; }
+
+    int32_t GetHeight() const;
+    size_t GetProxyCount() const { return m_proxy_count; }
+
+    // raw node storage, for saving a tree and restoring it as it was.
+    // Restore() checks the links and heights and leaves the tree as it was
+    // when they don't form a valid tree
+    const std::vector<Node>& GetNodes() const { return m_nodes; }
+    uint32_t GetFreeList() const { return m_free_list; }
+    bool Restore(std::vector<Node> nodes, uint32_t root, uint32_t free_list,
+                 size_t proxy_count);
+
+    // callback(proxy) returns false to stop the query
+    template <typename F>
+    void Query(const AABB& aabb, F&& callback) const {
+        GrowableStack<uint32_t, 256> stack;
+        stack.Push(m_root);
+        while (!stack.Empty()) {
+            uint32_t index = stack.Pop();
+            if (index == NullNode) {
+                continue;
+            }
+
+            const Node& node = m_nodes[index];
+            if (!node.m_aabb.Intersect(aabb)) {
+                continue;
+            }
+
+            if (node.IsLeaf()) {
+                if (!callback(index)) {
+                    return;
+                }
+            } else {
+                stack.Push(node.m_child1);
+                stack.Push(node.m_child2);
+            }
+        }
+    }
+
+    // walks the tree with a packet of casts at once, a node is opened when
+    // any live cast of the packet crosses it and only those casts are
+    // tested below it. At most 32 casts, one bit each in the traversal
+    // masks. callback(cast, proxy) may shorten or retire its cast
+    template <typename F>
+    void CastQuery(AABBCast* casts, uint32_t count, F&& callback) const {
+        struct Entry {
+            uint32_t m_node;
+            uint32_t m_mask;
+        };
+        GrowableStack<Entry, 256> stack;
+        stack.Push({m_root, count >= 32 ? ~0u : (1u << count) - 1});
+        while (!stack.Empty()) {
+            Entry entry = stack.Pop();
+            if (entry.m_node == NullNode) {
+                continue;
+            }
+
+            const Node& node = m_nodes[entry.m_node];
+            uint32_t mask = 0;
+            for (uint32_t bits = entry.m_mask; bits != 0; bits &= bits - 1) {
+                uint32_t i = static_cast<uint32_t>(std::countr_zero(bits));
+                if (casts[i].m_max_fraction >= 0 &&
+                    casts[i].Intersect(node.m_aabb)) {
+                    mask |= 1u << i;
+                }
+            }
+            if (mask == 0) {
+                continue;
+            }
+
+            if (node.IsLeaf()) {
+                for (; mask != 0; mask &= mask - 1) {
+                    callback(static_cast<uint32_t>(std::countr_zero(mask)),
+                             entry.m_node);
+                }
+            } else {
+                stack.Push({node.m_child1, mask});
+                stack.Push({node.m_child2, mask});
+            }
+        }
+    }
+
+    float m_margin = 0.1f;
+    float m_displacement_multiplier = 4.0f;
+
+private:
+    std::vector<Node> m_nodes;
+    uint32_t m_root = NullNode;
+    uint32_t m_free_list = NullNode;
+    size_t m_proxy_count = 0;
+
+    uint32_t allocateNode();
+    void freeNode(uint32_t node);
+    void insertLeaf(uint32_t leaf);
+    void removeLeaf(uint32_t leaf);
+    uint32_t balance(uint32_t index);
+    AABB makeFatAABB(const AABB& aabb,
+                     const Eigen::Vector3f& displacement) const;
+};
+
+}
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "Eigen/Dense"
-#include <memory>
 
 namespace toy_physics {
+
+// plain records without a vtable, the type tag is stored inline so they can
+// sit by value in the typed arrays of a GeometryPool
 class Geometry {
 public:
     enum class Type {
@@ -12,18 +14,22 @@ public:
         Capsule,
     };
 
-    virtual ~Geometry() = default;
-    virtual Type GetType() const = 0;
+    Type GetType() const { return m_type; }
 
     class BoxGeometry* AsBox();
     class SphereGeometry* AsSphere();
     class CapsuleGeometry* AsCapsule();
+
+protected:
+    explicit Geometry(Type type) : m_type{type} {}
+
+private:
+    Type m_type;
 };
 
 class BoxGeometry : public Geometry {
 public:
     explicit BoxGeometry(const Eigen::Vector3f& size);
-    Type GetType() const override { return Type::Box; }
 
     Eigen::Vector3f m_half_size;
 };
@@ -31,7 +37,6 @@ public:
 class SphereGeometry : public Geometry {
 public:
     explicit SphereGeometry(float radius);
-    Type GetType() const override { return Type::Sphere; }
 
     float m_radius;
 };
@@ -39,12 +44,9 @@ public:
 class CapsuleGeometry : public Geometry {
 public:
     explicit CapsuleGeometry(float radius, float height);
-    Type GetType() const override { return Type::Capsule; }
 
     float m_radius;
     float m_height;
 };
 
-using GeometryPtr = std::shared_ptr<Geometry>;
-
 }
@@ -0,0 +1,98 @@
+#pragma once
+#include "toy_physics/geometry.hpp"
+#include "toy_physics/pair_map.hpp"
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace toy_physics {
+
+// 2 bits of Geometry::Type and 30 bits of index into that type's array
+struct GeometryHandle {
+    static constexpr uint32_t InvalidValue = UINT32_MAX;
+    static constexpr uint32_t IndexBits = 30;
+    static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+
+    uint32_t m_value = InvalidValue;
+
+    static GeometryHandle Make(Geometry::Type type, uint32_t index) {
+        return {(static_cast<uint32_t>(type) << IndexBits) | index};
+    }
+
+    Geometry::Type GetType() const {
+        return static_cast<Geometry::Type>(m_value >> IndexBits);
+    }
+
+    uint32_t GetIndex() const { return m_value & IndexMask; }
+
+    bool operator==(const GeometryHandle&) const noexcept = default;
+
+    explicit operator bool() const noexcept {
+        return m_value != InvalidValue;
+    }
+};
+
+// one contiguous array per geometry type. Identical geometries are interned,
+// so a scene of equal crates stores a single box. Records are never removed,
+// handles stay valid for the lifetime of the pool
+class GeometryPool {
+public:
+    GeometryHandle Add(const BoxGeometry& box);
+    GeometryHandle Add(const SphereGeometry& sphere);
+    GeometryHandle Add(const CapsuleGeometry& capsule);
+    GeometryHandle Add(const Geometry& geom);
+
+    // handle has to be valid and of type T
+    template <typename T>
+    const T& Get(GeometryHandle handle) const {
+        return getArray<T>()[handle.GetIndex()];
+    }
+
+    const Geometry& Get(GeometryHandle handle) const;
+
+    bool IsValid(GeometryHandle handle) const;
+    size_t GetCount(Geometry::Type type) const;
+
+    // changes whenever a record is added and is unique across pools, so a
+    // copy with the same version holds the same records
+    uint64_t GetVersion() const { return m_version; }
+
+    // every record of type T in handle index order
+    template <typename T>
+    const std::vector<T>& GetRecords() const {
+        return getArray<T>();
+    }
+
+private:
+    template <typename T>
+    struct Records {
+        std::vector<T> m_records;
+        // next record whose key collides with this one
+        std::vector<uint32_t> m_next;
+        // key of the first parameters -> first record with that key
+        PairMap<uint32_t> m_lookup;
+    };
+
+    Records<BoxGeometry> m_boxes;
+    Records<SphereGeometry> m_spheres;
+    Records<CapsuleGeometry> m_capsules;
+    uint64_t m_version = 0;
+
+    template <typename T>
+    GeometryHandle intern(Records<T>& records, const T& geom, uint64_t key);
+
+    template <typename T>
+    const std::vector<T>& getArray() const {
+        if constexpr (std::is_same_v<T, BoxGeometry>) {
+            return m_boxes.m_records;
+        } else if constexpr (std::is_same_v<T, SphereGeometry>) {
+            return m_spheres.m_records;
+        } else {
+            static_assert(std::is_same_v<T, CapsuleGeometry>);
+            return m_capsules.m_records;
+        }
+    }
+};
+
+}
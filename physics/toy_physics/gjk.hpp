@@ -0,0 +1,65 @@
+#pragma once
+#include "toy_physics/geometry.hpp"
+#include "toy_physics/pose.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace toy_physics {
+
+// world space core of a convex shape: the shape is the convex hull of the
+// vertices inflated by m_radius. Sphere cores are a point, capsule cores
+// their inner segment and boxes keep their 8 corners
+struct ConvexProxy {
+    static constexpr uint32_t MaxVertices = 8;
+
+    std::array<Eigen::Vector3f, MaxVertices> m_vertices;
+    uint32_t m_count = 0;
+    float m_radius = 0;
+
+    // index of the vertex furthest along dir
+    uint32_t Support(const Eigen::Vector3f& dir) const;
+};
+
+ConvexProxy MakeConvexProxy(const BoxGeometry& box, const Pose& pose);
+ConvexProxy MakeConvexProxy(const SphereGeometry& sphere, const Pose& pose);
+ConvexProxy MakeConvexProxy(const CapsuleGeometry& capsule, const Pose& pose);
+ConvexProxy MakeConvexProxy(const Geometry& geom, const Pose& pose);
+
+// support vertex indices of the last GJK simplex. Kept per shape pair, a
+// cached simplex lets resting pairs converge in one or two iterations
+struct SimplexCache {
+    uint32_t m_count = 0;
+    std::array<uint8_t, 4> m_index_a{};
+    std::array<uint8_t, 4> m_index_b{};
+};
+
+struct GjkOutput {
+    // closest points between the cores, radius not applied
+    Eigen::Vector3f m_point_a = Eigen::Vector3f::Zero();
+    Eigen::Vector3f m_point_b = Eigen::Vector3f::Zero();
+    float m_distance = 0;
+    uint32_t m_iterations = 0;
+};
+
+// cache may be null, otherwise it warm starts the query and receives the
+// terminating simplex
+GjkOutput GjkDistance(const ConvexProxy& a, const ConvexProxy& b,
+                      SimplexCache* cache);
+
+struct ConvexContact {
+    // points from A to B
+    Eigen::Vector3f m_normal = Eigen::Vector3f::UnitY();
+    // deepest points on the surface of each shape
+    Eigen::Vector3f m_point_a = Eigen::Vector3f::Zero();
+    Eigen::Vector3f m_point_b = Eigen::Vector3f::Zero();
+    // > 0 when penetrating
+    float m_depth = 0;
+};
+
+// GJK while the cores are apart, EPA once they overlap. Returns false when
+// the shapes are further apart than margin
+bool CollideConvex(const ConvexProxy& a, const ConvexProxy& b, float margin,
+                   SimplexCache* cache, ConvexContact& contact);
+
+}
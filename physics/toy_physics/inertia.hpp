@@ -0,0 +1,20 @@
+#pragma once
+#include "toy_physics/geometry.hpp"
+#include "toy_physics/pose.hpp"
+
+namespace toy_physics {
+
+// inverse inertia tensors for a uniform density shape in its own frame,
+// zero when inv_mass is zero
+Eigen::Vector3f ComputeInvInertia(const BoxGeometry& box, float inv_mass);
+Eigen::Vector3f ComputeInvInertia(const SphereGeometry& sphere,
+                                  float inv_mass);
+Eigen::Vector3f ComputeInvInertia(const CapsuleGeometry& capsule,
+                                  float inv_mass);
+
+// body space inverse inertia of a shape placed at local_pose. The center of
+// mass is assumed at the body origin, so the shape offset is ignored
+Eigen::Matrix3f ComputeInvInertia(const Geometry& geom,
+                                  const Pose& local_pose, float inv_mass);
+
+}
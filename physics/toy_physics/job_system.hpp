@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace toy_physics {
+
+class JobSystem;
+
+// threads owned by the application. The job system hands it short tasks
+// that run queued jobs and return once there is no work left, so physics
+// shares cores with the application's own scheduler
+class JobExecutor {
+public:
+    virtual ~JobExecutor() = default;
+
+    // how many tasks may run at the same time
+    virtual uint32_t GetConcurrency() const = 0;
+    virtual void Execute(std::function<void()> task) = 0;
+};
+
+// tasks with dependencies, built once and run any number of times. Must be
+// acyclic
+class JobGraph {
+public:
+    // fn(worker_index)
+    using TaskFn = std::function<void(uint32_t)>;
+
+    uint32_t AddTask(TaskFn fn);
+    // after only starts once before has finished
+    void AddDependency(uint32_t before, uint32_t after);
+    size_t GetTaskCount() const { return m_tasks.size(); }
+    void Clear();
+
+private:
+    friend class JobSystem;
+
+    struct Task {
+        TaskFn m_fn;
+        std::vector<uint32_t> m_successors;
+        uint32_t m_dependency_count = 0;
+    };
+
+    // job payload per task, so running the graph never allocates
+    struct TaskRun {
+        JobGraph* m_graph = nullptr;
+        uint32_t m_index = 0;
+    };
+
+    std::vector<Task> m_tasks;
+    // unfinished dependencies per task while the graph runs
+    std::unique_ptr<std::atomic<uint32_t>[]> m_remaining;
+    std::unique_ptr<TaskRun[]> m_runs;
+    size_t m_remaining_size = 0;
+    JobSystem* m_system = nullptr;
+    std::atomic<uint32_t>* m_pending = nullptr;
+};
+
+// work-stealing scheduler. Every worker owns a deque, pushes and pops at its
+// back and steals from the front of the others. Threads waiting on jobs run
+// other jobs meanwhile, so parallel-fors and graphs may nest. The thread
+// calling into the job system from outside takes part as worker 0, only one
+// outside thread may do so at a time. ParallelFor() and Run() never touch
+// the heap once the worker queues have grown to their working size
+class JobSystem {
+public:
+    // fn(worker_index)
+    using JobFn = std::function<void(uint32_t)>;
+
+    // worker_count == 0 picks std::thread::hardware_concurrency()
+    explicit JobSystem(uint32_t worker_count = 0);
+    // runs on the executor's threads instead of its own, the executor has
+    // to outlive the job system
+    explicit JobSystem(JobExecutor& executor);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    uint32_t GetWorkerCount() const;
+    // 0 for threads outside the job system
+    uint32_t GetCurrentWorker() const;
+
+    // blocks until [0, count) was processed in chunks of grain_size,
+    // fn(begin, end, worker_index)
+    template <typename F>
+    void ParallelFor(uint32_t count, uint32_t grain_size, const F& fn) {
+        parallelFor(
+            count, grain_size,
+            [](const void* data, uint32_t begin, uint32_t end,
+               uint32_t worker) {
+                (*static_cast<const F*>(data))(begin, end, worker);
+            },
+            &fn);
+    }
+
+    // blocks until every task of the graph has run
+    void Run(JobGraph& graph);
+
+    // counter is incremented now and decremented once the job has run. The
+    // function object is heap allocated, hot paths use ParallelFor() or a
+    // JobGraph instead
+    void Submit(JobFn fn, std::atomic<uint32_t>* counter = nullptr);
+    // runs jobs until counter drops to zero
+    void Wait(const std::atomic<uint32_t>& counter);
+
+private:
+    using RawRangeFn = void (*)(const void*, uint32_t, uint32_t, uint32_t);
+
+    struct Job {
+        void (*m_fn)(void*, uint32_t) = nullptr;
+        void* m_data = nullptr;
+        std::atomic<uint32_t>* m_counter = nullptr;
+        // submitted inside an AllocationScope
+        bool m_tracked = false;
+    };
+
+    // ring buffer deque, only grows
+    struct Worker {
+        std::mutex m_mutex;
+        std::vector<Job> m_jobs;
+        size_t m_head = 0;
+        size_t m_count = 0;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<uint32_t> m_queued{0};
+
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wake_cv;
+    bool m_quit = false;
+
+    // executor tasks borrow a worker index for as long as they run
+    JobExecutor* m_executor = nullptr;
+    std::atomic<uint64_t> m_free_helper_slots{0};
+    std::atomic<uint32_t> m_pending_helpers{0};
+
+    void parallelFor(uint32_t count, uint32_t grain_size, RawRangeFn fn,
+                     const void* data);
+    void submit(void (*fn)(void*, uint32_t), void* data,
+                std::atomic<uint32_t>* counter);
+    void push(Job job, uint32_t worker);
+    bool runOne(uint32_t worker);
+    bool pop(uint32_t worker, Job& job);
+    bool steal(uint32_t worker, Job& job);
+    void workerMain(uint32_t worker);
+    void helperMain();
+    void requestHelpers();
+    static void runGraphTask(void* data, uint32_t worker);
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "spdlog/spdlog.h"
+#include "toy_physics/profiler.hpp"
 #include <memory>
 
 class LogManager {
@@ -52,3 +53,40 @@ private:
         SPDLOG_LOGGER_TRACE(LogManager::GetInst().GetConsoleLogger(), fmt, \
                             ##__VA_ARGS__);                                \
     } while (0)
+
+// scoped timings and counters for toy_physics::Profiler, recorded while
+// Profiler::SetRecording(true). Without TOY_PHYSICS_PROFILE they expand to
+// nothing and their arguments are not evaluated. Names have to be string
+// literals
+#ifdef TOY_PHYSICS_PROFILE
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#define PROFILE_SCOPE(name) \
+    ::toy_physics::ProfileScope PROFILE_CONCAT(profile_, __LINE__) { name }
+
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+
+#define PROFILE_COUNTER(name, value)                                   \
+    do {                                                               \
+        if (::toy_physics::Profiler::IsRecording()) {                  \
+            ::toy_physics::Profiler::RecordCounter(                    \
+                name, static_cast<int64_t>(value));                    \
+        }                                                              \
+    } while (0)
+
+#define PROFILE_THREAD_NAME(name) ::toy_physics::Profiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name) \
+    do {                    \
+    } while (0)
+#define PROFILE_FUNCTION() \
+    do {                   \
+    } while (0)
+#define PROFILE_COUNTER(name, value) \
+    do {                             \
+    } while (0)
+#define PROFILE_THREAD_NAME(name) \
+    do {                          \
+    } while (0)
+#endif
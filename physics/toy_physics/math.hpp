@@ -420,8 +420,9 @@ auto CreateZRotation(TRadians<T> radians) {
 }
 
 template <typename T>
-auto CreateXYZRotation(const Eigen::Vector3<TRadians<T>>& r) {
-    return CreateXRotation(r.x) * CreateYRotation(r.y) * CreateZRotation(r.z);
+Eigen::Matrix4<T> CreateXYZRotation(const Eigen::Vector3<TRadians<T>>& r) {
+    return CreateXRotation(r.x()) * CreateYRotation(r.y()) *
+           CreateZRotation(r.z());
 }
 
 template <typename T>
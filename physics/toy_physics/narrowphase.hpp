@@ -0,0 +1,85 @@
+#pragma once
+#include "toy_physics/contact.hpp"
+#include "toy_physics/contact_cache.hpp"
+#include "toy_physics/geometry_pool.hpp"
+#include "toy_physics/job_system.hpp"
+#include "toy_physics/pose.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace toy_physics {
+
+// indices into the context columns. Narrowphase::Collide reorders each pair
+// so the first shape has the smaller Geometry::Type
+struct NarrowphasePair {
+    uint32_t m_a = 0;
+    uint32_t m_b = 0;
+};
+
+struct NarrowphaseContext {
+    // world space shape pose per index
+    const Pose* m_poses = nullptr;
+    const GeometryHandle* m_geometries = nullptr;
+    const GeometryPool* m_pool = nullptr;
+    // ids that stay the same across steps, key the contact cache. Without
+    // them GJK starts cold and contacts are not warm started
+    const uint32_t* m_ids = nullptr;
+    // set by Narrowphase::Collide
+    ContactCache* m_contact_cache = nullptr;
+    float m_margin = 0.02f;
+};
+
+// collides a contiguous batch of pairs that all have the same type
+// combination, appending one manifold per touching pair
+using CollideBatchFn = void (*)(const NarrowphaseContext&,
+                                const NarrowphasePair* pairs, size_t count,
+                                std::vector<ContactManifold>& manifolds);
+
+class Narrowphase {
+public:
+    static constexpr size_t TypeCount = 3;
+
+    Narrowphase();
+
+    // a is expected to be the smaller type, the kernel for (b, a) is never
+    // called
+    void SetKernel(Geometry::Type a, Geometry::Type b, CollideBatchFn kernel);
+    CollideBatchFn GetKernel(Geometry::Type a, Geometry::Type b) const;
+    ContactCache& GetContactCache() { return m_contact_cache; }
+    const ContactCache& GetContactCache() const { return m_contact_cache; }
+
+    // buckets pairs by type combination, then runs the kernels over chunks
+    // of the buckets in parallel. Manifolds are appended in bucket order, the
+    // same for any worker count, and warm started from the contact cache
+    void Collide(const NarrowphaseContext& context,
+                 const NarrowphasePair* pairs, size_t count,
+                 std::vector<ContactManifold>& manifolds, JobSystem& jobs);
+
+    // saves solved impulses for the next step's warm start, ids are the
+    // same as NarrowphaseContext::m_ids
+    void StoreImpulses(const uint32_t* ids,
+                       const std::vector<ContactManifold>& manifolds);
+
+private:
+    // pairs [m_begin, m_end) of a bucket, collided into the buffer of
+    // m_worker where they filled [m_first, m_last)
+    struct Chunk {
+        uint32_t m_bucket = 0;
+        uint32_t m_begin = 0;
+        uint32_t m_end = 0;
+        uint32_t m_worker = 0;
+        size_t m_first = 0;
+        size_t m_last = 0;
+    };
+
+    std::array<std::array<CollideBatchFn, TypeCount>, TypeCount> m_kernels{};
+    std::array<std::vector<NarrowphasePair>, TypeCount * TypeCount>
+        m_buckets;
+    std::vector<Chunk> m_chunks;
+    std::vector<std::vector<ContactManifold>> m_worker_manifolds;
+    ContactCache m_contact_cache;
+};
+
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace toy_physics {
+
+// open addressing hash map keyed by a pair of 32 bit ids. Linear probing
+// with backward shift deletion, so there are no tombstones and memory is
+// only allocated when the table grows
+template <typename T>
+class PairMap {
+public:
+    static uint64_t MakeKey(uint32_t a, uint32_t b) {
+        return (static_cast<uint64_t>(a) << 32) | b;
+    }
+
+    T* Find(uint64_t key) {
+        if (m_size == 0) {
+            return nullptr;
+        }
+        for (size_t i = hash(key) & m_mask;; i = (i + 1) & m_mask) {
+            if (m_entries[i].m_key == key) {
+                return &m_entries[i].m_value;
+            }
+            if (m_entries[i].m_key == EmptyKey) {
+                return nullptr;
+            }
+        }
+    }
+
+    const T* Find(uint64_t key) const {
+        return const_cast<PairMap*>(this)->Find(key);
+    }
+
+    // value is default constructed when the key is new. The reference is
+    // invalidated by the next insertion or erase
+    T& Insert(uint64_t key, bool* inserted = nullptr) {
+        if ((m_size + 1) * 2 > m_entries.size()) {
+            grow();
+        }
+        size_t i = hash(key) & m_mask;
+        for (; m_entries[i].m_key != EmptyKey; i = (i + 1) & m_mask) {
+            if (m_entries[i].m_key == key) {
+                if (inserted) {
+                    *inserted = false;
+                }
+                return m_entries[i].m_value;
+            }
+        }
+        m_entries[i].m_key = key;
+        m_entries[i].m_value = T{};
+        m_size++;
+        if (inserted) {
+            *inserted = true;
+        }
+        return m_entries[i].m_value;
+    }
+
+    bool Erase(uint64_t key) {
+        if (m_size == 0) {
+            return false;
+        }
+        for (size_t i = hash(key) & m_mask;; i = (i + 1) & m_mask) {
+            if (m_entries[i].m_key == key) {
+                eraseAt(i);
+                return true;
+            }
+            if (m_entries[i].m_key == EmptyKey) {
+                return false;
+            }
+        }
+    }
+
+    // pred(key, value) returns true for entries to remove
+    template <typename Pred>
+    void EraseIf(Pred pred) {
+        // backward shift only moves entries into the slot being erased, so
+        // stay on it until it holds a kept entry
+        for (size_t i = 0; i < m_entries.size();) {
+            Entry& entry = m_entries[i];
+            if (entry.m_key != EmptyKey && pred(entry.m_key, entry.m_value)) {
+                eraseAt(i);
+            } else {
+                i++;
+            }
+        }
+    }
+
+    template <typename Fn>
+    void ForEach(Fn fn) {
+        for (Entry& entry : m_entries) {
+            if (entry.m_key != EmptyKey) {
+                fn(entry.m_key, entry.m_value);
+            }
+        }
+    }
+
+    template <typename Fn>
+    void ForEach(Fn fn) const {
+        for (const Entry& entry : m_entries) {
+            if (entry.m_key != EmptyKey) {
+                fn(entry.m_key, entry.m_value);
+            }
+        }
+    }
+
+    void Clear() {
+        for (Entry& entry : m_entries) {
+            entry = Entry{};
+        }
+        m_size = 0;
+    }
+
+    void Reserve(size_t count) {
+        while (count * 2 > m_entries.size()) {
+            grow();
+        }
+    }
+
+    size_t Size() const { return m_size; }
+
+    size_t Capacity() const { return m_entries.size(); }
+
+private:
+    static constexpr uint64_t EmptyKey = UINT64_MAX;
+
+    struct Entry {
+        uint64_t m_key = EmptyKey;
+        T m_value{};
+    };
+
+    std::vector<Entry> m_entries;
+    size_t m_mask = 0;
+    size_t m_size = 0;
+
+    // murmur3 finalizer, ids are small and sequential so they need mixing
+    static size_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+
+    void grow() {
+        std::vector<Entry> old = std::move(m_entries);
+        size_t capacity = old.empty() ? 64 : old.size() * 2;
+        m_entries.clear();
+        m_entries.resize(capacity);
+        m_mask = capacity - 1;
+        m_size = 0;
+        for (Entry& entry : old) {
+            if (entry.m_key != EmptyKey) {
+                Insert(entry.m_key) = std::move(entry.m_value);
+            }
+        }
+    }
+
+    void eraseAt(size_t hole) {
+        for (size_t j = (hole + 1) & m_mask; m_entries[j].m_key != EmptyKey;
+             j = (j + 1) & m_mask) {
+            // an entry may fill the hole unless its home slot lies
+            // cyclically in (hole, j]
+            size_t home = hash(m_entries[j].m_key) & m_mask;
+            bool movable = hole <= j ? (home <= hole || home > j)
+                                     : (home <= hole && home > j);
+            if (movable) {
+                m_entries[hole] = std::move(m_entries[j]);
+                hole = j;
+            }
+        }
+        m_entries[hole] = Entry{};
+        m_size--;
+    }
+};
+
+}
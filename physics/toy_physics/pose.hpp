@@ -4,11 +4,17 @@
 namespace toy_physics {
 
 struct Pose {
-    Eigen::Vector3f m_position{};
+    Eigen::Vector3f m_position = Eigen::Vector3f::Zero();
     Eigen::Quaternionf m_rotation{Eigen::Quaternionf::Identity()};
 
+    // o given in this pose's frame, moved to the parent frame
     Pose TransformBy(const Pose& o) const;
+    // the parent pose that child has to be transformed by to end up at this
+    // pose, P.TransformBy(child) == *this
     Pose RelativeBy(const Pose& child) const;
+    Pose Inverse() const;
+    // lerps the position and slerps the rotation, t in [0, 1]
+    Pose Lerp(const Pose& to, float t) const;
 
     bool operator==(const Pose&) const noexcept;
     bool operator!=(const Pose&) const noexcept;
@@ -0,0 +1,88 @@
+#pragma once
+#include "toy_physics/pose.hpp"
+#include "toy_physics/simd.hpp"
+
+#include <vector>
+
+namespace toy_physics {
+
+struct QuatColumn {
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    std::vector<float> m_w;
+
+    void Clear() {
+        m_x.clear();
+        m_y.clear();
+        m_z.clear();
+        m_w.clear();
+    }
+
+    void Resize(size_t count) {
+        m_x.resize(count);
+        m_y.resize(count);
+        m_z.resize(count);
+        m_w.resize(count);
+    }
+
+    void Push(const Eigen::Quaternionf& q) {
+        m_x.push_back(q.x());
+        m_y.push_back(q.y());
+        m_z.push_back(q.z());
+        m_w.push_back(q.w());
+    }
+
+    Eigen::Quaternionf Get(size_t i) const {
+        return {m_w[i], m_x[i], m_y[i], m_z[i]};
+    }
+};
+
+// structure of arrays poses for the wide pose kernels
+struct PoseBatch {
+    Vec3Column m_position;
+    QuatColumn m_rotation;
+
+    size_t Size() const { return m_position.m_x.size(); }
+
+    void Clear() {
+        m_position.Clear();
+        m_rotation.Clear();
+    }
+
+    void Resize(size_t count) {
+        m_position.Resize(count);
+        m_rotation.Resize(count);
+    }
+
+    void Push(const Pose& pose) {
+        m_position.Push(pose.m_position);
+        m_rotation.Push(pose.m_rotation);
+    }
+
+    Pose Get(size_t i) const {
+        return {m_position.Get(i), m_rotation.Get(i)};
+    }
+};
+
+// batched versions of the Pose operations, element i of the output only
+// depends on element i of the inputs. Rotations are expected to be unit
+// length. Like the contact kernels every level gives identical bits, they
+// match the scalar Pose methods up to rounding. Inputs and output may be
+// the same batch
+void ComposePoses(const PoseBatch& poses, const PoseBatch& children,
+                  PoseBatch& out, SimdLevel level = GetSimdLevel());
+void InvertPoses(const PoseBatch& poses, PoseBatch& out,
+                 SimdLevel level = GetSimdLevel());
+void RelativePoses(const PoseBatch& poses, const PoseBatch& children,
+                   PoseBatch& out, SimdLevel level = GetSimdLevel());
+// point i moved into the parent frame of pose i
+void TransformPoints(const PoseBatch& poses, const Vec3Column& points,
+                     Vec3Column& out, SimdLevel level = GetSimdLevel());
+// Pose::Lerp with the same t for every pose. The slerp weights come from a
+// polynomial instead of acos and sin, rotations stay within 5e-7 of
+// Pose::Lerp per component
+void LerpPoses(const PoseBatch& from, const PoseBatch& to, float t,
+               PoseBatch& out, SimdLevel level = GetSimdLevel());
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define TOY_PHYSICS_PROFILE_RDTSC 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#include <chrono>
+#endif
+
+namespace toy_physics {
+
+// raw timestamp of the profiler, the time stamp counter on x86. Converted
+// to microseconds when the trace is written
+inline uint64_t ReadProfileTicks() {
+#if defined(TOY_PHYSICS_PROFILE_RDTSC) && defined(_MSC_VER) && \
+    !defined(__clang__)
+    return __rdtsc();
+#elif defined(TOY_PHYSICS_PROFILE_RDTSC)
+    return __builtin_ia32_rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// records scopes and counters into a ring buffer per thread. Only the
+// owning thread writes its buffer, so recording takes no locks. A full
+// buffer overwrites its oldest events. Names are not copied, they have to
+// be string literals or live as long as the profiler. Usually driven
+// through the PROFILE_* macros in log.hpp
+class Profiler {
+public:
+    // events each thread keeps, a power of two
+    static constexpr uint32_t BufferCapacity = 1u << 16;
+
+    static bool IsRecording() {
+        return s_recording.load(std::memory_order_relaxed);
+    }
+    static void SetRecording(bool recording);
+
+    // a scope reads the clock at both ends and writes one event when it
+    // ends. Built with TOY_PHYSICS_PROFILE_ONE_READ, only the outermost
+    // scope of a thread reads it at its end. A nested scope then ends where
+    // the next scope or counter of its thread begins, or with its parent,
+    // so work the parent does after a child shows up in the child.
+    // scope identifies the scope to EndScope(), usually its address
+    static uint64_t BeginScope([[maybe_unused]] const void* scope) {
+#ifdef TOY_PHYSICS_PROFILE_ONE_READ
+        if (!s_outermost_scope) {
+            s_outermost_scope = scope;
+        }
+#endif
+        return ReadProfileTicks();
+    }
+    static void EndScope(const void* scope, const char* name,
+                         uint64_t begin);
+    static void RecordCounter(const char* name, int64_t value);
+    // track name of the calling thread in the trace, the name is copied
+    static void SetThreadName(const char* name);
+
+    // drops every recorded event
+    static void Clear();
+
+    // Chrome trace event JSON, loads in chrome://tracing and Perfetto.
+    // Writing while other threads record skips events that may have been
+    // overwritten during the copy
+    static void WriteChromeTrace(std::ostream& out);
+    static bool WriteChromeTrace(const std::string& path);
+
+private:
+    static inline std::atomic<bool> s_recording{false};
+#ifdef TOY_PHYSICS_PROFILE_ONE_READ
+    // outermost open scope of the calling thread. Nested scopes only read
+    // it, a depth counter would cost a read-modify-write per scope
+    static inline thread_local const void* s_outermost_scope = nullptr;
+#endif
+};
+
+// records the time from construction to destruction, when the profiler
+// was recording at construction
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) {
+        if (Profiler::IsRecording()) {
+            m_name = name;
+            m_begin = Profiler::BeginScope(this);
+        }
+    }
+
+    ~ProfileScope() {
+        if (m_name) {
+            Profiler::EndScope(this, m_name, m_begin);
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_name = nullptr;
+    uint64_t m_begin = 0;
+};
+
+}
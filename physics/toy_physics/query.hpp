@@ -0,0 +1,38 @@
+#pragma once
+#include "toy_physics/body.hpp"
+#include "toy_physics/raycast.hpp"
+
+#include <cstdint>
+
+namespace toy_physics {
+
+enum class QueryMode {
+    // nearest hit along the cast
+    Closest,
+    // first hit found, not necessarily the nearest
+    Any,
+    // every hit up to the buffer capacity, nearest first. When there are
+    // more hits than slots the nearest ones are kept
+    All,
+};
+
+struct QueryHit {
+    BodyHandle m_body;
+    CastHit m_hit;
+};
+
+// caller owned results, query i writes m_counts[i] hits starting at
+// m_hits[i * m_capacity]. Closest and Any write at most one
+struct QueryHitBuffer {
+    QueryHit* m_hits = nullptr;
+    uint32_t* m_counts = nullptr;
+    uint32_t m_capacity = 1;
+};
+
+// records hit in a query's hits according to mode. max_distance is the
+// cast's limit, it shrinks once closer hits can't matter anymore and turns
+// negative when the query is done
+void AddQueryHit(QueryMode mode, const QueryHit& hit, QueryHit* hits,
+                 uint32_t capacity, uint32_t& count, float& max_distance);
+
+}
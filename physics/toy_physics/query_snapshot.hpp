@@ -0,0 +1,134 @@
+#pragma once
+#include "toy_physics/dynamic_aabb_tree.hpp"
+#include "toy_physics/geometry_pool.hpp"
+#include "toy_physics/query.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace toy_physics {
+
+// immutable copy of body poses and a broadphase tree, for queries from
+// threads that run alongside the step. Bodies are addressed by the same
+// handles as in the world
+class QuerySnapshot {
+public:
+    // number of the publish that produced this snapshot, grows by one per
+    // published step
+    uint64_t GetEpoch() const { return m_epoch; }
+    // the world origin poses and queries are relative to
+    const Eigen::Vector3d& GetOrigin() const { return m_origin; }
+
+    bool IsValid(BodyHandle handle) const;
+    // body pose at the end of the published step
+    Pose GetPose(BodyHandle handle) const;
+    const GeometryPool& GetGeometryPool() const { return m_geometries; }
+
+    // callback(handle) for every body whose AABB overlaps, returns false to
+    // stop the query
+    template <typename F>
+    void Query(const AABB& aabb, F&& callback) const {
+        m_tree.Query(aabb, [&](uint32_t proxy) {
+            uint32_t slot = m_tree.GetUserData(proxy);
+            const Entry& entry = m_entries[slot];
+            if (!entry.m_aabb.Intersect(aabb)) {
+                return true;
+            }
+            return callback(BodyHandle{slot, entry.m_generation});
+        });
+    }
+
+    // single casts on the calling thread, hits are written like one query
+    // of World::RaycastBatch. Returns the hit count
+    uint32_t Raycast(const Ray& ray, QueryMode mode, QueryHit* hits,
+                     uint32_t capacity = 1) const;
+    uint32_t Sweep(const ShapeCast& cast, QueryMode mode, QueryHit* hits,
+                   uint32_t capacity = 1) const;
+
+    // writer side, only called on snapshots no reader holds. Bodies not set
+    // between BeginUpdate() and EndUpdate() are removed
+    void BeginUpdate(const GeometryPool& geometries, size_t slot_count,
+                     const Eigen::Vector3d& origin);
+    // shape pose and AABB come from the world's cache
+    void SetBody(uint32_t slot, uint32_t generation, const Pose& pose,
+                 const Pose& shape_pose, GeometryHandle geom,
+                 const AABB& aabb);
+    void EndUpdate();
+
+private:
+    friend class QuerySnapshotRef;
+    friend class QuerySnapshotPublisher;
+
+    struct Entry {
+        Pose m_pose;
+        Pose m_shape_pose;
+        AABB m_aabb;
+        GeometryHandle m_geom;
+        uint32_t m_generation = 0;
+        uint32_t m_proxy = DynamicAABBTree::NullNode;
+        // update that last set the body, 0 when the slot is empty
+        uint64_t m_update = 0;
+    };
+
+    DynamicAABBTree m_tree;
+    // indexed by handle slot
+    std::vector<Entry> m_entries;
+    GeometryPool m_geometries;
+    Eigen::Vector3d m_origin = Eigen::Vector3d::Zero();
+    uint64_t m_epoch = 0;
+    uint64_t m_update = 0;
+    mutable std::atomic<uint32_t> m_readers{0};
+
+    const Entry* getEntry(BodyHandle handle) const;
+    template <typename T, typename CastFn>
+    uint32_t castOne(const T& query, QueryMode mode, QueryHit* hits,
+                     uint32_t capacity, const CastFn& fn) const;
+};
+
+// keeps its snapshot alive, the writer never rebuilds a snapshot while a
+// reference to it exists. Hold it briefly, every held snapshot costs the
+// writer a spare one
+class QuerySnapshotRef {
+public:
+    QuerySnapshotRef() = default;
+    ~QuerySnapshotRef();
+    QuerySnapshotRef(QuerySnapshotRef&& other) noexcept;
+    QuerySnapshotRef& operator=(QuerySnapshotRef&& other) noexcept;
+
+    const QuerySnapshot& operator*() const { return *m_snapshot; }
+    const QuerySnapshot* operator->() const { return m_snapshot; }
+    explicit operator bool() const noexcept { return m_snapshot != nullptr; }
+
+private:
+    friend class QuerySnapshotPublisher;
+
+    const QuerySnapshot* m_snapshot = nullptr;
+
+    explicit QuerySnapshotRef(const QuerySnapshot* snapshot)
+        : m_snapshot{snapshot} {}
+};
+
+// read-copy-update with one writer and any number of readers. Readers pin
+// the current snapshot with a counter and never block. The writer rebuilds
+// a snapshot that is neither current nor pinned, and adds a new one
+// instead of waiting when every old snapshot is still read, so two
+// snapshots suffice unless readers hold on across steps
+class QuerySnapshotPublisher {
+public:
+    // thread safe, empty until the first Publish()
+    QuerySnapshotRef Acquire() const;
+
+    // writer side
+    QuerySnapshot& BeginWrite();
+    void Publish(QuerySnapshot& snapshot);
+    size_t GetSnapshotCount() const { return m_snapshots.size(); }
+
+private:
+    std::vector<std::unique_ptr<QuerySnapshot>> m_snapshots;
+    std::atomic<QuerySnapshot*> m_current{nullptr};
+    uint64_t m_epoch = 0;
+};
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "toy_physics/aabb.hpp"
+#include "toy_physics/geometry.hpp"
+#include "toy_physics/pose.hpp"
+
+namespace toy_physics {
+
+struct Ray {
+    Eigen::Vector3f m_origin = Eigen::Vector3f::Zero();
+    // unit length
+    Eigen::Vector3f m_direction = Eigen::Vector3f::UnitX();
+    float m_max_distance = 1000.0f;
+};
+
+// a sphere when m_height is zero, otherwise a capsule along the local Y
+// axis of m_pose like CapsuleGeometry. Moves without rotating
+struct ShapeCast {
+    Pose m_pose;
+    float m_radius = 0.5f;
+    float m_height = 0;
+    // unit length
+    Eigen::Vector3f m_direction = Eigen::Vector3f::UnitX();
+    float m_max_distance = 1000.0f;
+};
+
+struct CastHit {
+    float m_distance = 0;
+    Eigen::Vector3f m_point = Eigen::Vector3f::Zero();
+    // surface normal of the shape that was hit
+    Eigen::Vector3f m_normal = Eigen::Vector3f::UnitY();
+};
+
+// casts that start inside the shape hit at distance 0, with the normal
+// against the direction
+bool Raycast(const BoxGeometry& box, const Pose& pose, const Ray& ray,
+             CastHit& hit);
+bool Raycast(const SphereGeometry& sphere, const Pose& pose, const Ray& ray,
+             CastHit& hit);
+bool Raycast(const CapsuleGeometry& capsule, const Pose& pose, const Ray& ray,
+             CastHit& hit);
+bool Raycast(const Geometry& geom, const Pose& pose, const Ray& ray,
+             CastHit& hit);
+
+// conservative advancement of the cast shape against a resting one
+bool CastShape(const ShapeCast& cast, const Geometry& geom, const Pose& pose,
+               CastHit& hit);
+
+// broadphase casts over the whole distance. A shape cast drags the box of
+// the shape at its start pose
+AABBCast MakeAABBCast(const Ray& ray);
+AABBCast MakeAABBCast(const ShapeCast& cast);
+
+}
@@ -1,5 +1,5 @@
 #pragma once
-#include "toy_physics/geometry.hpp"
+#include "toy_physics/geometry_pool.hpp"
 #include "toy_physics/pose.hpp"
 
 namespace toy_physics {
@@ -7,7 +7,8 @@ namespace toy_physics {
 class Shape {
 public:
     Pose m_local_pose;
-    GeometryPtr m_geom;
+    // interned in the world's GeometryPool
+    GeometryHandle m_geom;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+#include "Eigen/Dense"
+
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TOY_PHYSICS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// x86 builds compile the AVX2 kernels into their own translation units and
+// pick them at runtime
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define TOY_PHYSICS_X86 1
+#endif
+
+namespace toy_physics {
+
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+// best instruction set supported by both the build and the running cpu,
+// detected once
+SimdLevel GetSimdLevel();
+
+// lowercase name for logs and reports, "scalar", "sse2" or "avx2"
+const char* GetSimdLevelName(SimdLevel level);
+
+// one float column per component, the layout the batched kernels load
+struct Vec3Column {
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+
+    void Clear() {
+        m_x.clear();
+        m_y.clear();
+        m_z.clear();
+    }
+
+    void Resize(size_t count) {
+        m_x.resize(count);
+        m_y.resize(count);
+        m_z.resize(count);
+    }
+
+    void Push(const Eigen::Vector3f& v) {
+        m_x.push_back(v.x());
+        m_y.push_back(v.y());
+        m_z.push_back(v.z());
+    }
+
+    Eigen::Vector3f Get(size_t i) const { return {m_x[i], m_y[i], m_z[i]}; }
+};
+
+}
@@ -0,0 +1,208 @@
+#pragma once
+#include "toy_physics/contact.hpp"
+#include "toy_physics/job_system.hpp"
+#include "toy_physics/simd.hpp"
+
+#include "Eigen/Dense"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace toy_physics {
+
+// how islands over SolverSettings::m_split_constraint_count are solved
+enum class LargeIslandMode {
+    // constraints are colored so no body appears twice in a color, each
+    // color is solved in parallel
+    Coloring,
+    // partitions work on copies of shared bodies that are averaged after
+    // every iteration
+    MassSplitting,
+};
+
+struct SolverSettings {
+    uint32_t m_velocity_iterations = 8;
+    float m_friction = 0.6f;
+    // fraction of the penetration pushed out per step
+    float m_baumgarte = 0.2f;
+    // penetration left alone so resting contacts stay touching
+    float m_linear_slop = 0.005f;
+    float m_max_correction_velocity = 3.0f;
+    // islands with more constraints are solved in parallel internally
+    uint32_t m_split_constraint_count = 256;
+    LargeIslandMode m_large_island_mode = LargeIslandMode::Coloring;
+    // at most 64, constraints of high degree bodies that find no free color
+    // go to an overflow batch solved serially
+    uint32_t m_max_colors = 16;
+    // instruction set of the colored island kernels, capped at
+    // GetSimdLevel(). Every level gives the same bits
+    SimdLevel m_simd_level = SimdLevel::AVX2;
+};
+
+// body state the solver works on, every array is indexed by dense index.
+// Bodies at m_count and above are treated as static, only their position
+// is read, so sleeping bodies can be kept out of the solver
+struct SolverBodies {
+    const Eigen::Vector3f* m_positions = nullptr;
+    const Eigen::Quaternionf* m_rotations = nullptr;
+    Eigen::Vector3f* m_velocities = nullptr;
+    Eigen::Vector3f* m_angular_velocities = nullptr;
+    const float* m_inv_masses = nullptr;
+    // body space
+    const Eigen::Matrix3f* m_inv_inertias = nullptr;
+    uint32_t m_count = 0;
+};
+
+// range of GetConstraintOrder() whose manifolds share dynamic bodies
+struct SolverIsland {
+    uint32_t m_begin = 0;
+    uint32_t m_end = 0;
+};
+
+// sequential impulse contact solver. Manifolds are grouped into islands
+// with union-find over dynamic bodies, and independent islands are solved
+// in parallel
+class ContactSolver {
+public:
+    // velocities and world space inverse inertia of one body
+    struct SolverBody {
+        Eigen::Vector3f m_velocity;
+        Eigen::Vector3f m_angular_velocity;
+        Eigen::Matrix3f m_inv_inertia;
+        float m_inv_mass;
+    };
+
+    // eight constraints of one color, one per lane, for the wide kernels in
+    // solver_batch.cpp. Lanes past the end of a color have no points and
+    // only touch the static body
+    struct ConstraintBlock {
+        static constexpr uint32_t Width = 8;
+        using Lanes = std::array<float, Width>;
+
+        struct Point {
+            std::array<Lanes, 3> m_ra;
+            std::array<Lanes, 3> m_rb;
+            Lanes m_normal_mass;
+            std::array<Lanes, 2> m_tangent_mass;
+            Lanes m_target_velocity;
+            Lanes m_normal_impulse;
+            std::array<Lanes, 2> m_tangent_impulse;
+        };
+
+        std::array<uint32_t, Width> m_body_a;
+        std::array<uint32_t, Width> m_body_b;
+        Lanes m_inv_mass_a;
+        Lanes m_inv_mass_b;
+        // row major world space inverse inertia
+        std::array<Lanes, 9> m_inv_inertia_a;
+        std::array<Lanes, 9> m_inv_inertia_b;
+        std::array<Lanes, 3> m_normal;
+        std::array<std::array<Lanes, 3>, 2> m_tangents;
+        std::array<Point, ContactManifold::MaxPoints> m_points;
+        // most points of any lane, missing points are all zero
+        uint32_t m_point_count;
+        // constraints [m_first, m_first + m_count) fill the first lanes
+        uint32_t m_first;
+        uint32_t m_count;
+    };
+
+    // updates body velocities and writes the accumulated impulses back into
+    // the manifolds. m_body_a/m_body_b of each manifold are dense indices
+    void Solve(const SolverBodies& bodies,
+               std::vector<ContactManifold>& manifolds, float delta_time,
+               JobSystem& jobs);
+
+    const std::vector<SolverIsland>& GetIslands() const { return m_islands; }
+
+    // bodies solved together share the root, valid after Solve for bodies
+    // below SolverBodies::m_count
+    uint32_t FindIslandRoot(uint32_t body) { return findRoot(body); }
+
+    // manifold indices sorted by island, colored islands are sorted by
+    // color inside their range
+    const std::vector<uint32_t>& GetConstraintOrder() const {
+        return m_order;
+    }
+
+    SolverSettings m_settings;
+
+private:
+    struct ConstraintPoint {
+        Eigen::Vector3f m_ra;
+        Eigen::Vector3f m_rb;
+        float m_normal_mass;
+        std::array<float, 2> m_tangent_mass;
+        float m_target_velocity;
+        float m_normal_impulse;
+        std::array<float, 2> m_tangent_impulse;
+    };
+
+    struct Constraint {
+        // solver body indices, dense indices or body copies of a split
+        // island
+        uint32_t m_body_a;
+        uint32_t m_body_b;
+        Eigen::Vector3f m_normal;
+        std::array<Eigen::Vector3f, 2> m_tangents;
+        std::array<ConstraintPoint, ContactManifold::MaxPoints> m_points;
+        uint32_t m_point_count;
+    };
+
+    // one per movable body plus a shared static body at m_body_count
+    std::vector<SolverBody> m_bodies;
+    uint32_t m_body_count = 0;
+    std::vector<Constraint> m_constraints;
+    std::vector<uint32_t> m_order;
+    std::vector<SolverIsland> m_islands;
+    std::vector<uint32_t> m_small_islands;
+    std::vector<uint32_t> m_large_islands;
+
+    // union-find over dense body indices
+    std::vector<uint32_t> m_parents;
+    std::vector<uint32_t> m_island_of_root;
+    std::vector<uint32_t> m_manifold_islands;
+    const Eigen::Vector3f* m_positions = nullptr;
+
+    // split island scratch
+    std::vector<SolverBody> m_copies;
+    std::vector<uint32_t> m_copy_owner;
+    std::vector<uint32_t> m_copy_of_body;
+    std::vector<uint32_t> m_partition_of_body;
+    std::vector<uint32_t> m_body_copy_offsets;
+    std::vector<uint32_t> m_body_copies;
+    std::vector<uint32_t> m_partition_offsets;
+    uint32_t m_partition_stamp = 0;
+
+    // colored island scratch, one bit per color used by a dynamic body
+    std::vector<uint64_t> m_body_colors;
+    std::vector<uint32_t> m_constraint_colors;
+    std::vector<uint32_t> m_color_offsets;
+    std::vector<uint32_t> m_colored_order;
+    std::vector<ConstraintBlock> m_blocks;
+    std::vector<uint32_t> m_color_block_offsets;
+
+    uint32_t solverIndex(uint32_t dense) const {
+        return dense < m_body_count ? dense : m_body_count;
+    }
+    uint32_t findRoot(uint32_t body);
+    void buildIslands(const SolverBodies& bodies,
+                      const std::vector<ContactManifold>& manifolds);
+    void prepare(Constraint& constraint, const ContactManifold& manifold,
+                 const SolverBody* bodies, float delta_time) const;
+    void warmStart(const Constraint& constraint, SolverBody* bodies) const;
+    void solveVelocity(Constraint& constraint, SolverBody* bodies) const;
+    void packBlock(ConstraintBlock& block) const;
+    void unpackBlock(const ConstraintBlock& block);
+    void solveIsland(const SolverIsland& island,
+                     const std::vector<ContactManifold>& manifolds,
+                     float delta_time);
+    void solveColoredIsland(const SolverIsland& island,
+                            const std::vector<ContactManifold>& manifolds,
+                            float delta_time, JobSystem& jobs);
+    void solveSplitIsland(const SolverIsland& island,
+                          const std::vector<ContactManifold>& manifolds,
+                          float delta_time, JobSystem& jobs);
+};
+
+}
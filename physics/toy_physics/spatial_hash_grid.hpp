@@ -0,0 +1,115 @@
+#pragma once
+#include "toy_physics/broadphase.hpp"
+#include "toy_physics/job_system.hpp"
+
+namespace toy_physics {
+
+// uniform grid of the active proxies rebuilt from scratch on every update,
+// meant for many bodies of similar size. Each proxy is binned by its center
+// into a hashed cell with an atomic counting sort, then every proxy scans
+// the 27 neighbouring cells for proxies sorted after it. Proxies larger
+// than a cell, like the ground, are kept in an oversized bucket and tested
+// against everything. Resting proxies get a second grid that is only
+// rebuilt when one of them changes, every active proxy looks itself up in
+// it. All passes run on the job system and each worker writes pairs to its
+// own buffer
+class SpatialHashGrid : public Broadphase {
+public:
+    explicit SpatialHashGrid(JobSystem* job_system = nullptr);
+
+    Type GetType() const override { return Type::HashGrid; }
+
+    void Add(uint32_t id, const AABB& aabb) override;
+    void Remove(uint32_t id) override;
+    void Update(uint32_t id, const AABB& aabb,
+                const Eigen::Vector3f& displacement) override;
+    bool Contains(uint32_t id) const override;
+    void ShiftOrigin(const Eigen::Vector3f& offset) override;
+    void SetResting(uint32_t id, bool resting) override;
+
+    void UpdatePairs() override;
+
+    const std::vector<BroadphasePair>& GetPairs() const override {
+        return m_pairs;
+    }
+
+    void Query(const AABB& aabb,
+               const std::function<bool(uint32_t)>& callback) const override;
+
+    // proxies larger than a cell are oversized. <= 0 derives it on every
+    // update from the largest proxy at most OversizeFactor times the median
+    float m_cell_size = 0;
+
+    static constexpr float OversizeFactor = 4;
+
+private:
+    // hashed cells of a range of the dense proxies
+    struct Grid {
+        float m_inv_cell_size = 1;
+        uint32_t m_table_mask = 0;
+        // one more bucket after the table holds the oversized proxies
+        std::vector<uint32_t> m_bucket_start;
+        // proxies grouped by bucket
+        std::vector<AABB> m_boxes;
+        std::vector<Eigen::Vector3i> m_cells;
+        std::vector<uint32_t> m_ids;
+
+        Eigen::Vector3i CellOf(const Eigen::Vector3f& point) const;
+        uint32_t BucketOf(const Eigen::Vector3i& cell) const;
+        // calls fn with the position of every proxy overlapping aabb until
+        // it returns false
+        template <typename F>
+        bool Visit(const AABB& aabb, const F& fn) const;
+    };
+
+    JobSystem* m_job_system;
+
+    // dense proxy storage, swap-removed. Active proxies come first
+    std::vector<AABB> m_boxes;
+    std::vector<uint32_t> m_ids;
+    std::vector<uint32_t> m_dense;  // id -> dense index
+    uint32_t m_active_count = 0;
+    bool m_structure_changed = false;
+    // the resting grid needs a rebuild
+    bool m_resting_changed = false;
+    // proxies updated since the last rebuild, queries test them apart from
+    // their stale cells
+    std::vector<uint8_t> m_moved;  // id -> in m_moved_ids
+    std::vector<uint32_t> m_moved_ids;
+
+    Grid m_active_grid;
+    Grid m_resting_grid;
+
+    // scratch of buildGrid(), per proxy of the range
+    std::vector<Eigen::Vector3i> m_cells;
+    std::vector<uint32_t> m_buckets;
+    std::vector<uint32_t> m_bucket_cursor;
+    std::vector<uint32_t> m_sorted;  // range indices grouped by bucket
+
+    struct ChunkRange {
+        uint32_t m_worker;
+        uint32_t m_begin;
+        uint32_t m_end;
+    };
+
+    std::vector<float> m_extents;
+    std::vector<float> m_extent_order;  // scratch for the median
+    std::vector<float> m_worker_max_extent;
+    std::vector<ChunkRange> m_chunk_ranges;
+    std::vector<std::vector<BroadphasePair>> m_worker_pairs;
+    std::vector<BroadphasePair> m_pairs;
+
+    template <typename F>
+    void parallelFor(uint32_t count, uint32_t grain_size, const F& fn) {
+        if (m_job_system) {
+            m_job_system->ParallelFor(count, grain_size, fn);
+        } else {
+            fn(0, count, 0);
+        }
+    }
+
+    void swapDense(uint32_t a, uint32_t b);
+    void buildGrid(Grid& grid, uint32_t first, uint32_t count);
+};
+
+}
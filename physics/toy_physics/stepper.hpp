@@ -0,0 +1,62 @@
+#pragma once
+#include "toy_physics/pose_batch.hpp"
+#include "toy_physics/world.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace toy_physics {
+
+// runs a World at a fixed rate from variable frame times. Leftover time is
+// kept in an accumulator, and poses are interpolated between the last two
+// steps for rendering
+class FixedStepper {
+public:
+    explicit FixedStepper(World& world, float fixed_delta_time = 1.0f / 60.0f);
+
+    // runs every whole step covered by the accumulated time, but at most
+    // m_max_steps. Time beyond that is dropped, so a hitch slows the
+    // simulation down instead of making the next frames even slower.
+    // Returns the number of steps taken
+    uint32_t Advance(float delta_time);
+
+    // how far the accumulated time is between the last step and the next
+    float GetAlpha() const;
+
+    // bodies that were not simulated in the last step return their pose
+    Pose GetInterpolatedPose(BodyHandle handle) const;
+    // indexed by dense index, interpolated with the batched pose kernels
+    void GetInterpolatedPoses(PoseBatch& poses) const;
+    void GetInterpolatedPoses(std::vector<Pose>& poses) const;
+
+    float m_fixed_delta_time;
+    // every fixed step runs as this many world steps of equal length
+    uint32_t m_substeps = 1;
+    uint32_t m_max_steps = 4;
+
+private:
+    struct PreviousPose {
+        Pose m_pose;
+        uint32_t m_generation = 0;
+        // fixed step the pose was captured before
+        uint64_t m_step = UINT64_MAX;
+    };
+
+    World& m_world;
+    float m_accumulator = 0;
+    uint64_t m_step_count = 0;
+    // indexed by handle slot, only awake bodies are captured
+    std::vector<PreviousPose> m_previous_poses;
+    // world origin the previous poses are relative to
+    Eigen::Vector3d m_previous_origin = Eigen::Vector3d::Zero();
+    // interpolation scratch
+    mutable PoseBatch m_from;
+    mutable PoseBatch m_interpolated;
+
+    void capturePoses();
+    const PreviousPose* findPrevious(BodyHandle handle) const;
+    // moves previous poses into the current frame of the world
+    Eigen::Vector3f getOriginShift() const;
+};
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "toy_physics/broadphase.hpp"
+#include "toy_physics/simd.hpp"
+
+namespace toy_physics {
+
+// sort and sweep along X. The order from the last update is kept and
+// repaired with insertion sort, which is close to linear when motion is
+// coherent. Y and Z are tested together with one 4-wide compare.
+// Resting proxies live in a second list that is only sorted again when one
+// of them changes. Each update sweeps the active list and looks every
+// active box up in the resting list, from min x minus the widest resting
+// box on. Resting boxes much wider than the rest are tested one by one.
+// Queries use the same window on both lists
+class SweepAndPrune : public Broadphase {
+public:
+    Type GetType() const override { return Type::SweepAndPrune; }
+
+    void Add(uint32_t id, const AABB& aabb) override;
+    void Remove(uint32_t id) override;
+    void Update(uint32_t id, const AABB& aabb,
+                const Eigen::Vector3f& displacement) override;
+    bool Contains(uint32_t id) const override;
+    void ShiftOrigin(const Eigen::Vector3f& offset) override;
+    void SetResting(uint32_t id, bool resting) override;
+    // keeps the sorted endpoints, re-adding every proxy would leave the
+    // insertion sort a random order
+    bool SaveState(std::vector<std::byte>& out) const override;
+    bool LoadState(std::span<const std::byte> data) override;
+
+    void UpdatePairs() override;
+
+    const std::vector<BroadphasePair>& GetPairs() const override {
+        return m_pairs;
+    }
+
+    void Query(const AABB& aabb,
+               const std::function<bool(uint32_t)>& callback) const override;
+
+    // resting boxes wider than this times the median width are left out of
+    // the resting window
+    static constexpr float WideFactor = 4;
+
+private:
+    struct Endpoint {
+        float m_min_x;
+        uint32_t m_id;
+    };
+
+    // Y/Z bounds packed as {min_y, min_z, -max_y, -max_z} so that
+    // b overlaps a iff every lane of b <= {max_y, max_z, -min_y, -min_z} of a
+    struct alignas(16) PackedYZ {
+        float m_v[4];
+    };
+
+    // which list holds the endpoint of an id
+    enum ListTag : uint8_t {
+        NoList,
+        ActiveList,
+        RestingList,
+    };
+
+    struct SweepList {
+        std::vector<Endpoint> m_endpoints;
+        // endpoints in the order of the last sort, endpoints added since
+        // then follow unsorted
+        size_t m_sorted_count = 0;
+        // a box moved below the x it was sorted by, queries can't stop
+        // early until the next sort
+        bool m_has_lowered = false;
+        // widest box of the sorted endpoints measured from its endpoint,
+        // wide resting boxes left out. Grows with updates until the next
+        // sort, so no box starting before min x minus it reaches min x
+        double m_reach = 0;
+
+        // sweep columns, in endpoint order
+        std::vector<float> m_max_x;
+        std::vector<PackedYZ> m_yz;
+    };
+
+    std::vector<AABB> m_boxes;      // id -> box
+    std::vector<uint8_t> m_in_use;  // id -> registered
+    std::vector<uint8_t> m_resting;  // id -> SetResting() flag
+    std::vector<uint8_t> m_list;     // id -> ListTag
+    std::vector<float> m_keys;       // id -> min x of its endpoint
+    SweepList m_active;
+    SweepList m_resting_list;
+    // removed ids or ids whose endpoint is in the wrong list
+    bool m_lists_changed = false;
+    // the resting list needs a sort and new columns
+    bool m_resting_changed = false;
+
+    // positions of the wide boxes in the resting list
+    std::vector<uint32_t> m_wide;
+    std::vector<uint8_t> m_is_wide;
+    std::vector<float> m_widths;  // scratch for the median
+
+    std::vector<BroadphasePair> m_pairs;
+
+    void moveEndpoints();
+    void sortEndpoints(SweepList& list);
+    void buildColumns(SweepList& list);
+    void findWideBoxes();
+    void measureReach(SweepList& list);
+    void sweepActive();
+    void sweepResting();
+    SweepList& listOf(uint32_t id);
+};
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "toy_physics/geometry.hpp"
+#include "toy_physics/pose.hpp"
+
+#include <cstdint>
+
+namespace toy_physics {
+
+// motion of a shape over one step, t in [0, 1]. The body moves and spins at
+// constant velocity about its origin, the shape is attached at m_local
+struct Sweep {
+    Pose m_body;
+    Pose m_local;
+    // displacement and rotation vector over the whole step
+    Eigen::Vector3f m_linear = Eigen::Vector3f::Zero();
+    Eigen::Vector3f m_angular = Eigen::Vector3f::Zero();
+
+    Pose GetBodyPose(float t) const;
+    Pose GetShapePose(float t) const;
+};
+
+struct ToiSettings {
+    // the shapes are stopped this far apart, so the next step finds them
+    // as a speculative contact instead of touching
+    float m_target_separation = 0.01f;
+    float m_tolerance = 0.0025f;
+    uint32_t m_max_iterations = 32;
+};
+
+struct ToiOutput {
+    enum class State {
+        // separated for the whole sweep
+        Separated,
+        // reached the target separation at m_t
+        Hit,
+        // closer than the target separation at t = 0
+        Touching,
+    };
+
+    State m_state = State::Separated;
+    float m_t = 1;
+    // separation at m_t, only meaningful when not separated
+    float m_separation = 0;
+    uint32_t m_iterations = 0;
+};
+
+// distance from the body origin to the furthest point of the shape, bounds
+// how fast a point of the surface moves when the body spins. A sphere
+// spinning about its center doesn't move its surface
+float ComputeSweepRadius(const Geometry& geom, const Pose& local_pose);
+
+// conservative advancement: step t forward by the separation divided by a
+// bound of the approach speed, so the shapes never pass through each
+// other. Both sweeps may move
+ToiOutput TimeOfImpact(const Geometry& a, const Sweep& sweep_a,
+                       const Geometry& b, const Sweep& sweep_b,
+                       const ToiSettings& settings = {});
+
+}
@@ -1 +1,29 @@
-#pragma once
\ No newline at end of file
+#pragma once
+
+#include "toy_physics/aabb.hpp"
+#include "toy_physics/arena.hpp"
+#include "toy_physics/broadphase.hpp"
+#include "toy_physics/collision.hpp"
+#include "toy_physics/contact.hpp"
+#include "toy_physics/contact_batch.hpp"
+#include "toy_physics/contact_cache.hpp"
+#include "toy_physics/geometry_pool.hpp"
+#include "toy_physics/gjk.hpp"
+#include "toy_physics/inertia.hpp"
+#include "toy_physics/job_system.hpp"
+#include "toy_physics/narrowphase.hpp"
+#include "toy_physics/pair_map.hpp"
+#include "toy_physics/pose_batch.hpp"
+#include "toy_physics/profiler.hpp"
+#include "toy_physics/query.hpp"
+#include "toy_physics/query_snapshot.hpp"
+#include "toy_physics/raycast.hpp"
+#include "toy_physics/simd.hpp"
+#include "toy_physics/solver.hpp"
+#include "toy_physics/spatial_hash_grid.hpp"
+#include "toy_physics/stepper.hpp"
+#include "toy_physics/sweep_and_prune.hpp"
+#include "toy_physics/toi.hpp"
+#include "toy_physics/tree_broadphase.hpp"
+#include "toy_physics/world.hpp"
+#include "toy_physics/world_snapshot.hpp"
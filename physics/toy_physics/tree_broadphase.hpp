@@ -0,0 +1,54 @@
+#pragma once
+#include "toy_physics/broadphase.hpp"
+#include "toy_physics/dynamic_aabb_tree.hpp"
+
+namespace toy_physics {
+
+// keeps a persistent set of overlapping fat AABB pairs. Only proxies that
+// got reinserted or woken since the last update can create new pairs, so a
+// step costs O(moved * log n) queries plus a linear pass over the existing
+// pairs, which leave out pairs of two resting proxies
+class TreeBroadphase : public Broadphase {
+public:
+    Type GetType() const override { return Type::Tree; }
+
+    void Add(uint32_t id, const AABB& aabb) override;
+    void Remove(uint32_t id) override;
+    void Update(uint32_t id, const AABB& aabb,
+                const Eigen::Vector3f& displacement) override;
+    bool Contains(uint32_t id) const override;
+    void ShiftOrigin(const Eigen::Vector3f& offset) override;
+    void SetResting(uint32_t id, bool resting) override;
+
+    void UpdatePairs() override;
+
+    const std::vector<BroadphasePair>& GetPairs() const override {
+        return m_pairs;
+    }
+
+    void Query(const AABB& aabb,
+               const std::function<bool(uint32_t)>& callback) const override;
+    void CastQuery(AABBCast* casts, uint32_t count,
+                   const std::function<void(uint32_t, uint32_t)>& callback)
+        const override;
+    bool SaveState(std::vector<std::byte>& out) const override;
+    bool LoadState(std::span<const std::byte> data) override;
+
+    const DynamicAABBTree& GetTree() const { return m_tree; }
+
+    DynamicAABBTree& GetTree() { return m_tree; }
+
+private:
+    DynamicAABBTree m_tree;
+    std::vector<uint32_t> m_proxies;  // id -> tree proxy
+    std::vector<uint32_t> m_move_buffer;
+    std::vector<uint8_t> m_moved;  // id -> already in move buffer
+    std::vector<uint8_t> m_resting;  // id -> SetResting() flag
+    std::vector<BroadphasePair> m_pairs;
+    std::vector<BroadphasePair> m_new_pairs;
+    std::vector<BroadphasePair> m_merged_pairs;
+
+    void markMoved(uint32_t id);
+};
+
+}
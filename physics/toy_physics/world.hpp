@@ -0,0 +1,281 @@
+#pragma once
+#include "toy_physics/arena.hpp"
+#include "toy_physics/body.hpp"
+#include "toy_physics/broadphase.hpp"
+#include "toy_physics/job_system.hpp"
+#include "toy_physics/narrowphase.hpp"
+#include "toy_physics/query_snapshot.hpp"
+#include "toy_physics/solver.hpp"
+#include "toy_physics/toi.hpp"
+#include "toy_physics/world_snapshot.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace toy_physics {
+
+// body data stored as dense columns, all indexed by the same dense index.
+// Removing a body swaps the last body into the hole so columns never have
+// gaps. Awake bodies come first, sleeping and static bodies after them, so
+// per step passes only walk [0, m_awake_count)
+struct BodyColumns {
+    std::vector<Eigen::Vector3f> m_positions;
+    std::vector<Eigen::Quaternionf> m_rotations;
+    std::vector<Eigen::Vector3f> m_velocities;
+    std::vector<Eigen::Vector3f> m_angular_velocities;
+    std::vector<float> m_inv_masses;
+    // body space, derived from the shape when the body is created
+    std::vector<Eigen::Matrix3f> m_inv_inertias;
+    std::vector<Shape> m_shapes;
+    // world space shape pose and bounds, recomputed whenever the body pose
+    // changes. Bodies without geometry get a point box at the shape pose
+    std::vector<Pose> m_shape_poses;
+    std::vector<AABB> m_aabbs;
+    // m_shapes[i].m_geom as its own column for the narrowphase
+    std::vector<GeometryHandle> m_shape_geometries;
+    // time the body has been below the sleep velocities
+    std::vector<float> m_sleep_times;
+    std::vector<uint8_t> m_bullets;
+
+    // dense index -> slot index, used to patch handles after swap-remove
+    std::vector<uint32_t> m_slots;
+
+    size_t m_awake_count = 0;
+
+    size_t Size() const { return m_positions.size(); }
+};
+
+// wall time of the phases of the last step, in seconds. Narrowphase and
+// velocity integration run side by side, so the phases don't add up to
+// m_total
+struct StepTimings {
+    double m_broadphase = 0;
+    double m_narrowphase = 0;
+    double m_integrate_velocities = 0;
+    double m_solve = 0;
+    double m_ccd = 0;
+    double m_integrate_positions = 0;
+    double m_sleep = 0;
+    double m_publish = 0;
+    double m_total = 0;
+};
+
+class World {
+public:
+    // worker_count == 0 uses every hardware thread
+    explicit World(Broadphase::Type broadphase = Broadphase::Type::Tree,
+                   uint32_t worker_count = 0);
+    // runs the step on the application's threads, the executor has to
+    // outlive the world
+    World(Broadphase::Type broadphase, JobExecutor& executor);
+
+    // the step graph points back at the world
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    BodyHandle CreateBody(const Body& body);
+    void RemoveBody(BodyHandle handle);
+    bool IsValid(BodyHandle handle) const;
+    size_t GetBodyCount() const;
+    void Reserve(size_t count);
+
+    Body GetBody(BodyHandle handle) const;
+    Pose GetPose(BodyHandle handle) const;
+    void SetPose(BodyHandle handle, const Pose& pose);
+    Eigen::Vector3f GetVelocity(BodyHandle handle) const;
+    void SetVelocity(BodyHandle handle, const Eigen::Vector3f& velocity);
+    Eigen::Vector3f GetAngularVelocity(BodyHandle handle) const;
+    void SetAngularVelocity(BodyHandle handle,
+                            const Eigen::Vector3f& velocity);
+    bool IsBullet(BodyHandle handle) const;
+    void SetBullet(BodyHandle handle, bool bullet);
+
+    // sleeping bodies are skipped by the step until something touches
+    // them or the user changes them. Whole islands sleep and wake together
+    bool IsSleeping(BodyHandle handle) const;
+    void WakeUp(BodyHandle handle);
+    size_t GetAwakeBodyCount() const { return m_bodies.m_awake_count; }
+
+    // dense index is only valid until the next step, body creation or
+    // removal
+    uint32_t GetDenseIndex(BodyHandle handle) const;
+    BodyHandle GetHandle(uint32_t dense_index) const;
+    const BodyColumns& GetBodies() const { return m_bodies; }
+
+    // shapes of new bodies reference geometries added here
+    GeometryPool& GetGeometryPool() { return m_geometries; }
+    const GeometryPool& GetGeometryPool() const { return m_geometries; }
+
+    // pairs are reported by handle slot index
+    const std::vector<BroadphasePair>& GetBroadphasePairs() const;
+    const Broadphase& GetBroadphase() const { return *m_broadphase; }
+    JobSystem& GetJobSystem() { return *m_job_system; }
+
+    // contacts found by the last step, bodies are reported by dense index
+    const std::vector<ContactManifold>& GetManifolds() const {
+        return m_manifolds;
+    }
+    Narrowphase& GetNarrowphase() { return m_narrowphase; }
+    ContactSolver& GetSolver() { return m_solver; }
+
+    // casts run in parallel on the job system, in packets of neighbouring
+    // queries that walk the broadphase together. Must not overlap Step()
+    // or changes to bodies, and only one thread outside the job system may
+    // run batches or steps at a time
+    void RaycastBatch(const Ray* rays, size_t count, QueryMode mode,
+                      const QueryHitBuffer& out) const;
+    void SweepBatch(const ShapeCast* casts, size_t count, QueryMode mode,
+                    const QueryHitBuffer& out) const;
+
+    // the query snapshot published by the last step, safe to call from any
+    // thread while the world steps. Empty until a step published one
+    QuerySnapshotRef AcquireQuerySnapshot() const {
+        return m_query_snapshots.Acquire();
+    }
+
+    // large worlds: poses, queries and contacts are floats relative to a
+    // double precision origin, so precision does not depend on how far the
+    // scene is from the world origin. The origin is the anchor of a region,
+    // a point on a grid of m_region_size
+    const Eigen::Vector3d& GetOrigin() const { return m_origin; }
+    // moves the origin to the anchor closest to origin and shifts every
+    // body into the new frame. Poses read earlier stay in the old frame
+    void SetOrigin(const Eigen::Vector3d& origin);
+    Eigen::Vector3d ToWorld(const Eigen::Vector3f& local) const {
+        return m_origin + local.cast<double>();
+    }
+    Eigen::Vector3f ToLocal(const Eigen::Vector3d& world) const {
+        return (world - m_origin).cast<float>();
+    }
+
+    // flat binary image of the simulation state: bodies, geometries,
+    // sleeping islands, the broadphase and the contact cache. Settings like
+    // m_gravity are not part of it
+    void SaveSnapshot(std::vector<std::byte>& out) const;
+    bool SaveSnapshot(const std::string& path) const;
+    // replaces every body and geometry with the snapshot's, which keeps
+    // the saved handles valid. Columns are bulk copied, the broadphase is
+    // rebuilt only when the snapshot came from another backend
+    bool LoadSnapshot(const WorldSnapshotView& snapshot);
+    bool LoadSnapshot(const std::string& path);
+
+    // runs as a job graph: broadphase, then narrowphase alongside velocity
+    // integration, then solve, continuous collision, position integration
+    // and sleeping
+    void Step(float delta_time);
+
+    // heap allocations made by the last step, only counted when built with
+    // TOY_PHYSICS_TRACK_ALLOCATIONS. Zero once the world reached a steady
+    // state, step scratch lives in per worker frame arenas
+    uint64_t GetStepAllocationCount() const { return m_step_allocation_count; }
+    const StepTimings& GetStepTimings() const { return m_step_timings; }
+
+    Eigen::Vector3f m_gravity{0, -9.8f, 0};
+    // contacts closer than this are reported as speculative points
+    float m_contact_margin = 0.02f;
+
+    bool m_allow_sleeping = true;
+    float m_sleep_linear_velocity = 0.05f;
+    float m_sleep_angular_velocity = 0.05f;
+    // an island sleeps once all its bodies were slow for this long
+    float m_time_to_sleep = 0.5f;
+
+    // bullets, and bodies moving further than this fraction of their
+    // thinnest extent in one step, are swept against the scene and stopped
+    // at the time of impact instead of tunneling
+    bool m_enable_ccd = true;
+    float m_ccd_motion_threshold = 0.5f;
+
+    // a step first moves the origin to the region of the awake bodies once
+    // their center is further than m_region_size from it
+    bool m_auto_rebase = true;
+    double m_region_size = 1024;
+
+    // copies poses and a broadphase tree into a snapshot for readers on
+    // other threads at the end of every step. Costs a pass over all bodies,
+    // and may allocate while readers hold old snapshots
+    bool m_publish_query_snapshots = false;
+
+    // asserts when a step touched the heap, for catching regressions in
+    // warmed up scenes
+    bool m_assert_no_step_allocations = false;
+
+private:
+    struct Slot {
+        uint32_t m_dense = BodyHandle::InvalidIndex;
+        uint32_t m_generation = 0;
+        // index into m_sleeping_islands while the body sleeps
+        uint32_t m_sleeping_island = BodyHandle::InvalidIndex;
+    };
+
+    // body pose at the time of impact, m_t == 1 when nothing was hit
+    struct Impact {
+        uint32_t m_body = 0;
+        float m_t = 1;
+        Pose m_pose;
+    };
+
+    BodyColumns m_bodies;
+    GeometryPool m_geometries;
+    Eigen::Vector3d m_origin = Eigen::Vector3d::Zero();
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_free_slots;
+    std::unique_ptr<JobSystem> m_job_system;
+    JobGraph m_step_graph;
+    float m_step_delta_time = 0;
+    // one per worker, reset at the end of every step
+    std::vector<std::unique_ptr<FrameArena>> m_arenas;
+    uint64_t m_step_allocation_count = 0;
+    StepTimings m_step_timings;
+    std::unique_ptr<Broadphase> m_broadphase;
+    // one bit per slot, bodies the integrator moved since the last
+    // broadphase update. Set from the workers with atomic ors
+    std::vector<uint64_t> m_moved_slots;
+    QuerySnapshotPublisher m_query_snapshots;
+
+    Narrowphase m_narrowphase;
+    ArenaVector<NarrowphasePair> m_narrowphase_pairs;
+    std::vector<ContactManifold> m_manifolds;
+    ContactSolver m_solver;
+
+    // slots of the bodies of each sleeping island
+    std::vector<std::vector<uint32_t>> m_sleeping_islands;
+    std::vector<uint32_t> m_free_sleeping_islands;
+    ArenaVector<uint32_t> m_wake_requests;
+    ArenaVector<uint32_t> m_ccd_bodies;
+    ArenaVector<Impact> m_impacts;
+    // scratch indexed by island root
+    ArenaVector<float> m_island_sleep_times;
+    ArenaVector<uint32_t> m_island_sleep_ids;
+
+    void buildStepGraph();
+    void rebaseToAwakeBodies();
+    void integrateVelocities(float delta_time);
+    void integratePositions(float delta_time);
+    void updateBroadphase(float delta_time);
+    void updateContacts(FrameArena& arena);
+    void solveContacts(float delta_time);
+    void findImpacts(float delta_time, FrameArena& arena);
+    Impact sweepBody(uint32_t dense, float delta_time) const;
+    Sweep makeSweep(uint32_t dense, float delta_time) const;
+    void rewindToImpacts();
+    void publishQuerySnapshot();
+    void updateSleep(float delta_time, FrameArena& arena);
+    void wakeIsland(uint32_t island);
+    void wakeTouching(AABB aabb);
+    void setResting(uint32_t slot, bool resting);
+    uint32_t getAwakeDenseIndex(BodyHandle handle);
+    void swapBodies(uint32_t a, uint32_t b);
+    void manifoldsToSlots();
+    void manifoldsToDense();
+    void updateShape(uint32_t dense);
+    void markMoved(uint32_t slot);
+    bool hasBodyProxies() const;
+    template <typename T, typename CastFn>
+    void castBatch(const T* queries, size_t count, QueryMode mode,
+                   const QueryHitBuffer& out, const CastFn& cast) const;
+};
+
+}
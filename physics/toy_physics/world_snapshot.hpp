@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace toy_physics {
+
+enum class WorldSnapshotSection : uint32_t {
+    // body columns, indexed by dense index
+    Positions,
+    Rotations,
+    Velocities,
+    AngularVelocities,
+    InvMasses,
+    InvInertias,
+    Shapes,
+    ShapePoses,
+    AABBs,
+    SleepTimes,
+    Bullets,
+    BodySlots,
+    // handle slots and sleeping islands
+    Slots,
+    FreeSlots,
+    IslandOffsets,
+    IslandSlots,
+    FreeIslands,
+    MovedSlots,
+    // geometry pool records in handle index order
+    Boxes,
+    Spheres,
+    Capsules,
+    // caches carried between steps
+    ContactCache,
+    Manifolds,
+    Broadphase,
+
+    Count,
+};
+
+// a snapshot is this header followed by the sections. Sections are the raw
+// arrays of the world, each starting at a 64 byte aligned offset, so a
+// mapped file can be read in place or bulk copied into the columns
+struct WorldSnapshotHeader {
+    static constexpr uint32_t Magic = 0x53575054;  // "TPWS"
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t Alignment = 64;
+    // required of the data a view reads, heap buffers and mapped files
+    // both meet it
+    static constexpr size_t DataAlignment = 16;
+
+    struct Section {
+        uint64_t m_offset = 0;
+        uint64_t m_size = 0;
+    };
+
+    uint32_t m_magic = Magic;
+    uint32_t m_version = Version;
+    // record sizes of the build that wrote the snapshot, files are only
+    // read by builds with the same layout and byte order
+    uint32_t m_layout = 0;
+    // Broadphase::Type, the broadphase section is only loaded by the same
+    // backend
+    uint32_t m_broadphase = 0;
+    uint64_t m_awake_count = 0;
+    uint32_t m_contact_step = 0;
+    uint32_t m_reserved = 0;
+    std::array<double, 3> m_origin{};
+    std::array<Section, size_t(WorldSnapshotSection::Count)> m_sections{};
+
+    // layout of this build
+    static uint32_t GetLayout();
+};
+
+// checked, read only access to a snapshot in memory. The data is not
+// copied and has to outlive the view
+class WorldSnapshotView {
+public:
+    WorldSnapshotView() = default;
+    // an invalid snapshot gives an empty view
+    explicit WorldSnapshotView(std::span<const std::byte> data);
+
+    bool IsValid() const { return !m_data.empty(); }
+    const WorldSnapshotHeader& GetHeader() const;
+
+    std::span<const std::byte> GetBytes(WorldSnapshotSection section) const;
+
+    // T has to be the record type the section was written with
+    template <typename T>
+    std::span<const T> Get(WorldSnapshotSection section) const {
+        std::span<const std::byte> bytes = GetBytes(section);
+        return {reinterpret_cast<const T*>(bytes.data()),
+                bytes.size() / sizeof(T)};
+    }
+
+private:
+    std::span<const std::byte> m_data;
+};
+
+// appends aligned sections to out, the header is written by Finish()
+class WorldSnapshotWriter {
+public:
+    explicit WorldSnapshotWriter(std::vector<std::byte>& out);
+
+    WorldSnapshotHeader& GetHeader() { return m_header; }
+
+    void Write(WorldSnapshotSection section, const void* data, size_t size);
+
+    template <typename T>
+    void Write(WorldSnapshotSection section, const std::vector<T>& data) {
+        Write(section, data.data(), data.size() * sizeof(T));
+    }
+
+    void Finish();
+
+private:
+    std::vector<std::byte>& m_out;
+    WorldSnapshotHeader m_header;
+};
+
+// read only memory mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    std::span<const std::byte> GetData() const {
+        return {static_cast<const std::byte*>(m_data), m_size};
+    }
+
+private:
+    const void* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+}